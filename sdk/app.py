@@ -13,6 +13,7 @@ import codecs
 import effess
 import fnmatch
 import platform
+import resource_archive
 import xml.etree.ElementTree
 from xml.etree.ElementTree import ElementTree
 
@@ -223,6 +224,26 @@ class App(object):
                 effess.lightweight_copy_tree(source, p.join(contents, 'modules', module[0], module[1]),
                     exclude=self.env.get_excludes())
                     
+    def pack_resources(self):
+        # Only the OS X port can serve app:// URLs straight from the archive.
+        # The GTK and Win32 WebKit ports load them from file paths, so an
+        # archive there would mean copying every resource back out to disk.
+        if self.env.target_os != 'osx':
+            self.env.log(u'Not packing resources: only OS X applications can serve them from an archive')
+            return
+
+        # Files the operating system or the runtime open by path stay
+        # loose: the application icon and localized resources.
+        image = getattr(self, 'image', None)
+        def keep(path):
+            if image and path == image.replace(os.sep, '/'):
+                return True
+            return any(part.endswith('.lproj') for part in path.split('/'))
+
+        resources = p.join(self.contents, 'Resources')
+        count = resource_archive.pack(resources, p.join(self.contents, 'Resources.pak'), keep)
+        self.env.log(u'Packed %i resources into %s' % (count, p.join(self.contents, 'Resources.pak')))
+
     def run(self):
         self.env.run(self.executable_path)
 
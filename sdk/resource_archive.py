@@ -0,0 +1,97 @@
+#!/usr/bin/env python
+
+#
+# Copyright (c) 2012 - 2014 TideSDK contributors
+# http://www.tidesdk.org
+# Includes modified sources under the Apache 2 License
+# Copyright (c) 2008 - 2012 Appcelerator Inc
+# Refer to LICENSE for details of distribution and use.
+#
+
+# Packs an application's Resources directory into the single indexed
+# archive which the runtime maps into memory to serve app:// URLs. The
+# layout must match src/lib/tide/resource_archive.h.
+
+import os
+import os.path as p
+import struct
+
+MAGIC = 'TIDEPAK\0'
+VERSION = 1
+HEADER_SIZE = 16
+ENTRY_SIZE = 32
+ALIGNMENT = 8
+
+def fnv1a_64(data):
+    hash = 14695981039346656037
+    for c in data:
+        hash ^= ord(c)
+        hash = (hash * 1099511628211) & 0xFFFFFFFFFFFFFFFF
+    return hash
+
+def pad(offset):
+    return (ALIGNMENT - offset % ALIGNMENT) % ALIGNMENT
+
+def collect(resources_dir, keep):
+    files = []
+    for dir_path, dir_names, file_names in os.walk(resources_dir):
+        for file_name in file_names:
+            full_path = p.join(dir_path, file_name)
+            relative = p.relpath(full_path, resources_dir).replace(os.sep, '/')
+            if isinstance(relative, unicode):
+                relative = relative.encode('utf-8')
+            if not keep(relative):
+                files.append((relative, full_path))
+    return files
+
+def pack(resources_dir, archive_path, keep=lambda path: False, remove=True):
+    """Write every file under resources_dir, except those for which keep
+    returns True, to archive_path. Packed files are removed afterwards
+    unless remove is False. Returns the number of files packed."""
+
+    files = collect(resources_dir, keep)
+    entries = sorted([(fnv1a_64(relative), relative, full_path)
+        for (relative, full_path) in files])
+
+    # Paths follow the index, and the data follows the paths.
+    offset = HEADER_SIZE + ENTRY_SIZE * len(entries)
+    path_offsets = []
+    for (hash, relative, full_path) in entries:
+        path_offsets.append(offset)
+        offset += len(relative)
+    offset += pad(offset)
+
+    data_offsets = []
+    for (hash, relative, full_path) in entries:
+        length = p.getsize(full_path)
+        if length > 0xFFFFFFFF:
+            raise Exception('%s is too large to pack' % full_path)
+        data_offsets.append((offset, length))
+        offset += length + pad(offset + length)
+
+    out = open(archive_path, 'wb')
+    try:
+        out.write(struct.pack('<8sII', MAGIC, VERSION, len(entries)))
+        for i, (hash, relative, full_path) in enumerate(entries):
+            (data_offset, length) = data_offsets[i]
+            out.write(struct.pack('<QQIIII', hash, data_offset, length,
+                path_offsets[i], len(relative), 0))
+        for (hash, relative, full_path) in entries:
+            out.write(relative)
+        out.write('\0' * pad(out.tell()))
+        for i, (hash, relative, full_path) in enumerate(entries):
+            f = open(full_path, 'rb')
+            out.write(f.read())
+            f.close()
+            out.write('\0' * pad(out.tell()))
+    finally:
+        out.close()
+
+    if remove:
+        for (relative, full_path) in files:
+            os.remove(full_path)
+        for dir_path, dir_names, file_names in os.walk(resources_dir, topdown=False):
+            if dir_path != resources_dir and not os.listdir(dir_path):
+                os.rmdir(dir_path)
+
+    return len(entries)
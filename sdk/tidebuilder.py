@@ -77,6 +77,7 @@ if __name__ == '__main__':
     parser.add_option("-j", "--jsobfuscate",action="store_true",dest="js_obfuscate",default=False,help="obfuscate the javascript code within project")
     parser.add_option("-s", "--src",dest="source",help="source folder which contains dist files",metavar="FILE")
     parser.add_option("-a", "--assets",dest="assets_dir",default=None,help="location of platform assets",metavar="FILE")
+    parser.add_option("-k", "--pack-resources",action="store_true",dest="pack_resources",default=False,help="pack the Resources directory into a single archive that is served from memory (OS X only); code that reads resources as files from the Resources directory will no longer find them")
     parser.add_option("--appstore", action="store_true", dest="appstore", default=False, help="Package for app store submission")
 
     (options, args) = parser.parse_args()
@@ -119,6 +120,9 @@ if __name__ == '__main__':
     app = environment.create_app(appdir)
     app.stage(path.join(options.destination, app.name), bundle=bundle, no_install=no_install, js_obfuscate=options.js_obfuscate, ignore_patterns=options.ignore_patterns)
 
+    if options.pack_resources:
+        app.pack_resources()
+
     # Always create the package on the packaging server.
     if options.package or packager:
         app.package(options.destination, bundle=bundle)
@@ -30,6 +30,7 @@ int curl_progress_func(
     double ulnow);
 size_t curl_write_func(void *ptr, size_t size, size_t nmemb, FILE *stream);
 size_t curl_read_func(void *ptr, size_t size, size_t nmemb, FILE *stream);
+bool unzip_progress_func(char* message, int current, int total, void* data);
 
 void Job::InitDownloader()
 {
@@ -255,17 +256,20 @@ void Job::UnzipComponent()
     }
 
     FileUtils::CreateDirectory(outdir, true);
-    FileUtils::Unzip(this->out_filename, outdir);
+    if (!FileUtils::Unzip(this->out_filename, outdir, &unzip_progress_func, this))
+        throw std::string("Install failed: could not extract ") + this->out_filename;
 }
 
 void Job::UnzipApplication()
 {
-    FileUtils::Unzip(this->out_filename, Installer::applicationPath);
+    if (!FileUtils::Unzip(this->out_filename, Installer::applicationPath,
+        &unzip_progress_func, this))
+        throw std::string("Install failed: could not extract ") + this->out_filename;
 }
 
 void Job::Unzip()
 {
-    this->progress = ((double) this->index) / ((double) Job::total);
+    this->progress = 0;
     if (this->type == COMPONENT_JOB)
     {
         this->UnzipComponent();
@@ -323,3 +327,13 @@ int curl_progress_func(
         job->SetProgress(d/t);
     return 0;
 }
+
+bool unzip_progress_func(char* message, int current, int total, void* data)
+{
+    Job* job = (Job*) data;
+    if (total == 0)
+        job->SetProgress(0);
+    else
+        job->SetProgress(((double) current) / ((double) total));
+    return true;
+}
@@ -18,6 +18,7 @@
 #include <sstream>
 #include <map>
 #include <algorithm>
+#include <Poco/File.h>
 #include <Poco/StringTokenizer.h>
  
 using std::string;
@@ -25,8 +26,96 @@ using std::map;
 
 namespace tide
 {
+    // Op arrays which are executing, and whether they were released
+    // meanwhile. A script can call back into PHP.evaluate, which may evict
+    // or invalidate the op array still running further up the stack, so
+    // destroying it is put off until its outermost run returns.
+    struct RunningOpArray
+    {
+        int depth;
+        bool released;
+    };
+    static map<zend_op_array*, RunningOpArray> runningOpArrays;
+    static Poco::Mutex runningOpArraysMutex;
+
+    static void DestroyOpArray(zend_op_array* opArray)
+    {
+        TSRMLS_FETCH();
+        destroy_op_array(opArray TSRMLS_CC);
+        efree(opArray);
+    }
+
+    static void ReleaseOpArray(zend_op_array* opArray)
+    {
+        {
+            Poco::Mutex::ScopedLock lock(runningOpArraysMutex);
+            map<zend_op_array*, RunningOpArray>::iterator i = runningOpArrays.find(opArray);
+            if (i != runningOpArrays.end())
+            {
+                i->second.released = true;
+                return;
+            }
+        }
+
+        DestroyOpArray(opArray);
+    }
+
+    static void ExecuteOpArray(zend_op_array* opArray TSRMLS_DC)
+    {
+        {
+            Poco::Mutex::ScopedLock lock(runningOpArraysMutex);
+            runningOpArrays[opArray].depth++;
+        }
+
+        // This mirrors what zend_execute_scripts does, except that the
+        // op array is kept around afterwards so that it can be run again.
+        zval* returnValue = NULL;
+        zval** originalReturnValue = EG(return_value_ptr_ptr);
+        zend_op_array* originalOpArray = EG(active_op_array);
+        bool bailedOut = false;
+
+        zend_try
+        {
+            EG(return_value_ptr_ptr) = &returnValue;
+            EG(active_op_array) = opArray;
+            zend_execute(opArray TSRMLS_CC);
+
+            if (EG(exception))
+                zend_exception_error(EG(exception), E_ERROR TSRMLS_CC);
+        }
+        zend_catch
+        {
+            bailedOut = true;
+        }
+        zend_end_try();
+
+        if (returnValue)
+            zval_ptr_dtor(&returnValue);
+        EG(active_op_array) = originalOpArray;
+        EG(return_value_ptr_ptr) = originalReturnValue;
+
+        bool destroy = false;
+        {
+            Poco::Mutex::ScopedLock lock(runningOpArraysMutex);
+            map<zend_op_array*, RunningOpArray>::iterator i = runningOpArrays.find(opArray);
+            if (--i->second.depth == 0)
+            {
+                destroy = i->second.released;
+                runningOpArrays.erase(i);
+            }
+        }
+
+        if (destroy)
+            DestroyOpArray(opArray);
+
+        // Let the caller's zend_try see the failure.
+        if (bailedOut)
+            zend_bailout();
+    }
+
     PHPEvaluator::PHPEvaluator()
-        : StaticBoundObject("PHP.PHPEvaluator")
+        : StaticBoundObject("PHP.PHPEvaluator"),
+          codeCache(&ReleaseOpArray)
     {
         /**
          * @notiapi(method=True,name=PHP.canEvaluate,since=0.7)
@@ -60,6 +149,34 @@ namespace tide
          * @notiresult[String] result of the evaluation
          */
         SetMethod("preprocess", &PHPEvaluator::Preprocess);
+
+        // Declare what we handle, so that Script can dispatch to us without
+        // calling canEvaluate or canPreprocess. Every resource WebKit loads
+        // is checked for preprocessing, so this keeps that check cheap.
+        TiListRef mimeTypes(new StaticBoundList());
+        mimeTypes->Append(Value::NewString("text/php"));
+        SetList("mimeTypes", mimeTypes);
+
+        TiListRef extensions(new StaticBoundList());
+        extensions->Append(Value::NewString("php"));
+        SetList("extensions", extensions);
+
+        /**
+         * @notiapi(method=True,name=PHP.getCacheStats,since=1.4)
+         * @notiresult[Object] hits, misses, evictions, invalidations and size
+         * of the cache of compiled scripts and preprocessed pages
+         */
+        SetMethod("getCacheStats", &PHPEvaluator::GetCacheStats);
+    }
+
+    void PHPEvaluator::ClearCache()
+    {
+        codeCache.Clear();
+    }
+
+    void PHPEvaluator::GetCacheStats(const ValueList& args, ValueRef result)
+    {
+        result->SetObject(codeCache.GetStats());
     }
 
     void PHPEvaluator::CanEvaluate(const ValueList& args, ValueRef result)
@@ -124,7 +241,7 @@ namespace tide
         codeString << "   }\n";
         codeString << "  }\n";
         codeString << "}\n";
-        printf("%s\n", codeString.str().c_str());
+        string source(codeString.str());
 
         // This seems to be needed to make PHP actually give us errors
         // at parse/compile time -- see: main/main.c line 969
@@ -135,8 +252,22 @@ namespace tide
 
         zend_first_try
         {
-            zend_eval_string((char *) codeString.str().c_str(), NULL, 
-                (char *) name.c_str() TSRMLS_CC);
+            // Functions in the script are bound when it is compiled, so
+            // running a cached op array again does not redeclare them.
+            string key(CodeCache<zend_op_array*>::GetKey(name, source));
+            zend_op_array* opArray = NULL;
+            if (!codeCache.Get(key, opArray))
+            {
+                zval sourceValue;
+                ZVAL_STRINGL(&sourceValue, (char *) source.c_str(), source.size(), 0);
+                opArray = zend_compile_string(&sourceValue,
+                    (char *) name.c_str() TSRMLS_CC);
+                if (opArray)
+                    codeCache.Put(key, opArray);
+            }
+
+            if (opArray)
+                ExecuteOpArray(opArray TSRMLS_CC);
         }
         zend_catch
         {
@@ -216,16 +347,46 @@ namespace tide
             // Convert the path to the system codepage.
             path = UTF8ToSystem(path);
 
-            zend_file_handle script;
-            script.type = ZEND_HANDLE_FILENAME;
-            script.filename = (char*) path.c_str();
-            script.opened_path = NULL;
-            script.free_filename = 0;
-            script.handle.fp = 0;
+            // Compiled pages are cached by path and recompiled once
+            // the file changes on disk.
+            Poco::Timestamp::TimeVal modified = 0;
+            try
+            {
+                modified = Poco::File(path).getLastModified().epochMicroseconds();
+            }
+            catch (Poco::Exception&)
+            {
+                // Let the compiler report the missing file.
+            }
 
             zend_first_try
             {
-               php_execute_script(&script TSRMLS_CC);
+               zend_op_array* opArray = NULL;
+               if (!modified || !codeCache.Get(path, opArray, modified))
+               {
+                   zend_file_handle script;
+                   script.type = ZEND_HANDLE_FILENAME;
+                   script.filename = (char*) path.c_str();
+                   script.opened_path = NULL;
+                   script.free_filename = 0;
+                   script.handle.fp = 0;
+
+                   opArray = zend_compile_file(&script, ZEND_REQUIRE TSRMLS_CC);
+                   zend_destroy_file_handle(&script TSRMLS_CC);
+                   if (opArray && modified)
+                       codeCache.Put(path, opArray, modified);
+               }
+
+               if (opArray)
+               {
+                   ExecuteOpArray(opArray TSRMLS_CC);
+                   if (!modified)
+                       ReleaseOpArray(opArray);
+               }
+               else
+               {
+                   EG(exit_status) = 255;
+               }
                exit_status = EG(exit_status);
             }
             zend_catch
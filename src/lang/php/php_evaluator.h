@@ -21,10 +21,16 @@ namespace tide
 		void CanPreprocess(const ValueList& args, ValueRef result);
 		void Evaluate(const ValueList& args, ValueRef result);
 		void Preprocess(const ValueList& args, ValueRef result);
+		void GetCacheStats(const ValueList& args, ValueRef result);
+
+		// Must be called before the PHP engine is shut down.
+		void ClearCache();
 		
 		protected:
 		std::string CreateContextName();
 		void FillGet(Poco::URI& uri TSRMLS_DC);
+
+		CodeCache<zend_op_array*> codeCache;
 		
 	};
 }
@@ -152,6 +152,10 @@ namespace tide
         global->Set("PHP", Value::Undefined);
         this->binding->Set("evaluate", Value::Undefined);
 
+        // Cached op arrays live in request memory, so release them
+        // before the engine goes away.
+        this->binding.cast<PHPEvaluator>()->ClearCache();
+
         this->binding = 0;
         PHPModule::instance_ = 0;
 
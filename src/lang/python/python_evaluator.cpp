@@ -7,14 +7,54 @@
  **/
 
 #include "python_module.h"
+#include <marshal.h>
+
+#include <Poco/File.h>
+#include <Poco/FileStream.h>
+#include <Poco/StreamCopier.h>
 
 namespace tide
 {
+    static void ReleaseCompiledCode(PyObject* compiled)
+    {
+        Py_DECREF(compiled);
+    }
+
     PythonEvaluator::PythonEvaluator() :
-        StaticBoundObject("Python.Evaluator")
+        StaticBoundObject("Python.Evaluator"),
+        codeCache(&ReleaseCompiledCode),
+        bytecodeCacheEnabled(false),
+        bytecodeHits(0),
+        bytecodeMisses(0)
     {
         SetMethod("canEvaluate", &PythonEvaluator::CanEvaluate);
         SetMethod("evaluate", &PythonEvaluator::Evaluate);
+
+        // Declare the mime type, so that Script can dispatch to us
+        // without calling canEvaluate.
+        TiListRef mimeTypes(new StaticBoundList());
+        mimeTypes->Append(Value::NewString("text/python"));
+        SetList("mimeTypes", mimeTypes);
+
+        /**
+         * @notiapi(method=True,name=Python.getCacheStats,since=1.4)
+         * @notiresult[Object] hits, misses, evictions and size of the compiled
+         * code cache, and hits and misses of the on-disk bytecode cache
+         */
+        SetMethod("getCacheStats", &PythonEvaluator::GetCacheStats);
+
+        /**
+         * @notiapi(method=True,name=Python.setBytecodeCacheEnabled,since=1.4)
+         * @notiapi Keep compiled bytecode in the application data directory,
+         * @notiapi so that scripts are not recompiled on the next launch.
+         * @notiarg[bool, enabled] whether or not to use the on-disk cache
+         */
+        SetMethod("setBytecodeCacheEnabled", &PythonEvaluator::SetBytecodeCacheEnabled);
+    }
+
+    void PythonEvaluator::ClearCache()
+    {
+        codeCache.Clear();
     }
     
     void PythonEvaluator::CanEvaluate(const ValueList& args, ValueRef result)
@@ -29,30 +69,41 @@ namespace tide
         }
     }
     
+    void PythonEvaluator::GetCacheStats(const ValueList& args, ValueRef result)
+    {
+        TiObjectRef stats(codeCache.GetStats());
+        stats->SetDouble("bytecodeHits", bytecodeHits);
+        stats->SetDouble("bytecodeMisses", bytecodeMisses);
+        stats->SetBool("bytecodeCacheEnabled", bytecodeCacheEnabled);
+        result->SetObject(stats);
+    }
+
+    void PythonEvaluator::SetBytecodeCacheEnabled(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("setBytecodeCacheEnabled", "b");
+        bytecodeCacheEnabled = args.GetBool(0);
+    }
+
     void PythonEvaluator::Evaluate(const ValueList& args, ValueRef result)
     {
         PyLockGIL lock;
         args.VerifyException("evaluate", "s s s o");
 
         //const char *mimeType = args.GetString(0).c_str();
-        const char *name = args.GetString(1).c_str();
-        std::string code = args.GetString(2);
+        std::string name(args.GetString(1));
+        std::string code(args.GetString(2));
         TiObjectRef windowGlobal = args.GetObject(3);
         
         // We must unindent the code block to prevent parsing errors.
         PythonEvaluator::UnindentCode(code);
 
-        // Insert all the js global properties into a copy of globals()
-        PyObject* mainModule = PyImport_AddModule("__main__");
-        PyObject* globals = PyDict_Copy(PyModule_GetDict(mainModule));
-        TiObjectPropsToDict(windowGlobal, globals);
-
         // Another way to do this is to use a Python sub-interpreter,
         // but that seems to put us into restricted execution mode
         // sometimes. So we're going to try to isolate the variables
         // in this script by compiling it and supplying our own copy
-        // of the globals.
-        PyObject* compiled = Py_CompileStringFlags(code.c_str(), name, Py_file_input, NULL);
+        // of the globals. Compiled code does not depend on the globals,
+        // so the same script included in many windows is compiled once.
+        PyObject* compiled = this->Compile(name, code);
         if (compiled == NULL)
         {
             Logger *logger = Logger::Get("Python");
@@ -61,12 +112,17 @@ namespace tide
             logger->Error(error);
 
             PyErr_Print();
-            Py_DECREF(globals);
             result->SetUndefined();
             return;
         }
 
+        // Insert all the js global properties into a copy of globals()
+        PyObject* mainModule = PyImport_AddModule("__main__");
+        PyObject* globals = PyDict_Copy(PyModule_GetDict(mainModule));
+        TiObjectPropsToDict(windowGlobal, globals);
+
         PyObject *returnValue = PyEval_EvalCode((PyCodeObject*) compiled, globals, globals);
+        Py_DECREF(compiled);
 
         // Clear the error indicator before doing anything else. It might
         // cause a a false positive for errors in other bits of Python.
@@ -81,18 +137,150 @@ namespace tide
 
             PyErr_Print();
         }
-        else
+        else if (returnValue != NULL)
         {
-            ValueRef kv = PythonUtils::ToTiValue(returnValue);
+            kv = PythonUtils::ToTiValue(returnValue);
             Py_DECREF(returnValue);
         }
 
         // Move all the new variables in globals() to the window context.
         // These are things that are now defined globally in JS.
         DictToTiObjectProps(globals, windowGlobal);
+        Py_DECREF(globals);
         result->SetValue(kv);
     }
 
+    PyObject* PythonEvaluator::Compile(const std::string& name, const std::string& code)
+    {
+        // Returns a new reference to the code object, or NULL with
+        // the Python error indicator set if the code does not compile.
+        std::string key(CodeCache<PyObject*>::GetKey(name, code));
+        PyObject* compiled = NULL;
+        if (codeCache.Get(key, compiled))
+        {
+            Py_INCREF(compiled);
+            return compiled;
+        }
+
+        if (bytecodeCacheEnabled)
+        {
+            compiled = this->LoadBytecode(key);
+            if (compiled)
+                bytecodeHits++;
+            else
+                bytecodeMisses++;
+        }
+
+        if (!compiled)
+        {
+            compiled = Py_CompileStringFlags(code.c_str(), name.c_str(), Py_file_input, NULL);
+            if (!compiled)
+                return NULL;
+
+            if (bytecodeCacheEnabled)
+                this->SaveBytecode(key, compiled);
+        }
+
+        Py_INCREF(compiled);
+        codeCache.Put(key, compiled);
+        return compiled;
+    }
+
+    std::string PythonEvaluator::GetBytecodePath(const std::string& key)
+    {
+        static std::string cacheDirectory;
+        if (cacheDirectory.empty())
+        {
+            cacheDirectory = FileUtils::Join(
+                Host::GetInstance()->GetApplication()->GetDataPath().c_str(),
+                "python_cache", NULL);
+            FileUtils::CreateDirectory(cacheDirectory, true);
+        }
+
+        std::string filename(key);
+        filename.append(".pyc");
+        return FileUtils::Join(cacheDirectory.c_str(), filename.c_str(), NULL);
+    }
+
+    PyObject* PythonEvaluator::LoadBytecode(const std::string& key)
+    {
+        // Each file starts with the magic number of the interpreter that
+        // wrote it, so bytecode from another Python version is ignored.
+        // The key already covers the script name and source, so there is
+        // no need to check modification times here.
+        std::string data;
+        try
+        {
+            std::string path(this->GetBytecodePath(key));
+            if (!FileUtils::IsFile(path))
+                return NULL;
+
+            Poco::FileInputStream stream(path);
+            Poco::StreamCopier::copyToString(stream, data);
+        }
+        catch (Poco::Exception& e)
+        {
+            Logger::Get("Python")->Warn("Could not read cached bytecode: %s",
+                e.displayText().c_str());
+            return NULL;
+        }
+
+        if (data.size() < 4)
+            return NULL;
+
+        const unsigned char* header = (const unsigned char*) data.data();
+        long magic = header[0] | (header[1] << 8) | (header[2] << 16) | (header[3] << 24);
+        if (magic != PyImport_GetMagicNumber())
+            return NULL;
+
+        PyObject* compiled = PyMarshal_ReadObjectFromString(
+            (char*) data.data() + 4, data.size() - 4);
+        if (!compiled || !PyCode_Check(compiled))
+        {
+            PyErr_Clear();
+            Py_XDECREF(compiled);
+            return NULL;
+        }
+        return compiled;
+    }
+
+    void PythonEvaluator::SaveBytecode(const std::string& key, PyObject* compiled)
+    {
+        PyObject* marshalled = PyMarshal_WriteObjectToString(compiled, Py_MARSHAL_VERSION);
+        if (!marshalled)
+        {
+            PyErr_Clear();
+            return;
+        }
+
+        long magic = PyImport_GetMagicNumber();
+        std::string data;
+        data.append(1, (char) (magic & 0xff));
+        data.append(1, (char) ((magic >> 8) & 0xff));
+        data.append(1, (char) ((magic >> 16) & 0xff));
+        data.append(1, (char) ((magic >> 24) & 0xff));
+        data.append(PyString_AS_STRING(marshalled), PyString_GET_SIZE(marshalled));
+        Py_DECREF(marshalled);
+
+        // Write to a temporary file first, so that another instance
+        // of the application never reads a partially written file.
+        try
+        {
+            std::string path(this->GetBytecodePath(key));
+            std::string tempPath(path + ".tmp");
+            {
+                Poco::FileOutputStream stream(tempPath);
+                stream.write(data.data(), data.size());
+            }
+            Poco::File(tempPath).renameTo(path);
+        }
+        catch (Poco::Exception& e)
+        {
+            Logger::Get("Python")->Warn("Could not write cached bytecode: %s",
+                e.displayText().c_str());
+        }
+    }
+
     void PythonEvaluator::TiObjectPropsToDict(TiObjectRef o, PyObject* pyobj)
     {
         PyObject* builtins = PyDict_GetItemString(pyobj, "__builtins__");
@@ -19,8 +19,24 @@ namespace tide
         PythonEvaluator();
         void Evaluate(const ValueList& args, ValueRef result);
         void CanEvaluate(const ValueList& args, ValueRef result);
+        void GetCacheStats(const ValueList& args, ValueRef result);
+        void SetBytecodeCacheEnabled(const ValueList& args, ValueRef result);
+
+        // Must be called with the GIL held, before the interpreter
+        // is finalized.
+        void ClearCache();
 
     private:
+        PyObject* Compile(const std::string& name, const std::string& code);
+        PyObject* LoadBytecode(const std::string& key);
+        void SaveBytecode(const std::string& key, PyObject* compiled);
+        std::string GetBytecodePath(const std::string& key);
+
+        CodeCache<PyObject*> codeCache;
+        bool bytecodeCacheEnabled;
+        double bytecodeHits;
+        double bytecodeMisses;
+
         static void UnindentCode(std::string &code);
         static void DictToTiObjectProps(PyObject* map, TiObjectRef o);
         static void TiObjectPropsToDict(TiObjectRef o, PyObject* pyobj);
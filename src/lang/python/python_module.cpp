@@ -71,6 +71,9 @@ namespace tide
         TiObjectRef global = this->host->GetGlobalObject();
         global->Set("Python", Value::Undefined);
         Script::GetInstance()->RemoveScriptEvaluator(this->binding);
+
+        // Release cached code objects while the interpreter is still alive.
+        this->binding.cast<PythonEvaluator>()->ClearCache();
         this->binding = NULL;
         PythonModule::instance_ = NULL;
         Py_Finalize();
@@ -22,7 +22,12 @@ namespace tide
     static int PyTiListContains(PyObject*, PyObject*);
     static PyObject* PyTiListInPlaceConcat(PyObject*, PyObject*);
     static PyObject* PyTiListInPlaceRepeat(PyObject*, Py_ssize_t);
+    static PyObject* PyTiListIter(PyObject*);
     static PyObject* PyTiMethod_call(PyObject*, PyObject *, PyObject*);
+    static Py_ssize_t PyTiBytesGetReadBuffer(PyObject*, Py_ssize_t, void**);
+    static Py_ssize_t PyTiBytesGetSegCount(PyObject*, Py_ssize_t*);
+    static Py_ssize_t PyTiBytesGetCharBuffer(PyObject*, Py_ssize_t, char**);
+    static int PyTiBytesGetBuffer(PyObject*, Py_buffer*, int);
 
     typedef struct {
         PyObject_HEAD
@@ -136,7 +141,44 @@ namespace tide
         0                           /* tp_base */
     };
 
+    static PyTypeObject PyTiBytesType =
+    {
+        PyObject_HEAD_INIT(NULL)
+        0,
+        "Bytes",
+        sizeof(PyTiObject),
+        0,
+        PyTiObject_dealloc,          /*tp_dealloc*/
+        0,                          /*tp_print*/
+        PyTiObject_getattr,          /*tp_getattr*/
+        PyTiObject_setattr,          /*tp_setattr*/
+        0,                          /*tp_compare*/
+        0,                          /*tp_repr*/
+        0,                          /*tp_as_number*/
+        0,                          /*tp_as_sequence*/
+        0,                          /*tp_as_mapping*/
+        0,                          /*tp_hash */
+        0,                          /*tp_call */
+        PyTiObject_str,              /*tp_str */
+        0,                          /*tp_getattro*/
+        0,                          /*tp_setattro*/
+        0,                          /*tp_as_buffer*/
+        0,                          /*tp_flags*/
+        0,                          /*tp_doc*/
+        0,                          /* tp_traverse */
+        0,                          /* tp_clear */
+        0,                          /* tp_richcompare */
+        0,                          /* tp_weaklistoffset */
+        0,                          /* tp_iter */
+        0,                          /* tp_iternext */
+        0,                          /* tp_methods */
+        0,                          /* tp_members */
+        0,                          /* tp_getset */
+        0                           /* tp_base */
+    };
+
     PySequenceMethods KPySequenceMethods = { 0 };
+    PyBufferProcs KPyBufferProcs = { 0 };
 
     void PythonUtils::InitializePythonKClasses()
     {
@@ -152,7 +194,20 @@ namespace tide
         KPySequenceMethods.sq_inplace_repeat = &PyTiListInPlaceRepeat;
 
         PyTiListType.tp_as_sequence = &KPySequenceMethods;
-        PyTiListType.tp_flags = Py_TPFLAGS_HAVE_INPLACEOPS | Py_TPFLAGS_HAVE_SEQUENCE_IN;
+        PyTiListType.tp_iter = &PyTiListIter;
+        PyTiListType.tp_flags = Py_TPFLAGS_HAVE_INPLACEOPS | Py_TPFLAGS_HAVE_SEQUENCE_IN
+            | Py_TPFLAGS_HAVE_ITER;
+
+        // Bytes expose their storage through both the old and the new
+        // buffer protocols, so that buffer(), memoryview() and functions
+        // like struct.unpack_from can read them without a copy.
+        KPyBufferProcs.bf_getreadbuffer = &PyTiBytesGetReadBuffer;
+        KPyBufferProcs.bf_getsegcount = &PyTiBytesGetSegCount;
+        KPyBufferProcs.bf_getcharbuffer = &PyTiBytesGetCharBuffer;
+        KPyBufferProcs.bf_getbuffer = &PyTiBytesGetBuffer;
+
+        PyTiBytesType.tp_as_buffer = &KPyBufferProcs;
+        PyTiBytesType.tp_flags = Py_TPFLAGS_HAVE_GETCHARBUFFER | Py_TPFLAGS_HAVE_NEWBUFFER;
 
         if (PyType_Ready(&PyTiObjectType) < 0)
             throw ValueException::FromString("Could not initialize PyTiObjectType!");
@@ -163,6 +218,9 @@ namespace tide
         if (PyType_Ready(&PyTiMethodType) < 0)
             throw ValueException::FromString("Could not initialize PyTiMethodType!");
 
+        if (PyType_Ready(&PyTiBytesType) < 0)
+            throw ValueException::FromString("Could not initialize PyTiBytesType!");
+
     }
 
     PyObject* PythonUtils::ToPyObject(ValueRef value)
@@ -236,6 +294,11 @@ namespace tide
             {
                 pythonValue = pydict->ToPython();
             }
+            else if (!obj.cast<Bytes>().isNull())
+            {
+                pythonValue = PythonUtils::TiBytesToPyObject(value);
+                needsReferenceIncrement = false;
+            }
             else
             {
                 pythonValue = PythonUtils::TiObjectToPyObject(value);
@@ -347,6 +410,11 @@ namespace tide
             PyTiObject *o = reinterpret_cast<PyTiObject*>(value);
             kvalue = *(o->value);
         }
+        else if (PyObject_TypeCheck(value, &PyTiBytesType))
+        {
+            PyTiObject *o = reinterpret_cast<PyTiObject*>(value);
+            kvalue = *(o->value);
+        }
         else if (PyObject_TypeCheck(value, &PyModule_Type))
         {
             kvalue = Value::NewObject(new KPythonObject(value));
@@ -514,8 +582,9 @@ namespace tide
 
         if (!listVal.isNull())
             return PythonUtils::ToPyObject(listVal);
-        else
-            return NULL;
+
+        PyErr_SetString(PyExc_IndexError, "list index out of range");
+        return NULL;
     }
 
     static int PyTiListSetItem(PyObject *o, Py_ssize_t i, PyObject *v)
@@ -540,13 +609,16 @@ namespace tide
         TiListRef tiList = pyko->value->get()->ToList();
         ValueRef kv = PythonUtils::ToTiValue(value);
 
+        std::vector<ValueRef> values;
         {
             PyAllowThreads allow;
-            for (unsigned int i = 0; i < tiList->Size(); i++)
-            {
-                if (kv == tiList->At(i))
-                    return 1;
-            }
+            tiList->GetValues(values);
+        }
+
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            if (kv->Equals(values[i]))
+                return 1;
         }
 
         return 0;
@@ -580,12 +652,13 @@ namespace tide
 
         {
             PyAllowThreads allow;
-            unsigned int size = tiList->Size();
+            std::vector<ValueRef> values;
+            tiList->GetValues(values);
             while (count > 0)
             {
-                for (unsigned int i = 0; i < size; i++)
+                for (size_t i = 0; i < values.size(); i++)
                 {
-                    tiList->Append(tiList->At(i));
+                    tiList->Append(values[i]);
                 }
                 count--;
             }
@@ -594,6 +667,32 @@ namespace tide
         return o;
     }
 
+    static PyObject* PyTiListIter(PyObject *o)
+    {
+        // Gather the elements in one pass and iterate over a real Python
+        // list, instead of crossing the bridge once per element.
+        PyLockGIL lock;
+        PyTiObject *pyko = reinterpret_cast<PyTiObject*>(o);
+        TiListRef tiList = pyko->value->get()->ToList();
+
+        std::vector<ValueRef> values;
+        {
+            PyAllowThreads allow;
+            tiList->GetValues(values);
+        }
+
+        PyObject* list = PyList_New(values.size());
+        if (!list)
+            return NULL;
+
+        for (size_t i = 0; i < values.size(); i++)
+            PyList_SET_ITEM(list, i, PythonUtils::ToPyObject(values[i]));
+
+        PyObject* iterator = PyObject_GetIter(list);
+        Py_DECREF(list);
+        return iterator;
+    }
+
     PyObject* PythonUtils::TiListToPyObject(ValueRef v)
     {
         PyLockGIL lock;
@@ -642,6 +741,58 @@ namespace tide
         return PythonUtils::ToPyObject(result);
     }
 
+    static Bytes* GetBytes(PyObject* o)
+    {
+        // The wrapper holds a reference to the Bytes for as long as
+        // Python does, including while a buffer view is exported.
+        PyTiObject *pyko = reinterpret_cast<PyTiObject*>(o);
+        return pyko->value->get()->ToObject().cast<Bytes>().get();
+    }
+
+    static Py_ssize_t PyTiBytesGetReadBuffer(PyObject *o, Py_ssize_t segment, void **pointer)
+    {
+        if (segment != 0)
+        {
+            PyErr_SetString(PyExc_SystemError, "accessing non-existent Bytes segment");
+            return -1;
+        }
+
+        Bytes* bytes = GetBytes(o);
+        *pointer = bytes->Pointer();
+        return bytes->Length();
+    }
+
+    static Py_ssize_t PyTiBytesGetSegCount(PyObject *o, Py_ssize_t *length)
+    {
+        if (length)
+            *length = GetBytes(o)->Length();
+        return 1;
+    }
+
+    static Py_ssize_t PyTiBytesGetCharBuffer(PyObject *o, Py_ssize_t segment, char **pointer)
+    {
+        return PyTiBytesGetReadBuffer(o, segment, (void**) pointer);
+    }
+
+    static int PyTiBytesGetBuffer(PyObject *o, Py_buffer *view, int flags)
+    {
+        // Views are read-only: PyBuffer_FillInfo refuses PyBUF_WRITABLE
+        // requests with a BufferError, so Python cannot write into the
+        // Bytes. The view is not a snapshot, though. It points at the
+        // Bytes' own memory, so anything Bytes.write puts there shows up
+        // through the view as well.
+        Bytes* bytes = GetBytes(o);
+        return PyBuffer_FillInfo(view, o, bytes->Pointer(), bytes->Length(), 1, flags);
+    }
+
+    PyObject* PythonUtils::TiBytesToPyObject(ValueRef v)
+    {
+        PyLockGIL lock;
+        PyTiObject* obj = PyObject_New(PyTiObject, &PyTiBytesType);
+        obj->value = new ValueRef(v);
+        return (PyObject*) obj;
+    }
+
     PyObject* PythonUtils::TiMethodToPyObject(ValueRef v)
     {
         PyLockGIL lock;
@@ -25,6 +25,7 @@ namespace tide
         static PyObject* TiObjectToPyObject(ValueRef o);
         static PyObject* TiMethodToPyObject(ValueRef o);
         static PyObject* TiListToPyObject(ValueRef o);
+        static PyObject* TiBytesToPyObject(ValueRef o);
         static std::string PythonErrorToString();
 
     private:
@@ -13,9 +13,25 @@
 
 namespace tide
 {
+    // Cached script sources are kept alive by this hash for as long as
+    // they are in the code cache of the evaluator.
+    static VALUE compiledScripts = Qnil;
+
+    static void ReleaseCompiledScript(VALUE script)
+    {
+        rb_hash_delete(compiledScripts, script);
+    }
+
     RubyEvaluator::RubyEvaluator() :
-        StaticBoundObject("Ruby.Evaluator")
+        StaticBoundObject("Ruby.Evaluator"),
+        codeCache(&ReleaseCompiledScript)
     {
+        if (compiledScripts == Qnil)
+        {
+            compiledScripts = rb_hash_new();
+            rb_gc_register_address(&compiledScripts);
+        }
+
         /**
          * @notiapi(method=True,name=Ruby.canEvaluate,since=0.7)
          * @notiarg[String, mimeType] Code mime type
@@ -32,12 +48,34 @@ namespace tide
          * @notiresult[Any] result of the evaluation
          */
         SetMethod("evaluate", &RubyEvaluator::Evaluate);
+
+        // Declare the mime type, so that Script can dispatch to us
+        // without calling canEvaluate.
+        TiListRef mimeTypes(new StaticBoundList());
+        mimeTypes->Append(Value::NewString("text/ruby"));
+        SetList("mimeTypes", mimeTypes);
+
+        /**
+         * @notiapi(method=True,name=Ruby.getCacheStats,since=1.4)
+         * @notiresult[Object] hits, misses, evictions and size of the compiled code cache
+         */
+        SetMethod("getCacheStats", &RubyEvaluator::GetCacheStats);
     }
 
     RubyEvaluator::~RubyEvaluator()
     {
     }
 
+    void RubyEvaluator::ClearCache()
+    {
+        codeCache.Clear();
+    }
+
+    void RubyEvaluator::GetCacheStats(const ValueList& args, ValueRef result)
+    {
+        result->SetObject(codeCache.GetStats());
+    }
+
     static TiObjectRef global_object;
     static VALUE m_missing(int argc, VALUE* argv, VALUE self)
     {
@@ -124,10 +162,60 @@ namespace tide
         // use any Ruby code block that was passed. See:
         // http://banisterfiend.wordpress.com/2008/09/25/metaprogramming-in-the-ruby-c-api-part-one-blocks/
         VALUE ctx = rb_ary_shift(args);
-        VALUE code = rb_ary_shift(args);
-        return rb_funcall(ctx, rb_intern("instance_eval"), 1, code);
+        VALUE script = rb_ary_shift(args);
+        VALUE name = rb_ary_shift(args);
+        return rb_funcall(ctx, rb_intern("instance_eval"), 3,
+            script, name, INT2FIX(1));
     }
-    
+
+    static void LogEvaluationError(const std::string& name)
+    {
+        std::string error("An error occured while parsing Ruby (");
+        error += name;
+        error += "): ";
+
+        // Display a stringified version of the exception.
+        VALUE exception = rb_gv_get("$!");
+        ValueRef v = RubyUtils::ToTiValue(exception);
+        SharedString ss = v->DisplayString();
+        error.append(ss->c_str());
+
+        // Try to make a nice backtrace for the user.
+        VALUE backtrace = rb_funcall(exception,
+            rb_intern("backtrace"), 0);
+        VALUE rBacktraceString = rb_funcall(backtrace,
+            rb_intern("join"), 1, rb_str_new2("\n"));
+        if (TYPE(rBacktraceString) == T_STRING)
+        {
+            error.append("\n");
+            error.append(StringValuePtr(rBacktraceString));
+        }
+
+        Logger *logger = Logger::Get("Ruby");
+        logger->Error(error);
+    }
+
+    VALUE RubyEvaluator::Compile(const std::string& name, const std::string& code)
+    {
+        // Ruby 1.8 parses a string each time it is evaluated, and wrapping
+        // the script in a block to keep the parse tree would change what it
+        // means: a block passed to instance_eval keeps the lexical scope of
+        // the wrapper, so constants and classes would land on Object and be
+        // shared by every window, and __END__ would cut the wrapper short.
+        // The script is still evaluated as a string on its context, so all
+        // that is kept here is the frozen Ruby copy of the source.
+        std::string key(CodeCache<VALUE>::GetKey(name, code));
+        VALUE script;
+        if (codeCache.Get(key, script))
+            return script;
+
+        script = rb_str_new(code.data(), code.size());
+        rb_obj_freeze(script);
+        rb_hash_aset(compiledScripts, script, Qtrue);
+        codeCache.Put(key, script);
+        return script;
+    }
+
     void RubyEvaluator::CanEvaluate(const ValueList& args, ValueRef result)
     {
         args.VerifyException("canEvaluate", "s");
@@ -145,10 +233,12 @@ namespace tide
         global_object = args.GetObject(3);
 
         VALUE ctx = this->GetContext(global_object);
+        VALUE script = this->Compile(name, code);
 
         VALUE rargs = rb_ary_new();
         rb_ary_push(rargs, ctx);
-        rb_ary_push(rargs, rb_str_new2(code.c_str()));
+        rb_ary_push(rargs, script);
+        rb_ary_push(rargs, rb_str_new2(name.c_str()));
 
         int error;
         VALUE returnValue = rb_protect(reval_do_call, rargs, &error);
@@ -156,30 +246,7 @@ namespace tide
 
         if (error != 0)
         {
-            std::string error("An error occured while parsing Ruby (");
-            error += name;
-            error += "): ";
-
-            // Display a stringified version of the exception.
-            VALUE exception = rb_gv_get("$!");
-            ValueRef v = RubyUtils::ToTiValue(exception);
-            SharedString ss = v->DisplayString();
-            error.append(ss->c_str());
-
-            // Try to make a nice backtrace for the user.
-            VALUE backtrace = rb_funcall(exception,
-                rb_intern("backtrace"), 0);
-            VALUE rBacktraceString = rb_funcall(backtrace,
-                rb_intern("join"), 1, rb_str_new2("\n"));
-            if (TYPE(rBacktraceString) == T_STRING)
-            {
-                error.append("\n");
-                error.append(StringValuePtr(rBacktraceString));
-            }
-
-            Logger *logger = Logger::Get("Ruby");
-            logger->Error(error);
-
+            LogEvaluationError(name);
             result->SetUndefined();
             return;
         }
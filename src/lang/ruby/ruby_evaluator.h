@@ -19,11 +19,18 @@ namespace tide
 
         void CanEvaluate(const ValueList& args, ValueRef result);
         void Evaluate(const ValueList& args, ValueRef result);
+        void GetCacheStats(const ValueList& args, ValueRef result);
+
+        // Must be called before the interpreter is cleaned up.
+        void ClearCache();
 
         private:
+        CodeCache<VALUE> codeCache;
+
         std::string GetContextId(TiObjectRef global);
         VALUE GetContext(TiObjectRef global);
         void ContextToGlobal(VALUE ctx, TiObjectRef o);
+        VALUE Compile(const std::string& name, const std::string& code);
     };
 }
 
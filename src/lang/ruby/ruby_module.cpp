@@ -45,6 +45,9 @@ namespace tide
         TiObjectRef global = this->host->GetGlobalObject();
         global->Set("Ruby", Value::Undefined);
         Script::GetInstance()->RemoveScriptEvaluator(this->binding);
+
+        // Release cached code while the interpreter is still alive.
+        this->binding.cast<RubyEvaluator>()->ClearCache();
         this->binding = NULL;
         RubyModule::instance_ = NULL;
 
@@ -24,6 +24,9 @@ namespace tide
          * @tiapi - canPreprocess(String mimeType), returns true or false.
          * @tiapi - evaluate(String mimeType, String name, String sourceCode, Object scope), returns result of evaluation
          * @tiapi - preprocess(String url, Object scope), returns preprocessed content.
+         * @tiapi Evaluators may instead declare what they handle with a mimeTypes property (an Array of mime types)
+         * @tiapi and an extensions property (an Array of URL extensions, without the leading dot). Evaluators that
+         * @tiapi do so are dispatched by table lookup, and their canEvaluate and canPreprocess methods are not called.
          * @tiarg[Object, evaluator] The evaluator to add
          */
         this->SetMethod("addScriptEvaluator", &ScriptBinding::_AddScriptEvaluator);
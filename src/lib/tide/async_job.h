@@ -48,6 +48,12 @@ namespace tide
          */
         void Cancel();
 
+        /**
+         * Whether Cancel has been called on this job. Long running
+         * jobs should check this and stop early.
+         */
+        bool IsCancelled() { return this->cancelled; }
+
         /**
          * The result of the execution of this job. On an execution
          * error and before the job is completed this will be Undefined;
@@ -24,6 +24,7 @@ namespace tide
 #include "list.h"
 #include "value.h"
 #include "static_bound_list.h"
+#include "vector_list.h"
 #include "static_bound_method.h"
 #include "static_bound_object.h"
 #include "function_ptr_method.h"
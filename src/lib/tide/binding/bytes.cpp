@@ -7,38 +7,213 @@
  **/
 
 #include "bytes.h"
+#include <algorithm>
+#include <climits>
 #include <cstring>
-#include <Poco/String.h>
-#include <Poco/StringTokenizer.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BYTES_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define BYTES_USE_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace tide
 {
+    static const size_t NOT_FOUND = (size_t) -1;
+
+#if defined(BYTES_USE_SSE2) || defined(BYTES_USE_AVX2)
+    static inline int LowestBit(unsigned int mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (int) index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+#endif
+
+    // Find the first occurrence of a byte, comparing a vector at a time.
+    static size_t FindByte(const char* data, size_t length, char c)
+    {
+        size_t i = 0;
+#ifdef BYTES_USE_AVX2
+        __m256i wide = _mm256_set1_epi8(c);
+        for (; i + 32 <= length; i += 32)
+        {
+            __m256i block = _mm256_loadu_si256((const __m256i*) (data + i));
+            unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, wide));
+            if (mask)
+                return i + LowestBit(mask);
+        }
+#endif
+#ifdef BYTES_USE_SSE2
+        __m128i narrow = _mm_set1_epi8(c);
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i block = _mm_loadu_si128((const __m128i*) (data + i));
+            unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, narrow));
+            if (mask)
+                return i + LowestBit(mask);
+        }
+#endif
+        const void* found = memchr(data + i, c, length - i);
+        return found ? static_cast<const char*>(found) - data : NOT_FOUND;
+    }
+
+    // Find the first occurrence of needle. Candidate positions are found
+    // by matching the first and last byte of the needle a vector at a
+    // time, and only those are compared in full.
+    static size_t FindBytes(const char* data, size_t length,
+        const char* needle, size_t needleLength)
+    {
+        if (needleLength == 0)
+            return 0;
+        if (needleLength > length)
+            return NOT_FOUND;
+        if (needleLength == 1)
+            return FindByte(data, length, needle[0]);
+
+        const char first = needle[0];
+        const char last = needle[needleLength - 1];
+        const size_t middleLength = needleLength - 2;
+        const size_t positions = length - needleLength + 1;
+        size_t i = 0;
+
+#ifdef BYTES_USE_AVX2
+        __m256i firstWide = _mm256_set1_epi8(first);
+        __m256i lastWide = _mm256_set1_epi8(last);
+        for (; i + 32 <= positions; i += 32)
+        {
+            __m256i a = _mm256_loadu_si256((const __m256i*) (data + i));
+            __m256i b = _mm256_loadu_si256((const __m256i*) (data + i + needleLength - 1));
+            unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(
+                _mm256_cmpeq_epi8(a, firstWide), _mm256_cmpeq_epi8(b, lastWide)));
+            while (mask)
+            {
+                size_t candidate = i + LowestBit(mask);
+                if (memcmp(data + candidate + 1, needle + 1, middleLength) == 0)
+                    return candidate;
+                mask &= mask - 1;
+            }
+        }
+#endif
+#ifdef BYTES_USE_SSE2
+        __m128i firstNarrow = _mm_set1_epi8(first);
+        __m128i lastNarrow = _mm_set1_epi8(last);
+        for (; i + 16 <= positions; i += 16)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*) (data + i));
+            __m128i b = _mm_loadu_si128((const __m128i*) (data + i + needleLength - 1));
+            unsigned int mask = _mm_movemask_epi8(_mm_and_si128(
+                _mm_cmpeq_epi8(a, firstNarrow), _mm_cmpeq_epi8(b, lastNarrow)));
+            while (mask)
+            {
+                size_t candidate = i + LowestBit(mask);
+                if (memcmp(data + candidate + 1, needle + 1, middleLength) == 0)
+                    return candidate;
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; i < positions; i++)
+        {
+            if (data[i] == first && data[i + needleLength - 1] == last &&
+                memcmp(data + i + 1, needle + 1, middleLength) == 0)
+                return i;
+        }
+        return NOT_FOUND;
+    }
+
+    // Find the last occurrence of needle which starts at or before start.
+    static size_t FindLastBytes(const char* data, size_t length,
+        const char* needle, size_t needleLength, size_t start)
+    {
+        if (needleLength > length)
+            return NOT_FOUND;
+
+        size_t i = std::min(start, length - needleLength);
+        if (needleLength == 0)
+            return i;
+
+        const char first = needle[0];
+        while (true)
+        {
+            if (data[i] == first && memcmp(data + i, needle, needleLength) == 0)
+                return i;
+            if (i == 0)
+                return NOT_FOUND;
+            i--;
+        }
+    }
+
+    // ASCII case mapping. Bytes outside of A-Z (or a-z when mapping to
+    // upper case) are copied unchanged, like toupper/tolower in the C locale.
+    static void MapCase(const char* in, char* out, size_t length, bool upper)
+    {
+        const unsigned char low = upper ? 'a' : 'A';
+        size_t i = 0;
+#ifdef BYTES_USE_SSE2
+        // Shift the range to be mapped down to the bottom of the signed
+        // byte range, so one signed comparison tests both of its ends.
+        __m128i shift = _mm_set1_epi8((char) (0x80 - low));
+        __m128i bound = _mm_set1_epi8((char) (-128 + 26));
+        __m128i flip = _mm_set1_epi8(0x20);
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i block = _mm_loadu_si128((const __m128i*) (in + i));
+            __m128i inRange = _mm_cmplt_epi8(_mm_add_epi8(block, shift), bound);
+            block = _mm_xor_si128(block, _mm_and_si128(inRange, flip));
+            _mm_storeu_si128((__m128i*) (out + i), block);
+        }
+#endif
+        for (; i < length; i++)
+        {
+            unsigned char c = in[i];
+            out[i] = (unsigned char) (c - low) < 26 ? c ^ 0x20 : c;
+        }
+    }
+
     Bytes::Bytes() :
         StaticBoundObject("Bytes"),
         buffer(0),
-        size(0)
+        size(0),
+        external(false)
     {
         this->SetupBinding();
     }
 
     Bytes::Bytes(size_t size) :
         StaticBoundObject("Bytes"),
-        size(size)
+        size(size),
+        external(false)
     {
         this->buffer = new char[size];
         this->SetupBinding();
     }
 
     Bytes::Bytes(BytesRef source, size_t offset, size_t length) :
-        StaticBoundObject("Bytes")
+        StaticBoundObject("Bytes"),
+        external(false)
     {
-        this->size = (length > 0) ? length : source->Length() - offset;
+        this->size = (length != (size_t) -1) ? length : source->Length() - offset;
         this->buffer = source->Pointer() + offset;
         this->source = source;
         this->SetupBinding();
     }
 
-    Bytes::Bytes(std::string& str) : StaticBoundObject("Bytes")
+    Bytes::Bytes(std::string& str) :
+        StaticBoundObject("Bytes"),
+        external(false)
     {
         this->size = str.length();
         this->buffer = new char[this->size];
@@ -47,23 +222,34 @@ namespace tide
     }
 
     Bytes::Bytes(const char* str, size_t length) :
-        StaticBoundObject("Bytes")
+        StaticBoundObject("Bytes"),
+        external(false)
     {
-        this->size = (length > 0) ? length : strlen(str);
+        this->size = (length != (size_t) -1) ? length : strlen(str);
         this->buffer = new char[this->size];
         memcpy(this->buffer, str, this->size);
         this->SetupBinding();
     }
 
+    Bytes::Bytes(const char* type, char* buffer, size_t size) :
+        StaticBoundObject(type),
+        buffer(buffer),
+        size(size),
+        external(true)
+    {
+        this->SetupBinding();
+    }
+
     Bytes::~Bytes()
     {
-        if (this->source.isNull() && this->buffer)
+        if (this->source.isNull() && this->buffer && !this->external)
             delete [] this->buffer;
     }
 
     size_t Bytes::ExtraMemoryCost()
     {
-        return this->size;
+        // Slices share the memory of their source.
+        return this->source.isNull() ? this->size : 0;
     }
 
     size_t Bytes::Write(const char* data, size_t length, size_t offset)
@@ -96,6 +282,7 @@ namespace tide
         this->SetMethod("charAt", &Bytes::_CharAt);
         this->SetMethod("byteAt", &Bytes::_ByteAt);
         this->SetMethod("split", &Bytes::_Split);
+        this->SetMethod("splitBytes", &Bytes::_SplitBytes);
         this->SetMethod("substring", &Bytes::_Substring);
         this->SetMethod("substr", &Bytes::_Substr);
         this->SetMethod("toLowerCase", &Bytes::_ToLowerCase);
@@ -142,19 +329,25 @@ namespace tide
         // https://developer.mozilla.org/en/Core_JavaScript_1.5_Reference/Global_Objects/String/indexOf
         args.VerifyException("Bytes.indexOf", "s,?i");
 
-        std::string target(this->AsString());
+        std::string needle(args.GetString(0));
         int start = args.GetInt(1, 0);
         if (start < 0) start = 0;
-         size_t pos = target.find(args.GetString(0), start);
 
-        if (pos == std::string::npos)
+        size_t pos = NOT_FOUND;
+        if ((size_t) start <= this->size)
+        {
+            pos = FindBytes(this->buffer + start, this->size - start,
+                needle.data(), needle.size());
+        }
+
+        if (pos == NOT_FOUND)
         {
             // No matches found
             result->SetInt(-1);
         }
         else
         {
-            result->SetInt(pos);
+            result->SetInt(pos + start);
         }
     }
 
@@ -163,12 +356,13 @@ namespace tide
         // https://developer.mozilla.org/en/Core_JavaScript_1.5_Reference/Global_Objects/String/lastIndexOf
         args.VerifyException("Bytes.lastIndexOf", "s,?i");
 
-        std::string target(this->AsString());
-        int start = args.GetInt(1, target.length() + 1);
+        std::string needle(args.GetString(0));
+        int start = args.GetInt(1, this->size + 1);
         if (start < 0) start = 0;
-        size_t pos = target.rfind(args.GetString(0), start);
+        size_t pos = FindLastBytes(this->buffer, this->size,
+            needle.data(), needle.size(), start);
 
-        if (pos == std::string::npos)
+        if (pos == NOT_FOUND)
         {
             // No matches found
             result->SetInt(-1);
@@ -210,59 +404,66 @@ namespace tide
         // https://developer.mozilla.org/en/Core_JavaScript_1.5_Reference/Global_Objects/String/split
         // Except support for regular expressions
         args.VerifyException("Bytes.split", "?s,i");
+        result->SetList(this->Split(args, false));
+    }
 
-        TiListRef list = new StaticBoundList();
-        result->SetList(list);
+    void Bytes::_SplitBytes(const ValueList& args, ValueRef result)
+    {
+        // Like split, but the pieces are Bytes slices which share
+        // this object's memory instead of being copied into strings.
+        args.VerifyException("Bytes.splitBytes", "?s,i");
+        result->SetList(this->Split(args, true));
+    }
 
-        std::string target = "";
-        if (this->size > 0)
-        {
-            target = this->buffer;
-        }
-        else
-        {
-            list->Append(Value::NewString(target));
-            return;
-        }
+    ValueRef Bytes::Piece(size_t offset, size_t length, bool slices)
+    {
+        if (slices)
+            return Value::NewObject(new Bytes(BytesRef(this, true), offset, length));
 
-        if (args.size() <= 0)
+        std::string piece(this->buffer + offset, length);
+        return Value::NewString(piece);
+    }
+
+    TiListRef Bytes::Split(const ValueList& args, bool slices)
+    {
+        TiListRef list = new StaticBoundList();
+        if (this->size == 0 || args.size() <= 0)
         {
-            list->Append(Value::NewString(target));
-            return;
+            list->Append(this->Piece(0, this->size, slices));
+            return list;
         }
 
         std::string separator = args.GetString(0);
+        size_t limit = std::max(args.GetInt(1, INT_MAX), 0);
 
-        int limit = args.GetInt(1, INT_MAX);
+        // An empty separator splits every byte.
+        if (separator.empty())
+        {
+            for (size_t i = 0; i < this->size && list->Size() < limit; i++)
+                list->Append(this->Piece(i, 1, slices));
+            return list;
+        }
 
         // We could use Poco's tokenizer here, but it doesn't split strings
         // like "abc,def,," -> ['abc', 'def', '', ''] correctly. It produces
         // ['abc', 'def', ''] which is a different behavior than the JS split.
-        // So we roll our own for now -- it's not very efficient right now, but
-        // it should be correct.
-        size_t next = target.find(separator);
-        while (target.size() > 0 && next != std::string::npos)
+        // Every byte is visited once, since each search resumes where the
+        // previous one ended.
+        size_t start = 0;
+        while (list->Size() < limit)
         {
-            std::string token;
-            if (separator.size() == 0)
-            {
-                token = target.substr(0, 1);
-            }
-            else
+            size_t next = FindBytes(this->buffer + start, this->size - start,
+                separator.data(), separator.size());
+            if (next == NOT_FOUND)
             {
-                token = target.substr(0, next);
+                list->Append(this->Piece(start, this->size - start, slices));
+                break;
             }
-            target = target.substr(next + 1);
-            next = target.find(separator);
-
-            if ((int) list->Size() >= limit)
-                return;
 
-            list->Append(Value::NewString(token));
+            list->Append(this->Piece(start, next, slices));
+            start += next + separator.size();
         }
-
-        if ((int) list->Size() < limit && separator.size() != 0)
-            list->Append(Value::NewString(target));
+        return list;
     }
 
     void Bytes::_Substr(const ValueList& args, ValueRef result)
@@ -270,28 +471,27 @@ namespace tide
         // This method now follows the spec located at:
         // https://developer.mozilla.org/en/Core_JavaScript_1.5_Reference/Global_Objects/String/substr
         args.VerifyException("Bytes.substr", "i,?i");
-        std::string target(this->buffer, this->size);
 
         int start = args.GetInt(0);
-        if (start > 0 && start >= (int)target.length())
+        if (start > 0 && start >= (int) this->size)
         {
             result->SetString("");
             return;
         }
 
-        if (start < 0 && (-1*start) > (int)target.length())
+        if (start < 0 && (-1*start) > (int) this->size)
         {
             start = 0;
         }
         else if (start < 0)
         {
-            start = target.length() + start;
+            start = this->size + start;
         }
 
-        long length = target.length() - start;
+        long length = this->size - start;
         if (args.size() > 1)
         {
-            length = args.GetInt(1);
+            length = std::min((long) args.GetInt(1), length);
         }
 
         if (length <= 0)
@@ -300,7 +500,7 @@ namespace tide
             return;
         }
 
-        std::string r = target.substr(start, length);
+        std::string r(this->buffer + start, length);
         result->SetString(r);
     }
 
@@ -309,53 +509,40 @@ namespace tide
         // This method now follows the spec located at:
         // https://developer.mozilla.org/en/Core_JavaScript_1.5_Reference/Global_Objects/String/substring
         args.VerifyException("Bytes.substring", "i,?i");
-        std::string target = "";
-        if (this->size > 0)
-        {
-            target = this->buffer;
-        }
 
         long indexA = args.GetInt(0);
         if (indexA < 0)
             indexA = 0;
-        if (indexA > (long) target.size())
-            indexA = target.size();
+        if (indexA > (long) this->size)
+            indexA = this->size;
 
-        if (args.size() < 2)
-        {
-            std::string r = target.substr(indexA);
-            result->SetString(r);
-        }
-        else
+        long indexB = this->size;
+        if (args.size() > 1)
         {
-            long indexB = args.GetInt(1);
+            indexB = args.GetInt(1);
             if (indexB < 0)
                 indexB = 0;
-            if (indexB > (long) target.size())
-                indexB = target.size();
+            if (indexB > (long) this->size)
+                indexB = this->size;
+        }
 
-            if (indexA == indexB)
-            {
-                result->SetString("");
-                return;
-            }
-            if (indexA > indexB)
-            {
-                long temp = indexA;
-                indexA = indexB;
-                indexB = temp;
-            }
-            std::string r = target.substr(indexA, indexB - indexA);
-            result->SetString(r);
+        if (indexA > indexB)
+        {
+            long temp = indexA;
+            indexA = indexB;
+            indexB = temp;
         }
+
+        std::string r(this->buffer + indexA, indexB - indexA);
+        result->SetString(r);
     }
 
     void Bytes::_ToLowerCase(const ValueList& args, ValueRef result)
     {
         if (this->size > 0)
         {
-            std::string target(this->buffer, this->size);
-            std::string r = Poco::toLower(target);
+            std::string r(this->size, '\0');
+            MapCase(this->buffer, &r[0], this->size, false);
             result->SetString(r);
         }
         else
@@ -368,8 +555,8 @@ namespace tide
     {
         if (this->size > 0)
         {
-            std::string target(this->buffer, this->size);
-            std::string r = Poco::toUpper(target);
+            std::string r(this->size, '\0');
+            MapCase(this->buffer, &r[0], this->size, true);
             result->SetString(r);
         }
         else
@@ -57,6 +57,11 @@ namespace tide
 
         static BytesRef Concat(std::vector<BytesRef>& bytes);
 
+    protected:
+        // Wrap storage that is owned by a subclass, for instance a
+        // memory-mapped file. The subclass must release it itself.
+        Bytes(const char* type, char* buffer, size_t size);
+
     private:
         // Binding methods
         void SetupBinding();
@@ -67,6 +72,7 @@ namespace tide
         void _CharAt(const ValueList& args, ValueRef result);
         void _ByteAt(const ValueList& args, ValueRef result);
         void _Split(const ValueList& args, ValueRef result);
+        void _SplitBytes(const ValueList& args, ValueRef result);
         void _Substr(const ValueList& args, ValueRef result);
         void _Substring(const ValueList& args, ValueRef result);
         void _ToLowerCase(const ValueList& args, ValueRef result);
@@ -75,9 +81,13 @@ namespace tide
         void _Concat(const ValueList& args, ValueRef result);
         void _Slice(const ValueList& args, ValueRef result);
 
+        TiListRef Split(const ValueList& args, bool slices);
+        ValueRef Piece(size_t offset, size_t length, bool slices);
+
         char* buffer;
         size_t size;
         BytesRef source;
+        bool external;
     };
 }
 
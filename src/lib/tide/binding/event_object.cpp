@@ -73,6 +73,19 @@ namespace tide
         this->listeners.clear();
     }
 
+    bool EventObject::HasEventListeners(const char* event)
+    {
+        Poco::FastMutex::ScopedLock lock(this->listenersMutex);
+
+        EventListenerList::iterator i = this->listeners.begin();
+        while (i != this->listeners.end())
+        {
+            if ((*i++)->Handles(event))
+                return true;
+        }
+        return false;
+    }
+
     void EventObject::FireEvent(const char* event)
     {
         FireEvent(event, ValueList());
@@ -29,6 +29,7 @@ namespace tide
         virtual void AddEventListener(std::string& event, TiMethodRef listener);
         virtual void RemoveEventListener(std::string& event, TiMethodRef listener);
         virtual void RemoveAllEventListeners();
+        bool HasEventListeners(const char* event);
 
         void FireEvent(const char* event);
         virtual void FireEvent(const char* event, const ValueList& args);
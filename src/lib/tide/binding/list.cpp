@@ -32,6 +32,23 @@ namespace tide
         }
     }
 
+    TiListRef TiList::SnapshotList()
+    {
+        TiListRef snapshot(this->Snapshot().cast<TiList>());
+        if (snapshot.isNull())
+            return TiListRef(this, true);
+        return snapshot;
+    }
+
+    void TiList::GetValues(std::vector<ValueRef>& values)
+    {
+        unsigned int size = this->Size();
+        values.clear();
+        values.reserve(size);
+        for (unsigned int i = 0; i < size; i++)
+            values.push_back(this->At(i));
+    }
+
     SharedString TiList::DisplayString(int levels)
     {
         std::ostringstream oss;
@@ -82,6 +82,20 @@ namespace tide
          */
         void ResizeTo(unsigned int size);
 
+        /**
+         * @see TiObject::Snapshot
+         * @return a list which can be read without calls into a script engine
+         */
+        TiListRef SnapshotList();
+
+        /**
+         * Copy every element of this list into values, replacing its
+         * contents. Lists which don't keep their elements in an array
+         * override this to gather them in one pass instead of one At()
+         * lookup per index.
+         */
+        virtual void GetValues(std::vector<ValueRef>& values);
+
         /**
          * @return a string representation of this object
          */
@@ -21,6 +21,11 @@ namespace tide
         return other.get() == this;
     }
 
+    TiObjectRef TiObject::Snapshot()
+    {
+        return TiObjectRef(this, true);
+    }
+
     bool TiObject::HasProperty(const char* name)
     {
         SharedStringList names = this->GetPropertyNames();
@@ -83,6 +83,14 @@ namespace tide
          */
         virtual size_t ExtraMemoryCost() { return 0; }
 
+        /**
+         * Objects which proxy an object in a script engine return a
+         * native copy of it, made in one pass, so that it can be read
+         * without calling back into the engine for every property.
+         * Native objects return themselves.
+         */
+        virtual TiObjectRef Snapshot();
+
         /**
          * @param name The property name
          * @param value The new property value
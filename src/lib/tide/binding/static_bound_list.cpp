@@ -9,6 +9,7 @@
 #include "../tide.h"
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
 namespace tide
@@ -58,6 +59,23 @@ namespace tide
         return this->length;
     }
 
+    void StaticBoundList::GetValues(std::vector<ValueRef>& values)
+    {
+        values.assign(this->length, Value::Undefined);
+
+        Poco::Mutex::ScopedLock lock(this->object->mutex);
+        std::map<std::string, ValueRef>::iterator i = this->object->properties.begin();
+        for (; i != this->object->properties.end(); i++)
+        {
+            if (i->first.empty() || !TiList::IsInt(i->first))
+                continue;
+
+            unsigned long index = strtoul(i->first.c_str(), NULL, 10);
+            if (index < this->length)
+                values[index] = i->second;
+        }
+    }
+
     ValueRef StaticBoundList::At(unsigned int index)
     {
         std::string name = TiList::IntToChars(index);
@@ -70,6 +70,11 @@ namespace tide
          */
         virtual SharedStringList GetPropertyNames();
 
+        /**
+         * Gather the elements with a single pass over the property map.
+         */
+        virtual void GetValues(std::vector<ValueRef>& values);
+
     protected:
         AutoPtr<StaticBoundObject> object;
         unsigned int length;
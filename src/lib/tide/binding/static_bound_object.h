@@ -69,6 +69,9 @@ namespace tide
         std::map<std::string, ValueRef> properties;
         Poco::Mutex mutex;
 
+        // Reads the properties directly to gather its elements in bulk.
+        friend class StaticBoundList;
+
     private:
         DISALLOW_EVIL_CONSTRUCTORS(StaticBoundObject);
     };
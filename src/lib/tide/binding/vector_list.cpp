@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors 
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include "../tide.h"
+#include <cstdlib>
+
+namespace tide
+{
+    VectorList::VectorList(const char *type) :
+        TiList(type),
+        object(new StaticBoundObject())
+    {
+    }
+
+    VectorList::~VectorList()
+    {
+    }
+
+    void VectorList::Reserve(unsigned int size)
+    {
+        this->values.reserve(size);
+    }
+
+    void VectorList::Append(ValueRef value)
+    {
+        this->values.push_back(value);
+    }
+
+    unsigned int VectorList::Size()
+    {
+        return (unsigned int) this->values.size();
+    }
+
+    ValueRef VectorList::At(unsigned int index)
+    {
+        if (index >= this->values.size())
+            return Value::Undefined;
+        return this->values[index];
+    }
+
+    void VectorList::GetValues(std::vector<ValueRef>& values)
+    {
+        values = this->values;
+    }
+
+    void VectorList::SetAt(unsigned int index, ValueRef value)
+    {
+        if (index >= this->values.size())
+            this->values.resize(index + 1, Value::Undefined);
+        this->values[index] = value;
+    }
+
+    bool VectorList::Remove(unsigned int index)
+    {
+        if (index >= this->values.size())
+            return false;
+
+        this->values.erase(this->values.begin() + index);
+        return true;
+    }
+
+    void VectorList::Set(const char *name, ValueRef value)
+    {
+        int index = -1;
+        if (TiList::IsInt(name) && (index = atoi(name)) >= 0)
+        {
+            this->SetAt(index, value);
+        }
+        else
+        {
+            this->object->Set(name, value);
+        }
+    }
+
+    ValueRef VectorList::Get(const char *name)
+    {
+        int index = -1;
+        if (TiList::IsInt(name) && (index = atoi(name)) >= 0)
+            return this->At(index);
+
+        return this->object->Get(name);
+    }
+
+    SharedStringList VectorList::GetPropertyNames()
+    {
+        SharedStringList names(this->object->GetPropertyNames());
+        for (size_t i = 0; i < this->values.size(); i++)
+            names->push_back(new std::string(TiList::IntToChars(i)));
+        return names;
+    }
+}
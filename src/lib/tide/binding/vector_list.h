@@ -0,0 +1,48 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors 
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _VECTOR_LIST_H_
+#define _VECTOR_LIST_H_
+
+#include <vector>
+
+namespace tide
+{
+    /**
+     * A list which keeps its elements in a vector, so that indexing
+     * is a plain array access. Properties which aren't indices are
+     * kept in a separate object, as StaticBoundList does.
+     */
+    class TIDE_API VectorList : public TiList
+    {
+    public:
+        VectorList(const char *type = "VectorList");
+        virtual ~VectorList();
+
+        void Reserve(unsigned int size);
+
+        virtual void Append(ValueRef value);
+        virtual unsigned int Size();
+        virtual ValueRef At(unsigned int index);
+        virtual void SetAt(unsigned int index, ValueRef value);
+        virtual bool Remove(unsigned int index);
+        virtual void Set(const char *name, ValueRef value);
+        virtual ValueRef Get(const char *name);
+        virtual SharedStringList GetPropertyNames();
+        virtual void GetValues(std::vector<ValueRef>& values);
+
+    protected:
+        std::vector<ValueRef> values;
+        AutoPtr<StaticBoundObject> object;
+
+    private:
+        DISALLOW_EVIL_CONSTRUCTORS(VectorList);
+    };
+}
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _CODE_CACHE_H_
+#define _CODE_CACHE_H_
+
+#include <list>
+#include <map>
+#include <string>
+
+#include <Poco/Mutex.h>
+#include <Poco/Timestamp.h>
+#include <tideutils/data_utils.h>
+
+namespace tide
+{
+    /**
+     * A bounded, least-recently-used cache of compiled script code for
+     * the language evaluators. Entries are keyed by a digest of the
+     * script source, so that a script included in every window is only
+     * compiled once. An entry may also carry the modification time of
+     * the file it was compiled from, and is dropped when a lookup finds
+     * the file has changed since.
+     *
+     * The cache owns its entries and hands each one to the release
+     * callback when it is evicted or the cache is cleared. Callers must
+     * hold whatever interpreter lock the callback needs.
+     */
+    template <class T>
+    class CodeCache
+    {
+    public:
+        typedef void (*ReleaseCallback)(T code);
+
+        CodeCache(ReleaseCallback release, size_t capacity=128) :
+            release(release),
+            capacity(capacity),
+            hits(0),
+            misses(0),
+            evictions(0),
+            invalidations(0)
+        {
+        }
+
+        ~CodeCache()
+        {
+            this->Clear();
+        }
+
+        static std::string GetKey(const std::string& name, const std::string& code)
+        {
+            // The name is part of the key because compiled code
+            // records it for tracebacks and error messages.
+            std::string data(name);
+            data.append(1, '\0');
+            data.append(code);
+            return TideUtils::DataUtils::HexMD5(data);
+        }
+
+        // Look up the code stored under key. When modified is non-zero
+        // an entry stored with a different modification time is stale
+        // and is released instead of returned.
+        bool Get(const std::string& key, T& code, Poco::Timestamp::TimeVal modified=0)
+        {
+            Poco::Mutex::ScopedLock lock(this->mutex);
+            typename EntryMap::iterator i = this->entries.find(key);
+            if (i == this->entries.end())
+            {
+                this->misses++;
+                return false;
+            }
+
+            if (modified != 0 && i->second.modified != modified)
+            {
+                this->Remove(i);
+                this->invalidations++;
+                this->misses++;
+                return false;
+            }
+
+            this->order.splice(this->order.begin(), this->order, i->second.position);
+            this->hits++;
+            code = i->second.code;
+            return true;
+        }
+
+        void Put(const std::string& key, T code, Poco::Timestamp::TimeVal modified=0)
+        {
+            Poco::Mutex::ScopedLock lock(this->mutex);
+            typename EntryMap::iterator i = this->entries.find(key);
+            if (i != this->entries.end())
+                this->Remove(i);
+
+            while (this->capacity > 0 && this->entries.size() >= this->capacity)
+            {
+                this->Remove(this->entries.find(this->order.back()));
+                this->evictions++;
+            }
+
+            this->order.push_front(key);
+            Entry& entry = this->entries[key];
+            entry.code = code;
+            entry.modified = modified;
+            entry.position = this->order.begin();
+        }
+
+        void Clear()
+        {
+            Poco::Mutex::ScopedLock lock(this->mutex);
+            while (!this->entries.empty())
+                this->Remove(this->entries.begin());
+        }
+
+        TiObjectRef GetStats()
+        {
+            Poco::Mutex::ScopedLock lock(this->mutex);
+            TiObjectRef stats(new StaticBoundObject());
+            stats->SetDouble("hits", this->hits);
+            stats->SetDouble("misses", this->misses);
+            stats->SetDouble("evictions", this->evictions);
+            stats->SetDouble("invalidations", this->invalidations);
+            stats->SetInt("size", this->entries.size());
+            stats->SetInt("capacity", this->capacity);
+            return stats;
+        }
+
+    private:
+        struct Entry
+        {
+            T code;
+            Poco::Timestamp::TimeVal modified;
+            std::list<std::string>::iterator position;
+        };
+        typedef std::map<std::string, Entry> EntryMap;
+
+        void Remove(typename EntryMap::iterator i)
+        {
+            T code = i->second.code;
+            this->order.erase(i->second.position);
+            this->entries.erase(i);
+            this->release(code);
+        }
+
+        ReleaseCallback release;
+        size_t capacity;
+        EntryMap entries;
+        std::list<std::string> order;
+        Poco::Mutex mutex;
+        double hits;
+        double misses;
+        double evictions;
+        double invalidations;
+
+        DISALLOW_EVIL_CONSTRUCTORS(CodeCache);
+    };
+}
+
+#endif
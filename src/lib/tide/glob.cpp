@@ -0,0 +1,44 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include "glob.h"
+
+namespace tide
+{
+    bool MatchGlob(const char* pattern, const char* target, bool anyCharacter)
+    {
+        const char* star = 0;
+        const char* resume = 0;
+        while (*target)
+        {
+            if (*pattern == '*')
+            {
+                star = pattern++;
+                resume = target;
+            }
+            else if (*pattern == *target || (anyCharacter && *pattern == '?'))
+            {
+                pattern++;
+                target++;
+            }
+            else if (star)
+            {
+                pattern = star + 1;
+                target = ++resume;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        while (*pattern == '*')
+            pattern++;
+        return *pattern == '\0';
+    }
+}
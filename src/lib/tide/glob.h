@@ -0,0 +1,30 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _GLOB_H_
+#define _GLOB_H_
+
+#include "base.h"
+
+namespace tide
+{
+    /**
+     * Match target against a glob in which '*' stands for any run of
+     * characters and, if anyCharacter is set, '?' for any one character.
+     * Otherwise '?' only matches itself, as it does in userscript URLs.
+     * When a literal run after a '*' fails to match, it is retried one
+     * character further along from where that '*' began matching, and
+     * earlier wildcards are never revisited. That takes time proportional
+     * to the length of the target times the number of wildcards at worst,
+     * instead of backtracking, and never recurses.
+     */
+    TIDE_API bool MatchGlob(const char* pattern, const char* target,
+        bool anyCharacter=false);
+}
+
+#endif
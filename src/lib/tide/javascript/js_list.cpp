@@ -128,4 +128,9 @@ namespace tide
     {
         return this->jsobject;
     }
+
+    TiObjectRef KKJSList::Snapshot()
+    {
+        return JSUtil::ToTiSnapshot(this->jsobject, this->context, NULL)->ToObject();
+    }
 }
@@ -30,6 +30,7 @@ namespace tide
         virtual unsigned int Size();
         virtual ValueRef At(unsigned int index);
         virtual bool Remove(unsigned int index);
+        virtual TiObjectRef Snapshot();
 
         bool SameContextGroup(JSContextRef c);
         JSObjectRef GetJSObject();
@@ -46,6 +46,11 @@ namespace tide
         return this->jsobject;
     }
 
+    TiObjectRef KKJSObject::Snapshot()
+    {
+        return JSUtil::ToTiSnapshot(this->jsobject, this->context, NULL)->ToObject();
+    }
+
     ValueRef KKJSObject::Get(const char *name)
     {
         JSStringRef jsName = JSStringCreateWithUTF8CString(name);
@@ -28,6 +28,7 @@ namespace tide
         virtual SharedStringList GetPropertyNames();
         virtual bool HasProperty(const char* name);
         virtual bool Equals(TiObjectRef);
+        virtual TiObjectRef Snapshot();
 
         bool SameContextGroup(JSContextRef c);
         JSObjectRef GetJSObject();
@@ -13,8 +13,16 @@ using namespace TideUtils;
 
 #include "javascript_module.h"
 
+#include <Poco/File.h>
 #include <Poco/FileStream.h>
 #include <Poco/Mutex.h>
+#include <Poco/Timestamp.h>
+#include <list>
+
+#define WRAPPER_CACHE_CAPACITY 256
+
+// Longer arrays, which are most likely sparse, are proxied instead.
+#define SNAPSHOT_MAX_ARRAY_LENGTH (16 * 1024 * 1024)
 
 namespace tide
 {
@@ -54,6 +62,52 @@ namespace JSUtil
     static bool DoSpecialSetBehavior(ValueRef target, const char* name, ValueRef newValue);
     static JSValueRef GetFunctionPrototype(JSContextRef jsContext, JSValueRef* exception);
     static JSValueRef GetArrayPrototype(JSContextRef jsContext, JSValueRef* exception);
+    static JSValueRef GetObjectPrototype(JSContextRef jsContext, JSValueRef* exception);
+    static JSObjectRef GetCachedWrapper(JSContextRef, void*, JSClassRef);
+    static void CacheWrapper(JSContextRef, void*, JSClassRef, JSObjectRef);
+    static void ClearWrapperCache(JSContextRef, JSObjectRef);
+
+    struct SnapshotState
+    {
+        // Objects seen before, including cycles, map to the same copy.
+        std::map<JSObjectRef, ValueRef> seen;
+        JSValueRef objectPrototype;
+        JSValueRef arrayPrototype;
+    };
+    static ValueRef SnapshotValue(JSValueRef, JSContextRef, JSObjectRef, SnapshotState&);
+
+    // The JS wrappers of native values, kept per global object so that
+    // passing the same value into a context twice yields the same JS
+    // object. Cached wrappers are protected: JSC may sweep a dead wrapper
+    // long after it became unreachable, and handing it out again in the
+    // meantime would resurrect it. Each global object keeps at most
+    // WRAPPER_CACHE_CAPACITY wrappers. The least recently used one is
+    // unprotected to make room, and all of them are unprotected when the
+    // context is registered again or unregistered. An evicted wrapper
+    // stays valid while script holds it, but the next conversion of its
+    // value makes a new one.
+    struct WrapperKey
+    {
+        void* native;
+        JSClassRef jsClass;
+
+        bool operator<(const WrapperKey& other) const
+        {
+            if (native != other.native)
+                return native < other.native;
+            return jsClass < other.jsClass;
+        }
+    };
+    typedef std::list<std::pair<WrapperKey, JSObjectRef> > WrapperList;
+    struct WrapperCache
+    {
+        WrapperList entries; // Most recently used first.
+        std::map<WrapperKey, WrapperList::iterator> index;
+    };
+    static std::map<JSObjectRef, WrapperCache> wrapperCaches;
+    static Poco::Mutex wrapperCacheMutex;
+    static size_t wrapperCacheHits = 0;
+    static size_t wrapperAllocations = 0;
 
     ValueRef ToTiValue(JSValueRef value, JSContextRef jsContext,
         JSObjectRef thisObject)
@@ -139,6 +193,140 @@ namespace JSUtil
         }
     }
 
+    static ValueRef SnapshotString(JSValueRef value, JSContextRef jsContext)
+    {
+        JSValueRef exception = NULL;
+        JSStringRef jsString = JSValueToStringCopy(jsContext, value, &exception);
+        if (!jsString)
+            throw ToTiValue(exception, jsContext, NULL);
+
+        std::string stringValue(ToChars(jsString));
+        JSStringRelease(jsString);
+        return Value::NewString(stringValue);
+    }
+
+    static ValueRef SnapshotArray(JSObjectRef array, JSContextRef jsContext,
+        JSObjectRef thisObject, SnapshotState& state)
+    {
+        JSValueRef exception = NULL;
+        JSStringRef lengthName = JSStringCreateWithUTF8CString("length");
+        JSValueRef lengthValue = JSObjectGetProperty(jsContext, array, lengthName, &exception);
+        JSStringRelease(lengthName);
+        if (exception)
+            throw ToTiValue(exception, jsContext, NULL);
+
+        // NaN fails both comparisons.
+        double lengthNumber = JSValueIsNumber(jsContext, lengthValue) ?
+            JSValueToNumber(jsContext, lengthValue, NULL) : -1;
+        if (!(lengthNumber >= 0 && lengthNumber <= SNAPSHOT_MAX_ARRAY_LENGTH))
+            return ToTiValue(array, jsContext, thisObject);
+
+        AutoPtr<VectorList> list(new VectorList());
+        ValueRef result(Value::NewList(list));
+        state.seen[array] = result;
+
+        unsigned int length = (unsigned int) lengthNumber;
+        list->Reserve(length);
+
+        for (unsigned int i = 0; i < length; i++)
+        {
+            JSValueRef element = JSObjectGetPropertyAtIndex(jsContext, array, i, &exception);
+            if (exception)
+                throw ToTiValue(exception, jsContext, NULL);
+
+            // Numbers and strings make up most large arrays, so they
+            // skip the general conversion.
+            switch (JSValueGetType(jsContext, element))
+            {
+                case kJSTypeNumber:
+                    list->Append(Value::NewDouble(JSValueToNumber(jsContext, element, NULL)));
+                    break;
+                case kJSTypeString:
+                    list->Append(SnapshotString(element, jsContext));
+                    break;
+                default:
+                    list->Append(SnapshotValue(element, jsContext, array, state));
+                    break;
+            }
+        }
+
+        return result;
+    }
+
+    static ValueRef SnapshotObject(JSObjectRef object, JSContextRef jsContext,
+        SnapshotState& state)
+    {
+        TiObjectRef tiObject(new StaticBoundObject());
+        ValueRef result(Value::NewObject(tiObject));
+        state.seen[object] = result;
+
+        JSPropertyNameArrayRef names = JSObjectCopyPropertyNames(jsContext, object);
+        size_t count = JSPropertyNameArrayGetCount(names);
+        try
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                JSStringRef jsName = JSPropertyNameArrayGetNameAtIndex(names, i);
+                JSValueRef exception = NULL;
+                JSValueRef property = JSObjectGetProperty(jsContext, object, jsName, &exception);
+                if (exception)
+                    throw ToTiValue(exception, jsContext, NULL);
+
+                std::string name(ToChars(jsName));
+                tiObject->Set(name.c_str(), SnapshotValue(property, jsContext, object, state));
+            }
+        }
+        catch (...)
+        {
+            JSPropertyNameArrayRelease(names);
+            throw;
+        }
+
+        JSPropertyNameArrayRelease(names);
+        return result;
+    }
+
+    static ValueRef SnapshotValue(JSValueRef value, JSContextRef jsContext,
+        JSObjectRef thisObject, SnapshotState& state)
+    {
+        if (value == NULL || !JSValueIsObject(jsContext, value))
+            return ToTiValue(value, jsContext, thisObject);
+
+        JSObjectRef o = JSValueToObject(jsContext, value, NULL);
+        ValueRef* wrapped = static_cast<ValueRef*>(JSObjectGetPrivate(o));
+        if (wrapped != NULL)
+            return *wrapped;
+
+        std::map<JSObjectRef, ValueRef>::iterator i = state.seen.find(o);
+        if (i != state.seen.end())
+            return i->second;
+
+        // Only plain arrays and objects are copied. Anything else, such
+        // as functions, dates, regular expressions and DOM objects, has
+        // behaviour a copy would lose, so it is still proxied.
+        JSValueRef prototype = JSObjectGetPrototype(jsContext, o);
+        if (JSObjectIsFunction(jsContext, o))
+            return ToTiValue(value, jsContext, thisObject);
+        else if (JSValueIsStrictEqual(jsContext, prototype, state.arrayPrototype))
+            return SnapshotArray(o, jsContext, thisObject, state);
+        else if (JSValueIsStrictEqual(jsContext, prototype, state.objectPrototype))
+            return SnapshotObject(o, jsContext, state);
+        else
+            return ToTiValue(value, jsContext, thisObject);
+    }
+
+    ValueRef ToTiSnapshot(JSValueRef value, JSContextRef jsContext,
+        JSObjectRef thisObject)
+    {
+        // Unlike ToTiValue, arrays and plain objects are copied into
+        // native lists and objects instead of being proxied, so native
+        // code can read them without calling back into JavaScript.
+        SnapshotState state;
+        state.objectPrototype = GetObjectPrototype(jsContext, NULL);
+        state.arrayPrototype = GetArrayPrototype(jsContext, NULL);
+        return SnapshotValue(value, jsContext, thisObject, state);
+    }
+
     JSValueRef ToJSValue(ValueRef value, JSContextRef jsContext)
     {
         JSValueRef jsValue = NULL;
@@ -235,7 +423,15 @@ namespace JSUtil
             jsClassDefinition.setProperty = SetPropertyCallback;
             KJSKObjectClass = JSClassCreate(&jsClassDefinition);
         }
-        return JSObjectMake(jsContext, KJSKObjectClass, new ValueRef(objectValue));
+
+        void* native = objectValue->ToObject().get();
+        JSObjectRef jsobject = GetCachedWrapper(jsContext, native, KJSKObjectClass);
+        if (jsobject)
+            return jsobject;
+
+        jsobject = JSObjectMake(jsContext, KJSKObjectClass, new ValueRef(objectValue));
+        CacheWrapper(jsContext, native, KJSKObjectClass, jsobject);
+        return jsobject;
     }
 
     JSValueRef TiMethodToJSValue(ValueRef methodValue, JSContextRef jsContext)
@@ -252,9 +448,16 @@ namespace JSUtil
             jsClassDefinition.callAsFunction = CallAsFunctionCallback;
             KJSKMethodClass = JSClassCreate(&jsClassDefinition);
         }
-        JSObjectRef jsobject = JSObjectMake(jsContext, KJSKMethodClass, new ValueRef(methodValue));
+
+        void* native = methodValue->ToMethod().get();
+        JSObjectRef jsobject = GetCachedWrapper(jsContext, native, KJSKMethodClass);
+        if (jsobject)
+            return jsobject;
+
+        jsobject = JSObjectMake(jsContext, KJSKMethodClass, new ValueRef(methodValue));
         JSValueRef functionPrototype = GetFunctionPrototype(jsContext, NULL);
         JSObjectSetPrototype(jsContext, jsobject, functionPrototype);
+        CacheWrapper(jsContext, native, KJSKMethodClass, jsobject);
         return jsobject;
     }
 
@@ -273,12 +476,101 @@ namespace JSUtil
             KJSKListClass = JSClassCreate(&jsClassDefinition);
         }
 
-        JSObjectRef jsobject = JSObjectMake(jsContext, KJSKListClass, new ValueRef(listValue));
+        void* native = listValue->ToList().get();
+        JSObjectRef jsobject = GetCachedWrapper(jsContext, native, KJSKListClass);
+        if (jsobject)
+            return jsobject;
+
+        jsobject = JSObjectMake(jsContext, KJSKListClass, new ValueRef(listValue));
         JSValueRef arrayPrototype = GetArrayPrototype(jsContext, NULL);
         JSObjectSetPrototype(jsContext, jsobject, arrayPrototype);
+        CacheWrapper(jsContext, native, KJSKListClass, jsobject);
         return jsobject;
     }
 
+    static JSObjectRef GetCachedWrapper(JSContextRef jsContext, void* native,
+        JSClassRef jsClass)
+    {
+        WrapperKey key;
+        key.native = native;
+        key.jsClass = jsClass;
+
+        Poco::Mutex::ScopedLock lock(wrapperCacheMutex);
+        std::map<JSObjectRef, WrapperCache>::iterator cache =
+            wrapperCaches.find(JSContextGetGlobalObject(jsContext));
+        if (cache == wrapperCaches.end())
+            return NULL;
+
+        std::map<WrapperKey, WrapperList::iterator>::iterator i = cache->second.index.find(key);
+        if (i == cache->second.index.end())
+            return NULL;
+
+        WrapperList& entries = cache->second.entries;
+        entries.splice(entries.begin(), entries, i->second);
+        wrapperCacheHits++;
+        return i->second->second;
+    }
+
+    static void CacheWrapper(JSContextRef jsContext, void* native,
+        JSClassRef jsClass, JSObjectRef jsObject)
+    {
+        WrapperKey key;
+        key.native = native;
+        key.jsClass = jsClass;
+
+        // The lock isn't held while the wrapper is made, since that
+        // may run a garbage collection which finalizes other wrappers.
+        JSValueProtect(jsContext, jsObject);
+
+        Poco::Mutex::ScopedLock lock(wrapperCacheMutex);
+        WrapperCache& cache = wrapperCaches[JSContextGetGlobalObject(jsContext)];
+        std::map<WrapperKey, WrapperList::iterator>::iterator i = cache.index.find(key);
+        if (i != cache.index.end())
+        {
+            JSValueUnprotect(jsContext, i->second->second);
+            cache.entries.erase(i->second);
+            cache.index.erase(i);
+        }
+
+        cache.entries.push_front(std::make_pair(key, jsObject));
+        cache.index[key] = cache.entries.begin();
+        wrapperAllocations++;
+
+        if (cache.entries.size() > WRAPPER_CACHE_CAPACITY)
+        {
+            JSValueUnprotect(jsContext, cache.entries.back().second);
+            cache.index.erase(cache.entries.back().first);
+            cache.entries.pop_back();
+        }
+    }
+
+    static void ClearWrapperCache(JSContextRef jsContext, JSObjectRef globalObject)
+    {
+        Poco::Mutex::ScopedLock lock(wrapperCacheMutex);
+        std::map<JSObjectRef, WrapperCache>::iterator cache = wrapperCaches.find(globalObject);
+        if (cache == wrapperCaches.end())
+            return;
+
+        WrapperList& entries = cache->second.entries;
+        for (WrapperList::iterator i = entries.begin(); i != entries.end(); i++)
+            JSValueUnprotect(jsContext, i->second);
+        wrapperCaches.erase(cache);
+    }
+
+    void GetWrapperCacheStats(size_t& hits, size_t& allocations, size_t& live,
+        size_t& contexts)
+    {
+        Poco::Mutex::ScopedLock lock(wrapperCacheMutex);
+        hits = wrapperCacheHits;
+        allocations = wrapperAllocations;
+        contexts = wrapperCaches.size();
+        live = 0;
+
+        std::map<JSObjectRef, WrapperCache>::iterator i = wrapperCaches.begin();
+        for (; i != wrapperCaches.end(); i++)
+            live += i->second.entries.size();
+    }
+
     std::string ToChars(JSStringRef jsString)
     {
         size_t size = JSStringGetMaximumUTF8CStringSize(jsString);
@@ -662,19 +954,34 @@ namespace JSUtil
     Poco::Mutex jsContextMapMutex;
     void RegisterGlobalContext(JSObjectRef object, JSGlobalContextRef globalContext)
     {
-        Poco::Mutex::ScopedLock lock(jsContextMapMutex);
-        jsContextMap[object] = globalContext;
+        {
+            Poco::Mutex::ScopedLock lock(jsContextMapMutex);
+            jsContextMap[object] = globalContext;
+        }
+
+        // A window keeps its global object when it loads a new page, so
+        // let go of the wrappers made for the old one.
+        ClearWrapperCache(globalContext, object);
     }
 
     void UnregisterGlobalContext(JSGlobalContextRef jsContext)
     {
         JSObjectRef globalObject(JSContextGetGlobalObject(jsContext));
-        Poco::Mutex::ScopedLock lock(jsContextMapMutex);
-        std::map<JSObjectRef, JSGlobalContextRef>::iterator i = jsContextMap.find(globalObject);
-        if (i != jsContextMap.end())
         {
-            jsContextMap.erase(i);
+            Poco::Mutex::ScopedLock lock(jsContextMapMutex);
+            std::map<JSObjectRef, JSGlobalContextRef>::iterator i = jsContextMap.find(globalObject);
+            if (i != jsContextMap.end())
+            {
+                jsContextMap.erase(i);
+            }
         }
+
+        ClearWrapperCache(jsContext, globalObject);
+
+        size_t hits, allocations, live, contexts;
+        GetWrapperCacheStats(hits, allocations, live, contexts);
+        GetLogger()->Debug("Wrapper cache: %lu hits, %lu wrappers made, %lu live",
+            (unsigned long) hits, (unsigned long) allocations, (unsigned long) live);
     }
     
 
@@ -736,18 +1043,13 @@ namespace JSUtil
         jsContextRefCounts[globalContext]--;
     }
 
-    ValueRef Evaluate(JSContextRef jsContext, const char* script, const char* url)
+    static ValueRef EvaluateScript(JSContextRef jsContext, JSStringRef script, JSStringRef url)
     {
         JSObjectRef globalObject = JSContextGetGlobalObject(jsContext);
-        JSStringRef scriptContents = JSStringCreateWithUTF8CString(script);
-        JSStringRef jsURL = JSStringCreateWithUTF8CString(url);
         JSValueRef exception = NULL;
 
-        JSValueRef returnValue = JSEvaluateScript(jsContext, scriptContents, globalObject, 
-            jsURL, 0, &exception);
-
-        JSStringRelease(jsURL);
-        JSStringRelease(scriptContents);
+        JSValueRef returnValue = JSEvaluateScript(jsContext, script, globalObject, 
+            url, 0, &exception);
 
         if (exception)
             throw ValueException(ToTiValue(exception, jsContext, NULL));
@@ -755,12 +1057,101 @@ namespace JSUtil
         return ToTiValue(returnValue, jsContext, globalObject);
     }
 
+    ValueRef Evaluate(JSContextRef jsContext, const char* script, const char* url)
+    {
+        JSStringRef scriptContents = JSStringCreateWithUTF8CString(script);
+        JSStringRef jsURL = JSStringCreateWithUTF8CString(url);
+
+        try
+        {
+            ValueRef result(EvaluateScript(jsContext, scriptContents, jsURL));
+            JSStringRelease(jsURL);
+            JSStringRelease(scriptContents);
+            return result;
+        }
+        catch (...)
+        {
+            JSStringRelease(jsURL);
+            JSStringRelease(scriptContents);
+            throw;
+        }
+    }
+
+    // Scripts evaluated from files, such as ui.js which runs in every
+    // page, are kept in memory already converted to JavaScriptCore
+    // strings. JavaScriptCore has no public way to keep the compiled
+    // script, so each evaluation still parses it. An entry is reloaded
+    // when its file changes.
+    struct ScriptSource
+    {
+        JSStringRef script;
+        JSStringRef url;
+        Poco::Timestamp modified;
+    };
+    static std::map<std::string, ScriptSource> scriptSources;
+    static Poco::Mutex scriptSourcesMutex;
+
+    static void GetScriptSource(const std::string& fullPath,
+        JSStringRef& script, JSStringRef& url)
+    {
+        Poco::Timestamp modified(Poco::File(fullPath).getLastModified());
+
+        Poco::Mutex::ScopedLock lock(scriptSourcesMutex);
+        std::map<std::string, ScriptSource>::iterator i = scriptSources.find(fullPath);
+        if (i == scriptSources.end() || i->second.modified != modified)
+        {
+            GetLogger()->Debug("Loading JavaScript file at: %s", fullPath.c_str());
+            std::string scriptContents(FileUtils::ReadFile(fullPath));
+            std::string fileURL(URLUtils::PathToFileURL(fullPath));
+
+            if (i != scriptSources.end())
+            {
+                JSStringRelease(i->second.script);
+                JSStringRelease(i->second.url);
+            }
+
+            ScriptSource& source = scriptSources[fullPath];
+            source.script = JSStringCreateWithUTF8CString(scriptContents.c_str());
+            source.url = JSStringCreateWithUTF8CString(fileURL.c_str());
+            source.modified = modified;
+            i = scriptSources.find(fullPath);
+        }
+
+        // Hold a reference for the caller, as the entry may be replaced
+        // by another thread while the script runs.
+        script = JSStringRetain(i->second.script);
+        url = JSStringRetain(i->second.url);
+    }
+
     ValueRef EvaluateFile(JSContextRef jsContext, const std::string& fullPath)
     {
         GetLogger()->Debug("Evaluating JavaScript file at: %s", fullPath.c_str());
-        std::string scriptContents(FileUtils::ReadFile(fullPath));
-        std::string fileURL(URLUtils::PathToFileURL(fullPath));
-        return Evaluate(jsContext, scriptContents.c_str(), fileURL.c_str());
+
+        JSStringRef script;
+        JSStringRef url;
+        try
+        {
+            GetScriptSource(fullPath, script, url);
+        }
+        catch (Poco::Exception& e)
+        {
+            throw ValueException::FromFormat("Could not read %s: %s",
+                fullPath.c_str(), e.displayText().c_str());
+        }
+
+        try
+        {
+            ValueRef result(EvaluateScript(jsContext, script, url));
+            JSStringRelease(url);
+            JSStringRelease(script);
+            return result;
+        }
+        catch (...)
+        {
+            JSStringRelease(url);
+            JSStringRelease(script);
+            throw;
+        }
     }
 
     //===========================================================================//
@@ -854,6 +1245,41 @@ namespace JSUtil
         return fnPrototype;
     }
 
+    /*
+     * The prototype of plain objects in this context.
+     *
+     * NOTE: The return value is not protected.
+     */
+    static JSValueRef GetObjectPrototype(JSContextRef jsContext, JSValueRef* exception)
+    {
+        JSObjectRef globalObject = JSContextGetGlobalObject(jsContext);
+        JSStringRef ctorPropName = JSStringCreateWithUTF8CString("Object");
+        JSValueRef ctorValue = JSObjectGetProperty(jsContext, globalObject,
+            ctorPropName, exception);
+        JSStringRelease(ctorPropName);
+        if (!ctorValue)
+        {
+            return JSValueMakeUndefined(jsContext);
+        }
+
+        JSObjectRef ctorObject = JSValueToObject(jsContext, ctorValue, exception);
+        if (!ctorObject)
+        {
+            return JSValueMakeUndefined(jsContext);
+        }
+
+        JSStringRef protoPropName = JSStringCreateWithUTF8CString("prototype");
+        JSValueRef prototype = JSObjectGetProperty(jsContext, ctorObject,
+            protoPropName, exception);
+        JSStringRelease(protoPropName);
+        if (!prototype)
+        {
+            return JSValueMakeUndefined(jsContext);
+        }
+
+        return prototype;
+    }
+
     ValueRef GetProperty(JSObjectRef globalObject, std::string name)
     {
         JSGlobalContextRef jsContext = GetGlobalContext(globalObject);
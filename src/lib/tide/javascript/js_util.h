@@ -6,6 +6,7 @@
  * Refer to LICENSE for details of distribution and use.
  **/
 
+#ifndef _JS_UTIL_H_
 #define _JS_UTIL_H_
 
 namespace tide
@@ -14,10 +15,13 @@ namespace JSUtil
 {
 
 TIDE_API ValueRef ToTiValue(JSValueRef, JSContextRef, JSObjectRef);
+TIDE_API ValueRef ToTiSnapshot(JSValueRef, JSContextRef, JSObjectRef);
 TIDE_API JSValueRef ToJSValue(ValueRef, JSContextRef);
 TIDE_API JSValueRef TiObjectToJSValue(ValueRef, JSContextRef);
 TIDE_API JSValueRef TiMethodToJSValue(ValueRef, JSContextRef);
 TIDE_API JSValueRef TiListToJSValue(ValueRef, JSContextRef);
+TIDE_API void GetWrapperCacheStats(size_t& hits, size_t& allocations, size_t& live,
+    size_t& contexts);
 TIDE_API std::string ToChars(JSStringRef);
 TIDE_API bool IsArrayLike(JSObjectRef, JSContextRef);
 TIDE_API JSGlobalContextRef CreateGlobalContext();
@@ -12,8 +12,10 @@ using namespace TideUtils;
 
 #include "../tide.h"
 #include "proxy_config.h"
+#include <map>
 #include <sstream>
 
+#include <Poco/Mutex.h>
 #include <Poco/String.h>
 #include <Poco/NumberParser.h>
 #include <Poco/StringTokenizer.h>
@@ -24,6 +26,12 @@ using std::string;
 #include <libproxy/proxy.h>
 #endif
 
+// Proxy decisions are cached per scheme, host and port, since making
+// one can mean evaluating a PAC script. Entries expire so that changes
+// to the system settings are eventually picked up.
+#define PROXY_CACHE_TTL_SECONDS 300
+#define PROXY_CACHE_MAX_ENTRIES 256
+
 namespace tide
 {
 
@@ -107,9 +115,81 @@ namespace ProxyConfig
 SharedProxy httpProxyOverride(0);
 SharedProxy httpsProxyOverride(0);
 
+struct ProxyCacheEntry
+{
+    SharedProxy proxy;
+    Poco::Timestamp expires;
+};
+static std::map<string, ProxyCacheEntry> proxyCache;
+static ProxyResolutionStats resolutionStats;
+static Poco::FastMutex proxyCacheMutex;
+
+void ClearProxyCache()
+{
+    Poco::FastMutex::ScopedLock lock(proxyCacheMutex);
+    proxyCache.clear();
+}
+
+ProxyResolutionStats GetResolutionStats()
+{
+    Poco::FastMutex::ScopedLock lock(proxyCacheMutex);
+    return resolutionStats;
+}
+
+static void CacheProxy(const string& key, SharedProxy proxy,
+    Poco::Timestamp::TimeDiff elapsed)
+{
+    Poco::FastMutex::ScopedLock lock(proxyCacheMutex);
+    resolutionStats.resolutions++;
+    resolutionStats.totalResolutionTime += elapsed;
+    if (elapsed > resolutionStats.maxResolutionTime)
+        resolutionStats.maxResolutionTime = elapsed;
+
+    Poco::Timestamp now;
+    if (proxyCache.size() >= PROXY_CACHE_MAX_ENTRIES)
+    {
+        std::map<string, ProxyCacheEntry>::iterator i = proxyCache.begin();
+        while (i != proxyCache.end())
+        {
+            if (i->second.expires <= now)
+                proxyCache.erase(i++);
+            else
+                i++;
+        }
+
+        if (proxyCache.size() >= PROXY_CACHE_MAX_ENTRIES)
+            proxyCache.clear();
+    }
+
+    ProxyCacheEntry& entry = proxyCache[key];
+    entry.proxy = proxy;
+    entry.expires = now + Poco::Timestamp::TimeDiff(PROXY_CACHE_TTL_SECONDS) * 1000000;
+}
+
+static bool GetCachedProxy(const string& key, SharedProxy& proxy)
+{
+    Poco::FastMutex::ScopedLock lock(proxyCacheMutex);
+    resolutionStats.lookups++;
+
+    std::map<string, ProxyCacheEntry>::iterator i = proxyCache.find(key);
+    if (i == proxyCache.end())
+        return false;
+
+    if (i->second.expires <= Poco::Timestamp())
+    {
+        proxyCache.erase(i);
+        return false;
+    }
+
+    resolutionStats.cacheHits++;
+    proxy = i->second.proxy;
+    return true;
+}
+
 void SetHTTPProxyOverride(SharedProxy newProxyOverride)
 {
     httpProxyOverride = newProxyOverride;
+    ClearProxyCache();
 }
 
 SharedProxy GetHTTPProxyOverride()
@@ -120,6 +200,7 @@ SharedProxy GetHTTPProxyOverride()
 void SetHTTPSProxyOverride(SharedProxy newProxyOverride)
 {
     httpsProxyOverride = newProxyOverride;
+    ClearProxyCache();
 }
 
 SharedProxy GetHTTPSProxyOverride()
@@ -143,76 +224,69 @@ SharedProxy GetProxyForURL(string& url)
     if (scheme == "https" && !httpsProxyOverride.isNull())
         return httpsProxyOverride;
 
-    SharedProxy environmentProxy(GetProxyFromEnvironment(scheme));
-    if (!environmentProxy.isNull())
+    std::ostringstream key;
+    key << scheme << "://" << Poco::toLower(uri.getHost()) << ":" << uri.getPort();
+
+    SharedProxy proxy(0);
+    if (GetCachedProxy(key.str(), proxy))
+        return proxy;
+
+    Poco::Timestamp start;
+    proxy = GetProxyFromEnvironment(scheme);
+    if (!proxy.isNull())
     {
         logger->Debug("Found proxy (%s) in environment",
-            environmentProxy->ToString().c_str());
-        return environmentProxy;
+            proxy->ToString().c_str());
     }
-
-    logger->Debug("Looking up proxy information for: %s", url.c_str());
-    SharedProxy proxy(ProxyConfig::GetProxyForURLImpl(uri));
-
-    if (proxy.isNull())
-        logger->Debug("Using direct connection.");
     else
-        logger->Debug("Using proxy: %s", proxy->ToString().c_str());
+    {
+        logger->Debug("Looking up proxy information for: %s", url.c_str());
+        proxy = ProxyConfig::GetProxyForURLImpl(uri);
 
+        if (proxy.isNull())
+            logger->Debug("Using direct connection.");
+        else
+            logger->Debug("Using proxy: %s", proxy->ToString().c_str());
+    }
+
+    CacheProxy(key.str(), proxy, start.elapsed());
     return proxy;
 }
 
-static inline bool EndsWith(string haystack, string needle)
+static inline bool EndsWith(const string& haystack, const string& needle)
 {
-    return haystack.find(needle) == (haystack.size() - needle.size());
+    return haystack.size() >= needle.size() &&
+        haystack.compare(haystack.size() - needle.size(), needle.size(), needle) == 0;
 }
 
-static bool ShouldBypassWithEntry(Poco::URI& uri, SharedPtr<BypassEntry> entry)
+static bool ShouldBypassWithEntry(const string& uriHost, const string& uriScheme,
+    unsigned short uriPort, SharedPtr<BypassEntry> entry)
 {
-    const std::string& uriHost = uri.getHost();
-    const std::string& uriScheme = uri.getScheme();
-    unsigned short uriPort = uri.getPort();
-    const std::string& entryHost = entry->host;
-    const std::string& entryScheme = entry->scheme;
-    unsigned short entryPort = entry->port;
-
-    GetLogger()->Debug("bypass entry: scheme='%s' host='%s' port='%i'", 
-        entry->scheme.c_str(), entry->host.c_str(), entry->port);
-
     // An empty bypass entry equals an unconditional bypass.
     if (entry.isNull())
-    {
         return true;
-    }
-    else
-    {
-        if (entryHost == "<local>" && uriHost.find(".") == string::npos)
-        {
-            return true;
-        }
-        else if (EndsWith(uriHost, entryHost) &&
-            (entryScheme.empty() || entryScheme == uriScheme) &&
-            (entryPort == 0 || entryPort == uriPort))
-        {
-            return true;
-        }
-    }
 
-    return false;
+    if (entry->localNames)
+        return uriHost.find(".") == string::npos;
+
+    return EndsWith(uriHost, entry->host) &&
+        (entry->scheme.empty() || entry->scheme == uriScheme) &&
+        (entry->port == 0 || entry->port == uriPort);
 }
 
 bool ShouldBypass(Poco::URI& uri, std::vector<SharedPtr<BypassEntry> >& bypassList)
 {
-    GetLogger()->Debug("Checking whether %s should be bypassed.", 
-        uri.toString().c_str());
+    // Entries are already lowercased by ParseBypassEntry.
+    string uriHost(Poco::toLower(uri.getHost()));
+    string uriScheme(Poco::toLower(uri.getScheme()));
+    unsigned short uriPort = uri.getPort();
 
     for (size_t i = 0; i < bypassList.size(); i++)
     {
-        if (ShouldBypassWithEntry(uri, bypassList.at(i)))
+        if (ShouldBypassWithEntry(uriHost, uriScheme, uriPort, bypassList.at(i)))
             return true;
     }
 
-    GetLogger()->Debug("No bypass");
     return false;
 }
 
@@ -232,6 +306,13 @@ SharedPtr<BypassEntry> ParseBypassEntry(string entry)
     }
 
     SharedPtr<BypassEntry> bypass(new BypassEntry());
+    Poco::toLowerInPlace(entry);
+    if (entry == "<local>")
+    {
+        bypass->localNames = true;
+        return bypass;
+    }
+
     size_t endScheme = entry.find("://");
     if (endScheme != string::npos)
     {
@@ -10,16 +10,21 @@
 #define _PROXY_CONFIG_H_
 
 #include <Poco/URI.h>
+#include <Poco/Timestamp.h>
 
 namespace tide
 {
+    // A bypass list entry, parsed once when the list is read. The host
+    // is lowercased and any leading wildcard is stripped, so matching is
+    // a plain suffix comparison.
     class TIDE_API BypassEntry
     {
     public:
-        BypassEntry() : port(0) {}
+        BypassEntry() : port(0), localNames(false) {}
         std::string scheme;
         std::string host;
         unsigned short port;
+        bool localNames;
     };
 
     enum ProxyType { HTTP, HTTPS, FTP, SOCKS };
@@ -36,6 +41,20 @@ namespace tide
     };
     typedef SharedPtr<Proxy> SharedProxy;
 
+    class TIDE_API ProxyResolutionStats
+    {
+    public:
+        ProxyResolutionStats() :
+            lookups(0), cacheHits(0), resolutions(0),
+            totalResolutionTime(0), maxResolutionTime(0) {}
+        unsigned long lookups;
+        unsigned long cacheHits;
+        unsigned long resolutions;
+        // Microseconds spent resolving proxies on cache misses.
+        Poco::Timestamp::TimeDiff totalResolutionTime;
+        Poco::Timestamp::TimeDiff maxResolutionTime;
+    };
+
     namespace ProxyConfig
     {
         TIDE_API void SetHTTPProxyOverride(SharedProxy);
@@ -43,6 +62,8 @@ namespace tide
         TIDE_API SharedProxy GetHTTPProxyOverride();
         TIDE_API SharedProxy GetHTTPSProxyOverride();
         TIDE_API SharedProxy GetProxyForURL(std::string& url);
+        TIDE_API void ClearProxyCache();
+        TIDE_API ProxyResolutionStats GetResolutionStats();
         TIDE_API SharedProxy ParseProxyEntry(std::string proxyEntry,
             const std::string& urlScheme, const std::string& entryScheme);
 
@@ -0,0 +1,359 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include "tide.h"
+#include "resource_archive.h"
+
+#include <cstring>
+#include <vector>
+
+#include <tideutils/file_utils.h>
+#include <Poco/File.h>
+#include <Poco/FileStream.h>
+#include <Poco/NumberFormatter.h>
+#include <Poco/Path.h>
+#include <Poco/Process.h>
+#include <Poco/TemporaryFile.h>
+
+#if defined(OS_WIN32)
+#include <windows.h>
+#include <tideutils/win/win32_utils.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace TideUtils;
+
+#define ARCHIVE_NAME "Resources.pak"
+#define ARCHIVE_MAGIC "TIDEPAK"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_HEADER_SIZE 16
+#define ARCHIVE_ENTRY_SIZE 32
+
+namespace tide
+{
+    static inline Poco::UInt32 ReadUInt32(const char* p)
+    {
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+        return (Poco::UInt32) b[0] | ((Poco::UInt32) b[1] << 8) |
+            ((Poco::UInt32) b[2] << 16) | ((Poco::UInt32) b[3] << 24);
+    }
+
+    static inline Poco::UInt64 ReadUInt64(const char* p)
+    {
+        return (Poco::UInt64) ReadUInt32(p) | ((Poco::UInt64) ReadUInt32(p + 4) << 32);
+    }
+
+#if !defined(OS_WIN32)
+    // Nobody else may be able to add or replace anything in a directory
+    // files are extracted to, or an extracted file could be swapped for
+    // another between being written and being loaded.
+    static bool IsPrivateDirectory(const std::string& path)
+    {
+        struct stat info;
+        return lstat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode) &&
+            info.st_uid == geteuid() && (info.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+    }
+
+    static bool CreatePrivateDirectory(const std::string& path)
+    {
+        if (mkdir(path.c_str(), S_IRWXU) == -1 && errno != EEXIST)
+            return false;
+        return IsPrivateDirectory(path);
+    }
+
+    static bool WriteNewFile(const std::string& path, const char* data, size_t length)
+    {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW,
+            S_IRUSR | S_IWUSR);
+        if (fd == -1)
+            return false;
+
+        while (length > 0)
+        {
+            ssize_t written = write(fd, data, length);
+            if (written == -1 && errno == EINTR)
+                continue;
+            if (written == -1)
+            {
+                close(fd);
+                unlink(path.c_str());
+                return false;
+            }
+            data += written;
+            length -= (size_t) written;
+        }
+        return close(fd) == 0;
+    }
+#endif
+
+    ResourceArchive::ResourceArchive() :
+        base(0),
+        size(0),
+        count(0)
+#if defined(OS_WIN32)
+        , fileHandle(INVALID_HANDLE_VALUE),
+        mappingHandle(0)
+#endif
+    {
+    }
+
+    ResourceArchive::~ResourceArchive()
+    {
+#if defined(OS_WIN32)
+        if (this->base)
+            UnmapViewOfFile(this->base);
+        if (this->mappingHandle)
+            CloseHandle(this->mappingHandle);
+        if (this->fileHandle != INVALID_HANDLE_VALUE)
+            CloseHandle(this->fileHandle);
+#else
+        if (this->base)
+            munmap(const_cast<char*>(this->base), this->size);
+#endif
+    }
+
+    /*static*/
+    ResourceArchive* ResourceArchive::Open(const std::string& path)
+    {
+        if (!FileUtils::IsFile(path))
+            return 0;
+
+        ResourceArchive* archive = new ResourceArchive();
+        if (!archive->Map(path))
+        {
+            Logger::Get("ResourceArchive")->Error(
+                "Ignoring invalid resource archive at %s", path.c_str());
+            delete archive;
+            return 0;
+        }
+        return archive;
+    }
+
+    /*static*/
+    ResourceArchive* ResourceArchive::GetApplicationArchive()
+    {
+        // The archive stays mapped until the process exits, so the data
+        // handed out by Find never goes away.
+        static Poco::Mutex mutex;
+        static bool opened = false;
+        static ResourceArchive* archive = 0;
+
+        Poco::Mutex::ScopedLock lock(mutex);
+        if (!opened)
+        {
+            opened = true;
+            SharedApplication app(Host::GetInstance()->GetApplication());
+            archive = Open(FileUtils::Join(app->path.c_str(), ARCHIVE_NAME, NULL));
+            if (archive)
+            {
+                Logger::Get("ResourceArchive")->Debug("Loaded %lu resources from %s",
+                    (unsigned long) archive->GetEntryCount(), ARCHIVE_NAME);
+            }
+        }
+        return archive;
+    }
+
+    /*static*/
+    Poco::UInt64 ResourceArchive::Hash(const char* path, size_t length)
+    {
+        Poco::UInt64 hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < length; i++)
+        {
+            hash ^= (unsigned char) path[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    bool ResourceArchive::Map(const std::string& path)
+    {
+#if defined(OS_WIN32)
+        this->fileHandle = CreateFileW(UTF8ToWide(path).c_str(), GENERIC_READ,
+            FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+        if (this->fileHandle == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(this->fileHandle, &fileSize) || fileSize.QuadPart == 0)
+            return false;
+        this->size = (size_t) fileSize.QuadPart;
+
+        this->mappingHandle = CreateFileMappingW(this->fileHandle, 0,
+            PAGE_READONLY, 0, 0, 0);
+        if (!this->mappingHandle)
+            return false;
+
+        this->base = (const char*) MapViewOfFile(this->mappingHandle,
+            FILE_MAP_READ, 0, 0, 0);
+        if (!this->base)
+            return false;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) == -1 || info.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+        this->size = (size_t) info.st_size;
+
+        void* mapping = mmap(0, this->size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+            return false;
+        this->base = (const char*) mapping;
+#endif
+
+        if (this->size < ARCHIVE_HEADER_SIZE ||
+            memcmp(this->base, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 ||
+            ReadUInt32(this->base + 8) != ARCHIVE_VERSION)
+            return false;
+
+        this->count = ReadUInt32(this->base + 12);
+        if (this->count > (this->size - ARCHIVE_HEADER_SIZE) / ARCHIVE_ENTRY_SIZE)
+            return false;
+
+        // Check every entry once here, so that lookups can trust them.
+        for (size_t i = 0; i < this->count; i++)
+        {
+            const char* entry = this->base + ARCHIVE_HEADER_SIZE + i * ARCHIVE_ENTRY_SIZE;
+            Poco::UInt64 dataOffset = ReadUInt64(entry + 8);
+            Poco::UInt64 dataLength = ReadUInt32(entry + 16);
+            Poco::UInt64 pathOffset = ReadUInt32(entry + 20);
+            Poco::UInt64 pathLength = ReadUInt32(entry + 24);
+            if (dataOffset + dataLength > this->size || pathOffset + pathLength > this->size)
+                return false;
+            if (i > 0 && ReadUInt64(entry - ARCHIVE_ENTRY_SIZE) > ReadUInt64(entry))
+                return false;
+        }
+        return true;
+    }
+
+    bool ResourceArchive::Find(const std::string& path, const char*& data, size_t& length) const
+    {
+        Poco::UInt64 hash = Hash(path.data(), path.size());
+        const char* entries = this->base + ARCHIVE_HEADER_SIZE;
+
+        // Find the first entry with this hash, then check the paths of
+        // it and any others which collide with it.
+        size_t low = 0;
+        size_t high = this->count;
+        while (low < high)
+        {
+            size_t middle = low + (high - low) / 2;
+            if (ReadUInt64(entries + middle * ARCHIVE_ENTRY_SIZE) < hash)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+
+        for (size_t i = low; i < this->count; i++)
+        {
+            const char* entry = entries + i * ARCHIVE_ENTRY_SIZE;
+            if (ReadUInt64(entry) != hash)
+                break;
+
+            size_t pathLength = ReadUInt32(entry + 24);
+            if (pathLength != path.size() ||
+                memcmp(this->base + ReadUInt32(entry + 20), path.data(), pathLength) != 0)
+                continue;
+
+            data = this->base + ReadUInt64(entry + 8);
+            length = ReadUInt32(entry + 16);
+            return true;
+        }
+        return false;
+    }
+
+    std::string ResourceArchive::Extract(const std::string& path)
+    {
+        const char* data;
+        size_t length;
+        if (!this->Find(path, data, length))
+            return std::string();
+
+        Poco::Mutex::ScopedLock lock(this->extractMutex);
+#if defined(OS_WIN32)
+        if (this->extractPath.empty())
+        {
+            this->extractPath = FileUtils::Join(FileUtils::GetTempDirectory().c_str(),
+                ("tide-resources-" + Poco::NumberFormatter::format(Poco::Process::id())).c_str(),
+                NULL);
+            Poco::TemporaryFile::registerForDeletion(this->extractPath);
+        }
+
+        Poco::Path extractedPath(this->extractPath);
+        extractedPath.append(Poco::Path(path, Poco::Path::PATH_UNIX));
+        std::string extracted(extractedPath.toString());
+        if (this->extracted.find(path) != this->extracted.end())
+            return extracted;
+
+        Poco::File(extractedPath.parent()).createDirectories();
+        Poco::FileOutputStream stream(extracted, std::ios::out | std::ios::binary);
+        stream.write(data, length);
+        stream.close();
+#else
+        // The shared temporary directory is writable by everyone, so files
+        // go in a directory with a name nobody can guess which only this
+        // user can write to, and are never written through a link.
+        if (this->extractPath.empty())
+        {
+            std::string pattern(FileUtils::Join(FileUtils::GetTempDirectory().c_str(),
+                "tide-resources-XXXXXX", NULL));
+            std::vector<char> buffer(pattern.begin(), pattern.end());
+            buffer.push_back('\0');
+            if (!mkdtemp(&buffer[0]) || !IsPrivateDirectory(&buffer[0]))
+            {
+                Logger::Get("ResourceArchive")->Error(
+                    "Could not create a directory to extract resources to");
+                return std::string();
+            }
+            this->extractPath = &buffer[0];
+            Poco::TemporaryFile::registerForDeletion(this->extractPath);
+        }
+
+        Poco::Path relativePath(path, Poco::Path::PATH_UNIX);
+        std::vector<std::string> directories;
+        std::string extracted(this->extractPath);
+        for (int i = 0; i < relativePath.depth(); i++)
+        {
+            if (relativePath[i] == "..")
+                return std::string();
+            extracted = FileUtils::Join(extracted.c_str(), relativePath[i].c_str(), NULL);
+            directories.push_back(extracted);
+        }
+        extracted = FileUtils::Join(extracted.c_str(),
+            relativePath.getFileName().c_str(), NULL);
+        if (this->extracted.find(path) != this->extracted.end())
+            return extracted;
+
+        for (size_t i = 0; i < directories.size(); i++)
+        {
+            if (!CreatePrivateDirectory(directories[i]))
+                return std::string();
+        }
+        if (!WriteNewFile(extracted, data, length))
+        {
+            Logger::Get("ResourceArchive")->Error(
+                "Could not extract %s to %s", path.c_str(), extracted.c_str());
+            return std::string();
+        }
+#endif
+
+        this->extracted.insert(path);
+        return extracted;
+    }
+}
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _RESOURCE_ARCHIVE_H_
+#define _RESOURCE_ARCHIVE_H_
+
+#include <set>
+#include <string>
+
+#include <Poco/Mutex.h>
+#include <Poco/Types.h>
+
+#include "base.h"
+
+namespace tide
+{
+    /**
+     * A read-only archive of an application's Resources directory, made
+     * by the packager's --pack-resources option. The file is mapped into
+     * memory, and entries are found by a binary search over the hashes
+     * of their paths, so a lookup neither parses URLs nor touches the
+     * filesystem and the contents are never copied.
+     *
+     * The archive is little-endian:
+     *   header:  "TIDEPAK\0", UInt32 version, UInt32 entry count
+     *   entries: UInt64 path hash, UInt64 data offset, UInt32 data length,
+     *            UInt32 path offset, UInt32 path length, UInt32 reserved
+     *   followed by the entry paths and data.
+     * Entries are sorted by hash. Paths are relative to Resources, use
+     * forward slashes and are hashed with 64-bit FNV-1a.
+     */
+    class TIDE_API ResourceArchive
+    {
+    public:
+        ~ResourceArchive();
+
+        // Map the archive at path. Returns null if there is no archive
+        // there or it is not valid.
+        static ResourceArchive* Open(const std::string& path);
+
+        // The archive of the running application, opened on first use.
+        // Returns null when the application's resources are loose files.
+        static ResourceArchive* GetApplicationArchive();
+
+        static Poco::UInt64 Hash(const char* path, size_t length);
+
+        // Find the entry for a path relative to Resources. The data
+        // stays valid for as long as the archive is open.
+        bool Find(const std::string& path, const char*& data, size_t& length) const;
+
+        // Write an entry out to a file under a temporary directory, for
+        // code which can only load resources from a path. Each entry is
+        // only written once. Returns an empty string if there is no entry
+        // or it could not be written out safely.
+        std::string Extract(const std::string& path);
+
+        size_t GetEntryCount() const { return this->count; }
+
+    private:
+        ResourceArchive();
+        bool Map(const std::string& path);
+
+        const char* base;
+        size_t size;
+        size_t count;
+#if defined(OS_WIN32)
+        void* fileHandle;
+        void* mappingHandle;
+#endif
+        std::string extractPath;
+        std::set<std::string> extracted;
+        Poco::Mutex extractMutex;
+
+        DISALLOW_EVIL_CONSTRUCTORS(ResourceArchive);
+    };
+}
+
+#endif
@@ -8,6 +8,7 @@
 
 #include "script.h"
 #include <Poco/File.h>
+#include <Poco/String.h>
 #include <Poco/TemporaryFile.h>
 
 namespace tide
@@ -44,13 +45,67 @@ namespace tide
         return scriptStr.substr(scriptStr.rfind("."));
     }
     
+    /*static*/
+    std::string Script::GetURLExtension(const std::string& url)
+    {
+        // Only the last path segment counts, so strip the query and
+        // fragment and ignore dots in directory names.
+        std::string path(url.substr(0, url.find_first_of("?#")));
+        size_t slash = path.rfind('/');
+        size_t dot = path.rfind('.');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            return std::string();
+
+        return Poco::toLower(path.substr(dot + 1));
+    }
+
+    static void RegisterEvaluator(std::map<std::string, TiObjectRef>& table,
+        TiObjectRef evaluator, const char* property)
+    {
+        std::vector<std::string> keys;
+        evaluator->GetStringList(property, keys);
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            // The first evaluator to claim a key keeps it, just as the
+            // first one to answer true used to win.
+            std::string key(Poco::toLower(keys[i]));
+            if (table.find(key) == table.end())
+                table[key] = evaluator;
+        }
+    }
+
+    static void UnregisterEvaluator(std::map<std::string, TiObjectRef>& table,
+        TiObjectRef evaluator)
+    {
+        std::map<std::string, TiObjectRef>::iterator i = table.begin();
+        while (i != table.end())
+        {
+            if (i->second->Equals(evaluator))
+                table.erase(i++);
+            else
+                i++;
+        }
+    }
+
     void Script::AddScriptEvaluator(TiObjectRef evaluator)
     {
+        Poco::Mutex::ScopedLock lock(mutex);
         evaluators->Append(Value::NewObject(evaluator));
+
+        if (evaluator->HasProperty("mimeTypes"))
+        {
+            RegisterEvaluator(mimeTypeEvaluators, evaluator, "mimeTypes");
+            RegisterEvaluator(extensionEvaluators, evaluator, "extensions");
+        }
+        else
+        {
+            dynamicEvaluators.push_back(evaluator);
+        }
     }
     
     void Script::RemoveScriptEvaluator(TiObjectRef evaluator)
     {
+        Poco::Mutex::ScopedLock lock(mutex);
         int index = -1;
         for (unsigned int i = 0; i < evaluators->Size(); i++)
         {
@@ -64,22 +119,65 @@ namespace tide
         {
             evaluators->Remove(index);
         }
+
+        UnregisterEvaluator(mimeTypeEvaluators, evaluator);
+        UnregisterEvaluator(extensionEvaluators, evaluator);
+        for (size_t i = 0; i < dynamicEvaluators.size(); i++)
+        {
+            if (dynamicEvaluators[i]->Equals(evaluator))
+            {
+                dynamicEvaluators.erase(dynamicEvaluators.begin() + i);
+                break;
+            }
+        }
+    }
+
+    TiObjectRef Script::FindEvaluator(const char *mimeType)
+    {
+        {
+            Poco::Mutex::ScopedLock lock(mutex);
+            EvaluatorMap::iterator i = mimeTypeEvaluators.find(Poco::toLower(std::string(mimeType)));
+            if (i != mimeTypeEvaluators.end())
+                return i->second;
+        }
+        return this->FindEvaluatorWithMethod("canEvaluate", mimeType);
+    }
+
+    TiObjectRef Script::FindPreprocessor(const char *url)
+    {
+        {
+            Poco::Mutex::ScopedLock lock(mutex);
+            EvaluatorMap::iterator i = extensionEvaluators.find(GetURLExtension(url));
+            if (i != extensionEvaluators.end())
+                return i->second;
+        }
+        return this->FindEvaluatorWithMethod("canPreprocess", url);
     }
     
     TiObjectRef Script::FindEvaluatorWithMethod(const char *method, const char *arg)
     {
+        // Only evaluators which did not declare what they handle are asked.
+        // Call them without holding the lock, since they may be scripts.
+        std::vector<TiObjectRef> candidates;
+        {
+            Poco::Mutex::ScopedLock lock(mutex);
+            if (dynamicEvaluators.empty())
+                return 0;
+            candidates = dynamicEvaluators;
+        }
+
         ValueList args;
         args.push_back(Value::NewString(arg));
         
-        for (unsigned int i = 0; i < evaluators->Size(); i++)
+        for (size_t i = 0; i < candidates.size(); i++)
         {
-            TiMethodRef finder = evaluators->At(i)->ToObject()->GetMethod(method);
+            TiMethodRef finder = candidates[i]->GetMethod(method);
             if (!finder.isNull())
             {
                 ValueRef result = finder->Call(args);
                 if (result->IsBool() && result->ToBool())
                 {
-                    return evaluators->At(i)->ToObject();
+                    return candidates[i];
                 }
             }
         }
@@ -88,17 +186,17 @@ namespace tide
     
     bool Script::CanEvaluate(const char *mimeType)
     {
-        return !this->FindEvaluatorWithMethod("canEvaluate", mimeType).isNull();
+        return !this->FindEvaluator(mimeType).isNull();
     }
     
     bool Script::CanPreprocess(const char *url)
     {
-        return !this->FindEvaluatorWithMethod("canPreprocess", url).isNull();
+        return !this->FindPreprocessor(url).isNull();
     }
     
     ValueRef Script::Evaluate(const char *mimeType, const char *name, const char *code, TiObjectRef scope)
     {
-        TiObjectRef evaluator = this->FindEvaluatorWithMethod("canEvaluate", mimeType);
+        TiObjectRef evaluator = this->FindEvaluator(mimeType);
         if (!evaluator.isNull())
         {
             TiMethodRef evaluate = evaluator->GetMethod("evaluate");
@@ -125,7 +223,7 @@ namespace tide
     
     AutoPtr<PreprocessData> Script::Preprocess(const char *url, TiObjectRef scope)
     {
-        TiObjectRef evaluator = this->FindEvaluatorWithMethod("canPreprocess", url);
+        TiObjectRef evaluator = this->FindPreprocessor(url);
         if (!evaluator.isNull())
         {
             TiMethodRef preprocess = evaluator->GetMethod("preprocess");
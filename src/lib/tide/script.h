@@ -10,6 +10,8 @@
 #define _SCRIPT_H_
 
 #include <tide/tide.h>
+#include <map>
+#include <Poco/Mutex.h>
 
 namespace tide
 {
@@ -20,6 +22,15 @@ namespace tide
         std::string mimeType;
     };
     
+    /**
+     * Dispatches script evaluation and URL preprocessing to the registered
+     * evaluators. An evaluator can declare what it handles up front with a
+     * "mimeTypes" list property and an "extensions" list property (URL
+     * extensions without the leading dot), in which case dispatch is a table
+     * lookup. Evaluators without a "mimeTypes" property are asked through
+     * their canEvaluate and canPreprocess methods instead, in the order they
+     * were added.
+     */
     class TIDE_API Script
     {
     public:
@@ -27,6 +38,7 @@ namespace tide
         static void Initialize();
         static bool HasExtension(const char *url, const char *ext);
         static std::string GetExtension(const char *url);
+        static std::string GetURLExtension(const std::string& url);
         
         void AddScriptEvaluator(TiObjectRef evaluator);
         void RemoveScriptEvaluator(TiObjectRef evaluator);
@@ -39,10 +51,18 @@ namespace tide
         AutoPtr<PreprocessData> Preprocess(const char *url, TiObjectRef scope);
         
     protected:
+        typedef std::map<std::string, TiObjectRef> EvaluatorMap;
+
         TiListRef evaluators;
+        std::vector<TiObjectRef> dynamicEvaluators;
+        EvaluatorMap mimeTypeEvaluators;
+        EvaluatorMap extensionEvaluators;
+        Poco::Mutex mutex;
         static SharedPtr<Script> instance;
         
         Script() : evaluators(new StaticBoundList()) { }
+        TiObjectRef FindEvaluator(const char *mimeType);
+        TiObjectRef FindPreprocessor(const char *url);
         TiObjectRef FindEvaluatorWithMethod(const char *method, const char *arg);
     };
 }
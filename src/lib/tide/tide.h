@@ -44,6 +44,7 @@ namespace tide
     class StaticBoundObject;
     class StaticBoundMethod;
     class StaticBoundList;
+    class VectorList;
 
     class GlobalObject;
     class ScopeMethodDelegate;
@@ -81,6 +82,8 @@ namespace tide
 #include "async_job.h"
 #include "main_thread_job.h"
 #include "script.h"
+#include "code_cache.h"
+#include "glob.h"
 
 #ifdef OS_OSX
 #include "osx/osx.h"
@@ -18,14 +18,152 @@ using namespace TideUtils;
 
 #include <tide/url_utils.h>
 #include <tide/tide.h>
+#include <tide/resource_archive.h>
 #include <Poco/URI.h>
 #include <Poco/TemporaryFile.h>
 #include <Poco/FileStream.h>
+#include <Poco/Mutex.h>
+
+#include <list>
+#include <map>
+
+#define URL_CACHE_CAPACITY 512
 
 namespace TideUtils
 {
 namespace URLUtils
 {
+    // Conversions depend only on the URL and on the application's paths,
+    // but every page load asks for the same few URLs many times over, so
+    // the results are kept in a small LRU cache. Conversions which fail
+    // are not cached, so that they are logged each time.
+    class URLCache
+    {
+    public:
+        URLCache() :
+            application(0),
+            moduleCount(0),
+            runtime(0),
+            hits(0),
+            misses(0)
+        {
+        }
+
+        bool Get(char kind, const std::string& url, std::string& result)
+        {
+            Poco::Mutex::ScopedLock lock(this->mutex);
+            this->Validate();
+
+            EntryMap::iterator i = this->entries.find(GetKey(kind, url));
+            if (i == this->entries.end())
+            {
+                this->misses++;
+                return false;
+            }
+
+            this->order.splice(this->order.begin(), this->order, i->second.position);
+            this->hits++;
+            result = i->second.result;
+            return true;
+        }
+
+        void Put(char kind, const std::string& url, const std::string& result)
+        {
+            Poco::Mutex::ScopedLock lock(this->mutex);
+            std::string key(GetKey(kind, url));
+            EntryMap::iterator i = this->entries.find(key);
+            if (i != this->entries.end())
+                this->Remove(i);
+
+            while (this->entries.size() >= URL_CACHE_CAPACITY)
+                this->Remove(this->entries.find(this->order.back()));
+
+            this->order.push_front(key);
+            Entry& entry = this->entries[key];
+            entry.result = result;
+            entry.position = this->order.begin();
+        }
+
+        void Clear()
+        {
+            Poco::Mutex::ScopedLock lock(this->mutex);
+            this->entries.clear();
+            this->order.clear();
+        }
+
+        void GetStats(size_t& hits, size_t& misses, size_t& size)
+        {
+            Poco::Mutex::ScopedLock lock(this->mutex);
+            hits = this->hits;
+            misses = this->misses;
+            size = this->entries.size();
+        }
+
+    private:
+        struct Entry
+        {
+            std::string result;
+            std::list<std::string>::iterator position;
+        };
+        typedef std::map<std::string, Entry> EntryMap;
+
+        static std::string GetKey(char kind, const std::string& url)
+        {
+            std::string key(1, kind);
+            key.append(url);
+            return key;
+        }
+
+        void Remove(EntryMap::iterator i)
+        {
+            this->order.erase(i->second.position);
+            this->entries.erase(i);
+        }
+
+        // Drop every entry if the application has moved or its set of
+        // components has been resolved again since they were stored.
+        void Validate()
+        {
+            SharedApplication app(Host::GetInstance()->GetApplication());
+            if (app.get() == this->application && app->path == this->applicationPath &&
+                app->modules.size() == this->moduleCount && app->runtime.get() == this->runtime)
+                return;
+
+            this->entries.clear();
+            this->order.clear();
+            this->application = app.get();
+            this->applicationPath = app->path;
+            this->moduleCount = app->modules.size();
+            this->runtime = app->runtime.get();
+        }
+
+        EntryMap entries;
+        std::list<std::string> order;
+        Poco::Mutex mutex;
+        Application* application;
+        std::string applicationPath;
+        size_t moduleCount;
+        KComponent* runtime;
+        size_t hits;
+        size_t misses;
+    };
+
+    static URLCache& GetURLCache()
+    {
+        static URLCache cache;
+        return cache;
+    }
+
+    void ClearURLCache()
+    {
+        GetURLCache().Clear();
+    }
+
+    void GetURLCacheStats(size_t& hits, size_t& misses, size_t& size)
+    {
+        GetURLCache().GetStats(hits, misses, size);
+    }
+
     static std::string NormalizeAppURL(const std::string& url)
     {
         size_t appLength = 6; // app://
@@ -43,6 +181,44 @@ namespace URLUtils
         }
     }
 
+    // Find the path within Resources of an app:// URL by picking the
+    // string apart directly, which is much cheaper than parsing it with
+    // Poco::URI. URLs with dot segments are left to the slow path.
+    static bool AppURLToArchivePath(const std::string& url, std::string& path)
+    {
+        if (url.compare(0, 6, "app://") != 0)
+            return false;
+
+        size_t start = 6;
+        const std::string& id(Host::GetInstance()->GetApplication()->id);
+        if (url.compare(start, id.size(), id) == 0 &&
+            (url.size() == start + id.size() || url[start + id.size()] == '/'))
+            start += id.size();
+
+        size_t end = url.find_first_of("?#", start);
+        std::string encoded(url, start, end == std::string::npos ? end : end - start);
+        path.clear();
+        Poco::URI::decode(encoded, path);
+
+        size_t first = path.find_first_not_of('/');
+        if (first == std::string::npos)
+            return false;
+        path.erase(0, first);
+
+        std::string segmented("/" + path + "/");
+        return segmented.find("/./") == std::string::npos &&
+            segmented.find("/../") == std::string::npos &&
+            path.find('\\') == std::string::npos;
+    }
+
+    bool AppURLToResource(const std::string& url, const char*& data, size_t& length)
+    {
+        ResourceArchive* archive = ResourceArchive::GetApplicationArchive();
+        std::string path;
+        return archive && AppURLToArchivePath(url, path) &&
+            archive->Find(path, data, length);
+    }
+
     std::string& BlankPageURL()
     {
         static std::string url("app://__blank__.html");
@@ -69,37 +245,55 @@ namespace URLUtils
 
     std::string NormalizeURL(const std::string& url)
     {
-        Poco::URI inURI = Poco::URI(url);
         if (url == BlankPageURL())
         {
             return url;
         }
+
+        std::string normalized;
+        if (GetURLCache().Get('n', url, normalized))
+        {
+            return normalized;
+        }
+
+        Poco::URI inURI = Poco::URI(url);
         if (inURI.getScheme() != "app")
         {
-            return url;
+            normalized = url;
         }
         else
         {
-            return NormalizeAppURL(url);
+            normalized = NormalizeAppURL(url);
         }
+        GetURLCache().Put('n', url, normalized);
+        return normalized;
     }
 
     std::string URLToPath(const std::string& url)
     {
+        if (url == BlankPageURL())
+        {
+            return BlankURLToFilePath();
+        }
+
+        // Caching the whole conversion here also saves parsing the URL
+        // and, for URLs with no scheme, probing the filesystem.
+        std::string path;
+        if (GetURLCache().Get('u', url, path))
+        {
+            return path;
+        }
+
         Poco::URI inURI = Poco::URI(url);
         try
         {
-            if (url == BlankPageURL())
-            {
-                return BlankURLToFilePath();
-            }
             if (inURI.getScheme() == "ti")
             {
-                return TiURLToPath(url);
+                path = TiURLToPath(url);
             }
             else if (inURI.getScheme() == "app")
             {
-                return AppURLToPath(url);
+                path = AppURLToPath(url);
             }
             else if (inURI.getScheme().empty())
             {
@@ -107,12 +301,24 @@ namespace URLUtils
                 // it's a path or a relative app:// URL. If a file can be found, assume thi
                 // is a file path.
                 if (FileUtils::IsFile(url))
+                {
+                    GetURLCache().Put('u', url, url);
                     return url;
+                }
 
                 // Otherwise treat this like an app:// URL relative to the root.
                 std::string newURL("app://");
                 newURL.append(url);
-                return AppURLToPath(newURL);
+                path = AppURLToPath(newURL);
+                if (path == newURL)
+                    return path;
+            }
+
+            // A conversion which failed returns the URL it was given.
+            if (!path.empty() && path != url)
+            {
+                GetURLCache().Put('u', url, path);
+                return path;
             }
         }
         catch (ValueException& e)
@@ -126,6 +332,12 @@ namespace URLUtils
 
     std::string TiURLToPath(const std::string& tiURL)
     {
+        std::string cached;
+        if (GetURLCache().Get('t', tiURL, cached))
+        {
+            return cached;
+        }
+
         try
         {
             Poco::URI inURI = Poco::URI(tiURL);
@@ -151,6 +363,7 @@ namespace URLUtils
             {
                 path = FileUtils::Join(path.c_str(), segments[i].c_str(), NULL);
             }
+            GetURLCache().Put('t', tiURL, path);
             return path;
         }
         catch (ValueException& e)
@@ -169,8 +382,31 @@ namespace URLUtils
 
     std::string AppURLToPath(const std::string& inURL)
     {
+        std::string cached;
+        if (GetURLCache().Get('a', inURL, cached))
+        {
+            return cached;
+        }
+
         try
         {
+            // Resources packed into an archive take precedence over loose
+            // files, which are the fallback during development. Code that
+            // needs a path gets a copy of the archived file. Only OS X
+            // applications are packed, since the GTK and Win32 WebKit ports
+            // would need a copy of every resource.
+            ResourceArchive* archive = ResourceArchive::GetApplicationArchive();
+            std::string archivePath;
+            if (archive && AppURLToArchivePath(inURL, archivePath))
+            {
+                std::string extracted(archive->Extract(archivePath));
+                if (!extracted.empty())
+                {
+                    GetURLCache().Put('a', inURL, extracted);
+                    return extracted;
+                }
+            }
+
             Poco::URI inURI = Poco::URI(inURL);
             if (inURI.getScheme() != "app")
             {
@@ -189,6 +425,7 @@ namespace URLUtils
             {
                 path = FileUtils::Join(path.c_str(), segments[i].c_str(), NULL);
             }
+            GetURLCache().Put('a', inURL, path);
             return path;
         }
         catch (ValueException& e)
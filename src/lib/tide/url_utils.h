@@ -34,6 +34,23 @@ namespace TideUtils
 
         TIDE_API std::string TiURLToPath(const std::string& url);
         TIDE_API std::string AppURLToPath(const std::string& url);
+
+        /**
+         * Find the contents of an app:// URL in the application's
+         * resource archive without copying them. Returns false if the
+         * application has no archive or the URL is not in it, in which
+         * case the resource should be loaded from AppURLToPath.
+         */
+        TIDE_API bool AppURLToResource(const std::string& url,
+            const char*& data, size_t& length);
+
+        /**
+         * The results of the conversions above are cached, and the cache
+         * is emptied whenever the application's paths or components
+         * change. ClearURLCache empties it immediately.
+         */
+        TIDE_API void ClearURLCache();
+        TIDE_API void GetURLCacheStats(size_t& hits, size_t& misses, size_t& size);
     };
 }
 
@@ -8,6 +8,7 @@
 
 
 #include <tideutils/file_utils.h>
+#include <tideutils/zip_utils.h>
 
 #ifdef OS_OSX
 #include <Cocoa/Cocoa.h>
@@ -224,14 +225,14 @@ namespace TideUtils
         RunAndWait(cmdline, args);
         return true;
 #elif OS_LINUX
-        std::vector<std::string> args;
-        args.push_back("-qq");
-        args.push_back("-o");
-        args.push_back(source);
-        args.push_back("-d");
-        args.push_back(destination);
-        std::string cmdline("/usr/bin/unzip");
-        RunAndWait(cmdline, args);
+        std::string error;
+        if (!ZipUtils::Extract(source, destination, error, callback, data))
+        {
+#ifdef DEBUG
+            std::cout << "could not unzip " << source << ": " << error << std::endl;
+#endif
+            return false;
+        }
         return true;
 #endif
     }
@@ -0,0 +1,1417 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include <tideutils/zip_utils.h>
+
+#ifndef NO_UNZIP
+
+#include <zlib.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#define LOCAL_HEADER_SIGNATURE 0x04034b50
+#define CENTRAL_HEADER_SIGNATURE 0x02014b50
+#define END_OF_DIRECTORY_SIGNATURE 0x06054b50
+#define ZIP64_END_OF_DIRECTORY_SIGNATURE 0x06064b50
+#define ZIP64_LOCATOR_SIGNATURE 0x07064b50
+
+#define METHOD_STORED 0
+#define METHOD_DEFLATED 8
+#define FLAG_ENCRYPTED 0x0001
+#define FLAG_UTF8 0x0800
+#define HOST_UNIX 3
+
+#define MAX_THREADS 8
+#define IO_BUFFER_SIZE (256 * 1024)
+
+// Files larger than this are deflated in a streaming fashion by the
+// thread writing the archive, instead of being compressed into memory.
+#define STREAMING_THRESHOLD (32 * 1024 * 1024)
+
+namespace TideUtils
+{
+namespace ZipUtils
+{
+    static uint16_t Read16(const unsigned char* p)
+    {
+        return p[0] | (p[1] << 8);
+    }
+
+    static uint32_t Read32(const unsigned char* p)
+    {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+    }
+
+    static uint64_t Read64(const unsigned char* p)
+    {
+        return Read32(p) | ((uint64_t) Read32(p + 4) << 32);
+    }
+
+    static void Put16(std::string& out, uint16_t value)
+    {
+        out += (char) (value & 0xff);
+        out += (char) (value >> 8);
+    }
+
+    static void Put32(std::string& out, uint32_t value)
+    {
+        Put16(out, value & 0xffff);
+        Put16(out, value >> 16);
+    }
+
+    static std::string ErrnoMessage(const char* action, const std::string& path)
+    {
+        std::ostringstream message;
+        message << action << " " << path << ": " << strerror(errno);
+        return message.str();
+    }
+
+    static int ThreadCount(int requested, size_t work)
+    {
+        int count = requested;
+        if (count <= 0)
+        {
+            long processors = sysconf(_SC_NPROCESSORS_ONLN);
+            count = processors > 0 ? (int) processors : 1;
+        }
+        if (count > MAX_THREADS)
+            count = MAX_THREADS;
+        if ((size_t) count > work)
+            count = (int) work;
+        return count;
+    }
+
+    static bool WriteAll(int fd, const char* data, size_t length)
+    {
+        while (length > 0)
+        {
+            ssize_t written = write(fd, data, length);
+            if (written == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += written;
+            length -= written;
+        }
+        return true;
+    }
+
+    static time_t DosTimeToTime(uint16_t time, uint16_t date)
+    {
+        struct tm value;
+        memset(&value, 0, sizeof(value));
+        value.tm_sec = (time & 0x1f) * 2;
+        value.tm_min = (time >> 5) & 0x3f;
+        value.tm_hour = time >> 11;
+        value.tm_mday = date & 0x1f;
+        value.tm_mon = ((date >> 5) & 0x0f) - 1;
+        value.tm_year = (date >> 9) + 80;
+        value.tm_isdst = -1;
+        return mktime(&value);
+    }
+
+    static void TimeToDosTime(time_t time, uint16_t& dosTime, uint16_t& dosDate)
+    {
+        struct tm value;
+        localtime_r(&time, &value);
+        if (value.tm_year < 80)
+        {
+            dosTime = 0;
+            dosDate = (1 << 5) | 1;
+            return;
+        }
+        dosTime = (value.tm_hour << 11) | (value.tm_min << 5) | (value.tm_sec / 2);
+        dosDate = ((value.tm_year - 80) << 9) | ((value.tm_mon + 1) << 5) | value.tm_mday;
+    }
+
+    // Create path and any missing parents. When refuseLinks is set, an
+    // existing component which is not a real directory is an error, so
+    // that a symlink cannot redirect extraction outside the destination.
+    // Components already in created are trusted.
+    static bool MakeDirectories(const std::string& path, std::set<std::string>& created,
+        bool refuseLinks=false)
+    {
+        if (path.empty() || created.find(path) != created.end())
+            return true;
+
+        size_t separator = path.rfind('/');
+        if (separator != std::string::npos && separator > 0)
+        {
+            if (!MakeDirectories(path.substr(0, separator), created, refuseLinks))
+                return false;
+        }
+
+        if (mkdir(path.c_str(), 0755) == -1)
+        {
+            if (errno != EEXIST)
+                return false;
+
+            struct stat info;
+            if (refuseLinks && (lstat(path.c_str(), &info) == -1 || !S_ISDIR(info.st_mode)))
+            {
+                errno = ENOTDIR;
+                return false;
+            }
+        }
+
+        created.insert(path);
+        return true;
+    }
+
+    class ScopedMutex
+    {
+    public:
+        ScopedMutex(pthread_mutex_t& mutex) : mutex(mutex)
+        {
+            pthread_mutex_lock(&this->mutex);
+        }
+
+        ~ScopedMutex()
+        {
+            pthread_mutex_unlock(&this->mutex);
+        }
+
+    private:
+        pthread_mutex_t& mutex;
+    };
+
+    /**
+     * State shared between the calling thread and the workers of a zip
+     * operation. Workers report into it and the calling thread waits on
+     * it to make progress callbacks.
+     */
+    class ZipJob
+    {
+    public:
+        ZipJob() :
+            next(0),
+            completed(0),
+            running(0),
+            cancelled(false),
+            failed(false)
+        {
+            pthread_mutex_init(&this->mutex, 0);
+            pthread_cond_init(&this->condition, 0);
+        }
+
+        virtual ~ZipJob()
+        {
+            pthread_cond_destroy(&this->condition);
+            pthread_mutex_destroy(&this->mutex);
+        }
+
+        void Fail(const std::string& message)
+        {
+            ScopedMutex lock(this->mutex);
+            if (!this->failed)
+            {
+                this->failed = true;
+                this->error = message;
+            }
+            pthread_cond_broadcast(&this->condition);
+        }
+
+        bool Stopped()
+        {
+            ScopedMutex lock(this->mutex);
+            return this->failed || this->cancelled;
+        }
+
+        void StartWorkers(int count)
+        {
+            this->running = count;
+            for (int i = 0; i < count; i++)
+            {
+                pthread_t thread;
+                if (pthread_create(&thread, 0, &ZipJob::WorkerMain, this) != 0)
+                {
+                    this->WorkerFinished();
+                    continue;
+                }
+                this->threads.push_back(thread);
+            }
+        }
+
+        void JoinWorkers()
+        {
+            for (size_t i = 0; i < this->threads.size(); i++)
+                pthread_join(this->threads[i], 0);
+            this->threads.clear();
+        }
+
+        pthread_mutex_t mutex;
+        pthread_cond_t condition;
+        size_t next;
+        size_t completed;
+        int running;
+        bool cancelled;
+        bool failed;
+        std::string error;
+        std::string lastName;
+
+    protected:
+        virtual void Work() = 0;
+
+        void WorkerFinished()
+        {
+            ScopedMutex lock(this->mutex);
+            this->running--;
+            pthread_cond_broadcast(&this->condition);
+        }
+
+    private:
+        static void* WorkerMain(void* data)
+        {
+            ZipJob* job = static_cast<ZipJob*>(data);
+            job->Work();
+            job->WorkerFinished();
+            return 0;
+        }
+
+        std::vector<pthread_t> threads;
+    };
+
+    struct ExtractEntry
+    {
+        std::string name;
+        std::string path;
+        uint16_t method;
+        uint16_t flags;
+        uint16_t dosTime;
+        uint16_t dosDate;
+        uint32_t crc;
+        uint64_t compressedSize;
+        uint64_t size;
+        uint64_t localOffset;
+        uint32_t mode;
+        bool directory;
+        bool symlink;
+    };
+
+    static bool CompareCompressedSize(const ExtractEntry* a, const ExtractEntry* b)
+    {
+        return a->compressedSize > b->compressedSize;
+    }
+
+    class Extractor : public ZipJob
+    {
+    public:
+        Extractor() : base(0), length(0)
+        {
+        }
+
+        virtual ~Extractor()
+        {
+            if (this->base)
+                munmap((void*) this->base, this->length);
+        }
+
+        bool Open(const std::string& zipFile)
+        {
+            int fd = open(zipFile.c_str(), O_RDONLY);
+            if (fd == -1)
+            {
+                this->error = ErrnoMessage("Could not open", zipFile);
+                return false;
+            }
+
+            struct stat info;
+            if (fstat(fd, &info) == -1 || info.st_size < 22)
+            {
+                close(fd);
+                this->error = "Not a zip file: " + zipFile;
+                return false;
+            }
+
+            void* address = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (address == MAP_FAILED)
+            {
+                this->error = ErrnoMessage("Could not map", zipFile);
+                return false;
+            }
+
+            this->base = static_cast<const unsigned char*>(address);
+            this->length = info.st_size;
+            return true;
+        }
+
+        bool ReadDirectory(const std::string& destination)
+        {
+            // The end of central directory record is at the end of the
+            // file, followed only by a comment of at most 64KB.
+            const unsigned char* end = 0;
+            size_t minimum = this->length > 0xffff + 22 ? this->length - 0xffff - 22 : 0;
+            for (size_t offset = this->length - 22; ; offset--)
+            {
+                if (Read32(this->base + offset) == END_OF_DIRECTORY_SIGNATURE)
+                {
+                    end = this->base + offset;
+                    break;
+                }
+                if (offset == minimum)
+                    break;
+            }
+
+            if (!end)
+            {
+                this->error = "Could not find the zip central directory";
+                return false;
+            }
+
+            uint64_t count = Read16(end + 10);
+            uint64_t directorySize = Read32(end + 12);
+            uint64_t directoryOffset = Read32(end + 16);
+
+            // Zip64 archives keep the real values in a separate record.
+            if ((count == 0xffff || directoryOffset == 0xffffffff) &&
+                end - this->base >= 20 && Read32(end - 20) == ZIP64_LOCATOR_SIGNATURE)
+            {
+                uint64_t recordOffset = Read64(end - 20 + 8);
+                if (recordOffset > this->length || this->length - recordOffset < 56 ||
+                    Read32(this->base + recordOffset) != ZIP64_END_OF_DIRECTORY_SIGNATURE)
+                {
+                    this->error = "Corrupt Zip64 end of central directory";
+                    return false;
+                }
+                const unsigned char* record = this->base + recordOffset;
+                count = Read64(record + 32);
+                directorySize = Read64(record + 40);
+                directoryOffset = Read64(record + 48);
+            }
+
+            // Offsets and sizes can be anything in a Zip64 archive, so
+            // bounds are checked by subtracting rather than by adding,
+            // which could wrap around.
+            if (directoryOffset > this->length ||
+                directorySize > this->length - directoryOffset)
+            {
+                this->error = "Corrupt zip central directory";
+                return false;
+            }
+
+            const unsigned char* p = this->base + directoryOffset;
+            const unsigned char* directoryEnd = p + directorySize;
+            for (uint64_t i = 0; i < count; i++)
+            {
+                if (directoryEnd - p < 46 || Read32(p) != CENTRAL_HEADER_SIGNATURE)
+                {
+                    this->error = "Corrupt zip central directory entry";
+                    return false;
+                }
+
+                ExtractEntry entry;
+                uint16_t madeBy = Read16(p + 4);
+                entry.flags = Read16(p + 8);
+                entry.method = Read16(p + 10);
+                entry.dosTime = Read16(p + 12);
+                entry.dosDate = Read16(p + 14);
+                entry.crc = Read32(p + 16);
+                entry.compressedSize = Read32(p + 20);
+                entry.size = Read32(p + 24);
+                uint16_t nameLength = Read16(p + 28);
+                uint16_t extraLength = Read16(p + 30);
+                uint16_t commentLength = Read16(p + 32);
+                uint32_t externalAttributes = Read32(p + 38);
+                entry.localOffset = Read32(p + 42);
+
+                size_t entryLength = 46 + (size_t) nameLength + extraLength + commentLength;
+                if ((size_t) (directoryEnd - p) < entryLength)
+                {
+                    this->error = "Corrupt zip central directory entry";
+                    return false;
+                }
+                const unsigned char* name = p + 46;
+                const unsigned char* extra = name + nameLength;
+                p += entryLength;
+
+                // Zip64 sizes and offsets replace fields set to 0xffffffff,
+                // in the order they appear in the header. A field may not
+                // run past the end of the extra data.
+                size_t fieldOffset = 0;
+                while (extraLength - fieldOffset >= 4)
+                {
+                    const unsigned char* field = extra + fieldOffset;
+                    size_t fieldLength = Read16(field + 2);
+                    if (fieldLength > extraLength - fieldOffset - 4)
+                        break;
+                    fieldOffset += 4 + fieldLength;
+                    if (Read16(field) != 0x0001)
+                        continue;
+
+                    const unsigned char* value = field + 4;
+                    const unsigned char* valueEnd = value + fieldLength;
+                    if (entry.size == 0xffffffff && value + 8 <= valueEnd)
+                        entry.size = Read64(value), value += 8;
+                    if (entry.compressedSize == 0xffffffff && value + 8 <= valueEnd)
+                        entry.compressedSize = Read64(value), value += 8;
+                    if (entry.localOffset == 0xffffffff && value + 8 <= valueEnd)
+                        entry.localOffset = Read64(value);
+                }
+
+                entry.name.assign((const char*) name, nameLength);
+                std::replace(entry.name.begin(), entry.name.end(), '\\', '/');
+                if (!this->IsSafeName(entry.name))
+                {
+                    this->error = "Refusing to extract unsafe zip entry: " + entry.name;
+                    return false;
+                }
+
+                entry.mode = (madeBy >> 8) == HOST_UNIX ? externalAttributes >> 16 : 0;
+                entry.directory = entry.name[entry.name.size() - 1] == '/' ||
+                    (externalAttributes & 0x10) || S_ISDIR(entry.mode);
+                entry.symlink = !entry.directory && S_ISLNK(entry.mode);
+                entry.path = destination + "/" + entry.name;
+                if (entry.directory && entry.path[entry.path.size() - 1] == '/')
+                    entry.path.resize(entry.path.size() - 1);
+
+                if (entry.flags & FLAG_ENCRYPTED)
+                {
+                    this->error = "Encrypted zip entries are not supported: " + entry.name;
+                    return false;
+                }
+                if (entry.method != METHOD_STORED && entry.method != METHOD_DEFLATED)
+                {
+                    this->error = "Unsupported zip compression method for: " + entry.name;
+                    return false;
+                }
+
+                this->entries.push_back(entry);
+            }
+
+            return true;
+        }
+
+        bool CreateDirectories(const std::string& destination)
+        {
+            // Create the whole directory structure up front, so that the
+            // workers only ever write files.
+            std::set<std::string> created;
+            if (!MakeDirectories(destination, created))
+            {
+                this->error = ErrnoMessage("Could not create directory", destination);
+                return false;
+            }
+
+            for (size_t i = 0; i < this->entries.size(); i++)
+            {
+                ExtractEntry& entry = this->entries[i];
+                std::string directory(entry.path);
+                if (!entry.directory)
+                    directory = directory.substr(0, directory.rfind('/'));
+
+                if (!MakeDirectories(directory, created, true))
+                {
+                    this->error = ErrnoMessage("Could not create directory", directory);
+                    return false;
+                }
+
+                if (!entry.directory)
+                    this->files.push_back(&entry);
+            }
+
+            // Start with the largest entries to keep the workers balanced.
+            std::stable_sort(this->files.begin(), this->files.end(), CompareCompressedSize);
+            return true;
+        }
+
+        void FinishDirectories()
+        {
+            for (size_t i = 0; i < this->entries.size(); i++)
+            {
+                ExtractEntry& entry = this->entries[i];
+                if (entry.directory && entry.mode & 0777)
+                    chmod(entry.path.c_str(), entry.mode & 0777);
+            }
+        }
+
+        std::vector<ExtractEntry> entries;
+        std::vector<ExtractEntry*> files;
+
+    protected:
+        virtual void Work()
+        {
+            while (true)
+            {
+                ExtractEntry* entry;
+                {
+                    ScopedMutex lock(this->mutex);
+                    if (this->failed || this->cancelled || this->next >= this->files.size())
+                        return;
+                    entry = this->files[this->next++];
+                }
+
+                std::string message;
+                if (!this->ExtractFile(*entry, message))
+                {
+                    this->Fail(message);
+                    return;
+                }
+
+                ScopedMutex lock(this->mutex);
+                this->completed++;
+                this->lastName = entry->name;
+                pthread_cond_broadcast(&this->condition);
+            }
+        }
+
+    private:
+        bool IsSafeName(const std::string& name)
+        {
+            if (name.empty() || name[0] == '/')
+                return false;
+
+            size_t start = 0;
+            while (start <= name.size())
+            {
+                size_t end = name.find('/', start);
+                if (end == std::string::npos)
+                    end = name.size();
+                if (name.compare(start, end - start, "..") == 0)
+                    return false;
+                start = end + 1;
+            }
+            return true;
+        }
+
+        bool ExtractFile(ExtractEntry& entry, std::string& message)
+        {
+            if (entry.localOffset > this->length || this->length - entry.localOffset < 30 ||
+                Read32(this->base + entry.localOffset) != LOCAL_HEADER_SIGNATURE)
+            {
+                message = "Corrupt local header for zip entry: " + entry.name;
+                return false;
+            }
+
+            const unsigned char* local = this->base + entry.localOffset;
+            uint64_t dataOffset = entry.localOffset + 30 +
+                Read16(local + 26) + Read16(local + 28);
+            if (dataOffset > this->length || entry.compressedSize > this->length - dataOffset)
+            {
+                message = "Truncated data for zip entry: " + entry.name;
+                return false;
+            }
+
+            const unsigned char* input = this->base + dataOffset;
+            if (entry.symlink)
+                return this->ExtractLink(entry, input, message);
+
+            // Never restore setuid, setgid or sticky bits, and never write
+            // through a symlink made by an earlier entry.
+            unlink(entry.path.c_str());
+            mode_t mode = entry.mode & 0777 ? entry.mode & 0777 : 0644;
+            int fd = open(entry.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, mode);
+            if (fd == -1)
+            {
+                message = ErrnoMessage("Could not create", entry.path);
+                return false;
+            }
+
+            // Apply the mode and times through the descriptor, since the
+            // path could be replaced while the entry is written.
+            if (entry.mode & 0777)
+                fchmod(fd, entry.mode & 0777);
+
+            uint32_t crc = crc32(0, Z_NULL, 0);
+            uint64_t written = 0;
+            bool success = this->Inflate(entry, input, fd, 0, crc, written, message);
+            if (success)
+            {
+                struct timeval times[2];
+                times[0].tv_sec = times[1].tv_sec = DosTimeToTime(entry.dosTime, entry.dosDate);
+                times[0].tv_usec = times[1].tv_usec = 0;
+                futimes(fd, times);
+            }
+            if (close(fd) == -1 && success)
+            {
+                message = ErrnoMessage("Could not write", entry.path);
+                success = false;
+            }
+
+            if (success && (crc != entry.crc || written != entry.size))
+            {
+                message = "CRC mismatch for zip entry: " + entry.name;
+                success = false;
+            }
+
+            if (!success)
+            {
+                unlink(entry.path.c_str());
+                return false;
+            }
+            return true;
+        }
+
+        bool ExtractLink(ExtractEntry& entry, const unsigned char* input,
+            std::string& message)
+        {
+            std::string target;
+            uint32_t crc = crc32(0, Z_NULL, 0);
+            uint64_t written = 0;
+            if (!this->Inflate(entry, input, -1, &target, crc, written, message))
+                return false;
+
+            unlink(entry.path.c_str());
+            if (symlink(target.c_str(), entry.path.c_str()) == -1)
+            {
+                message = ErrnoMessage("Could not create symlink", entry.path);
+                return false;
+            }
+            return true;
+        }
+
+        // Decompress an entry into a file descriptor or a string.
+        bool Inflate(ExtractEntry& entry, const unsigned char* input, int fd,
+            std::string* output, uint32_t& crc, uint64_t& written,
+            std::string& message)
+        {
+            if (entry.method == METHOD_STORED)
+            {
+                uint64_t remaining = entry.compressedSize;
+                while (remaining > 0)
+                {
+                    size_t count = remaining > IO_BUFFER_SIZE ? IO_BUFFER_SIZE : remaining;
+                    crc = crc32(crc, input, count);
+                    if (output)
+                    {
+                        output->append((const char*) input, count);
+                    }
+                    else if (!WriteAll(fd, (const char*) input, count))
+                    {
+                        message = ErrnoMessage("Could not write", entry.path);
+                        return false;
+                    }
+
+                    input += count;
+                    remaining -= count;
+                    written += count;
+                    if (this->Stopped())
+                        return false;
+                }
+                return true;
+            }
+
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+            if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+            {
+                message = "Could not initialize zlib";
+                return false;
+            }
+
+            std::vector<unsigned char> buffer(IO_BUFFER_SIZE);
+            uint64_t remaining = entry.compressedSize;
+            int result = Z_OK;
+            while (result != Z_STREAM_END)
+            {
+                if (stream.avail_in == 0 && remaining > 0)
+                {
+                    // avail_in is only 32 bits wide.
+                    uInt chunk = remaining > 0x40000000 ? 0x40000000 : (uInt) remaining;
+                    stream.next_in = (Bytef*) input;
+                    stream.avail_in = chunk;
+                    input += chunk;
+                    remaining -= chunk;
+                }
+
+                stream.next_out = &buffer[0];
+                stream.avail_out = buffer.size();
+                result = inflate(&stream, Z_NO_FLUSH);
+                if (result != Z_OK && result != Z_STREAM_END)
+                {
+                    inflateEnd(&stream);
+                    message = "Corrupt compressed data for zip entry: " + entry.name;
+                    return false;
+                }
+
+                size_t count = buffer.size() - stream.avail_out;
+                crc = crc32(crc, &buffer[0], count);
+                written += count;
+                if (output)
+                {
+                    output->append((const char*) &buffer[0], count);
+                }
+                else if (!WriteAll(fd, (const char*) &buffer[0], count))
+                {
+                    inflateEnd(&stream);
+                    message = ErrnoMessage("Could not write", entry.path);
+                    return false;
+                }
+
+                if (result == Z_OK && count == 0 && stream.avail_in == 0 && remaining == 0)
+                {
+                    inflateEnd(&stream);
+                    message = "Truncated compressed data for zip entry: " + entry.name;
+                    return false;
+                }
+
+                if (this->Stopped())
+                {
+                    inflateEnd(&stream);
+                    return false;
+                }
+            }
+
+            inflateEnd(&stream);
+            return true;
+        }
+
+        const unsigned char* base;
+        size_t length;
+    };
+
+    bool Extract(const std::string& zipFile, const std::string& destination,
+        std::string& error, FileUtils::UnzipCallback callback, void* data, int threads)
+    {
+        Extractor extractor;
+        if (!extractor.Open(zipFile) ||
+            !extractor.ReadDirectory(destination) ||
+            !extractor.CreateDirectories(destination))
+        {
+            error = extractor.error;
+            return false;
+        }
+
+        size_t total = extractor.files.size();
+        if (callback)
+        {
+            std::ostringstream message;
+            message << "Starting extraction of " << total
+                << " items from " << zipFile << " to " << destination;
+            std::string messageString(message.str());
+            if (!callback((char*) messageString.c_str(), 0, total, data))
+            {
+                error = "Extraction cancelled";
+                return false;
+            }
+        }
+
+        extractor.StartWorkers(ThreadCount(threads, total));
+
+        // Report progress from this thread while the workers run.
+        size_t reported = 0;
+        pthread_mutex_lock(&extractor.mutex);
+        while (extractor.running > 0)
+        {
+            if (callback && extractor.completed != reported && !extractor.cancelled)
+            {
+                reported = extractor.completed;
+                std::string message("Extracting ");
+                message.append(extractor.lastName);
+                message.append("...");
+
+                pthread_mutex_unlock(&extractor.mutex);
+                bool proceed = callback((char*) message.c_str(), reported, total, data);
+                pthread_mutex_lock(&extractor.mutex);
+
+                if (!proceed)
+                    extractor.cancelled = true;
+                continue;
+            }
+            pthread_cond_wait(&extractor.condition, &extractor.mutex);
+        }
+        pthread_mutex_unlock(&extractor.mutex);
+        extractor.JoinWorkers();
+
+        if (extractor.failed)
+        {
+            error = extractor.error;
+            return false;
+        }
+        if (extractor.cancelled)
+        {
+            error = "Extraction cancelled";
+            return false;
+        }
+        if (extractor.completed != total)
+        {
+            error = "Could not start zip extraction threads";
+            return false;
+        }
+
+        extractor.FinishDirectories();
+        return true;
+    }
+
+    struct CreateEntry
+    {
+        std::string path;
+        std::string name;
+        bool directory;
+        bool symlink;
+        uint32_t mode;
+        time_t modified;
+        uint64_t size;
+
+        // Filled in once the entry has been compressed.
+        std::string data;
+        uint16_t method;
+        uint32_t crc;
+        uint64_t offset;
+    };
+
+    class Creator : public ZipJob
+    {
+    public:
+        Creator() : maxPending(0), fd(-1), offset(0)
+        {
+        }
+
+        virtual ~Creator()
+        {
+            if (this->fd != -1)
+                close(this->fd);
+        }
+
+        bool Scan(const std::string& directory, const std::string& prefix)
+        {
+            DIR* dir = opendir(directory.c_str());
+            if (!dir)
+            {
+                this->error = ErrnoMessage("Could not open directory", directory);
+                return false;
+            }
+
+            struct dirent* dirent;
+            while ((dirent = readdir(dir)))
+            {
+                const char* name = dirent->d_name;
+                if (!strcmp(name, ".") || !strcmp(name, ".."))
+                    continue;
+
+                CreateEntry entry;
+                entry.path = directory + "/" + name;
+                entry.name = prefix + name;
+
+                struct stat info;
+                if (lstat(entry.path.c_str(), &info) == -1)
+                {
+                    closedir(dir);
+                    this->error = ErrnoMessage("Could not stat", entry.path);
+                    return false;
+                }
+
+                entry.directory = S_ISDIR(info.st_mode);
+                entry.symlink = S_ISLNK(info.st_mode);
+                if (!entry.directory && !entry.symlink && !S_ISREG(info.st_mode))
+                    continue;
+
+                entry.mode = info.st_mode;
+                entry.modified = info.st_mtime;
+                entry.size = entry.directory ? 0 : info.st_size;
+                entry.method = METHOD_STORED;
+                entry.crc = 0;
+                entry.offset = 0;
+
+                if (entry.directory)
+                    entry.name += "/";
+
+                this->entries.push_back(entry);
+                if (entry.directory && !this->Scan(entry.path, entry.name))
+                {
+                    closedir(dir);
+                    return false;
+                }
+            }
+
+            closedir(dir);
+            return true;
+        }
+
+        bool OpenOutput(const std::string& zipFile)
+        {
+            this->fd = open(zipFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (this->fd == -1)
+            {
+                this->error = ErrnoMessage("Could not create", zipFile);
+                return false;
+            }
+            return true;
+        }
+
+        void Partition(int threads)
+        {
+            for (size_t i = 0; i < this->entries.size(); i++)
+            {
+                CreateEntry& entry = this->entries[i];
+                if (!entry.directory && !entry.symlink && entry.size > STREAMING_THRESHOLD)
+                    this->streamed.push_back(&entry);
+                else
+                    this->work.push_back(&entry);
+            }
+
+            // Bound the amount of compressed data waiting to be written.
+            this->maxPending = threads * 2;
+        }
+
+        // Called on the writing thread. Returns false on failure.
+        bool WriteEntry(CreateEntry& entry)
+        {
+            entry.offset = this->offset;
+            std::string header(this->LocalHeader(entry));
+            if (!WriteAll(this->fd, header.data(), header.size()) ||
+                !WriteAll(this->fd, entry.data.data(), entry.data.size()))
+            {
+                this->error = "Could not write zip file";
+                return false;
+            }
+
+            this->offset += header.size() + entry.data.size();
+            this->compressedSizes.push_back(entry.data.size());
+            this->written.push_back(&entry);
+
+            // The data is not needed for the central directory.
+            std::string().swap(entry.data);
+            return this->CheckLimits();
+        }
+
+        // Deflate a large file straight into the archive and patch its
+        // local header once the sizes are known.
+        bool StreamEntry(CreateEntry& entry)
+        {
+            int in = open(entry.path.c_str(), O_RDONLY);
+            if (in == -1)
+            {
+                this->error = ErrnoMessage("Could not open", entry.path);
+                return false;
+            }
+
+            entry.offset = this->offset;
+            entry.method = METHOD_DEFLATED;
+            entry.crc = 0;
+            std::string header(this->LocalHeader(entry));
+            if (!WriteAll(this->fd, header.data(), header.size()))
+            {
+                close(in);
+                this->error = "Could not write zip file";
+                return false;
+            }
+
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+            deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+
+            std::vector<unsigned char> input(IO_BUFFER_SIZE);
+            std::vector<unsigned char> output(IO_BUFFER_SIZE);
+            uint32_t crc = crc32(0, Z_NULL, 0);
+            uint64_t size = 0, compressedSize = 0;
+            bool success = true;
+            int flush = Z_NO_FLUSH;
+
+            while (success && flush != Z_FINISH)
+            {
+                ssize_t count = read(in, &input[0], input.size());
+                if (count == -1)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    this->error = ErrnoMessage("Could not read", entry.path);
+                    success = false;
+                    break;
+                }
+
+                flush = count == 0 ? Z_FINISH : Z_NO_FLUSH;
+                crc = crc32(crc, &input[0], count);
+                size += count;
+                stream.next_in = &input[0];
+                stream.avail_in = count;
+
+                do
+                {
+                    stream.next_out = &output[0];
+                    stream.avail_out = output.size();
+                    deflate(&stream, flush);
+
+                    size_t produced = output.size() - stream.avail_out;
+                    compressedSize += produced;
+                    if (!WriteAll(this->fd, (const char*) &output[0], produced))
+                    {
+                        this->error = "Could not write zip file";
+                        success = false;
+                        break;
+                    }
+                } while (stream.avail_out == 0);
+
+                if (this->Stopped())
+                    success = false;
+            }
+
+            deflateEnd(&stream);
+            close(in);
+            if (!success)
+                return false;
+
+            entry.crc = crc;
+            entry.size = size;
+            this->offset += header.size() + compressedSize;
+
+            std::string sizes;
+            Put32(sizes, crc);
+            Put32(sizes, (uint32_t) compressedSize);
+            Put32(sizes, (uint32_t) size);
+            if (pwrite(this->fd, sizes.data(), sizes.size(), entry.offset + 14) != 12)
+            {
+                this->error = "Could not write zip file";
+                return false;
+            }
+
+            this->compressedSizes.push_back(compressedSize);
+            this->written.push_back(&entry);
+            if (size > 0xffffffff || compressedSize > 0xffffffff)
+            {
+                this->error = "Zip entries larger than 4GB are not supported: " + entry.name;
+                return false;
+            }
+            return this->CheckLimits();
+        }
+
+        bool WriteCentralDirectory()
+        {
+            std::string directory;
+            for (size_t i = 0; i < this->written.size(); i++)
+            {
+                CreateEntry& entry = *this->written[i];
+                uint16_t dosTime, dosDate;
+                TimeToDosTime(entry.modified, dosTime, dosDate);
+
+                Put32(directory, CENTRAL_HEADER_SIGNATURE);
+                Put16(directory, (HOST_UNIX << 8) | 20);
+                Put16(directory, 20);
+                Put16(directory, FLAG_UTF8);
+                Put16(directory, entry.method);
+                Put16(directory, dosTime);
+                Put16(directory, dosDate);
+                Put32(directory, entry.crc);
+                Put32(directory, (uint32_t) this->compressedSizes[i]);
+                Put32(directory, (uint32_t) entry.size);
+                Put16(directory, entry.name.size());
+                Put16(directory, 0);
+                Put16(directory, 0);
+                Put16(directory, 0);
+                Put16(directory, 0);
+                Put32(directory, (entry.mode << 16) | (entry.directory ? 0x10 : 0));
+                Put32(directory, (uint32_t) entry.offset);
+                directory.append(entry.name);
+            }
+
+            std::string end;
+            Put32(end, END_OF_DIRECTORY_SIGNATURE);
+            Put16(end, 0);
+            Put16(end, 0);
+            Put16(end, this->written.size());
+            Put16(end, this->written.size());
+            Put32(end, directory.size());
+            Put32(end, (uint32_t) this->offset);
+            Put16(end, 0);
+
+            if (this->offset + directory.size() > 0xffffffff)
+            {
+                this->error = "Zip archives larger than 4GB are not supported";
+                return false;
+            }
+
+            if (!WriteAll(this->fd, directory.data(), directory.size()) ||
+                !WriteAll(this->fd, end.data(), end.size()) ||
+                close(this->fd) == -1)
+            {
+                this->fd = -1;
+                this->error = "Could not write zip file";
+                return false;
+            }
+
+            this->fd = -1;
+            return true;
+        }
+
+        std::vector<CreateEntry> entries;
+        std::vector<CreateEntry*> work;
+        std::vector<CreateEntry*> streamed;
+        std::deque<CreateEntry*> pending;
+        size_t maxPending;
+
+    protected:
+        virtual void Work()
+        {
+            while (true)
+            {
+                CreateEntry* entry;
+                {
+                    ScopedMutex lock(this->mutex);
+                    while (this->pending.size() >= this->maxPending &&
+                        !this->failed && !this->cancelled)
+                    {
+                        pthread_cond_wait(&this->condition, &this->mutex);
+                    }
+
+                    if (this->failed || this->cancelled || this->next >= this->work.size())
+                        return;
+                    entry = this->work[this->next++];
+                }
+
+                std::string message;
+                if (!this->Compress(*entry, message))
+                {
+                    this->Fail(message);
+                    return;
+                }
+
+                ScopedMutex lock(this->mutex);
+                this->pending.push_back(entry);
+                pthread_cond_broadcast(&this->condition);
+            }
+        }
+
+    private:
+        std::string LocalHeader(CreateEntry& entry)
+        {
+            uint16_t dosTime, dosDate;
+            TimeToDosTime(entry.modified, dosTime, dosDate);
+
+            std::string header;
+            Put32(header, LOCAL_HEADER_SIGNATURE);
+            Put16(header, 20);
+            Put16(header, FLAG_UTF8);
+            Put16(header, entry.method);
+            Put16(header, dosTime);
+            Put16(header, dosDate);
+            Put32(header, entry.crc);
+            Put32(header, (uint32_t) entry.data.size());
+            Put32(header, (uint32_t) entry.size);
+            Put16(header, entry.name.size());
+            Put16(header, 0);
+            header.append(entry.name);
+            return header;
+        }
+
+        bool CheckLimits()
+        {
+            if (this->offset > 0xffffffff || this->written.size() > 0xffff)
+            {
+                this->error = "Zip archives larger than 4GB or 65535 entries are not supported";
+                return false;
+            }
+            return true;
+        }
+
+        bool ReadContents(CreateEntry& entry, std::string& contents, std::string& message)
+        {
+            if (entry.symlink)
+            {
+                std::vector<char> target(PATH_MAX);
+                ssize_t length = readlink(entry.path.c_str(), &target[0], target.size());
+                if (length == -1)
+                {
+                    message = ErrnoMessage("Could not read symlink", entry.path);
+                    return false;
+                }
+                contents.assign(&target[0], length);
+                return true;
+            }
+
+            int in = open(entry.path.c_str(), O_RDONLY);
+            if (in == -1)
+            {
+                message = ErrnoMessage("Could not open", entry.path);
+                return false;
+            }
+
+            contents.resize(entry.size);
+            size_t total = 0;
+            while (total < contents.size())
+            {
+                ssize_t count = read(in, &contents[total], contents.size() - total);
+                if (count == -1 && errno == EINTR)
+                    continue;
+                if (count <= 0)
+                    break;
+                total += count;
+            }
+            close(in);
+
+            // The file may have shrunk since it was scanned.
+            contents.resize(total);
+            return true;
+        }
+
+        bool Compress(CreateEntry& entry, std::string& message)
+        {
+            if (entry.directory)
+            {
+                entry.crc = crc32(0, Z_NULL, 0);
+                return true;
+            }
+
+            std::string contents;
+            if (!this->ReadContents(entry, contents, message))
+                return false;
+
+            entry.size = contents.size();
+            entry.crc = crc32(crc32(0, Z_NULL, 0),
+                (const Bytef*) contents.data(), contents.size());
+
+            if (contents.size() > 0 && !entry.symlink)
+            {
+                z_stream stream;
+                memset(&stream, 0, sizeof(stream));
+                deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                    -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+
+                std::string compressed;
+                compressed.resize(deflateBound(&stream, contents.size()));
+                stream.next_in = (Bytef*) contents.data();
+                stream.avail_in = contents.size();
+                stream.next_out = (Bytef*) &compressed[0];
+                stream.avail_out = compressed.size();
+
+                int result = deflate(&stream, Z_FINISH);
+                size_t length = compressed.size() - stream.avail_out;
+                deflateEnd(&stream);
+
+                // Keep incompressible data stored.
+                if (result == Z_STREAM_END && length < contents.size())
+                {
+                    compressed.resize(length);
+                    entry.data.swap(compressed);
+                    entry.method = METHOD_DEFLATED;
+                    return true;
+                }
+            }
+
+            entry.data.swap(contents);
+            entry.method = METHOD_STORED;
+            return true;
+        }
+
+        int fd;
+        uint64_t offset;
+        std::vector<CreateEntry*> written;
+        std::vector<uint64_t> compressedSizes;
+    };
+
+    bool Create(const std::string& directory, const std::string& zipFile,
+        std::string& error, FileUtils::UnzipCallback callback, void* data, int threads)
+    {
+        Creator creator;
+        std::string root(directory);
+        while (root.size() > 1 && root[root.size() - 1] == '/')
+            root.resize(root.size() - 1);
+
+        if (!creator.Scan(root, "") || !creator.OpenOutput(zipFile))
+        {
+            error = creator.error;
+            return false;
+        }
+
+        size_t total = creator.entries.size();
+        int threadCount = ThreadCount(threads, total);
+        creator.Partition(threadCount > 0 ? threadCount : 1);
+        creator.StartWorkers(threadCount);
+
+        // This thread writes the archive: compressed entries as the
+        // workers finish them, and large files by streaming them itself.
+        size_t written = 0;
+        size_t nextStreamed = 0;
+        bool success = true;
+        pthread_mutex_lock(&creator.mutex);
+        while (success && !creator.failed && !creator.cancelled)
+        {
+            CreateEntry* entry = 0;
+            bool stream = false;
+            if (!creator.pending.empty())
+            {
+                entry = creator.pending.front();
+                creator.pending.pop_front();
+                pthread_cond_broadcast(&creator.condition);
+            }
+            else if (nextStreamed < creator.streamed.size())
+            {
+                entry = creator.streamed[nextStreamed++];
+                stream = true;
+            }
+            else if (creator.running > 0)
+            {
+                pthread_cond_wait(&creator.condition, &creator.mutex);
+                continue;
+            }
+            else
+            {
+                break;
+            }
+
+            pthread_mutex_unlock(&creator.mutex);
+            success = stream ? creator.StreamEntry(*entry) : creator.WriteEntry(*entry);
+            written++;
+
+            if (success && callback)
+            {
+                std::string message("Adding ");
+                message.append(entry->name);
+                message.append("...");
+                if (!callback((char*) message.c_str(), written, total, data))
+                {
+                    ScopedMutex lock(creator.mutex);
+                    creator.cancelled = true;
+                    creator.error = "Zip creation cancelled";
+                }
+            }
+            pthread_mutex_lock(&creator.mutex);
+        }
+
+        if (!success && !creator.failed)
+        {
+            creator.failed = true;
+            pthread_cond_broadcast(&creator.condition);
+        }
+        pthread_mutex_unlock(&creator.mutex);
+        creator.JoinWorkers();
+
+        if (creator.failed || creator.cancelled)
+        {
+            error = creator.error;
+            unlink(zipFile.c_str());
+            return false;
+        }
+
+        if (written != total)
+        {
+            error = "Could not start zip compression threads";
+            unlink(zipFile.c_str());
+            return false;
+        }
+
+        if (!creator.WriteCentralDirectory())
+        {
+            error = creator.error;
+            unlink(zipFile.c_str());
+            return false;
+        }
+        return true;
+    }
+}
+}
+
+#endif
@@ -0,0 +1,48 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _ZIP_UTILS_H_
+#define _ZIP_UTILS_H_
+
+#include <tideutils/file_utils.h>
+
+#if !defined(NO_UNZIP) && !defined(OS_WIN32)
+
+/**
+ * A native zip engine built on zlib. Entries are inflated and deflated
+ * on a pool of worker threads, while progress callbacks are always made
+ * on the calling thread. A callback returning false cancels the work.
+ * When threads is zero, one thread per processor is used.
+ */
+namespace TideUtils
+{
+    namespace ZipUtils
+    {
+        /**
+         * Extract all entries of zipFile into destination, preserving
+         * Unix modes, symbolic links and modification times. Entries
+         * which would be written outside of destination are rejected.
+         */
+        TIDE_UTILS_API bool Extract(const std::string& zipFile,
+            const std::string& destination, std::string& error,
+            FileUtils::UnzipCallback callback=0, void* data=0, int threads=0);
+
+        /**
+         * Create zipFile from the contents of directory. Entry names are
+         * relative to directory. Archives are limited to 4GB and 65535
+         * entries, since Zip64 output is not supported.
+         */
+        TIDE_UTILS_API bool Create(const std::string& directory,
+            const std::string& zipFile, std::string& error,
+            FileUtils::UnzipCallback callback=0, void* data=0, int threads=0);
+    }
+}
+
+#endif
+
+#endif
@@ -118,6 +118,15 @@ namespace ti
 		 */
 		this->SetMethod("appURLToPath", &AppBinding::AppURLToPath);
 
+		/**
+		 * @tiapi(method=True,name=App.getURLCacheStats,since=1.4)
+		 * @tiapi Return counters for the cache of URL to path conversions
+		 * @tiapi used when loading app://, ti:// and relative URLs.
+		 * @tiresult(for=App.getURLCacheStats,type=Object) an object with
+		 * @tiresult hits, misses and size properties
+		 */
+		this->SetMethod("getURLCacheStats", &AppBinding::GetURLCacheStats);
+
 		/**
 		 * @tiapi(method=True,name=App.exit,since=0.2)
 		 * @tiapi Exit the application.
@@ -247,6 +256,18 @@ namespace ti
 		result->SetString(path);
 	}
 
+	void AppBinding::GetURLCacheStats(const ValueList& args, ValueRef result)
+	{
+		size_t hits, misses, size;
+		URLUtils::GetURLCacheStats(hits, misses, size);
+
+		TiObjectRef stats(new StaticBoundObject());
+		stats->SetDouble("hits", hits);
+		stats->SetDouble("misses", misses);
+		stats->SetInt("size", size);
+		result->SetObject(stats);
+	}
+
 	void AppBinding::CreateProperties(const ValueList& args, ValueRef result)
 	{
 		AutoPtr<PropertiesBinding> properties = new PropertiesBinding();
@@ -38,6 +38,7 @@ namespace ti
 		void GetHome(const ValueList& args, ValueRef result);
 		void GetArguments(const ValueList& args, ValueRef result);
 		void AppURLToPath(const ValueList& args, ValueRef result);
+		void GetURLCacheStats(const ValueList& args, ValueRef result);
 		void SetMenu(const ValueList& args, ValueRef result);
 		void Exit(const ValueList& args, ValueRef result);
 		void Restart(const ValueList& args, ValueRef result);
@@ -0,0 +1,521 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include "binary_encoding.h"
+
+#include <cctype>
+#include <cstring>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// SSSE3 code is compiled into every build and only used when the
+// processor supports it, which needs per-function target attributes
+// on GCC and Clang.
+#if defined(USE_SSE2) && (defined(_MSC_VER) || defined(__clang__) || \
+    (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define USE_SSSE3 1
+#include <tmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SSSE3_FUNCTION
+#else
+#define SSSE3_FUNCTION __attribute__((target("ssse3")))
+#endif
+#endif
+
+namespace ti
+{
+    static const char base64Alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    static const char base64UrlAlphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    static const char hexDigits[] = "0123456789abcdef";
+
+    // Characters that are not part of an encoding decode to one of
+    // these, which are all larger than any encoded value.
+    enum
+    {
+        CHAR_PAD = 0xfd,
+        CHAR_SPACE = 0xfe,
+        CHAR_INVALID = 0xff
+    };
+
+    struct DecodeTables
+    {
+        unsigned char base64[256];
+        unsigned char base64Url[256];
+        unsigned char hex[256];
+
+        DecodeTables()
+        {
+            memset(base64, CHAR_INVALID, sizeof(base64));
+            memset(base64Url, CHAR_INVALID, sizeof(base64Url));
+            memset(hex, CHAR_INVALID, sizeof(hex));
+
+            for (int i = 0; i < 64; i++)
+            {
+                base64[(unsigned char) base64Alphabet[i]] = i;
+                base64Url[(unsigned char) base64UrlAlphabet[i]] = i;
+            }
+            for (int i = 0; i < 16; i++)
+            {
+                hex[(unsigned char) hexDigits[i]] = i;
+                hex[(unsigned char) toupper(hexDigits[i])] = i;
+            }
+
+            const char* spaces = " \t\r\n\f\v";
+            for (const char* c = spaces; *c; c++)
+            {
+                base64[(unsigned char) *c] = CHAR_SPACE;
+                base64Url[(unsigned char) *c] = CHAR_SPACE;
+                hex[(unsigned char) *c] = CHAR_SPACE;
+            }
+            base64['='] = CHAR_PAD;
+            base64Url['='] = CHAR_PAD;
+        }
+    };
+    static const DecodeTables tables;
+
+#if defined(USE_SSSE3)
+    static bool DetectSSSE3()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3");
+#endif
+    }
+    static const bool hasSSSE3 = DetectSSSE3();
+
+    // Encode 12 bytes at a time into 16 characters, reading 16 bytes
+    // of input for each block. Returns the number of bytes encoded.
+    SSSE3_FUNCTION
+    static size_t EncodeBase64SSSE3(const unsigned char* in, size_t length,
+        char* out, bool url)
+    {
+        const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+            4, 5, 3, 4, 1, 2, 0, 1);
+        const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, (url ? '-' : '+') - 62, (url ? '_' : '/') - 63,
+            'A', 0, 0);
+
+        size_t i = 0;
+        for (; i + 16 <= length; i += 12, out += 16)
+        {
+            // Move each group of three bytes into a 32-bit lane and
+            // shift its four 6-bit values into separate bytes.
+            __m128i input = _mm_loadu_si128((const __m128i*) (in + i));
+            input = _mm_shuffle_epi8(input, spread);
+            __m128i high = _mm_mulhi_epu16(
+                _mm_and_si128(input, _mm_set1_epi32(0x0fc0fc00)),
+                _mm_set1_epi32(0x04000040));
+            __m128i low = _mm_mullo_epi16(
+                _mm_and_si128(input, _mm_set1_epi32(0x003f03f0)),
+                _mm_set1_epi32(0x01000010));
+            __m128i values = _mm_or_si128(high, low);
+
+            // Turn each value into an index into the offset table:
+            // 0 to 25 become 13, 26 to 51 become 0 and 52 to 63
+            // become 1 to 12.
+            __m128i index = _mm_subs_epu8(values, _mm_set1_epi8(51));
+            __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), values);
+            index = _mm_or_si128(index, _mm_and_si128(upper, _mm_set1_epi8(13)));
+            __m128i chars = _mm_add_epi8(values, _mm_shuffle_epi8(offsets, index));
+            _mm_storeu_si128((__m128i*) out, chars);
+        }
+        return i;
+    }
+
+    // Decode 16 characters at a time into 12 bytes, stopping at the
+    // first block with any character outside the alphabet. Returns
+    // the number of characters decoded.
+    SSSE3_FUNCTION
+    static size_t DecodeBase64SSSE3(const unsigned char* in, size_t length,
+        unsigned char* out, bool url)
+    {
+        const __m128i char62 = _mm_set1_epi8(url ? '-' : '+');
+        const __m128i char63 = _mm_set1_epi8(url ? '_' : '/');
+        const __m128i order = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+            14, 13, 12, -1, -1, -1, -1);
+
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16, out += 12)
+        {
+            // Bytes above 0x7f compare as negative, so they fall
+            // outside every range.
+            __m128i input = _mm_loadu_si128((const __m128i*) (in + i));
+            __m128i upper = _mm_and_si128(
+                _mm_cmpgt_epi8(input, _mm_set1_epi8('A' - 1)),
+                _mm_cmplt_epi8(input, _mm_set1_epi8('Z' + 1)));
+            __m128i lower = _mm_and_si128(
+                _mm_cmpgt_epi8(input, _mm_set1_epi8('a' - 1)),
+                _mm_cmplt_epi8(input, _mm_set1_epi8('z' + 1)));
+            __m128i digit = _mm_and_si128(
+                _mm_cmpgt_epi8(input, _mm_set1_epi8('0' - 1)),
+                _mm_cmplt_epi8(input, _mm_set1_epi8('9' + 1)));
+            __m128i is62 = _mm_cmpeq_epi8(input, char62);
+            __m128i is63 = _mm_cmpeq_epi8(input, char63);
+
+            __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower),
+                _mm_or_si128(digit, _mm_or_si128(is62, is63)));
+            if (_mm_movemask_epi8(valid) != 0xffff)
+                break;
+
+            __m128i values = _mm_or_si128(
+                _mm_or_si128(
+                    _mm_and_si128(upper, _mm_sub_epi8(input, _mm_set1_epi8('A'))),
+                    _mm_and_si128(lower, _mm_sub_epi8(input, _mm_set1_epi8('a' - 26)))),
+                _mm_or_si128(
+                    _mm_and_si128(digit, _mm_add_epi8(input, _mm_set1_epi8(52 - '0'))),
+                    _mm_or_si128(
+                        _mm_and_si128(is62, _mm_set1_epi8(62)),
+                        _mm_and_si128(is63, _mm_set1_epi8(63)))));
+
+            // Merge pairs of 6-bit values into 12 bits, then pairs of
+            // those into 24 bits, and put the bytes in order.
+            __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+            merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+            merged = _mm_shuffle_epi8(merged, order);
+
+            char block[16];
+            _mm_storeu_si128((__m128i*) block, merged);
+            memcpy(out, block, 12);
+        }
+        return i;
+    }
+#endif
+
+#if defined(USE_SSE2)
+    static inline __m128i ToHexDigits(__m128i nibbles)
+    {
+        __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)),
+            _mm_set1_epi8('a' - '0' - 10));
+        return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+    }
+
+    static size_t EncodeHexSSE2(const unsigned char* in, size_t length, char* out)
+    {
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16, out += 32)
+        {
+            __m128i input = _mm_loadu_si128((const __m128i*) (in + i));
+            __m128i high = _mm_and_si128(_mm_srli_epi16(input, 4), _mm_set1_epi8(0x0f));
+            __m128i low = _mm_and_si128(input, _mm_set1_epi8(0x0f));
+            _mm_storeu_si128((__m128i*) out, ToHexDigits(_mm_unpacklo_epi8(high, low)));
+            _mm_storeu_si128((__m128i*) (out + 16), ToHexDigits(_mm_unpackhi_epi8(high, low)));
+        }
+        return i;
+    }
+
+    static inline bool FromHexDigits(__m128i input, __m128i* values)
+    {
+        __m128i digit = _mm_and_si128(
+            _mm_cmpgt_epi8(input, _mm_set1_epi8('0' - 1)),
+            _mm_cmplt_epi8(input, _mm_set1_epi8('9' + 1)));
+        __m128i lower = _mm_and_si128(
+            _mm_cmpgt_epi8(input, _mm_set1_epi8('a' - 1)),
+            _mm_cmplt_epi8(input, _mm_set1_epi8('f' + 1)));
+        __m128i upper = _mm_and_si128(
+            _mm_cmpgt_epi8(input, _mm_set1_epi8('A' - 1)),
+            _mm_cmplt_epi8(input, _mm_set1_epi8('F' + 1)));
+        if (_mm_movemask_epi8(_mm_or_si128(digit, _mm_or_si128(lower, upper))) != 0xffff)
+            return false;
+
+        *values = _mm_or_si128(
+            _mm_and_si128(digit, _mm_sub_epi8(input, _mm_set1_epi8('0'))),
+            _mm_or_si128(
+                _mm_and_si128(lower, _mm_sub_epi8(input, _mm_set1_epi8('a' - 10))),
+                _mm_and_si128(upper, _mm_sub_epi8(input, _mm_set1_epi8('A' - 10)))));
+        return true;
+    }
+
+    // Decode 32 characters at a time, stopping at the first block with
+    // a character that is not a hex digit. Returns the number of
+    // characters decoded.
+    static size_t DecodeHexSSE2(const unsigned char* in, size_t length, unsigned char* out)
+    {
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32, out += 16)
+        {
+            __m128i first, second;
+            if (!FromHexDigits(_mm_loadu_si128((const __m128i*) (in + i)), &first)
+                || !FromHexDigits(_mm_loadu_si128((const __m128i*) (in + i + 16)), &second))
+                break;
+
+            // Each 16-bit lane holds the high nibble of a byte in its
+            // low half and the low nibble in its high half.
+            const __m128i mask = _mm_set1_epi16(0x00ff);
+            first = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(first, mask), 4),
+                _mm_srli_epi16(first, 8));
+            second = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(second, mask), 4),
+                _mm_srli_epi16(second, 8));
+            _mm_storeu_si128((__m128i*) out, _mm_packus_epi16(first, second));
+        }
+        return i;
+    }
+#endif
+
+    static size_t EncodeBase64(const unsigned char* in, size_t length, char* out, bool url)
+    {
+        const char* alphabet = url ? base64UrlAlphabet : base64Alphabet;
+        char* start = out;
+        size_t i = 0;
+
+#if defined(USE_SSSE3)
+        if (hasSSSE3)
+        {
+            i = EncodeBase64SSSE3(in, length, out, url);
+            out += i / 3 * 4;
+        }
+#endif
+
+        for (; i + 3 <= length; i += 3)
+        {
+            unsigned int group = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+            *out++ = alphabet[group >> 18];
+            *out++ = alphabet[(group >> 12) & 0x3f];
+            *out++ = alphabet[(group >> 6) & 0x3f];
+            *out++ = alphabet[group & 0x3f];
+        }
+
+        size_t remaining = length - i;
+        if (remaining > 0)
+        {
+            unsigned int group = in[i] << 16;
+            if (remaining == 2)
+                group |= in[i + 1] << 8;
+
+            *out++ = alphabet[group >> 18];
+            *out++ = alphabet[(group >> 12) & 0x3f];
+            if (remaining == 2)
+                *out++ = alphabet[(group >> 6) & 0x3f];
+            else if (!url)
+                *out++ = '=';
+            if (!url)
+                *out++ = '=';
+        }
+        return out - start;
+    }
+
+    // Decode whole groups of four characters, stopping at the first one
+    // which contains whitespace, padding or an invalid character.
+    // Returns the number of bytes written.
+    static size_t DecodeBase64Groups(const unsigned char* in, size_t length,
+        unsigned char* out, bool url, size_t* consumed)
+    {
+        const unsigned char* table = url ? tables.base64Url : tables.base64;
+        unsigned char* start = out;
+        size_t i = 0;
+
+#if defined(USE_SSSE3)
+        if (hasSSSE3)
+        {
+            i = DecodeBase64SSSE3(in, length, out, url);
+            out += i / 4 * 3;
+        }
+#endif
+
+        for (; i + 4 <= length; i += 4)
+        {
+            unsigned int a = table[in[i]];
+            unsigned int b = table[in[i + 1]];
+            unsigned int c = table[in[i + 2]];
+            unsigned int d = table[in[i + 3]];
+            if ((a | b | c | d) > 0x3f)
+                break;
+
+            unsigned int group = (a << 18) | (b << 12) | (c << 6) | d;
+            *out++ = (unsigned char) (group >> 16);
+            *out++ = (unsigned char) (group >> 8);
+            *out++ = (unsigned char) group;
+        }
+
+        *consumed = i;
+        return out - start;
+    }
+
+    static bool DecodeBase64(const unsigned char* in, size_t length,
+        unsigned char* out, size_t* written, bool url)
+    {
+        size_t consumed;
+        size_t decoded = DecodeBase64Groups(in, length, out, url, &consumed);
+        if (consumed == length)
+        {
+            *written = decoded;
+            return true;
+        }
+
+        // Whatever follows contains whitespace, padding or a partial
+        // group. Gather its characters and decode those.
+        const unsigned char* table = url ? tables.base64Url : tables.base64;
+        std::string rest;
+        rest.reserve(length - consumed);
+        size_t padding = 0;
+        for (size_t i = consumed; i < length; i++)
+        {
+            unsigned char value = table[in[i]];
+            if (value == CHAR_SPACE)
+                continue;
+            if (value == CHAR_PAD)
+                padding++;
+            else if (value == CHAR_INVALID || padding > 0)
+                return false;
+            else
+                rest += in[i];
+        }
+
+        const unsigned char* restData = (const unsigned char*) rest.data();
+        decoded += DecodeBase64Groups(restData, rest.size(), out + decoded, url, &consumed);
+
+        size_t remaining = rest.size() - consumed;
+        if (remaining == 1 || padding > 2)
+            return false;
+
+        if (remaining > 1)
+        {
+            unsigned int group = (table[restData[consumed]] << 18)
+                | (table[restData[consumed + 1]] << 12);
+            if (remaining == 3)
+                group |= table[restData[consumed + 2]] << 6;
+
+            out[decoded++] = (unsigned char) (group >> 16);
+            if (remaining == 3)
+                out[decoded++] = (unsigned char) (group >> 8);
+        }
+
+        *written = decoded;
+        return true;
+    }
+
+    static size_t EncodeHex(const unsigned char* in, size_t length, char* out)
+    {
+        size_t i = 0;
+#if defined(USE_SSE2)
+        i = EncodeHexSSE2(in, length, out);
+#endif
+        for (; i < length; i++)
+        {
+            out[i * 2] = hexDigits[in[i] >> 4];
+            out[i * 2 + 1] = hexDigits[in[i] & 0x0f];
+        }
+        return length * 2;
+    }
+
+    static size_t DecodeHexPairs(const unsigned char* in, size_t length,
+        unsigned char* out, size_t* consumed)
+    {
+        size_t i = 0;
+#if defined(USE_SSE2)
+        i = DecodeHexSSE2(in, length, out);
+#endif
+        for (; i + 2 <= length; i += 2)
+        {
+            unsigned int high = tables.hex[in[i]];
+            unsigned int low = tables.hex[in[i + 1]];
+            if ((high | low) > 0x0f)
+                break;
+            out[i / 2] = (unsigned char) ((high << 4) | low);
+        }
+
+        *consumed = i;
+        return i / 2;
+    }
+
+    static bool DecodeHex(const unsigned char* in, size_t length,
+        unsigned char* out, size_t* written)
+    {
+        size_t consumed;
+        size_t decoded = DecodeHexPairs(in, length, out, &consumed);
+        if (consumed == length)
+        {
+            *written = decoded;
+            return true;
+        }
+
+        std::string rest;
+        rest.reserve(length - consumed);
+        for (size_t i = consumed; i < length; i++)
+        {
+            unsigned char value = tables.hex[in[i]];
+            if (value == CHAR_INVALID)
+                return false;
+            if (value != CHAR_SPACE)
+                rest += in[i];
+        }
+
+        if (rest.size() % 2 != 0)
+            return false;
+
+        decoded += DecodeHexPairs((const unsigned char*) rest.data(),
+            rest.size(), out + decoded, &consumed);
+        *written = decoded;
+        return true;
+    }
+
+    /*static*/
+    bool BinaryEncoding::IsSupported(int type)
+    {
+        return type == CODEC_BASE64 || type == CODEC_BASE64URL || type == CODEC_HEX;
+    }
+
+    /*static*/
+    size_t BinaryEncoding::EncodedLength(int type, size_t length)
+    {
+        switch (type)
+        {
+            case CODEC_BASE64:
+                return (length + 2) / 3 * 4;
+            case CODEC_BASE64URL:
+                return length / 3 * 4 + (length % 3 == 0 ? 0 : length % 3 + 1);
+            default:
+                return length * 2;
+        }
+    }
+
+    /*static*/
+    size_t BinaryEncoding::DecodedLength(int type, size_t length)
+    {
+        if (type == CODEC_HEX)
+            return length / 2;
+        return length / 4 * 3 + 2;
+    }
+
+    /*static*/
+    size_t BinaryEncoding::BlockSize(int type)
+    {
+        return type == CODEC_HEX ? 1 : 3;
+    }
+
+    /*static*/
+    size_t BinaryEncoding::Encode(int type, const char* data, size_t length, char* out)
+    {
+        const unsigned char* in = (const unsigned char*) data;
+        if (type == CODEC_HEX)
+            return EncodeHex(in, length, out);
+        return EncodeBase64(in, length, out, type == CODEC_BASE64URL);
+    }
+
+    /*static*/
+    bool BinaryEncoding::Decode(int type, const char* data, size_t length,
+        char* out, size_t* written)
+    {
+        const unsigned char* in = (const unsigned char*) data;
+        unsigned char* bytes = (unsigned char*) out;
+        if (type == CODEC_HEX)
+            return DecodeHex(in, length, bytes, written);
+        return DecodeBase64(in, length, bytes, written, type == CODEC_BASE64URL);
+    }
+}
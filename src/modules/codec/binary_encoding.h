@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _CODEC_BINARY_ENCODING_H_
+#define _CODEC_BINARY_ENCODING_H_
+
+#include <cstddef>
+
+#define CODEC_BASE64    1
+#define CODEC_BASE64URL 2
+#define CODEC_HEX       3
+
+namespace ti
+{
+    /**
+     * Base64, base64url and hex encoding of raw buffers. Base64 uses
+     * SSSE3 when the processor has it and hex uses SSE2, with scalar
+     * code for the remainder and for other processors.
+     *
+     * Base64 output is padded and base64url output is not. Decoding
+     * accepts either, and skips whitespace anywhere in the input.
+     */
+    class BinaryEncoding
+    {
+    public:
+        static bool IsSupported(int type);
+
+        // The exact length of the encoding of length bytes.
+        static size_t EncodedLength(int type, size_t length);
+
+        // An upper bound on the length of the data decoded from
+        // length characters.
+        static size_t DecodedLength(int type, size_t length);
+
+        // The number of input bytes that encode without padding, so
+        // that a stream can be encoded in pieces.
+        static size_t BlockSize(int type);
+
+        // Encode into out, which must hold EncodedLength bytes.
+        // Returns the number of characters written.
+        static size_t Encode(int type, const char* data, size_t length, char* out);
+
+        // Decode into out, which must hold DecodedLength bytes. Returns
+        // false if the input is not valid for the encoding.
+        static bool Decode(int type, const char* data, size_t length,
+            char* out, size_t* written);
+    };
+}
+
+#endif
@@ -10,48 +10,24 @@
 #include <tideutils/win/win32_utils.h>
 #else
 #include <tideutils/posix/posix_utils.h>
+#include <tideutils/zip_utils.h>
 #endif
 #include <tide/tide.h>
 #include "codec_binding.h"
+#include "digest.h"
+#include "binary_encoding.h"
+#include "encoder.h"
 
 #include <sstream>
 
 #include <Poco/Zip/Zip.h>
 #include <Poco/Zip/Compress.h>
 #include <Poco/Zip/Decompress.h>
-#include <Poco/Base64Encoder.h>
-#include <Poco/Base64Decoder.h>
-#include <Poco/DigestEngine.h>
-#include <Poco/MD2Engine.h>
-#include <Poco/MD4Engine.h>
-#include <Poco/MD5Engine.h>
-#include <Poco/SHA1Engine.h>
-#include <Poco/HMACEngine.h>
-#include <Poco/HexBinaryEncoder.h>
-#include <Poco/HexBinaryDecoder.h>
-#include <Poco/Checksum.h>
 #include <Poco/File.h>
 #include <Poco/Path.h>
 
-#include <boost/archive/iterators/base64_from_binary.hpp>
-#include <boost/archive/iterators/binary_from_base64.hpp>
-#include <boost/archive/iterators/transform_width.hpp>
-#include <boost/archive/iterators/insert_linebreaks.hpp>
-#include <boost/archive/iterators/remove_whitespace.hpp>
-
-using namespace boost::archive::iterators;
 using namespace std;
 
-typedef transform_width< binary_from_base64<remove_whitespace<string::const_iterator> >, 8, 6 > it_binary_t;
-typedef insert_linebreaks<base64_from_binary<transform_width<string::const_iterator,6,8> >, 72 > it_base64_t;
-
-
-#define CODEC_MD2       1
-#define CODEC_MD4       2
-#define CODEC_MD5       3
-#define CODEC_SHA1      4
-#define CODEC_CRC32     1
-#define CODEC_ADLER32   2
 
 namespace ti
 {
@@ -69,13 +45,36 @@ namespace ti
         /**
          * @tiapi(method=True,name=Codec.decodeBase64,since=0.7) decode a string from base64
          * @tiarg(for=Codec.decodeBase64,name=data,type=String) data to decode
-         * @tiresult(for=Codec.decodeBase64,type=string) returns base64 decoded string
+         * @tiresult(for=Codec.decodeBase64,type=string) returns base64 decoded string. Use Codec.decode for binary data.
          */
         this->SetMethod("decodeBase64", &CodecBinding::DecodeBase64);
 
+        /**
+         * @tiapi(method=True,name=Codec.encode,since=1.4) encode a string or Bytes
+         * @tiarg(for=Codec.encode,name=type,type=int) encoding type: BASE64, BASE64URL or HEX
+         * @tiarg(for=Codec.encode,name=data,type=String|Bytes) data to encode
+         * @tiresult(for=Codec.encode,type=Bytes) returns the encoded data
+         */
+        this->SetMethod("encode", &CodecBinding::Encode);
+
+        /**
+         * @tiapi(method=True,name=Codec.decode,since=1.4) decode a string or Bytes, ignoring whitespace
+         * @tiarg(for=Codec.decode,name=type,type=int) encoding type: BASE64, BASE64URL or HEX
+         * @tiarg(for=Codec.decode,name=data,type=String|Bytes) data to decode
+         * @tiresult(for=Codec.decode,type=Bytes) returns the decoded data
+         */
+        this->SetMethod("decode", &CodecBinding::Decode);
+
+        /**
+         * @tiapi(method=True,name=Codec.createEncoder,since=1.4) create an encoder object which can be fed data incrementally
+         * @tiarg(for=Codec.createEncoder,name=type,type=int) encoding type: BASE64, BASE64URL or HEX
+         * @tiresult(for=Codec.createEncoder,type=Codec.Encoder) returns a new encoder object
+         */
+        this->SetMethod("createEncoder", &CodecBinding::CreateEncoder);
+
         /**
          * @tiapi(method=True,name=Codec.digestToHex,since=0.7) encode a string or Bytes using a digest algorithm
-         * @tiarg(for=Codec.digestToHex,name=type,type=int) encoding type: currently supports MD2, MD4, MD5, SHA1
+         * @tiarg(for=Codec.digestToHex,name=type,type=int) encoding type: currently supports MD2, MD4, MD5, SHA1, SHA256, SHA512
          * @tiarg(for=Codec.digestToHex,name=data,type=String|Bytes) data to encode
          * @tiresult(for=Codec.digestToHex,type=string) returns encoded string
          */
@@ -83,13 +82,37 @@ namespace ti
 
         /**
          * @tiapi(method=True,name=Codec.digestHMACToHex,since=0.7) digest a encoded string in HMAC
-         * @tiarg(for=Codec.digestHMACToHex,name=type,type=int) encoding type: currently supports MD2, MD4, MD5, SHA1
+         * @tiarg(for=Codec.digestHMACToHex,name=type,type=int) encoding type: currently supports MD2, MD4, MD5, SHA1, SHA256, SHA512
          * @tiarg(for=Codec.digestHMACToHex,name=data,type=String) data to encode
          * @tiarg(for=Codec.digestHMACToHex,name=data,type=String) key to us for HMAC
          * @tiresult(for=Codec.digestHMACToHex,type=string) returns base64 decoded string
          */
         this->SetMethod("digestHMACToHex", &CodecBinding::DigestHMACToHex);
 
+        /**
+         * @tiapi(method=True,name=Codec.createDigest,since=1.4) create a digest object which can be fed data incrementally
+         * @tiarg(for=Codec.createDigest,name=type,type=int) digest type: MD2, MD4, MD5, SHA1, SHA256 or SHA512
+         * @tiarg(for=Codec.createDigest,name=key,type=String,optional=True) key to compute an HMAC with
+         * @tiresult(for=Codec.createDigest,type=Codec.Digest) returns a new digest object
+         */
+        this->SetMethod("createDigest", &CodecBinding::CreateDigest);
+
+        /**
+         * @tiapi(method=True,name=Codec.createChecksum,since=1.4) create a checksum object which can be fed data incrementally
+         * @tiarg(for=Codec.createChecksum,name=type,type=int,optional=True) checksum type: CRC32 (default), ADLER32 or CRC32C
+         * @tiresult(for=Codec.createChecksum,type=Codec.Digest) returns a new checksum object, whose digest is the big-endian checksum in hex
+         */
+        this->SetMethod("createChecksum", &CodecBinding::CreateChecksum);
+
+        /**
+         * @tiapi(method=True,name=Codec.digestFile,since=1.4) Asynchronously compute the digest of a file
+         * @tiarg(for=Codec.digestFile,name=type,type=int|Codec.Digest) a digest type, or a digest or checksum object to add the file contents to
+         * @tiarg(for=Codec.digestFile,name=file,type=Filesystem.File|String) the file to hash
+         * @tiarg(for=Codec.digestFile,name=onComplete,type=Function,optional=True) receives the digest as a hex string: function onComplete(digest) {}
+         * @tiresult(for=Codec.digestFile,type=AsyncJob) returns the job hashing the file
+         */
+        this->SetMethod("digestFile", &CodecBinding::DigestFile);
+
         /**
          * @tiapi(method=True,name=Codec.encodeHexBinary,since=0.7) encode a string or Bytes into hex binary
          * @tiarg(for=Codec.encodeHexBinary,name=data,type=String|Bytes) data to encode
@@ -100,7 +123,7 @@ namespace ti
         /**
          * @tiapi(method=True,name=Codec.decodeHexBinary,since=0.7) decode a string from hex binary
          * @tiarg(for=Codec.decodeHexBinary,name=data,type=String) data to decode
-         * @tiresult(for=Codec.decodeHexBinary,type=string) returns unencoded hex binary string
+         * @tiresult(for=Codec.decodeHexBinary,type=string) returns unencoded hex binary string. Use Codec.decode for binary data.
          */
         this->SetMethod("decodeHexBinary", &CodecBinding::DecodeHexBinary);
 
@@ -139,6 +162,14 @@ namespace ti
          * @tiapi(property=True,name=Codec.SHA1,since=0.7) SHA1 property
          */
         this->SetInt("SHA1", CODEC_SHA1);
+        /**
+         * @tiapi(property=True,name=Codec.SHA256,since=1.4) SHA256 property
+         */
+        this->SetInt("SHA256", CODEC_SHA256);
+        /**
+         * @tiapi(property=True,name=Codec.SHA512,since=1.4) SHA512 property
+         */
+        this->SetInt("SHA512", CODEC_SHA512);
         /**
          * @tiapi(property=True,name=Codec.CRC32,since=0.7) CRC32 property
          */
@@ -147,189 +178,201 @@ namespace ti
          * @tiapi(property=True,name=Codec.ADLER32,since=0.7) ADLER32 property
          */
         this->SetInt("ADLER32", CODEC_ADLER32);
+        /**
+         * @tiapi(property=True,name=Codec.CRC32C,since=1.4) CRC32C property
+         */
+        this->SetInt("CRC32C", CODEC_CRC32C);
+        /**
+         * @tiapi(property=True,name=Codec.BASE64,since=1.4) BASE64 property
+         */
+        this->SetInt("BASE64", CODEC_BASE64);
+        /**
+         * @tiapi(property=True,name=Codec.BASE64URL,since=1.4) BASE64URL property, the URL and filename safe alphabet without padding
+         */
+        this->SetInt("BASE64URL", CODEC_BASE64URL);
+        /**
+         * @tiapi(property=True,name=Codec.HEX,since=1.4) HEX property
+         */
+        this->SetInt("HEX", CODEC_HEX);
     }
     
     CodecBinding::~CodecBinding()
     {
     }
     
-    static std::string& GetStringFromValue(ValueRef value)
+    // Feed a String or Bytes argument to a digest without copying it.
+    static void UpdateDigest(DigestAlgorithm* algorithm, ValueRef value)
     {
-        static std::string data;
         if (value->IsString())
         {
-            data = value->ToString();
+            const char* data = value->ToString();
+            algorithm->Update(data, strlen(data));
+            return;
         }
-        else
+
+        AutoPtr<Bytes> bytes(value->ToObject().cast<Bytes>());
+        if (bytes.isNull())
         {
-            AutoPtr<Bytes> bytes(value->ToObject().cast<Bytes>());
-            if (!bytes.isNull())
-            {
-                data = std::string(bytes->Pointer(), bytes->Length());
-            }
-            else
-            {
-                data = "";
-            }
+            delete algorithm;
+            throw ValueException::FromString("unsupported data type passed as argument 1");
         }
-        return data;
+        algorithm->Update(bytes->Pointer(), bytes->Length());
     }
     
+    // Point at the contents of a String or Bytes argument without copying.
+    static void GetDataFromValue(ValueRef value, const char** data, size_t* length)
+    {
+        if (value->IsString())
+        {
+            *data = value->ToString();
+            *length = strlen(*data);
+            return;
+        }
+
+        AutoPtr<Bytes> bytes(value->ToObject().cast<Bytes>());
+        if (bytes.isNull())
+            throw ValueException::FromString("unsupported data type passed as argument");
+        *data = bytes->Pointer();
+        *length = bytes->Length();
+    }
+
+    static void VerifyEncoding(int type)
+    {
+        if (!BinaryEncoding::IsSupported(type))
+            throw ValueException::FromFormat("Unsupported encoding: %i", type);
+    }
+
+    static std::string EncodeToString(int type, ValueRef value)
+    {
+        const char* data;
+        size_t length;
+        GetDataFromValue(value, &data, &length);
+
+        std::string encoded(BinaryEncoding::EncodedLength(type, length), '\0');
+        if (!encoded.empty())
+            BinaryEncoding::Encode(type, data, length, &encoded[0]);
+        return encoded;
+    }
+
+    static BytesRef DecodeToBytes(int type, ValueRef value)
+    {
+        const char* data;
+        size_t length;
+        GetDataFromValue(value, &data, &length);
+
+        BytesRef decoded(new Bytes(BinaryEncoding::DecodedLength(type, length)));
+        size_t written;
+        if (!BinaryEncoding::Decode(type, data, length, decoded->Pointer(), &written))
+            throw ValueException::FromString("Invalid encoded data");
+
+        // Whitespace and padding make the decoded data shorter than
+        // the space reserved for it.
+        if (written < decoded->Length())
+            return new Bytes(decoded, 0, written);
+        return decoded;
+    }
+
     void CodecBinding::EncodeBase64(const ValueList& args, ValueRef result)
     {
         args.VerifyException("encodeBase64", "s|o");
-        
-        std::string s = GetStringFromValue(args.at(0));
-
-        // Encode
-        unsigned int writePaddChars = (3-s.length()%3)%3;
-        string base64(it_base64_t(s.begin()),it_base64_t(s.end()));
-        base64.append(writePaddChars,'=');
-	result->SetString(base64);
+        std::string encoded(EncodeToString(CODEC_BASE64, args.at(0)));
+        result->SetString(encoded);
     }
 
     void CodecBinding::DecodeBase64(const ValueList& args, ValueRef result)
     {
         args.VerifyException("decodeBase64", "s");
+        std::string decoded(DecodeToBytes(CODEC_BASE64, args.at(0))->AsString());
+        result->SetString(decoded);
+    }
 
-        std::string base64 = args.at(0)->ToString();
+    void CodecBinding::Encode(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("encode", "i s|o");
+        int type = args.GetInt(0);
+        VerifyEncoding(type);
 
-        // Decode
-        unsigned int paddChars = std::count(base64.begin(), base64.end(), '=');
-        std::replace(base64.begin(),base64.end(),'=','A'); // replace '=' by base64 encoding of '\0'
-        std::string decoded(it_binary_t(base64.begin()), it_binary_t(base64.end())); // decode
-        decoded.erase(decoded.end()-paddChars, decoded.end());  // erase padding '\0' characters
-        result->SetString(decoded);
+        const char* data;
+        size_t length;
+        GetDataFromValue(args.at(1), &data, &length);
+
+        BytesRef encoded(new Bytes(BinaryEncoding::EncodedLength(type, length)));
+        BinaryEncoding::Encode(type, data, length, encoded->Pointer());
+        result->SetObject(encoded);
+    }
+
+    void CodecBinding::Decode(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("decode", "i s|o");
+        int type = args.GetInt(0);
+        VerifyEncoding(type);
+        result->SetObject(DecodeToBytes(type, args.at(1)));
+    }
+
+    void CodecBinding::CreateEncoder(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("createEncoder", "i");
+        int type = args.GetInt(0);
+        VerifyEncoding(type);
+        result->SetObject(new Encoder(type));
     }
 
     void CodecBinding::DigestToHex(const ValueList& args, ValueRef result)
     {
         args.VerifyException("digestToHex", "i s|o");
         
-        int type = args.at(0)->ToInt();
-        
-        Poco::DigestEngine *engine = NULL;
-        
-        switch(type)
-        {
-            case CODEC_MD2:
-            {
-                engine = new Poco::MD2Engine(); 
-                break;
-            }
-            case CODEC_MD4:
-            {
-                engine = new Poco::MD4Engine(); 
-                break;
-            }
-            case CODEC_MD5:
-            {
-                engine = new Poco::MD5Engine(); 
-                break;
-            }
-            case CODEC_SHA1:
-            {
-                engine = new Poco::SHA1Engine(); 
-                break;
-            }
-            default:
-            {
-                std::ostringstream msg("Unsupported encoding type: ");
-                msg << type;
-                throw ValueException::FromString(msg.str());
-            }
-        }
-        
-        if (args.at(1)->IsString())
-        {
-            engine->update(args.GetString(1));
-        }
-        else
-        {
-            AutoPtr<Bytes> bytes(args.GetObject(1).cast<Bytes>());
-            if (!bytes.isNull())
-            {
-                engine->update(bytes->Pointer(), bytes->Length());
-            }
-        }
-        std::string data = Poco::DigestEngine::digestToHex(engine->digest()); 
-        result->SetString(data);
-        delete engine;
+        DigestAlgorithm* algorithm = DigestAlgorithm::CreateDigest(args.GetInt(0));
+        UpdateDigest(algorithm, args.at(1));
+        std::string hex(DigestAlgorithm::ToHex(algorithm->Finish()));
+        delete algorithm;
+        result->SetString(hex);
     }
 
     void CodecBinding::DigestHMACToHex(const ValueList& args, ValueRef result)
     {
         args.VerifyException("digestHMACToHex", "i s s");
         
-        int type = args.at(0)->ToInt();
-        std::string encoded = args.at(1)->ToString();
-        std::string key = args.at(2)->ToString();
+        std::string key(args.GetString(2));
+        DigestAlgorithm* algorithm = DigestAlgorithm::CreateDigest(args.GetInt(0), &key);
+        UpdateDigest(algorithm, args.at(1));
+        std::string hex(DigestAlgorithm::ToHex(algorithm->Finish()));
+        delete algorithm;
+        result->SetString(hex);
+    }
 
-        switch(type)
-        {
-            case CODEC_MD2:
-            {
-                Poco::HMACEngine<Poco::MD2Engine> engine(key); 
-                engine.update(encoded); 
-                std::string data = Poco::DigestEngine::digestToHex(engine.digest()); 
-                result->SetString(data);
-                break;
-            }
-            case CODEC_MD4:
-            {
-                Poco::HMACEngine<Poco::MD4Engine> engine(key); 
-                engine.update(encoded); 
-                std::string data = Poco::DigestEngine::digestToHex(engine.digest()); 
-                result->SetString(data);
-                break;
-            }
-            case CODEC_MD5:
-            {
-                Poco::HMACEngine<Poco::MD5Engine> engine(key); 
-                engine.update(encoded); 
-                std::string data = Poco::DigestEngine::digestToHex(engine.digest()); 
-                result->SetString(data);
-                break;
-            }
-            case CODEC_SHA1:
-            {
-                Poco::HMACEngine<Poco::SHA1Engine> engine(key); 
-                engine.update(encoded); 
-                std::string data = Poco::DigestEngine::digestToHex(engine.digest()); 
-                result->SetString(data);
-                break;
-            }
-            default:
-            {
-                std::ostringstream msg("Unsupported encoding type: ");
-                msg << type;
-                throw ValueException::FromString(msg.str());
-            }
-        }
+    void CodecBinding::CreateDigest(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("createDigest", "i ?s");
+
+        std::string key;
+        if (args.size() > 1)
+            key = args.GetString(1);
+
+        DigestAlgorithm* algorithm = DigestAlgorithm::CreateDigest(
+            args.GetInt(0), args.size() > 1 ? &key : 0);
+        result->SetObject(new Digest(algorithm));
+    }
+
+    void CodecBinding::CreateChecksum(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("createChecksum", "?i");
+
+        DigestAlgorithm* algorithm = DigestAlgorithm::CreateChecksum(
+            args.GetInt(0, CODEC_CRC32));
+        result->SetObject(new Digest(algorithm));
     }
 
     void CodecBinding::EncodeHexBinary(const ValueList& args, ValueRef result)
     {
         args.VerifyException("encodeHexBinary", "s|o");
-        
-        std::stringstream str;
-        Poco::HexBinaryEncoder encoder(str);
-        encoder << GetStringFromValue(args.at(0));
-        encoder.close();
-        std::string encoded = str.str();
+        std::string encoded(EncodeToString(CODEC_HEX, args.at(0)));
         result->SetString(encoded);
     }
 
     void CodecBinding::DecodeHexBinary(const ValueList& args, ValueRef result)
     {
         args.VerifyException("decodeHexBinary", "s");
-        
-        std::string encoded = args.at(0)->ToString();
-        std::stringstream str;
-        str << encoded;
-        Poco::HexBinaryDecoder decoder(str);
-        std::string decoded;
-        decoder >> decoded;
+        std::string decoded(DecodeToBytes(CODEC_HEX, args.at(0))->AsString());
         result->SetString(decoded);
     }
 
@@ -337,60 +380,17 @@ namespace ti
     {
         args.VerifyException("checksum", "s|o ?i");
 
-        int type = CODEC_CRC32;
-        
-        if (args.size() == 2)
-        {
-            type = args.at(1)->ToInt();
-        }
-        
-        Poco::Checksum *checksum = NULL;
-        
-        switch(type)
-        {
-            case CODEC_CRC32:
-            {
-                checksum = new Poco::Checksum(Poco::Checksum::TYPE_CRC32);
-                break;
-            }
-            case CODEC_ADLER32:
-            {
-                checksum = new Poco::Checksum(Poco::Checksum::TYPE_ADLER32);
-                break;
-            }
-            default:
-            {
-                std::ostringstream msg("Unsupported type: ");
-                msg << type;
-                throw ValueException::FromString(msg.str());
-            }
-        }
+        DigestAlgorithm* algorithm = DigestAlgorithm::CreateChecksum(
+            args.GetInt(1, CODEC_CRC32));
+        UpdateDigest(algorithm, args.at(0));
 
-        if (args.at(0)->IsString())
-        {
-            std::string encoded = args.at(0)->ToString();
-            const char *data = encoded.c_str();
-            checksum->update(data,encoded.size());
-            result->SetInt(checksum->checksum());
-        }
-        else if (args.at(0)->IsObject())
-        {
-            BytesRef bytes = args.at(0)->ToObject().cast<Bytes>();
-            if (bytes.isNull())
-            {
-                delete checksum;
-                throw ValueException::FromString("unsupported data type passed as argument 1");
-            }
-            checksum->update(bytes->Pointer(),bytes->Length());
-            result->SetInt(checksum->checksum());
-        }
-        else
-        {
-            delete checksum;
-            throw ValueException::FromString("unsupported data type passed as argument 1");
-        }
-        
-        delete checksum;
+        std::string digest(algorithm->Finish());
+        delete algorithm;
+
+        unsigned int checksum = 0;
+        for (size_t i = 0; i < digest.size(); i++)
+            checksum = (checksum << 8) | (unsigned char) digest[i];
+        result->SetInt(checksum);
     }
     
     static std::string GetPathFromValue(ValueRef value)
@@ -478,6 +478,51 @@ namespace ti
         result->SetObject(extractJob);
     }
 
+    void CodecBinding::DigestFile(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("digestFile", "i|o s|o ?m");
+
+        AutoPtr<Digest> digest;
+        if (args.at(0)->IsObject())
+        {
+            digest = args.GetObject(0).cast<Digest>();
+            if (digest.isNull())
+            {
+                throw ValueException::FromString("digestFile expects a digest type or a Codec.Digest");
+            }
+        }
+        else
+        {
+            digest = new Digest(DigestAlgorithm::CreateDigest(args.GetInt(0)));
+        }
+
+        std::string path = GetPathFromValue(args.at(1));
+        if (path.empty())
+        {
+            throw ValueException::FromString("Error: File name in digestFile is empty");
+        }
+
+        TiMethodRef callback;
+        if (args.size() > 2)
+        {
+            callback = args.GetMethod(2);
+        }
+
+        AutoPtr<AsyncJob> job = new DigestFileJob(digest, path, callback);
+        job->RunAsynchronously();
+        result->SetObject(job);
+    }
+
+#ifndef OS_WIN32
+    static bool ZipProgressCallback(char* message, int current, int total, void* data)
+    {
+        AsyncJob* job = static_cast<AsyncJob*>(data);
+        if (total > 0)
+            job->SetProgress(double(current) / total, true);
+        return !job->IsCancelled();
+    }
+#endif
+
     /*static*/
     ValueRef CodecBinding::CreateZipAsync(const ValueList& args)
     {
@@ -490,6 +535,7 @@ namespace ti
             callback = args.GetMethod(3);
         }
         
+#ifdef OS_WIN32
         Poco::Path path(directory);
         path.makeDirectory();
         
@@ -508,6 +554,15 @@ namespace ti
         
         compressor.close();
         stream.close();
+#else
+        std::string error;
+        if (!ZipUtils::Create(UTF8ToSystem(directory), UTF8ToSystem(zipFile),
+            error, &ZipProgressCallback, job.get()))
+        {
+            Logger::Get("Codec")->Error("exception compressing: %s", error.c_str());
+            throw ValueException::FromFormat("Exception during zip: %s", error.c_str());
+        }
+#endif
         
         if (!callback.isNull())
         {
@@ -531,6 +586,7 @@ namespace ti
             callback = args.GetMethod(3);
         }
 
+#ifdef OS_WIN32
         std::ifstream stream(UTF8ToSystem(zipFile).c_str(), std::ios::binary);
         Poco::Zip::Decompress decompressor(stream, directory);
         try
@@ -544,6 +600,15 @@ namespace ti
         }
 
         stream.close();
+#else
+        std::string error;
+        if (!ZipUtils::Extract(UTF8ToSystem(zipFile), UTF8ToSystem(directory),
+            error, &ZipProgressCallback, job.get()))
+        {
+            Logger::Get("Codec")->Error("exception decompressing: %s", error.c_str());
+            throw ValueException::FromFormat("Exception during extraction: %s", error.c_str());
+        }
+#endif
 
         if (!callback.isNull())
         {
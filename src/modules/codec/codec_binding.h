@@ -25,8 +25,14 @@ namespace ti
 
         void EncodeBase64(const ValueList& args, ValueRef result);
         void DecodeBase64(const ValueList& args, ValueRef result);
+        void Encode(const ValueList& args, ValueRef result);
+        void Decode(const ValueList& args, ValueRef result);
+        void CreateEncoder(const ValueList& args, ValueRef result);
         void DigestToHex(const ValueList& args, ValueRef result);
         void DigestHMACToHex(const ValueList& args, ValueRef result);
+        void CreateDigest(const ValueList& args, ValueRef result);
+        void CreateChecksum(const ValueList& args, ValueRef result);
+        void DigestFile(const ValueList& args, ValueRef result);
         void EncodeHexBinary(const ValueList& args, ValueRef result);
         void DecodeHexBinary(const ValueList& args, ValueRef result);
         void Checksum(const ValueList& args, ValueRef result);
@@ -0,0 +1,805 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include "digest.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <Poco/Types.h>
+#include <Poco/DigestEngine.h>
+#include <Poco/MD2Engine.h>
+#include <Poco/MD4Engine.h>
+#include <Poco/MD5Engine.h>
+#include <Poco/SHA1Engine.h>
+#include <Poco/Checksum.h>
+
+#ifdef OS_WIN32
+#include <tideutils/win/win32_utils.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+using Poco::UInt32;
+using Poco::UInt64;
+
+// Files are hashed through a sliding window, so that large files
+// can be hashed in a 32-bit address space.
+#define DIGEST_FILE_WINDOW (64 * 1024 * 1024)
+
+namespace ti
+{
+    static inline UInt32 RotateRight32(UInt32 value, int bits)
+    {
+        return (value >> bits) | (value << (32 - bits));
+    }
+
+    static inline UInt64 RotateRight64(UInt64 value, int bits)
+    {
+        return (value >> bits) | (value << (64 - bits));
+    }
+
+    static inline UInt32 LoadBigEndian32(const unsigned char* p)
+    {
+        return ((UInt32) p[0] << 24) | ((UInt32) p[1] << 16) |
+            ((UInt32) p[2] << 8) | p[3];
+    }
+
+    static inline UInt64 LoadBigEndian64(const unsigned char* p)
+    {
+        return ((UInt64) LoadBigEndian32(p) << 32) | LoadBigEndian32(p + 4);
+    }
+
+    static inline UInt32 LoadLittleEndian32(const unsigned char* p)
+    {
+        return p[0] | ((UInt32) p[1] << 8) | ((UInt32) p[2] << 16) |
+            ((UInt32) p[3] << 24);
+    }
+
+    static void AppendBigEndian(std::string& out, UInt64 value, int bytes)
+    {
+        for (int i = bytes - 1; i >= 0; i--)
+            out += (char) ((value >> (i * 8)) & 0xff);
+    }
+
+    /**
+     * Shared block buffering and padding for the SHA-2 family.
+     * Word is the word size of the hash and BLOCK its block size.
+     */
+    template <typename Word, size_t BLOCK>
+    class SHA2Algorithm : public DigestAlgorithm
+    {
+    public:
+        SHA2Algorithm() : used(0), length(0) {}
+
+        virtual void Update(const void* data, size_t size)
+        {
+            const unsigned char* input = static_cast<const unsigned char*>(data);
+            this->length += size;
+
+            if (this->used > 0)
+            {
+                size_t count = std::min(size, BLOCK - this->used);
+                memcpy(this->buffer + this->used, input, count);
+                this->used += count;
+                input += count;
+                size -= count;
+
+                if (this->used < BLOCK)
+                    return;
+
+                this->Transform(this->buffer);
+                this->used = 0;
+            }
+
+            // Hash whole blocks straight from the input.
+            while (size >= BLOCK)
+            {
+                this->Transform(input);
+                input += BLOCK;
+                size -= BLOCK;
+            }
+
+            memcpy(this->buffer, input, size);
+            this->used = size;
+        }
+
+        virtual size_t BlockSize()
+        {
+            return BLOCK;
+        }
+
+    protected:
+        virtual void Transform(const unsigned char* block) = 0;
+
+        // Pad the final block, which ends with the message length in bits.
+        void Pad()
+        {
+            const size_t lengthSize = BLOCK / 8;
+            UInt64 bits = this->length * 8;
+
+            this->buffer[this->used++] = 0x80;
+            if (this->used > BLOCK - lengthSize)
+            {
+                memset(this->buffer + this->used, 0, BLOCK - this->used);
+                this->Transform(this->buffer);
+                this->used = 0;
+            }
+
+            memset(this->buffer + this->used, 0, BLOCK - this->used);
+            for (int i = 0; i < 8; i++)
+                this->buffer[BLOCK - 1 - i] = (unsigned char) (bits >> (i * 8));
+            this->Transform(this->buffer);
+
+            this->used = 0;
+            this->length = 0;
+        }
+
+        Word state[8];
+        unsigned char buffer[BLOCK];
+        size_t used;
+        UInt64 length;
+    };
+
+    static const UInt32 SHA256_K[64] =
+    {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    class SHA256Algorithm : public SHA2Algorithm<UInt32, 64>
+    {
+    public:
+        SHA256Algorithm()
+        {
+            this->Reset();
+        }
+
+        virtual std::string Finish()
+        {
+            this->Pad();
+            std::string digest;
+            for (int i = 0; i < 8; i++)
+                AppendBigEndian(digest, this->state[i], 4);
+            this->Reset();
+            return digest;
+        }
+
+    protected:
+        void Reset()
+        {
+            static const UInt32 initial[8] =
+            {
+                0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+            };
+            memcpy(this->state, initial, sizeof(initial));
+        }
+
+        virtual void Transform(const unsigned char* block)
+        {
+            UInt32 w[64];
+            for (int i = 0; i < 16; i++)
+                w[i] = LoadBigEndian32(block + i * 4);
+            for (int i = 16; i < 64; i++)
+            {
+                UInt32 s0 = RotateRight32(w[i - 15], 7) ^ RotateRight32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                UInt32 s1 = RotateRight32(w[i - 2], 17) ^ RotateRight32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            UInt32 a = state[0], b = state[1], c = state[2], d = state[3];
+            UInt32 e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; i++)
+            {
+                UInt32 s1 = RotateRight32(e, 6) ^ RotateRight32(e, 11) ^ RotateRight32(e, 25);
+                UInt32 choose = (e & f) ^ (~e & g);
+                UInt32 temp1 = h + s1 + choose + SHA256_K[i] + w[i];
+                UInt32 s0 = RotateRight32(a, 2) ^ RotateRight32(a, 13) ^ RotateRight32(a, 22);
+                UInt32 majority = (a & b) ^ (a & c) ^ (b & c);
+                UInt32 temp2 = s0 + majority;
+
+                h = g; g = f; f = e; e = d + temp1;
+                d = c; c = b; b = a; a = temp1 + temp2;
+            }
+
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+            state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        }
+    };
+
+    static const UInt64 SHA512_K[80] =
+    {
+        0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+        0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+        0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+        0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+        0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+        0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+        0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+        0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+        0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+        0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+        0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+        0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+        0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+        0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+        0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+        0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+        0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+        0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+        0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+        0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+    };
+
+    class SHA512Algorithm : public SHA2Algorithm<UInt64, 128>
+    {
+    public:
+        SHA512Algorithm()
+        {
+            this->Reset();
+        }
+
+        virtual std::string Finish()
+        {
+            this->Pad();
+            std::string digest;
+            for (int i = 0; i < 8; i++)
+                AppendBigEndian(digest, this->state[i], 8);
+            this->Reset();
+            return digest;
+        }
+
+    protected:
+        void Reset()
+        {
+            static const UInt64 initial[8] =
+            {
+                0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+                0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+                0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+                0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+            };
+            memcpy(this->state, initial, sizeof(initial));
+        }
+
+        virtual void Transform(const unsigned char* block)
+        {
+            UInt64 w[80];
+            for (int i = 0; i < 16; i++)
+                w[i] = LoadBigEndian64(block + i * 8);
+            for (int i = 16; i < 80; i++)
+            {
+                UInt64 s0 = RotateRight64(w[i - 15], 1) ^ RotateRight64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+                UInt64 s1 = RotateRight64(w[i - 2], 19) ^ RotateRight64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            UInt64 a = state[0], b = state[1], c = state[2], d = state[3];
+            UInt64 e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 80; i++)
+            {
+                UInt64 s1 = RotateRight64(e, 14) ^ RotateRight64(e, 18) ^ RotateRight64(e, 41);
+                UInt64 choose = (e & f) ^ (~e & g);
+                UInt64 temp1 = h + s1 + choose + SHA512_K[i] + w[i];
+                UInt64 s0 = RotateRight64(a, 28) ^ RotateRight64(a, 34) ^ RotateRight64(a, 39);
+                UInt64 majority = (a & b) ^ (a & c) ^ (b & c);
+                UInt64 temp2 = s0 + majority;
+
+                h = g; g = f; f = e; e = d + temp1;
+                d = c; c = b; b = a; a = temp1 + temp2;
+            }
+
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+            state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        }
+    };
+
+    /**
+     * CRC-32C (Castagnoli). Uses the SSE4.2 crc32 instruction when the
+     * build targets it and slicing-by-8 tables otherwise.
+     */
+    class CRC32CAlgorithm : public DigestAlgorithm
+    {
+    public:
+        CRC32CAlgorithm() : crc(0xffffffff) {}
+
+        virtual void Update(const void* data, size_t size)
+        {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            UInt32 value = this->crc;
+
+#if defined(__SSE4_2__)
+#if defined(__x86_64__)
+            UInt64 wide = value;
+            for (; size >= 8; p += 8, size -= 8)
+            {
+                UInt64 word;
+                memcpy(&word, p, 8);
+                wide = _mm_crc32_u64(wide, word);
+            }
+            value = (UInt32) wide;
+#endif
+            for (; size >= 4; p += 4, size -= 4)
+            {
+                UInt32 word;
+                memcpy(&word, p, 4);
+                value = _mm_crc32_u32(value, word);
+            }
+            for (; size > 0; p++, size--)
+                value = _mm_crc32_u8(value, *p);
+#else
+            const UInt32 (*table)[256] = Tables();
+            for (; size >= 8; p += 8, size -= 8)
+            {
+                UInt32 low = value ^ LoadLittleEndian32(p);
+                UInt32 high = LoadLittleEndian32(p + 4);
+                value = table[7][low & 0xff] ^ table[6][(low >> 8) & 0xff] ^
+                    table[5][(low >> 16) & 0xff] ^ table[4][low >> 24] ^
+                    table[3][high & 0xff] ^ table[2][(high >> 8) & 0xff] ^
+                    table[1][(high >> 16) & 0xff] ^ table[0][high >> 24];
+            }
+            for (; size > 0; p++, size--)
+                value = table[0][(value ^ *p) & 0xff] ^ (value >> 8);
+#endif
+
+            this->crc = value;
+        }
+
+        virtual std::string Finish()
+        {
+            std::string digest;
+            AppendBigEndian(digest, this->crc ^ 0xffffffff, 4);
+            this->crc = 0xffffffff;
+            return digest;
+        }
+
+        virtual size_t BlockSize()
+        {
+            return 1;
+        }
+
+    private:
+#if !defined(__SSE4_2__)
+        static const UInt32 (*Tables())[256]
+        {
+            // Built during static initialization, before any script
+            // can run on another thread.
+            static UInt32 table[8][256];
+            static bool initialized = false;
+            if (!initialized)
+            {
+                for (UInt32 i = 0; i < 256; i++)
+                {
+                    UInt32 value = i;
+                    for (int bit = 0; bit < 8; bit++)
+                        value = (value >> 1) ^ (0x82f63b78 & (0 - (value & 1)));
+                    table[0][i] = value;
+                }
+                for (int k = 1; k < 8; k++)
+                {
+                    for (int i = 0; i < 256; i++)
+                        table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+                }
+                initialized = true;
+            }
+            return table;
+        }
+#endif
+
+        UInt32 crc;
+    };
+
+#if !defined(__SSE4_2__)
+    static struct CRC32CTableInitializer
+    {
+        CRC32CTableInitializer()
+        {
+            CRC32CAlgorithm().Update("", 0);
+        }
+    } crc32cTableInitializer;
+#endif
+
+    class PocoDigestAlgorithm : public DigestAlgorithm
+    {
+    public:
+        PocoDigestAlgorithm(Poco::DigestEngine* engine, size_t blockSize) :
+            engine(engine),
+            blockSize(blockSize)
+        {
+        }
+
+        virtual ~PocoDigestAlgorithm()
+        {
+            delete this->engine;
+        }
+
+        virtual void Update(const void* data, size_t size)
+        {
+            // DigestEngine takes an unsigned length.
+            const char* p = static_cast<const char*>(data);
+            while (size > 0)
+            {
+                unsigned count = size > 0x40000000 ? 0x40000000 : (unsigned) size;
+                this->engine->update(p, count);
+                p += count;
+                size -= count;
+            }
+        }
+
+        virtual std::string Finish()
+        {
+            const Poco::DigestEngine::Digest& digest = this->engine->digest();
+            return std::string(digest.begin(), digest.end());
+        }
+
+        virtual size_t BlockSize()
+        {
+            return this->blockSize;
+        }
+
+    private:
+        Poco::DigestEngine* engine;
+        size_t blockSize;
+    };
+
+    class PocoChecksumAlgorithm : public DigestAlgorithm
+    {
+    public:
+        PocoChecksumAlgorithm(Poco::Checksum::Type type) :
+            type(type),
+            checksum(new Poco::Checksum(type))
+        {
+        }
+
+        virtual ~PocoChecksumAlgorithm()
+        {
+            delete this->checksum;
+        }
+
+        virtual void Update(const void* data, size_t size)
+        {
+            const char* p = static_cast<const char*>(data);
+            while (size > 0)
+            {
+                unsigned count = size > 0x40000000 ? 0x40000000 : (unsigned) size;
+                this->checksum->update(p, count);
+                p += count;
+                size -= count;
+            }
+        }
+
+        virtual std::string Finish()
+        {
+            std::string digest;
+            AppendBigEndian(digest, this->checksum->checksum(), 4);
+            delete this->checksum;
+            this->checksum = new Poco::Checksum(this->type);
+            return digest;
+        }
+
+        virtual size_t BlockSize()
+        {
+            return 1;
+        }
+
+    private:
+        Poco::Checksum::Type type;
+        Poco::Checksum* checksum;
+    };
+
+    class HMACAlgorithm : public DigestAlgorithm
+    {
+    public:
+        HMACAlgorithm(int type, const std::string& key) :
+            inner(DigestAlgorithm::CreateDigest(type)),
+            outer(DigestAlgorithm::CreateDigest(type))
+        {
+            size_t blockSize = this->inner->BlockSize();
+            std::string paddedKey(key);
+            if (paddedKey.size() > blockSize)
+            {
+                this->inner->Update(paddedKey.data(), paddedKey.size());
+                paddedKey = this->inner->Finish();
+            }
+            paddedKey.resize(blockSize, '\0');
+
+            this->innerPad = paddedKey;
+            this->outerPad = paddedKey;
+            for (size_t i = 0; i < blockSize; i++)
+            {
+                this->innerPad[i] ^= 0x36;
+                this->outerPad[i] ^= 0x5c;
+            }
+
+            this->inner->Update(this->innerPad.data(), blockSize);
+        }
+
+        virtual ~HMACAlgorithm()
+        {
+            delete this->inner;
+            delete this->outer;
+        }
+
+        virtual void Update(const void* data, size_t size)
+        {
+            this->inner->Update(data, size);
+        }
+
+        virtual std::string Finish()
+        {
+            std::string innerDigest(this->inner->Finish());
+            this->outer->Update(this->outerPad.data(), this->outerPad.size());
+            this->outer->Update(innerDigest.data(), innerDigest.size());
+            std::string digest(this->outer->Finish());
+
+            this->inner->Update(this->innerPad.data(), this->innerPad.size());
+            return digest;
+        }
+
+        virtual size_t BlockSize()
+        {
+            return this->inner->BlockSize();
+        }
+
+    private:
+        DigestAlgorithm* inner;
+        DigestAlgorithm* outer;
+        std::string innerPad;
+        std::string outerPad;
+    };
+
+    /*static*/
+    DigestAlgorithm* DigestAlgorithm::CreateDigest(int type, const std::string* key)
+    {
+        if (key)
+            return new HMACAlgorithm(type, *key);
+
+        switch (type)
+        {
+            // HMAC pads keys to the engine's own block size, as
+            // Poco::HMACEngine does. For MD2 that is not the 16 bytes of
+            // RFC 1319, but keyed MD2 digests have always used it.
+            case CODEC_MD2:
+                return new PocoDigestAlgorithm(new Poco::MD2Engine(),
+                    Poco::MD2Engine::BLOCK_SIZE);
+            case CODEC_MD4:
+                return new PocoDigestAlgorithm(new Poco::MD4Engine(),
+                    Poco::MD4Engine::BLOCK_SIZE);
+            case CODEC_MD5:
+                return new PocoDigestAlgorithm(new Poco::MD5Engine(),
+                    Poco::MD5Engine::BLOCK_SIZE);
+            case CODEC_SHA1:
+                return new PocoDigestAlgorithm(new Poco::SHA1Engine(),
+                    Poco::SHA1Engine::BLOCK_SIZE);
+            case CODEC_SHA256:
+                return new SHA256Algorithm();
+            case CODEC_SHA512:
+                return new SHA512Algorithm();
+            default:
+                throw ValueException::FromFormat("Unsupported encoding type: %i", type);
+        }
+    }
+
+    /*static*/
+    DigestAlgorithm* DigestAlgorithm::CreateChecksum(int type)
+    {
+        switch (type)
+        {
+            case CODEC_CRC32:
+                return new PocoChecksumAlgorithm(Poco::Checksum::TYPE_CRC32);
+            case CODEC_ADLER32:
+                return new PocoChecksumAlgorithm(Poco::Checksum::TYPE_ADLER32);
+            case CODEC_CRC32C:
+                return new CRC32CAlgorithm();
+            default:
+                throw ValueException::FromFormat("Unsupported type: %i", type);
+        }
+    }
+
+    /*static*/
+    std::string DigestAlgorithm::ToHex(const std::string& digest)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+        hex.reserve(digest.size() * 2);
+        for (size_t i = 0; i < digest.size(); i++)
+        {
+            unsigned char c = digest[i];
+            hex += digits[c >> 4];
+            hex += digits[c & 0x0f];
+        }
+        return hex;
+    }
+
+    Digest::Digest(DigestAlgorithm* algorithm) :
+        StaticBoundObject("Codec.Digest"),
+        algorithm(algorithm)
+    {
+        /**
+         * @tiapi(method=True,name=Codec.Digest.update,since=1.4) Add data to the digest
+         * @tiarg(for=Codec.Digest.update,name=data,type=String|Bytes) data to add
+         */
+        this->SetMethod("update", &Digest::_Update);
+
+        /**
+         * @tiapi(method=True,name=Codec.Digest.digest,since=1.4) Finish the digest and reset it for new data
+         * @tiresult(for=Codec.Digest.digest,type=String) the digest as a hex string
+         */
+        this->SetMethod("digest", &Digest::_Digest);
+
+        /**
+         * @tiapi(method=True,name=Codec.Digest.digestBytes,since=1.4) Finish the digest and reset it for new data
+         * @tiresult(for=Codec.Digest.digestBytes,type=Bytes) the raw digest
+         */
+        this->SetMethod("digestBytes", &Digest::_DigestBytes);
+
+        /**
+         * @tiapi(method=True,name=Codec.Digest.reset,since=1.4) Discard all data added to the digest
+         */
+        this->SetMethod("reset", &Digest::_Reset);
+    }
+
+    Digest::~Digest()
+    {
+        delete this->algorithm;
+    }
+
+    void Digest::Update(const void* data, size_t length)
+    {
+        Poco::Mutex::ScopedLock lock(this->mutex);
+        this->algorithm->Update(data, length);
+    }
+
+    std::string Digest::Finish()
+    {
+        Poco::Mutex::ScopedLock lock(this->mutex);
+        return this->algorithm->Finish();
+    }
+
+    void Digest::_Update(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("update", "s|o");
+
+        if (args.at(0)->IsString())
+        {
+            const char* data = args.at(0)->ToString();
+            this->Update(data, strlen(data));
+        }
+        else
+        {
+            BytesRef bytes(args.GetObject(0).cast<Bytes>());
+            if (bytes.isNull())
+                throw ValueException::FromString("update expects a String or Bytes");
+
+            this->Update(bytes->Pointer(), bytes->Length());
+        }
+
+        result->SetObject(GetAutoPtr());
+    }
+
+    void Digest::_Digest(const ValueList& args, ValueRef result)
+    {
+        std::string hex(DigestAlgorithm::ToHex(this->Finish()));
+        result->SetString(hex);
+    }
+
+    void Digest::_DigestBytes(const ValueList& args, ValueRef result)
+    {
+        std::string digest(this->Finish());
+        result->SetObject(new Bytes(digest));
+    }
+
+    void Digest::_Reset(const ValueList& args, ValueRef result)
+    {
+        this->Finish();
+    }
+
+    DigestFileJob::DigestFileJob(AutoPtr<Digest> digest,
+        const std::string& path, TiMethodRef callback) :
+        AsyncJob(),
+        digest(digest),
+        path(path),
+        callback(callback)
+    {
+    }
+
+    ValueRef DigestFileJob::Execute()
+    {
+        try
+        {
+            this->HashFile();
+        }
+        catch (ValueException& e)
+        {
+            this->Error(e);
+            return Value::Undefined;
+        }
+
+        if (this->cancelled)
+            return Value::Undefined;
+
+        ValueRef hex(Value::NewString(DigestAlgorithm::ToHex(this->digest->Finish())));
+        if (!this->callback.isNull())
+            RunOnMainThread(this->callback, ValueList(hex), false);
+        return hex;
+    }
+
+    void DigestFileJob::HashFile()
+    {
+#ifdef OS_WIN32
+        std::ifstream stream(UTF8ToSystem(this->path).c_str(), std::ios::binary);
+        if (!stream.is_open())
+        {
+            throw ValueException::FromFormat("Could not open %s for hashing",
+                this->path.c_str());
+        }
+
+        std::vector<char> buffer(1024 * 1024);
+        while (!this->cancelled && stream)
+        {
+            stream.read(&buffer[0], buffer.size());
+            this->digest->Update(&buffer[0], stream.gcount());
+        }
+#else
+        int fd = open(this->path.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            throw ValueException::FromFormat("Could not open %s for hashing: %s",
+                this->path.c_str(), strerror(errno));
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) == -1)
+        {
+            close(fd);
+            throw ValueException::FromFormat("Could not stat %s: %s",
+                this->path.c_str(), strerror(errno));
+        }
+
+        UInt64 size = info.st_size;
+        UInt64 offset = 0;
+        while (offset < size && !this->cancelled)
+        {
+            size_t length = (size_t) std::min((UInt64) DIGEST_FILE_WINDOW, size - offset);
+            void* window = mmap(0, length, PROT_READ, MAP_SHARED, fd, offset);
+            if (window == MAP_FAILED)
+            {
+                close(fd);
+                throw ValueException::FromFormat("Could not map %s: %s",
+                    this->path.c_str(), strerror(errno));
+            }
+
+            madvise(window, length, MADV_SEQUENTIAL);
+            this->digest->Update(window, length);
+            munmap(window, length);
+
+            offset += length;
+            this->SetProgress(double(offset) / size, true);
+        }
+
+        close(fd);
+#endif
+    }
+}
@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _CODEC_DIGEST_H_
+#define _CODEC_DIGEST_H_
+
+#include <tide/tide.h>
+#include <string>
+#include <Poco/Mutex.h>
+
+#define CODEC_MD2       1
+#define CODEC_MD4       2
+#define CODEC_MD5       3
+#define CODEC_SHA1      4
+#define CODEC_SHA256    5
+#define CODEC_SHA512    6
+#define CODEC_CRC32     1
+#define CODEC_ADLER32   2
+#define CODEC_CRC32C    3
+
+namespace ti
+{
+    /**
+     * A digest or checksum algorithm which is fed data incrementally.
+     */
+    class DigestAlgorithm
+    {
+    public:
+        virtual ~DigestAlgorithm() {}
+
+        virtual void Update(const void* data, size_t length) = 0;
+
+        // Return the raw digest and reset the algorithm, so
+        // that it can be reused for new data.
+        virtual std::string Finish() = 0;
+
+        // The input block size, used when computing an HMAC.
+        virtual size_t BlockSize() = 0;
+
+        // Create an algorithm for one of the digest types (MD2 to
+        // SHA512), optionally keyed as an HMAC, or for one of the
+        // checksum types. Both throw for an unknown type.
+        static DigestAlgorithm* CreateDigest(int type, const std::string* key=0);
+        static DigestAlgorithm* CreateChecksum(int type);
+
+        static std::string ToHex(const std::string& digest);
+    };
+
+    /**
+     * A script object which computes a digest or checksum over data
+     * given in any number of update calls. Bytes are hashed in place,
+     * so large inputs can be fed in chunks without being copied.
+     */
+    class Digest : public StaticBoundObject
+    {
+    public:
+        Digest(DigestAlgorithm* algorithm);
+        virtual ~Digest();
+
+        void Update(const void* data, size_t length);
+        std::string Finish();
+
+    private:
+        void _Update(const ValueList& args, ValueRef result);
+        void _Digest(const ValueList& args, ValueRef result);
+        void _DigestBytes(const ValueList& args, ValueRef result);
+        void _Reset(const ValueList& args, ValueRef result);
+
+        DigestAlgorithm* algorithm;
+        Poco::Mutex mutex;
+    };
+
+    /**
+     * Hashes a file on a background thread, mapping it into memory
+     * where possible, and passes the hex digest to a callback on the
+     * main thread. The digest is also the result of the job.
+     */
+    class DigestFileJob : public AsyncJob
+    {
+    public:
+        DigestFileJob(AutoPtr<Digest> digest, const std::string& path,
+            TiMethodRef callback);
+
+    protected:
+        virtual ValueRef Execute();
+
+    private:
+        void HashFile();
+
+        AutoPtr<Digest> digest;
+        std::string path;
+        TiMethodRef callback;
+    };
+}
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include "encoder.h"
+#include "binary_encoding.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ti
+{
+    Encoder::Encoder(int type) :
+        StaticBoundObject("Codec.Encoder"),
+        type(type)
+    {
+        /**
+         * @tiapi(method=True,name=Codec.Encoder.update,since=1.4) Encode more data
+         * @tiarg(for=Codec.Encoder.update,name=data,type=String|Bytes) data to encode
+         * @tiresult(for=Codec.Encoder.update,type=Bytes) the encoding of all complete blocks of input so far
+         */
+        this->SetMethod("update", &Encoder::_Update);
+
+        /**
+         * @tiapi(method=True,name=Codec.Encoder.finish,since=1.4) Encode the remaining input and reset the encoder
+         * @tiresult(for=Codec.Encoder.finish,type=Bytes) the end of the encoding, including any padding
+         */
+        this->SetMethod("finish", &Encoder::_Finish);
+
+        /**
+         * @tiapi(method=True,name=Codec.Encoder.reset,since=1.4) Discard any input which has not been encoded
+         */
+        this->SetMethod("reset", &Encoder::_Reset);
+    }
+
+    BytesRef Encoder::Update(const char* data, size_t length)
+    {
+        Poco::Mutex::ScopedLock lock(this->mutex);
+        size_t block = BinaryEncoding::BlockSize(this->type);
+
+        // Complete the block left over from the last update first.
+        size_t fill = 0;
+        if (!this->pending.empty())
+        {
+            fill = std::min(block - this->pending.size(), length);
+            this->pending.append(data, fill);
+        }
+        size_t head = this->pending.size() == block ? block : 0;
+        size_t whole = (length - fill) / block * block;
+
+        BytesRef result(new Bytes(
+            BinaryEncoding::EncodedLength(this->type, head) +
+            BinaryEncoding::EncodedLength(this->type, whole)));
+        char* out = result->Pointer();
+        if (head > 0)
+        {
+            out += BinaryEncoding::Encode(this->type, this->pending.data(), head, out);
+            this->pending.clear();
+        }
+
+        // Whole blocks are encoded straight from the input.
+        BinaryEncoding::Encode(this->type, data + fill, whole, out);
+        this->pending.append(data + fill + whole, length - fill - whole);
+        return result;
+    }
+
+    BytesRef Encoder::Finish()
+    {
+        Poco::Mutex::ScopedLock lock(this->mutex);
+        BytesRef result(new Bytes(
+            BinaryEncoding::EncodedLength(this->type, this->pending.size())));
+        BinaryEncoding::Encode(this->type, this->pending.data(),
+            this->pending.size(), result->Pointer());
+        this->pending.clear();
+        return result;
+    }
+
+    void Encoder::_Update(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("update", "s|o");
+
+        if (args.at(0)->IsString())
+        {
+            const char* data = args.at(0)->ToString();
+            result->SetObject(this->Update(data, strlen(data)));
+        }
+        else
+        {
+            BytesRef bytes(args.GetObject(0).cast<Bytes>());
+            if (bytes.isNull())
+                throw ValueException::FromString("update expects a String or Bytes");
+
+            result->SetObject(this->Update(bytes->Pointer(), bytes->Length()));
+        }
+    }
+
+    void Encoder::_Finish(const ValueList& args, ValueRef result)
+    {
+        result->SetObject(this->Finish());
+    }
+
+    void Encoder::_Reset(const ValueList& args, ValueRef result)
+    {
+        Poco::Mutex::ScopedLock lock(this->mutex);
+        this->pending.clear();
+    }
+}
@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _CODEC_ENCODER_H_
+#define _CODEC_ENCODER_H_
+
+#include <tide/tide.h>
+#include <string>
+#include <Poco/Mutex.h>
+
+namespace ti
+{
+    /**
+     * A script object which encodes data given in any number of update
+     * calls. Each update returns the encoding of every complete block
+     * of input so far, and the remaining bytes are held until the next
+     * update or the end of the stream.
+     */
+    class Encoder : public StaticBoundObject
+    {
+    public:
+        Encoder(int type);
+
+        BytesRef Update(const char* data, size_t length);
+        BytesRef Finish();
+
+    private:
+        void _Update(const ValueList& args, ValueRef result);
+        void _Finish(const ValueList& args, ValueRef result);
+        void _Reset(const ValueList& args, ValueRef result);
+
+        int type;
+        std::string pending;
+        Poco::Mutex mutex;
+    };
+}
+
+#endif
@@ -220,7 +220,9 @@ namespace ti
                     ValueRef anarg = args.at(c);
                     if (anarg->IsList())
                     {
-                        TiListRef list = anarg->ToList();
+                        // Copy script arrays once instead of calling
+                        // into the script engine for every parameter.
+                        TiListRef list = anarg->ToList()->SnapshotList();
                         for (size_t a=0;a<list->Size();a++)
                         {
                             ValueRef arg = list->At(a);
@@ -13,6 +13,8 @@ using namespace TideUtils;
 #include "async_copy.h"
 #include "filesystem_binding.h"
 #include <tide/thread_manager.h>
+#include <Poco/RunnableAdapter.h>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -20,20 +22,63 @@ using namespace TideUtils;
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #endif
 
+#ifdef OS_LINUX
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
+#define DEFAULT_COPY_THREADS 4
+#define MAX_COPY_THREADS 16
+#define DEFAULT_PROGRESS_INTERVAL 250
+
+// Bytes moved per copy call, which is also how often a copy in
+// progress notices that it has been cancelled.
+#define COPY_CHUNK_SIZE (8 * 1024 * 1024)
+#define COPY_BUFFER_SIZE (1024 * 1024)
+
 namespace ti
 {
     AsyncCopy::AsyncCopy(FilesystemBinding* parent, Host *host,
-        std::vector<std::string> files, std::string destination, TiMethodRef callback) :
+        std::vector<std::string> files, std::string destination, TiMethodRef callback,
+        TiObjectRef options) :
             StaticBoundObject("Filesystem.AsyncCopy"),
             parent(parent),
             host(host),
             files(files),
             destination(destination),
             callback(callback),
-            stopped(false)
+            threadCount(DEFAULT_COPY_THREADS),
+            progressInterval(DEFAULT_PROGRESS_INTERVAL),
+            stopped(false),
+            nextTask(0),
+            itemTasksRemaining(files.size(), 0),
+            itemFailed(files.size(), false),
+            runningWorkers(0),
+            bytesCopied(0),
+            totalBytes(0),
+            filesCopied(0)
     {
+        if (!options.isNull())
+        {
+            this->progressCallback = options->GetMethod("progress");
+            this->threadCount = options->GetInt("threads", this->threadCount);
+            this->progressInterval = options->GetInt("progressInterval", this->progressInterval);
+
+            if (this->threadCount < 1)
+                this->threadCount = 1;
+            if (this->threadCount > MAX_COPY_THREADS)
+                this->threadCount = MAX_COPY_THREADS;
+            if (this->progressInterval < 10)
+                this->progressInterval = 10;
+        }
+
+        this->SetMethod("toString", &AsyncCopy::ToString);
+        this->SetMethod("cancel", &AsyncCopy::Cancel);
+        this->SetMethod("getStats", &AsyncCopy::GetStats);
         this->Set("running",Value::NewBool(true));
         this->thread = new Poco::Thread();
         this->thread->start(&AsyncCopy::Run,this);
@@ -43,156 +88,573 @@ namespace ti
     {
         if (this->thread!=NULL)
         {
-            this->thread->tryJoin(10); // precaution, should already be stopped
+            // The job only lets go of its last reference once it has
+            // cleared "running", after all the workers have finished, so
+            // this only waits for the end of Run.
+            {
+                Poco::Mutex::ScopedLock lock(this->mutex);
+                this->stopped = true;
+            }
+            this->thread->join();
             delete this->thread;
             this->thread = NULL;
         }
     }
 
-    void AsyncCopy::Copy(Poco::Path &src, Poco::Path &dest)
+    void AsyncCopy::AddTask(size_t item, const std::string& source,
+        const std::string& destination, DirectoryWalker::EntryType type,
+        Poco::Int64 size)
+    {
+        CopyTask task;
+        task.source = source;
+        task.destination = destination;
+        task.type = type;
+        task.size = size;
+        task.item = item;
+
+        this->tasks.push_back(task);
+        this->itemTasksRemaining[item]++;
+        this->totalBytes += size;
+    }
+
+    void AsyncCopy::MakeDirectory(const std::string& source, const std::string& destination)
+    {
+#ifndef OS_WIN32
+        struct stat info;
+        if (stat(source.c_str(), &info) == -1)
+        {
+            throw ValueException::FromFormat("Could not stat %s: %s",
+                source.c_str(), strerror(errno));
+        }
+
+        if (mkdir(destination.c_str(), S_IRWXU) == -1 && errno != EEXIST)
+        {
+            throw ValueException::FromFormat("Could not create directory %s: %s",
+                destination.c_str(), strerror(errno));
+        }
+
+        this->directoryModes.push_back(std::make_pair(destination,
+            (int) (info.st_mode & 07777)));
+#else
+        Poco::File d(destination);
+        if (!d.exists())
+        {
+            d.createDirectories();
+        }
+#endif
+    }
+
+    bool AsyncCopy::IsStopped()
+    {
+        Poco::Mutex::ScopedLock lock(this->mutex);
+        return this->stopped;
+    }
+
+    void AsyncCopy::Plan(size_t item, const std::string& source)
     {
         Logger* logger = Logger::Get("Filesystem.AsyncCopy");
-        std::string srcString = src.toString();
-        std::string destString = dest.toString();
-        Poco::File from(srcString);
-        bool isLink = from.isLink();
+        Poco::File from(source);
+        std::string name(Poco::Path(source).getFileName());
 
-        logger->Debug("file=%s dest=%s link=%i", srcString.c_str(), destString.c_str(), isLink);
 #ifndef OS_WIN32
-        if (isLink)
+        if (from.isLink())
+        {
+            this->AddTask(item, source,
+                FileUtils::Join(this->destination.c_str(), name.c_str(), NULL),
+                DirectoryWalker::ENTRY_SYMLINK, 0);
+        }
+        else
+#endif
+        if (from.isDirectory())
         {
-            char linkPath[PATH_MAX];
-            ssize_t length = readlink(from.path().c_str(), linkPath, PATH_MAX);
-            linkPath[length] = '\0';
+            // The contents of a source directory are copied into the
+            // destination itself, not into a subdirectory of it, so the
+            // destination takes on the mode of the source directory.
+            this->MakeDirectory(source, this->destination);
 
-            std::string newPath (dest.toString());
-            const char *destPath = newPath.c_str();
-            unlink(destPath); // unlink it first, fails in some OS if already there
-            int result = symlink(linkPath, destPath);
+            DirectoryWalker::Options options;
+            options.recursive = true;
+            options.stat = true;
 
-            if (result == -1)
+            AutoPtr<DirectoryWalker> walker = new DirectoryWalker(source, options);
+            DirectoryWalker::Entry entry;
+            while (!this->IsStopped() && walker->Next(entry))
             {
-                std::string err = "Copy failed: Could not make symlink (";
-                err.append(destPath);
-                err.append(") from ");
-                err.append(linkPath);
-                err.append(" : ");
-                err.append(strerror(errno));
-                throw tide::ValueException::FromString(err);
+                std::string relative(entry.path.substr(source.length()));
+                if (!relative.empty() && (relative[0] == '/' || relative[0] == '\\'))
+                    relative.erase(0, 1);
+
+                std::string target(FileUtils::Join(
+                    this->destination.c_str(), relative.c_str(), NULL));
+
+                if (entry.type == DirectoryWalker::ENTRY_DIRECTORY)
+                {
+                    this->MakeDirectory(entry.path, target);
+                }
+#ifdef OS_WIN32
+                else if (entry.type != DirectoryWalker::ENTRY_OTHER)
+                {
+                    this->AddTask(item, entry.path, target,
+                        DirectoryWalker::ENTRY_FILE, (Poco::Int64) entry.size);
+                }
+#else
+                else if (entry.type == DirectoryWalker::ENTRY_FILE ||
+                    entry.type == DirectoryWalker::ENTRY_SYMLINK)
+                {
+                    this->AddTask(item, entry.path, target, entry.type,
+                        (Poco::Int64) entry.size);
+                }
+#endif
+                else
+                {
+                    logger->Warn("Skipping special file: %s", entry.path.c_str());
+                }
             }
         }
+        else
+        {
+            this->AddTask(item, source,
+                FileUtils::Join(this->destination.c_str(), name.c_str(), NULL),
+                DirectoryWalker::ENTRY_FILE, (Poco::Int64) from.getSize());
+        }
+
+        if (this->itemTasksRemaining[item] == 0)
+            this->completedItems.push_back(item);
+    }
+
+    bool AsyncCopy::NextTask(CopyTask& task)
+    {
+        Poco::Mutex::ScopedLock lock(this->mutex);
+        if (this->stopped || this->nextTask >= this->tasks.size())
+            return false;
+
+        task = this->tasks[this->nextTask++];
+        return true;
+    }
+
+    void AsyncCopy::FinishTask(const CopyTask& task, bool copied)
+    {
+        Poco::Mutex::ScopedLock lock(this->mutex);
+        if (copied)
+            this->filesCopied++;
+        else
+            this->itemFailed[task.item] = true;
+
+        // Like before, the callback only reports items which were copied
+        // in full, not those which failed or were cancelled part way.
+        if (--this->itemTasksRemaining[task.item] == 0 && !this->itemFailed[task.item])
+            this->completedItems.push_back(task.item);
+    }
+
+    bool AsyncCopy::AddProgress(Poco::Int64 bytes)
+    {
+        Poco::Mutex::ScopedLock lock(this->mutex);
+        this->bytesCopied += bytes;
+        return !this->stopped;
+    }
+
+    void AsyncCopy::CopyLink(const CopyTask& task)
+    {
+#ifndef OS_WIN32
+        Logger* logger = Logger::Get("Filesystem.AsyncCopy");
+
+        char linkPath[PATH_MAX];
+        ssize_t length = readlink(task.source.c_str(), linkPath, PATH_MAX - 1);
+        if (length == -1)
+        {
+            throw ValueException::FromFormat("Copy failed: Could not read symlink %s: %s",
+                task.source.c_str(), strerror(errno));
+        }
+        linkPath[length] = '\0';
+
+        logger->Debug("link=%s dest=%s", linkPath, task.destination.c_str());
+        const char *destPath = task.destination.c_str();
+        unlink(destPath); // unlink it first, fails in some OS if already there
+        if (symlink(linkPath, destPath) == -1)
+        {
+            std::string err = "Copy failed: Could not make symlink (";
+            err.append(destPath);
+            err.append(") from ");
+            err.append(linkPath);
+            err.append(" : ");
+            err.append(strerror(errno));
+            throw tide::ValueException::FromString(err);
+        }
 #endif
-        if (!isLink && from.isDirectory())
+    }
+
+#ifndef OS_WIN32
+    bool AsyncCopy::CopyContents(int in, int out)
+    {
+        enum { COPY_RANGE, SEND_FILE, READ_WRITE };
+#ifdef OS_LINUX
+#ifdef __NR_copy_file_range
+        int method = COPY_RANGE;
+#else
+        int method = SEND_FILE;
+#endif
+#else
+        int method = READ_WRITE;
+#endif
+        std::vector<char> buffer;
+
+        while (true)
         {
-            Poco::File d(dest.toString());
-            if (!d.exists())
+            ssize_t count = -1;
+#ifdef OS_LINUX
+            // Prefer copies which never leave the kernel, falling back
+            // when the filesystem or kernel does not support them.
+            if (method == COPY_RANGE)
             {
-                d.createDirectories();
+#ifdef __NR_copy_file_range
+                count = syscall(__NR_copy_file_range, in, NULL, out, NULL,
+                    COPY_CHUNK_SIZE, 0);
+#endif
+                if (count == -1 && (errno == ENOSYS || errno == EXDEV ||
+                    errno == EINVAL || errno == EOPNOTSUPP))
+                {
+                    method = SEND_FILE;
+                    continue;
+                }
             }
-            std::vector<std::string> files;
-            from.list(files);
-            std::vector<std::string>::iterator i = files.begin();
-            while(i!=files.end())
+            else if (method == SEND_FILE)
             {
-                std::string fn = (*i++);
-                Poco::Path sp(FileUtils::Join(src.toString().c_str(),fn.c_str(),NULL));
-                Poco::Path dp(FileUtils::Join(dest.toString().c_str(),fn.c_str(),NULL));
-                this->Copy(sp,dp);
+                count = sendfile(out, in, NULL, COPY_CHUNK_SIZE);
+                if (count == -1 && (errno == ENOSYS || errno == EINVAL))
+                {
+                    method = READ_WRITE;
+                    continue;
+                }
             }
-        }
-        else if (!isLink)
-        {
-            // in this case it's a regular file
-            Poco::File s(src.toString());
-            s.copyTo(dest.toString().c_str());
+            else
+#endif
+            {
+                if (buffer.empty())
+                    buffer.resize(COPY_BUFFER_SIZE);
+
+                count = read(in, &buffer[0], buffer.size());
+                ssize_t written = 0;
+                while (count > 0 && written < count)
+                {
+                    ssize_t result = write(out, &buffer[written], count - written);
+                    if (result == -1 && errno != EINTR)
+                        throw ValueException::FromFormat("Copy failed: %s", strerror(errno));
+                    if (result > 0)
+                        written += result;
+                }
+            }
+
+            if (count == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw ValueException::FromFormat("Copy failed: %s", strerror(errno));
+            }
+
+            if (count == 0)
+                return true;
+
+            if (!this->AddProgress(count))
+                return false;
         }
     }
+#endif
 
-    void AsyncCopy::Run(void* data)
+    bool AsyncCopy::CopyRegularFile(const CopyTask& task)
     {
-        START_TIDE_THREAD;
+#ifndef OS_WIN32
+        int in = open(task.source.c_str(), O_RDONLY);
+        if (in == -1)
+        {
+            throw ValueException::FromFormat("Could not open %s: %s",
+                task.source.c_str(), strerror(errno));
+        }
 
-        Logger* logger = Logger::Get("Filesystem.AsyncCopy");
+        struct stat info;
+        if (fstat(in, &info) == -1)
+        {
+            int error = errno;
+            close(in);
+            throw ValueException::FromFormat("Could not stat %s: %s",
+                task.source.c_str(), strerror(error));
+        }
 
-        AsyncCopy* ac = static_cast<AsyncCopy*>(data);
-        std::vector<std::string>::iterator iter = ac->files.begin();
-        Poco::Path to(ac->destination);
-        Poco::File tof(to.toString());
+        mode_t mode = info.st_mode & 07777;
+        int out = open(task.destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC, mode);
+        if (out == -1)
+        {
+            int error = errno;
+            close(in);
+            throw ValueException::FromFormat("Could not create %s: %s",
+                task.destination.c_str(), strerror(error));
+        }
 
-        logger->Debug("Job started: dest=%s, count=%i", ac->destination.c_str(), ac->files.size());
-        if (!tof.exists())
+        // Apply the mode explicitly so that the umask does not change it.
+        fchmod(out, mode);
+#ifdef OS_LINUX
+        posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+        bool completed = false;
+        try
         {
-            tof.createDirectory();
+            completed = this->CopyContents(in, out);
         }
-        int c = 0;
-        while (!ac->stopped && iter!=ac->files.end())
+        catch (...)
         {
-            std::string file = (*iter++);
-            c++;
+            close(in);
+            close(out);
+            unlink(task.destination.c_str());
+            throw;
+        }
+
+        close(in);
+        close(out);
 
-            logger->Debug("File: path=%s, count=%i\n", file.c_str(), c);
+        // Don't leave partial files behind after a cancel.
+        if (!completed)
+            unlink(task.destination.c_str());
+        return completed;
+#else
+        Poco::File(task.source).copyTo(task.destination);
+        this->AddProgress(task.size);
+        return true;
+#endif
+    }
+
+    void AsyncCopy::Work()
+    {
+        START_TIDE_THREAD;
+
+        Logger* logger = Logger::Get("Filesystem.AsyncCopy");
+        CopyTask task;
+        while (this->NextTask(task))
+        {
+            bool copied = false;
             try
             {
-                Poco::Path from(file);
-                Poco::File f(file);
-                if (f.isDirectory())
+                if (task.type == DirectoryWalker::ENTRY_SYMLINK)
                 {
-                    ac->Copy(from,to);
+                    this->CopyLink(task);
+                    copied = true;
                 }
                 else
                 {
-                    Poco::Path dest(to,from.getFileName());
-                    ac->Copy(from,dest);
+                    copied = this->CopyRegularFile(task);
                 }
-                logger->Debug("File copied");
+            }
+            catch (ValueException &ex)
+            {
+                SharedString ss = ex.DisplayString();
+                logger->Error(std::string("Error: ") + *ss + " for file: " + task.source);
+            }
+            catch (Poco::Exception &ex)
+            {
+                logger->Error(std::string("Error: ") + ex.displayText() + " for file: " + task.source);
+            }
+            catch (std::exception &ex)
+            {
+                logger->Error(std::string("Error: ") + ex.what() + " for file: " + task.source);
+            }
+            catch (...)
+            {
+                logger->Error(std::string("Unknown error during copy: ") + task.source);
+            }
 
-                ValueRef value = Value::NewString(file);
-                ValueList args;
-                args.push_back(value);
-                args.push_back(Value::NewInt(c));
-                args.push_back(Value::NewInt(ac->files.size()));
-                RunOnMainThread(ac->callback, args, false);
+            this->FinishTask(task, copied);
+        }
 
-                logger->Debug("Callback executed");
+        {
+            Poco::Mutex::ScopedLock lock(this->mutex);
+            if (--this->runningWorkers == 0)
+                this->workersFinished.set();
+        }
+
+        END_TIDE_THREAD;
+    }
+
+    void AsyncCopy::Run(void* data)
+    {
+        START_TIDE_THREAD;
+
+        Logger* logger = Logger::Get("Filesystem.AsyncCopy");
+
+        AsyncCopy* ac = static_cast<AsyncCopy*>(data);
+        Poco::File tof(ac->destination);
+        ac->startTime.update();
+
+        logger->Debug("Job started: dest=%s, count=%i", ac->destination.c_str(), ac->files.size());
+        try
+        {
+            if (!tof.exists())
+            {
+                tof.createDirectory();
+            }
+        }
+        catch (Poco::Exception &ex)
+        {
+            logger->Error(std::string("Error: ") + ex.displayText() + " for destination: " + ac->destination);
+        }
+
+        // Plan the whole copy before starting, so that we know
+        // the total amount of work for progress reporting.
+        for (size_t i = 0; !ac->IsStopped() && i < ac->files.size(); i++)
+        {
+            std::string file(ac->files[i]);
+            try
+            {
+                ac->Plan(i, file);
             }
             catch (ValueException &ex)
             {
+                ac->itemFailed[i] = true;
                 SharedString ss = ex.DisplayString();
                 logger->Error(std::string("Error: ") + *ss + " for file: " + file);
             }
             catch (Poco::Exception &ex)
             {
+                ac->itemFailed[i] = true;
                 logger->Error(std::string("Error: ") + ex.displayText() + " for file: " + file);
             }
             catch (std::exception &ex)
             {
+                ac->itemFailed[i] = true;
                 logger->Error(std::string("Error: ") + ex.what() + " for file: " + file);
             }
             catch (...)
             {
+                ac->itemFailed[i] = true;
                 logger->Error(std::string("Unknown error during copy: ") + file);
             }
         }
-        ac->Set("running",Value::NewBool(false));
-        ac->stopped = true;
 
-        logger->Debug(std::string("Job finished"));
+        logger->Debug("Job planned: files=%i, bytes=%.0f",
+            ac->tasks.size(), (double) ac->totalBytes);
+
+        int workerCount = std::min((int) ac->tasks.size(), ac->threadCount);
+        std::vector<Poco::Thread*> workers;
+        Poco::RunnableAdapter<AsyncCopy> adapter(*ac, &AsyncCopy::Work);
+
+        ac->runningWorkers = workerCount;
+        for (int i = 0; i < workerCount; i++)
+        {
+            Poco::Thread* worker = new Poco::Thread();
+            worker->start(adapter);
+            workers.push_back(worker);
+        }
+
+        int c = 0;
+        bool finished = workerCount == 0;
+        while (true)
+        {
+            if (!finished)
+                finished = ac->workersFinished.tryWait(ac->progressInterval);
+
+            std::deque<size_t> completed;
+            {
+                Poco::Mutex::ScopedLock lock(ac->mutex);
+                completed.swap(ac->completedItems);
+            }
+
+            while (!completed.empty())
+            {
+                std::string file(ac->files[completed.front()]);
+                completed.pop_front();
+                c++;
+
+                ValueList args;
+                args.push_back(Value::NewString(file));
+                args.push_back(Value::NewInt(c));
+                args.push_back(Value::NewInt(ac->files.size()));
+                RunOnMainThread(ac->callback, args, false);
+            }
+
+            if (!ac->progressCallback.isNull())
+            {
+                RunOnMainThread(ac->progressCallback,
+                    ValueList(Value::NewObject(ac->CreateStats())), false);
+            }
+
+            if (finished)
+                break;
+        }
+
+        for (size_t i = 0; i < workers.size(); i++)
+        {
+            workers[i]->join();
+            delete workers[i];
+        }
+
+#ifndef OS_WIN32
+        // Restore directory modes deepest first, so that read-only
+        // parents do not stop us from updating their children.
+        std::vector<std::pair<std::string, int> >::reverse_iterator mode =
+            ac->directoryModes.rbegin();
+        while (mode != ac->directoryModes.rend())
+        {
+            chmod(mode->first.c_str(), (mode_t) mode->second);
+            mode++;
+        }
+#endif
+
+        logger->Debug("Job finished: bytes=%.0f, seconds=%.2f",
+            (double) ac->bytesCopied, ac->startTime.elapsed() / 1000000.0);
+
+        // Clearing "running" lets the binding drop its reference to the
+        // job, so nothing may touch it after this.
+        {
+            Poco::Mutex::ScopedLock lock(ac->mutex);
+            ac->stopped = true;
+        }
+        ac->Set("running",Value::NewBool(false));
 
         END_TIDE_THREAD;
     }
 
+    TiObjectRef AsyncCopy::CreateStats()
+    {
+        Poco::Int64 bytesCopied, totalBytes;
+        size_t filesCopied, totalFiles;
+        {
+            Poco::Mutex::ScopedLock lock(this->mutex);
+            bytesCopied = this->bytesCopied;
+            totalBytes = this->totalBytes;
+            filesCopied = this->filesCopied;
+            totalFiles = this->tasks.size();
+        }
+
+        double elapsed = this->startTime.elapsed() / 1000000.0;
+        TiObjectRef stats = new StaticBoundObject();
+        stats->SetDouble("bytesCopied", (double) bytesCopied);
+        stats->SetDouble("totalBytes", (double) totalBytes);
+        stats->SetInt("filesCopied", (int) filesCopied);
+        stats->SetInt("totalFiles", (int) totalFiles);
+        stats->SetDouble("elapsed", elapsed);
+        stats->SetDouble("throughput", elapsed > 0 ? bytesCopied / elapsed : 0);
+        stats->SetDouble("progress", totalBytes > 0 ?
+            (double) bytesCopied / totalBytes : (filesCopied == totalFiles ? 1.0 : 0.0));
+        return stats;
+    }
+
     void AsyncCopy::ToString(const ValueList& args, ValueRef result)
     {
         result->SetString("[Async Copy]");
     }
 
+    void AsyncCopy::GetStats(const ValueList& args, ValueRef result)
+    {
+        result->SetObject(this->CreateStats());
+    }
+
     void AsyncCopy::Cancel(const ValueList& args, ValueRef result)
     {
         TIDE_DUMP_LOCATION
         if (thread!=NULL && thread->isRunning())
         {
+            // The workers stop at their next chunk and Run clears
+            // "running" once they have all finished.
+            Poco::Mutex::ScopedLock lock(this->mutex);
             this->stopped = true;
-            this->Set("running",Value::NewBool(false));
             result->SetBool(true);
         }
         else
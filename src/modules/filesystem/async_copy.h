@@ -19,35 +19,92 @@
 
 #include <string>
 #include <vector>
+#include <deque>
 #include <Poco/Thread.h>
+#include <Poco/Mutex.h>
+#include <Poco/Event.h>
+#include <Poco/Timestamp.h>
 #include <Poco/Exception.h>
 #include <Poco/Path.h>
 #include <Poco/File.h>
 #include "filesystem_binding.h"
+#include "directory_walker.h"
 
 
 namespace ti
 {
+    /**
+     * Copies a set of files and directories on background threads.
+     * The whole tree is planned up front so that progress can be reported
+     * in bytes, then regular files are copied by a small pool of workers
+     * using in-kernel copies where the platform supports them.
+     */
     class AsyncCopy : public StaticBoundObject
     {
     public:
-        AsyncCopy(FilesystemBinding* parent,tide::Host *host,std::vector<std::string> files, std::string destination, TiMethodRef callback);
+        AsyncCopy(FilesystemBinding* parent,tide::Host *host,std::vector<std::string> files, std::string destination, TiMethodRef callback, TiObjectRef options = 0);
         virtual ~AsyncCopy();
 
     private:
+        struct CopyTask
+        {
+            std::string source;
+            std::string destination;
+            DirectoryWalker::EntryType type;
+            Poco::Int64 size;
+            size_t item;
+        };
+
         FilesystemBinding* parent;
         Host *host;
         std::vector<std::string> files;
         std::string destination;
         TiMethodRef callback;
+        TiMethodRef progressCallback;
+        int threadCount;
+        long progressInterval;
         Poco::Thread *thread;
         bool stopped;
 
+        // State shared with the worker threads, guarded by mutex.
+        Poco::Mutex mutex;
+        std::vector<CopyTask> tasks;
+        size_t nextTask;
+        std::vector<size_t> itemTasksRemaining;
+        std::vector<bool> itemFailed;
+        std::deque<size_t> completedItems;
+        int runningWorkers;
+        Poco::Event workersFinished;
+        Poco::Int64 bytesCopied;
+        Poco::Int64 totalBytes;
+        size_t filesCopied;
+        Poco::Timestamp startTime;
+
+        // Modes of copied directories are applied once their contents
+        // are in place, since a read-only directory could not be filled.
+        std::vector<std::pair<std::string, int> > directoryModes;
+
         static void Run(void*);
+        bool IsStopped();
+        void Plan(size_t item, const std::string& source);
+        void AddTask(size_t item, const std::string& source,
+            const std::string& destination, DirectoryWalker::EntryType type,
+            Poco::Int64 size);
+        void MakeDirectory(const std::string& source, const std::string& destination);
+        void Work();
+        bool NextTask(CopyTask& task);
+        void FinishTask(const CopyTask& task, bool copied);
+        bool AddProgress(Poco::Int64 bytes);
+        bool CopyRegularFile(const CopyTask& task);
+        void CopyLink(const CopyTask& task);
+#ifndef OS_WIN32
+        bool CopyContents(int in, int out);
+#endif
+        TiObjectRef CreateStats();
 
         void ToString(const ValueList& args, ValueRef result);
         void Cancel(const ValueList& args, ValueRef result);
-        void Copy(Poco::Path &src, Poco::Path &dest);
+        void GetStats(const ValueList& args, ValueRef result);
     };
 }
 
@@ -0,0 +1,416 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include "directory_walker.h"
+
+#ifdef OS_WIN32
+#include <tideutils/win/win32_utils.h>
+using namespace TideUtils;
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+#define DEFAULT_BATCH_SIZE 256
+
+namespace ti
+{
+    static const char* TypeName(DirectoryWalker::EntryType type)
+    {
+        switch (type)
+        {
+            case DirectoryWalker::ENTRY_FILE: return "file";
+            case DirectoryWalker::ENTRY_DIRECTORY: return "directory";
+            case DirectoryWalker::ENTRY_SYMLINK: return "symlink";
+            case DirectoryWalker::ENTRY_OTHER: return "other";
+            default: return "unknown";
+        }
+    }
+
+    static std::string JoinPath(const std::string& directory, const std::string& name)
+    {
+#ifdef OS_WIN32
+        const char separator = '\\';
+#else
+        const char separator = '/';
+#endif
+        if (!directory.empty() && directory[directory.size() - 1] == separator)
+            return directory + name;
+        return directory + separator + name;
+    }
+
+#ifndef OS_WIN32
+    static DirectoryWalker::EntryType TypeFromMode(mode_t mode)
+    {
+        if (S_ISREG(mode))
+            return DirectoryWalker::ENTRY_FILE;
+        if (S_ISDIR(mode))
+            return DirectoryWalker::ENTRY_DIRECTORY;
+        if (S_ISLNK(mode))
+            return DirectoryWalker::ENTRY_SYMLINK;
+        return DirectoryWalker::ENTRY_OTHER;
+    }
+
+    static DirectoryWalker::EntryType TypeFromDirent(unsigned char type)
+    {
+        switch (type)
+        {
+            case DT_REG: return DirectoryWalker::ENTRY_FILE;
+            case DT_DIR: return DirectoryWalker::ENTRY_DIRECTORY;
+            case DT_LNK: return DirectoryWalker::ENTRY_SYMLINK;
+            case DT_UNKNOWN: return DirectoryWalker::ENTRY_UNKNOWN;
+            default: return DirectoryWalker::ENTRY_OTHER;
+        }
+    }
+#endif
+
+    DirectoryWalker::Options::Options() :
+        recursive(false),
+        maxDepth(-1),
+        stat(false),
+        includeFiles(true),
+        includeDirectories(true),
+        includeHidden(true),
+        batchSize(DEFAULT_BATCH_SIZE)
+    {
+    }
+
+    void DirectoryWalker::Options::Read(TiObjectRef object)
+    {
+        if (object.isNull())
+            return;
+
+        this->recursive = object->GetBool("recursive", this->recursive);
+        this->maxDepth = object->GetInt("maxDepth", this->maxDepth);
+        this->stat = object->GetBool("stat", this->stat);
+        this->includeFiles = object->GetBool("files", this->includeFiles);
+        this->includeDirectories = object->GetBool("directories", this->includeDirectories);
+        this->includeHidden = object->GetBool("hidden", this->includeHidden);
+        this->pattern = object->GetString("pattern", this->pattern);
+
+        int batchSize = object->GetInt("batchSize", (int) this->batchSize);
+        if (batchSize > 0)
+            this->batchSize = batchSize;
+    }
+
+    DirectoryWalker::DirectoryWalker(const std::string& root, const Options& options) :
+        StaticBoundObject("Filesystem.DirectoryWalker"),
+        options(options),
+        hasPending(false)
+    {
+        if (!this->Push(root, 0))
+        {
+            throw ValueException::FromFormat("Could not open directory: %s",
+                root.c_str());
+        }
+
+        this->SetMethod("next", &DirectoryWalker::_Next);
+        this->SetMethod("hasNext", &DirectoryWalker::_HasNext);
+        this->SetMethod("readAll", &DirectoryWalker::_ReadAll);
+        this->SetMethod("close", &DirectoryWalker::_Close);
+    }
+
+    DirectoryWalker::~DirectoryWalker()
+    {
+        this->Close();
+    }
+
+    bool DirectoryWalker::Push(const std::string& path, int depth)
+    {
+        Level level;
+        level.path = path;
+        level.depth = depth;
+
+#ifdef OS_WIN32
+        std::wstring pattern(UTF8ToWide(path + "\\*"));
+        level.handle = FindFirstFileW(pattern.c_str(), &level.data);
+        if (level.handle == INVALID_HANDLE_VALUE)
+            return false;
+        level.hasData = true;
+#else
+        level.dir = opendir(path.c_str());
+        if (!level.dir)
+            return false;
+#endif
+
+        this->stack.push_back(level);
+        return true;
+    }
+
+    void DirectoryWalker::Close()
+    {
+        while (!this->stack.empty())
+        {
+#ifdef OS_WIN32
+            FindClose(this->stack.back().handle);
+#else
+            closedir(this->stack.back().dir);
+#endif
+            this->stack.pop_back();
+        }
+        this->hasPending = false;
+    }
+
+    bool DirectoryWalker::ReadEntry(Entry& entry, int& depth)
+    {
+        while (!this->stack.empty())
+        {
+            Level& level = this->stack.back();
+
+#ifdef OS_WIN32
+            if (!level.hasData)
+            {
+                FindClose(level.handle);
+                this->stack.pop_back();
+                continue;
+            }
+
+            WIN32_FIND_DATAW data(level.data);
+            level.hasData = FindNextFileW(level.handle, &level.data) != 0;
+
+            if (!wcscmp(data.cFileName, L".") || !wcscmp(data.cFileName, L".."))
+                continue;
+
+            entry.name = WideToUTF8(data.cFileName);
+            entry.path = JoinPath(level.path, entry.name);
+            depth = level.depth;
+
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+                entry.type = ENTRY_SYMLINK;
+            else if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                entry.type = ENTRY_DIRECTORY;
+            else
+                entry.type = ENTRY_FILE;
+
+            // FindNextFile hands us the metadata for free.
+            entry.hasStat = this->options.stat;
+            if (entry.hasStat)
+            {
+                ULARGE_INTEGER size, time;
+                size.LowPart = data.nFileSizeLow;
+                size.HighPart = data.nFileSizeHigh;
+                time.LowPart = data.ftLastWriteTime.dwLowDateTime;
+                time.HighPart = data.ftLastWriteTime.dwHighDateTime;
+
+                // FILETIME counts 100ns intervals since 1601.
+                entry.size = (double) size.QuadPart;
+                entry.modificationTimestamp =
+                    (double) ((time.QuadPart - 116444736000000000ULL) / 10);
+            }
+
+            bool hidden = (data.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) ||
+                entry.name[0] == '.';
+#else
+            struct dirent* dirent = readdir(level.dir);
+            if (!dirent)
+            {
+                closedir(level.dir);
+                this->stack.pop_back();
+                continue;
+            }
+
+            const char* name = dirent->d_name;
+            if (name[0] == '.' && (name[1] == '\0' ||
+                (name[1] == '.' && name[2] == '\0')))
+                continue;
+
+            entry.name = name;
+            entry.path = JoinPath(level.path, entry.name);
+            entry.type = TypeFromDirent(dirent->d_type);
+            entry.hasStat = false;
+            depth = level.depth;
+
+            // Only stat when asked to or when the filesystem does not
+            // report the type of an entry in the directory itself.
+            if (this->options.stat || entry.type == ENTRY_UNKNOWN)
+            {
+                struct stat info;
+                if (fstatat(dirfd(level.dir), name, &info, AT_SYMLINK_NOFOLLOW) == 0)
+                {
+                    entry.type = TypeFromMode(info.st_mode);
+                    if (this->options.stat)
+                    {
+                        entry.hasStat = true;
+                        entry.size = (double) info.st_size;
+                        entry.modificationTimestamp = info.st_mtime * 1000000.0;
+#ifdef OS_LINUX
+                        entry.modificationTimestamp += info.st_mtim.tv_nsec / 1000;
+#endif
+                    }
+                }
+            }
+
+            bool hidden = name[0] == '.';
+#endif
+            if (hidden && !this->options.includeHidden)
+                continue;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    bool DirectoryWalker::Matches(const Entry& entry)
+    {
+        if (entry.type == ENTRY_DIRECTORY)
+        {
+            if (!this->options.includeDirectories)
+                return false;
+        }
+        else if (!this->options.includeFiles)
+        {
+            return false;
+        }
+
+        return this->options.pattern.empty() ||
+            MatchGlob(this->options.pattern.c_str(), entry.name.c_str(), true);
+    }
+
+    bool DirectoryWalker::Next(Entry& entry)
+    {
+        if (this->hasPending)
+        {
+            entry = this->pending;
+            this->hasPending = false;
+            return true;
+        }
+
+        int depth;
+        while (this->ReadEntry(entry, depth))
+        {
+            // Symbolic links to directories are not followed, which keeps
+            // the walk free of cycles.
+            if (entry.type == ENTRY_DIRECTORY && this->options.recursive &&
+                (this->options.maxDepth < 0 || depth < this->options.maxDepth))
+            {
+                if (!this->Push(entry.path, depth + 1))
+                {
+                    Logger::Get("Filesystem.DirectoryWalker")->Warn(
+                        "Could not open directory: %s", entry.path.c_str());
+                }
+            }
+
+            if (this->Matches(entry))
+                return true;
+        }
+
+        return false;
+    }
+
+    bool DirectoryWalker::HasNext()
+    {
+        if (!this->hasPending)
+            this->hasPending = this->Next(this->pending);
+        return this->hasPending;
+    }
+
+    TiListRef DirectoryWalker::NextBatch(size_t count)
+    {
+        TiListRef batch;
+        Entry entry;
+        while (count > 0 && this->Next(entry))
+        {
+            if (batch.isNull())
+                batch = new StaticBoundList();
+
+            batch->Append(Value::NewObject(CreateEntryObject(entry)));
+            count--;
+        }
+        return batch;
+    }
+
+    /*static*/
+    TiObjectRef DirectoryWalker::CreateEntryObject(const Entry& entry)
+    {
+        TiObjectRef object = new StaticBoundObject("Filesystem.DirectoryEntry");
+        object->SetString("name", entry.name);
+        object->SetString("path", entry.path);
+        object->SetString("type", TypeName(entry.type));
+
+        if (entry.hasStat)
+        {
+            object->SetDouble("size", entry.size);
+            object->SetDouble("modificationTimestamp", entry.modificationTimestamp);
+        }
+        return object;
+    }
+
+    void DirectoryWalker::_Next(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("next", "?i");
+
+        int count = args.GetInt(0, (int) this->options.batchSize);
+        if (count <= 0)
+            throw ValueException::FromString("DirectoryWalker.next() count must be greater than zero");
+
+        TiListRef batch(this->NextBatch(count));
+        if (batch.isNull())
+            result->SetNull();
+        else
+            result->SetList(batch);
+    }
+
+    void DirectoryWalker::_HasNext(const ValueList& args, ValueRef result)
+    {
+        result->SetBool(this->HasNext());
+    }
+
+    void DirectoryWalker::_ReadAll(const ValueList& args, ValueRef result)
+    {
+        TiListRef list = new StaticBoundList();
+        Entry entry;
+        while (this->Next(entry))
+            list->Append(Value::NewObject(CreateEntryObject(entry)));
+
+        result->SetList(list);
+    }
+
+    void DirectoryWalker::_Close(const ValueList& args, ValueRef result)
+    {
+        this->Close();
+    }
+
+    DirectoryListingJob::DirectoryListingJob(const std::string& root,
+        const DirectoryWalker::Options& options, TiMethodRef callback) :
+        AsyncJob(),
+        root(root),
+        options(options),
+        callback(callback)
+    {
+    }
+
+    ValueRef DirectoryListingJob::Execute()
+    {
+        try
+        {
+            AutoPtr<DirectoryWalker> walker =
+                new DirectoryWalker(this->root, this->options);
+
+            while (!this->cancelled)
+            {
+                TiListRef batch(walker->NextBatch(this->options.batchSize));
+                if (batch.isNull())
+                    break;
+
+                RunOnMainThread(this->callback,
+                    ValueList(Value::NewList(batch)), false);
+            }
+
+            walker->Close();
+        }
+        catch (ValueException& e)
+        {
+            this->Error(e);
+        }
+
+        return Value::Undefined;
+    }
+}
@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _TI_DIRECTORY_WALKER_H_
+#define _TI_DIRECTORY_WALKER_H_
+
+#include <tide/tide.h>
+
+#ifdef OS_WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <dirent.h>
+#endif
+
+#include <string>
+#include <vector>
+
+namespace ti
+{
+    /**
+     * Streams the entries of a directory, optionally recursing into
+     * subdirectories. Entries are returned in batches as plain objects
+     * carrying the name, path and type of the entry, and the size and
+     * modification time when stat information was requested. This is
+     * much cheaper than getDirectoryListing, which creates a full
+     * Filesystem.File for every entry.
+     */
+    class DirectoryWalker : public StaticBoundObject
+    {
+    public:
+        enum EntryType
+        {
+            ENTRY_UNKNOWN,
+            ENTRY_FILE,
+            ENTRY_DIRECTORY,
+            ENTRY_SYMLINK,
+            ENTRY_OTHER
+        };
+
+        struct Options
+        {
+            Options();
+
+            // Read options from a script object, leaving defaults
+            // for properties which are not set.
+            void Read(TiObjectRef object);
+
+            bool recursive;
+            int maxDepth;
+            bool stat;
+            bool includeFiles;
+            bool includeDirectories;
+            bool includeHidden;
+            size_t batchSize;
+            std::string pattern;
+        };
+
+        struct Entry
+        {
+            std::string name;
+            std::string path;
+            EntryType type;
+            bool hasStat;
+            double size;
+            double modificationTimestamp;
+        };
+
+        DirectoryWalker(const std::string& root, const Options& options);
+        virtual ~DirectoryWalker();
+
+        // Read the next entry which passes the filters.
+        bool Next(Entry& entry);
+
+        // Read up to count entries, returning a NULL list once
+        // the walk is complete.
+        TiListRef NextBatch(size_t count);
+
+        bool HasNext();
+        void Close();
+
+        static TiObjectRef CreateEntryObject(const Entry& entry);
+
+    private:
+        struct Level
+        {
+            std::string path;
+            int depth;
+#ifdef OS_WIN32
+            HANDLE handle;
+            WIN32_FIND_DATAW data;
+            bool hasData;
+#else
+            DIR* dir;
+#endif
+        };
+
+        bool Push(const std::string& path, int depth);
+        bool ReadEntry(Entry& entry, int& depth);
+        bool Matches(const Entry& entry);
+
+        void _Next(const ValueList& args, ValueRef result);
+        void _HasNext(const ValueList& args, ValueRef result);
+        void _ReadAll(const ValueList& args, ValueRef result);
+        void _Close(const ValueList& args, ValueRef result);
+
+        Options options;
+        std::vector<Level> stack;
+        Entry pending;
+        bool hasPending;
+    };
+
+    /**
+     * Walks a directory on a background thread and delivers each batch
+     * of entries to a callback on the main thread.
+     */
+    class DirectoryListingJob : public AsyncJob
+    {
+    public:
+        DirectoryListingJob(const std::string& root,
+            const DirectoryWalker::Options& options, TiMethodRef callback);
+
+    protected:
+        virtual ValueRef Execute();
+
+    private:
+        std::string root;
+        DirectoryWalker::Options options;
+        TiMethodRef callback;
+    };
+}
+
+#endif
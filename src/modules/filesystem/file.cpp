@@ -13,6 +13,7 @@ using namespace TideUtils;
 
 #include "file.h"
 #include "filesystem_utils.h"
+#include "directory_walker.h"
 
 #include <Poco/File.h>
 #include <Poco/Path.h>
@@ -72,6 +73,9 @@ namespace ti
         this->SetMethod("deleteDirectory", &File::DeleteDirectory);
         this->SetMethod("deleteFile", &File::DeleteFile);
         this->SetMethod("getDirectoryListing", &File::GetDirectoryListing);
+        this->SetMethod("getDirectoryIterator", &File::GetDirectoryIterator);
+        this->SetMethod("getDirectoryListingAsync", &File::GetDirectoryListingAsync);
+        this->SetMethod("walk", &File::Walk);
         this->SetMethod("parent", &File::GetParent);
         this->SetMethod("exists", &File::GetExists);
         this->SetMethod("createTimestamp", &File::GetCreateTimestamp);
@@ -460,6 +464,38 @@ namespace ti
         }
     }
 
+    void File::GetDirectoryIterator(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("getDirectoryIterator", "?o");
+
+        DirectoryWalker::Options options;
+        options.Read(args.GetObject(0));
+        result->SetObject(new DirectoryWalker(this->filename, options));
+    }
+
+    void File::Walk(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("walk", "?o");
+
+        DirectoryWalker::Options options;
+        options.recursive = true;
+        options.Read(args.GetObject(0));
+        result->SetObject(new DirectoryWalker(this->filename, options));
+    }
+
+    void File::GetDirectoryListingAsync(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("getDirectoryListingAsync", "m ?o");
+
+        DirectoryWalker::Options options;
+        options.Read(args.GetObject(1));
+
+        AutoPtr<AsyncJob> job = new DirectoryListingJob(
+            this->filename, options, args.GetMethod(0));
+        job->RunAsynchronously();
+        result->SetObject(job);
+    }
+
     void File::GetParent(const ValueList& args, ValueRef result)
     {
         try
@@ -762,7 +798,11 @@ namespace ti
             {
                 throw ValueException::FromString("destination must be a directory");
             }
-            FileUtils::Unzip(from_s,to_s);
+            if (!FileUtils::Unzip(from_s,to_s))
+            {
+                throw ValueException::FromFormat("Could not unzip %s to %s",
+                    from_s.c_str(), to_s.c_str());
+            }
             result->SetBool(true);
         }
         catch (Poco::FileNotFoundException&)
@@ -60,6 +60,9 @@ namespace ti
         void DeleteFile(const ValueList& args, ValueRef result);
         void Equals(const ValueList& args, ValueRef result);
         void GetDirectoryListing(const ValueList& args, ValueRef result);
+        void GetDirectoryIterator(const ValueList& args, ValueRef result);
+        void GetDirectoryListingAsync(const ValueList& args, ValueRef result);
+        void Walk(const ValueList& args, ValueRef result);
         void GetParent(const ValueList& args, ValueRef result);
         void GetExists(const ValueList& args, ValueRef result);
         void GetCreateTimestamp(const ValueList& args, ValueRef result);
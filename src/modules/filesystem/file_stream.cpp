@@ -12,12 +12,110 @@
 #include <sstream>
 #include <sys/stat.h>
 
+#ifndef OS_WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include <Poco/File.h>
 #include <Poco/LineEndingConverter.h>
 
 namespace ti {
+
+static const size_t READ_BUFFER_SIZE = 64 * 1024;
+static const size_t WRITE_BUFFER_SIZE = 64 * 1024;
+
+#ifndef OS_WIN32
+class MappedBytes : public Bytes {
+public:
+    MappedBytes(char* address, size_t length) :
+        Bytes("Bytes", address, length),
+        address(address),
+        length(length)
+    {
+    }
+
+    virtual ~MappedBytes()
+    {
+        munmap(this->address, this->length);
+    }
+
+    // Mapped pages are backed by the file and can be dropped by the
+    // kernel until they are written, so they do not count as heap memory.
+    virtual size_t ExtraMemoryCost() { return 0; }
+
+private:
+    char* address;
+    size_t length;
+};
+#endif
+
+static BytesRef SliceBytes(BytesRef source, size_t offset, size_t length)
+{
+    // Avoid holding a reference to the source for an empty result.
+    if (length == 0)
+        return new Bytes();
+
+    return new Bytes(source, offset, length);
+}
+
+static BytesRef SliceLine(BytesRef source, size_t offset, size_t length)
+{
+#ifdef OS_WIN32
+    if (length > 0 && source->Pointer()[offset + length - 1] == '\r')
+        length--;
+#endif
+    return SliceBytes(source, offset, length);
+}
+
+static bool GetWriteData(const ValueList& args, std::string& storage,
+    const char*& data, size_t& size)
+{
+    data = NULL;
+    size = 0;
+
+    if (args.at(0)->IsObject())
+    {
+        TiObjectRef b = args.at(0)->ToObject();
+        AutoPtr<Bytes> bytes = b.cast<Bytes>();
+        if (!bytes.isNull())
+        {
+            data = bytes->Pointer();
+            size = bytes->Length();
+        }
+    }
+    else if (args.at(0)->IsString())
+    {
+        data = args.at(0)->ToString();
+        size = strlen(data);
+    }
+    else if (args.at(0)->IsInt() || args.at(0)->IsDouble())
+    {
+        std::stringstream ostr;
+        if (args.at(0)->IsInt())
+            ostr << args.at(0)->ToInt();
+        else
+            ostr << args.at(0)->ToDouble();
+
+        storage = ostr.str();
+        data = storage.c_str();
+        size = storage.length();
+    }
+    else
+    {
+        throw ValueException::FromString("Could not write with type passed");
+    }
+
+    return data != NULL && size > 0;
+}
+
 FileStream::FileStream(std::string filename) :
     Stream("Filesystem.FileStream"),
-    istream(0), ostream(0), stream(0)
+    istream(0), ostream(0), stream(0),
+    mappingOffset(0),
+    readPosition(0), readLimit(0), readEOF(false)
 {
 #ifdef OS_OSX
     // in OSX, we need to expand ~ in paths to their absolute path value
@@ -35,6 +133,8 @@ FileStream::FileStream(std::string filename) :
     this->SetMethod("tell", &FileStream::_Tell);
     this->SetMethod("write", &FileStream::_Write);
     this->SetMethod("read", &FileStream::_Read);
+    this->SetMethod("readAll", &FileStream::_ReadAll);
+    this->SetMethod("flush", &FileStream::_Flush);
 
     this->SetMethod("readLine", &FileStream::_ReadLine);
     this->SetMethod("writeLine", &FileStream::_WriteLine);
@@ -45,6 +145,7 @@ FileStream::FileStream(std::string filename) :
     this->Set("MODE_READ", Value::NewInt(MODE_READ));
     this->Set("MODE_APPEND", Value::NewInt(MODE_APPEND));
     this->Set("MODE_WRITE", Value::NewInt(MODE_WRITE));
+    this->Set("MODE_MAPPED", Value::NewInt(MODE_MAPPED));
 }
 
 FileStream::~FileStream()
@@ -57,6 +158,12 @@ bool FileStream::Open(FileStreamMode mode, bool binary, bool append)
     // close the prev stream if needed
     this->Close();
 
+    if (mode == MODE_MAPPED)
+    {
+        this->OpenMapped();
+        return true;
+    }
+
     try
     {
         std::ios::openmode flags = (std::ios::openmode) 0;
@@ -86,6 +193,7 @@ bool FileStream::Open(FileStreamMode mode, bool binary, bool append)
         {
             this->ostream = new Poco::FileOutputStream(this->filename,flags);
             this->stream = this->ostream;
+            this->writeBuffer.reserve(WRITE_BUFFER_SIZE);
 #ifndef OS_WIN32
             chmod(this->filename.c_str(),S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
 #endif      
@@ -106,19 +214,80 @@ bool FileStream::Open(FileStreamMode mode, bool binary, bool append)
     }
 }
 
+void FileStream::OpenMapped()
+{
+#ifndef OS_WIN32
+    int fd = open(this->filename.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        throw ValueException::FromFormat("Could not open %s: %s",
+            this->filename.c_str(), strerror(errno));
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == -1)
+    {
+        int error = errno;
+        close(fd);
+        throw ValueException::FromFormat("Could not stat %s: %s",
+            this->filename.c_str(), strerror(error));
+    }
+
+    size_t length = info.st_size;
+    if (length == 0)
+    {
+        // Empty files cannot be mapped.
+        close(fd);
+        this->mapping = new Bytes();
+        this->mappingOffset = 0;
+        return;
+    }
+
+    // Slices of the mapping are handed to scripts, which may write to
+    // them, so map the file copy-on-write rather than read-only.
+    void* address = mmap(0, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    int error = errno;
+    close(fd);
+
+    if (address == MAP_FAILED)
+    {
+        throw ValueException::FromFormat("Could not map %s: %s",
+            this->filename.c_str(), strerror(error));
+    }
+
+    madvise(address, length, MADV_SEQUENTIAL);
+    this->mapping = new MappedBytes(static_cast<char*>(address), length);
+    this->mappingOffset = 0;
+#else
+    // No mapping support here yet, so read the whole file with a single
+    // allocation. Reads are still served as slices of that buffer.
+    this->Open(MODE_READ, true);
+    BytesRef contents(this->ReadAll());
+    this->Close();
+    this->mapping = contents;
+    this->mappingOffset = 0;
+#endif
+}
+
 bool FileStream::IsOpen() const
 {
-    return this->stream != NULL;
+    return this->stream != NULL || !this->mapping.isNull();
 }
 
 void FileStream::Close()
 {
+    this->mapping = NULL;
+    this->mappingOffset = 0;
+    this->DiscardReadBuffer();
+    this->readEOF = false;
+
     try
     {
         if (this->stream)
         {
             if (this->ostream)
             {
+                this->FlushWriteBuffer();
                 this->ostream->flush();
             }
 
@@ -139,20 +308,49 @@ void FileStream::Close()
 
 void FileStream::Seek(int offset, int direction)
 {
-    if (this->istream)
+    if (!this->mapping.isNull())
+    {
+        long position = offset;
+        if (direction == std::ios::cur)
+            position += this->mappingOffset;
+        else if (direction == std::ios::end)
+            position += this->mapping->Length();
+
+        if (position < 0)
+            position = 0;
+        if (position > (long) this->mapping->Length())
+            position = this->mapping->Length();
+
+        this->mappingOffset = position;
+    }
+    else if (this->istream)
+    {
+        // Buffered input has already been consumed from the file.
+        if (direction == std::ios::cur)
+            offset -= this->BufferedInput();
+
+        this->DiscardReadBuffer();
+        this->readEOF = false;
+        this->istream->clear();
         this->istream->seekg(offset, (std::ios::seekdir)direction);
+    }
     else if (this->ostream)
+    {
+        this->FlushWriteBuffer();
         this->ostream->seekp(offset, (std::ios::seekdir)direction);
+    }
     else
         throw ValueException::FromString("FileStream must be opened before seeking");
 }
 
 int FileStream::Tell()
 {
-    if (this->istream)
-        return this->istream->tellg();
+    if (!this->mapping.isNull())
+        return this->mappingOffset;
+    else if (this->istream)
+        return (int) this->istream->tellg() - (int) this->BufferedInput();
     else if (this->ostream)
-        return this->ostream->tellp();
+        return (int) this->ostream->tellp() + (int) this->writeBuffer.size();
 
     throw ValueException::FromString("FileStream must be opend before using tell");
 }
@@ -162,6 +360,20 @@ void FileStream::Write(const char* buffer, size_t size)
     if(!this->ostream)
         throw ValueException::FromString("FileStream must be opened for writing before calling write");
 
+    if (this->writeBuffer.size() + size <= WRITE_BUFFER_SIZE)
+    {
+        this->writeBuffer.insert(this->writeBuffer.end(), buffer, buffer + size);
+        return;
+    }
+
+    this->FlushWriteBuffer();
+    if (size < WRITE_BUFFER_SIZE)
+    {
+        this->writeBuffer.insert(this->writeBuffer.end(), buffer, buffer + size);
+        return;
+    }
+
+    // Large writes skip the buffer entirely.
     try {
         this->ostream->write(buffer, size);
     }
@@ -172,19 +384,127 @@ void FileStream::Write(const char* buffer, size_t size)
     }
 }
 
+void FileStream::FlushWriteBuffer()
+{
+    if (!this->ostream || this->writeBuffer.empty())
+        return;
+
+    try {
+        this->ostream->write(&(this->writeBuffer[0]), this->writeBuffer.size());
+        this->writeBuffer.clear();
+    }
+    catch (Poco::Exception& ex) {
+        this->writeBuffer.clear();
+        Logger* logger = Logger::Get("Filesystem.FileStream");
+        logger->Error("Error in write. Exception: %s",ex.displayText().c_str());
+        throw ValueException::FromString(ex.displayText());
+    }
+}
+
+void FileStream::Flush()
+{
+    if(!this->ostream)
+        throw ValueException::FromString("FileStream must be opened for writing before calling flush");
+
+    this->FlushWriteBuffer();
+    this->ostream->flush();
+}
+
 bool FileStream::IsWritable() const
 {
     return this->ostream != NULL;
 }
 
+size_t FileStream::BufferedInput() const
+{
+    return this->readLimit - this->readPosition;
+}
+
+void FileStream::DiscardReadBuffer()
+{
+    this->readBuffer = NULL;
+    this->readPosition = 0;
+    this->readLimit = 0;
+}
+
+bool FileStream::FillReadBuffer()
+{
+    if (this->readEOF || !this->istream)
+        return false;
+
+    // Allocate a fresh chunk, since slices of the current one may still
+    // be referenced. Unconsumed input moves to the front of the new chunk
+    // and the chunk grows when a single line does not fit.
+    size_t pending = this->BufferedInput();
+    size_t capacity = READ_BUFFER_SIZE;
+    if (pending * 2 > capacity)
+        capacity = pending * 2;
+
+    BytesRef chunk = new Bytes(capacity);
+    if (pending > 0)
+        chunk->Write(this->readBuffer->Pointer() + this->readPosition, pending);
+
+    try
+    {
+        this->istream->read(chunk->Pointer() + pending, capacity - pending);
+    }
+    catch (Poco::Exception& exc)
+    {
+        Logger* logger = Logger::Get("Filesystem.FileStream");
+        logger->Error("Error in read. Exception: %s",exc.displayText().c_str());
+        throw ValueException::FromString(exc.displayText());
+    }
+
+    size_t count = this->istream->gcount();
+    if (count < capacity - pending)
+    {
+        // Hit the end of the file. Clear the stream state so
+        // that tell and seek keep working on this stream.
+        this->readEOF = true;
+        this->istream->clear();
+    }
+
+    this->readBuffer = chunk;
+    this->readPosition = 0;
+    this->readLimit = pending + count;
+    return count > 0;
+}
+
 size_t FileStream::Read(const char* buffer, size_t size)
 {
+    if (!this->mapping.isNull())
+    {
+        size_t available = this->mapping->Length() - this->mappingOffset;
+        size_t count = size < available ? size : available;
+        memcpy((char*) buffer, this->mapping->Pointer() + this->mappingOffset, count);
+        this->mappingOffset += count;
+        return count;
+    }
+
     if(!this->istream)
-        throw ValueException::FromString("FileStream must be opened for writing before calling write");
+        throw ValueException::FromString("FileStream must be opened for reading before calling read");
+
+    size_t count = 0;
+    size_t buffered = this->BufferedInput();
+    if (buffered > 0)
+    {
+        count = size < buffered ? size : buffered;
+        memcpy((char*) buffer, this->readBuffer->Pointer() + this->readPosition, count);
+        this->readPosition += count;
+    }
+
+    if (count == size || this->readEOF)
+        return count;
 
     try {
-        this->istream->read((char*)buffer, size);
-        return this->istream->gcount();
+        this->istream->read((char*)buffer + count, size - count);
+        size_t read = this->istream->gcount();
+        if (read < size - count)
+        {
+            this->readEOF = true;
+            this->istream->clear();
+        }
+        return count + read;
     }
     catch (Poco::Exception& ex) {
         Logger* logger = Logger::Get("Filesystem.FileStream");
@@ -193,9 +513,127 @@ size_t FileStream::Read(const char* buffer, size_t size)
     }
 }
 
+BytesRef FileStream::ReadAll()
+{
+    if (!this->mapping.isNull())
+    {
+        size_t offset = this->mappingOffset;
+        this->mappingOffset = this->mapping->Length();
+        return SliceBytes(this->mapping, offset, this->mappingOffset - offset);
+    }
+
+    if(!this->istream)
+        throw ValueException::FromString("FileStream must be opened for reading before calling read");
+
+    // Size the result from what is left in the file, so that in the
+    // common case the whole read is a single allocation and copy.
+    size_t expected = 0;
+    int position = this->Tell();
+    try
+    {
+        Poco::File::FileSize fileSize = Poco::File(this->filename).getSize();
+        if (position >= 0 && (Poco::File::FileSize) position < fileSize)
+            expected = fileSize - position;
+    }
+    catch (Poco::Exception&)
+    {
+    }
+
+    std::vector<BytesRef> chunks;
+    size_t total = 0;
+    size_t chunkSize = expected > 0 ? expected : READ_BUFFER_SIZE;
+    while (true)
+    {
+        BytesRef chunk = new Bytes(chunkSize);
+        size_t count = this->Read(chunk->Pointer(), chunkSize);
+        if (count > 0)
+        {
+            chunks.push_back(count < chunkSize ? SliceBytes(chunk, 0, count) : chunk);
+            total += count;
+        }
+
+        if (count < chunkSize)
+            break;
+
+        // The file was exactly the size we expected, so check for the end
+        // before allocating another chunk.
+        if (this->BufferedInput() == 0 &&
+            this->istream->peek() == std::char_traits<char>::eof())
+        {
+            this->readEOF = true;
+            this->istream->clear();
+            break;
+        }
+
+        // The file grew or we could not size it, so continue in chunks.
+        chunkSize = READ_BUFFER_SIZE;
+    }
+
+    if (chunks.empty())
+        return new Bytes();
+    if (chunks.size() == 1)
+        return chunks[0];
+    return Bytes::Concat(chunks);
+}
+
+BytesRef FileStream::ReadLine()
+{
+    if (!this->mapping.isNull())
+    {
+        size_t length = this->mapping->Length();
+        size_t offset = this->mappingOffset;
+        if (offset >= length)
+            return NULL;
+
+        const char* start = this->mapping->Pointer() + offset;
+        const char* newline = (const char*) memchr(start, '\n', length - offset);
+        size_t lineLength = newline ? newline - start : length - offset;
+        this->mappingOffset = offset + lineLength + (newline ? 1 : 0);
+        return SliceLine(this->mapping, offset, lineLength);
+    }
+
+    if (!this->istream)
+    {
+        Logger* logger = Logger::Get("Filesystem.FileStream");
+        logger->Error("Error in readLine. FileInputStream is null");
+        throw ValueException::FromString("FileStream must be opened for reading before calling readLine");
+    }
+
+    size_t scanned = 0;
+    while (true)
+    {
+        size_t available = this->BufferedInput();
+        if (available > scanned)
+        {
+            const char* start = this->readBuffer->Pointer() + this->readPosition;
+            const char* newline = (const char*) memchr(start + scanned, '\n', available - scanned);
+            if (newline)
+            {
+                size_t offset = this->readPosition;
+                size_t lineLength = newline - start;
+                this->readPosition += lineLength + 1;
+                return SliceLine(this->readBuffer, offset, lineLength);
+            }
+        }
+
+        scanned = available;
+        if (!this->FillReadBuffer())
+            break;
+    }
+
+    // The last line of the file may not end with a newline.
+    size_t remaining = this->BufferedInput();
+    if (remaining == 0)
+        return NULL;
+
+    size_t offset = this->readPosition;
+    this->readPosition = this->readLimit;
+    return SliceLine(this->readBuffer, offset, remaining);
+}
+
 bool FileStream::IsReadable() const
 {
-    return this->istream != NULL;
+    return this->istream != NULL || !this->mapping.isNull();
 }
 
 void FileStream::_Open(const ValueList& args, ValueRef result)
@@ -238,53 +676,16 @@ void FileStream::_Write(const ValueList& args, ValueRef result)
 {
     args.VerifyException("write", "s|o|n");
 
-    char *text = NULL;
-    int size = 0;
-    if (args.at(0)->IsObject())
-    {
-        TiObjectRef b = args.at(0)->ToObject();
-        AutoPtr<Bytes> bytes = b.cast<Bytes>();
-        if (!bytes.isNull())
-        {
-            text = (char*)bytes->Pointer();
-            size = (int)bytes->Length();
-        }
-    }
-    else if (args.at(0)->IsString())
-    {
-        text = (char*)args.at(0)->ToString();
-    }
-    else if (args.at(0)->IsInt())
-    {
-        std::stringstream ostr;
-        ostr << args.at(0)->ToInt();
-        text = (char*)ostr.str().c_str();
-        size = ostr.str().length();
-    }
-    else if (args.at(0)->IsDouble())
-    {
-        std::stringstream ostr;
-        ostr << args.at(0)->ToDouble();
-        text = (char*)ostr.str().c_str();
-        size = ostr.str().length();
-    }
-    else
-    {
-        throw ValueException::FromString("Could not write with type passed");
-    }
-
-    if (size==0)
-    {
-        size = strlen(text);
-    }
-
-    if (text == NULL || size <= 0)
+    std::string storage;
+    const char* data;
+    size_t size;
+    if (!GetWriteData(args, storage, data, size))
     {
         result->SetBool(false);
         return;
     }
 
-    Write(text,size);
+    Write(data, size);
     result->SetBool(true);
 }
 
@@ -292,113 +693,59 @@ void FileStream::_Read(const ValueList& args, ValueRef result)
 {
     args.VerifyException("read", "?i");
 
-    try
+    if (args.size() < 1)
     {
-        if (args.size() >= 1)
-        {
-            int size = args.GetInt(0);
-            if (size <= 0)
-                throw ValueException::FromString("File.read() size must be greater than zero");
+        // If no read size is provided, read the rest of the file.
+        result->SetObject(this->ReadAll());
+        return;
+    }
 
-            BytesRef buffer = new Bytes(size + 1);
-            int readCount = this->Read(buffer->Pointer(), size);
+    int size = args.GetInt(0);
+    if (size <= 0)
+        throw ValueException::FromString("File.read() size must be greater than zero");
 
-            if (readCount > 0)
-            {
-                buffer->Write("\0", 1, readCount);
-                result->SetObject(buffer);
-            }
-            else
-            {
-                // No data read, must be at EOF
-                result->SetNull();
-            }
-        }
+    if (!this->mapping.isNull())
+    {
+        size_t offset = this->mappingOffset;
+        size_t available = this->mapping->Length() - offset;
+        size_t count = (size_t) size < available ? size : available;
+        this->mappingOffset += count;
+
+        if (count > 0)
+            result->SetObject(SliceBytes(this->mapping, offset, count));
         else
-        {
-            // If no read size is provided, read the entire file.
-            // TODO: this is not a very efficent method and should be deprecated
-            // and replaced by buffered stream transports
-            std::vector<char> buffer;
-            char data[4096];
+            result->SetNull(); // No data read, must be at EOF
+        return;
+    }
 
-            while (!this->istream->eof())
-            {
-                this->istream->read((char*)&data, 4095);
-                int length = this->istream->gcount();
-                if (length > 0)
-                {
-                    buffer.insert(buffer.end(), data, data+length);
-                }
-                else break;
-            }
+    // Keep the data NUL-terminated for callers which treat it as a string.
+    BytesRef buffer = new Bytes(size + 1);
+    size_t readCount = this->Read(buffer->Pointer(), size);
 
-            result->SetObject(new Bytes(&(buffer[0]), buffer.size()));
-        }
+    if (readCount > 0)
+    {
+        buffer->Write("\0", 1, readCount);
+        result->SetObject(SliceBytes(buffer, 0, readCount));
     }
-    catch (Poco::Exception& exc)
+    else
     {
-        Logger* logger = Logger::Get("Filesystem.FileStream");
-        logger->Error("Error in read. Exception: %s",exc.displayText().c_str());
-        throw ValueException::FromString(exc.displayText());
+        // No data read, must be at EOF
+        result->SetNull();
     }
 }
 
-void FileStream::_ReadLine(const ValueList& args, ValueRef result)
+void FileStream::_ReadAll(const ValueList& args, ValueRef result)
 {
-    try
-    {
-        if (!this->istream)
-        {
-            Logger* logger = Logger::Get("Filesystem.FileStream");
-            logger->Error("Error in readLine. FileInputStream is null");
-            throw ValueException::FromString("FileStream must be opened for reading before calling readLine");
-        }
+    result->SetObject(this->ReadAll());
+}
 
-        if (this->istream->eof())
-        {
-            // close the file
-            result->SetNull();
-        }
-        else
-        {
-            std::string line;
-            std::getline(*this->istream, line);
-#ifdef OS_WIN32
-            // In some cases std::getline leaves a CR on the end of the line in win32 -- why God, why?
-            if (!line.empty())
-            {
-                char lastChar = line.at(line.size()-1);
-                if (lastChar == '\r') {
-                    line = line.substr(0, line.size()-1);
-                }
-            }
-#endif
-            if (line.empty() || line.size()==0)
-            {
-                if (this->istream->eof())
-                {
-                    // if this is EOF, return null
-                    result->SetNull();
-                }
-                else
-                {
-                    // this is an empty line, just empty Bytes object.
-                    result->SetObject(new Bytes());
-                }
-            }
-            else
-            {
-                result->SetObject(new Bytes(line));
-            }
-        }
-    }
-    catch (Poco::Exception& exc)
-    {
-        Logger* logger = Logger::Get("Filesystem.FileStream");
-        logger->Error("Error in readLine. Exception: %s",exc.displayText().c_str());
-        throw ValueException::FromString(exc.displayText());
-    }
+void FileStream::_ReadLine(const ValueList& args, ValueRef result)
+{
+    BytesRef line(this->ReadLine());
+    if (line.isNull())
+        result->SetNull();
+    else
+        result->SetObject(line);
 }
 
 void FileStream::_WriteLine(const ValueList& args, ValueRef result)
@@ -407,71 +754,47 @@ void FileStream::_WriteLine(const ValueList& args, ValueRef result)
 
     if(! this->stream)
     {
-        throw ValueException::FromString("FileStream must be opened before calling readLine");
-    }
-
-    char *text = NULL;
-    int size = 0;
-    if (args.at(0)->IsObject())
-    {
-        TiObjectRef b = args.at(0)->ToObject();
-        AutoPtr<Bytes> bytes = b.cast<Bytes>();
-        if (!bytes.isNull())
-        {
-            text = (char*)bytes->Pointer();
-            size = (int)bytes->Length();
-        }
-    }
-    else if (args.at(0)->IsString())
-    {
-        text = (char*)args.at(0)->ToString();
-    }
-    else if (args.at(0)->IsInt())
-    {
-        std::stringstream ostr;
-        ostr << args.at(0)->ToInt();
-        text = (char*)ostr.str().c_str();
-        size = ostr.str().length();
-    }
-    else if (args.at(0)->IsDouble())
-    {
-        std::stringstream ostr;
-        ostr << args.at(0)->ToDouble();
-        text = (char*)ostr.str().c_str();
-        size = ostr.str().length();
-    }
-    else
-    {
-        throw ValueException::FromString("Could not write with type passed");
-    }
-
-    if (size==0)
-    {
-        size = strlen(text);
+        throw ValueException::FromString("FileStream must be opened before calling writeLine");
     }
 
-    if (text == NULL || size <= 0)
+    std::string storage;
+    const char* data;
+    size_t size;
+    if (!GetWriteData(args, storage, data, size))
     {
         result->SetBool(false);
         return;
     }
 
-    std::string astr = text;
+    Write(data, size);
 #ifdef OS_WIN32
-    astr += "\r\n";
+    Write("\r\n", 2);
 #else
-    astr += "\n";
+    Write("\n", 1);
 #endif
-    Write((char*)astr.c_str(),astr.length());
     result->SetBool(true);
 }
 
+void FileStream::_Flush(const ValueList& args, ValueRef result)
+{
+    this->Flush();
+}
+
 void FileStream::_Ready(const ValueList& args, ValueRef result)
 {
-    if(!this->stream)
+    if (!this->mapping.isNull())
+    {
+        result->SetBool(this->mappingOffset < this->mapping->Length());
+    }
+    else if(!this->stream)
     {
         result->SetBool(false);
     }
+    else if (this->istream)
+    {
+        result->SetBool(this->BufferedInput() > 0 ||
+            (!this->readEOF && this->stream->eof()==false));
+    }
     else
     {
         result->SetBool(this->stream->eof()==false);
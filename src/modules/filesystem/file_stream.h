@@ -14,6 +14,7 @@
 #endif
 
 #include <string>
+#include <vector>
 
 #include <tide/tide.h>
 #include <Poco/FileStream.h>
@@ -25,7 +26,8 @@ public:
     enum FileStreamMode {
         MODE_READ = 1,
         MODE_APPEND = 2,
-        MODE_WRITE = 3
+        MODE_WRITE = 3,
+        MODE_MAPPED = 4
     };
 
     FileStream(std::string filename);
@@ -43,6 +45,10 @@ public:
     virtual size_t Read(const char* buffer, size_t size);
     virtual bool IsReadable() const;
 
+    BytesRef ReadAll();
+    BytesRef ReadLine();
+    void Flush();
+
     // TODO: make this private once removed from File.
     void _Open(const ValueList& args, ValueRef result);
 
@@ -57,12 +63,38 @@ private:
     void _ReadLine(const ValueList& args, ValueRef result);
     void _WriteLine(const ValueList& args, ValueRef result);
     void _Ready(const ValueList& args, ValueRef result);
+    void _ReadAll(const ValueList& args, ValueRef result);
+    void _Flush(const ValueList& args, ValueRef result);
+
+    void OpenMapped();
+    bool FillReadBuffer();
+    void DiscardReadBuffer();
+    size_t BufferedInput() const;
+    void FlushWriteBuffer();
 
     std::string filename;
 
     Poco::FileInputStream* istream;
     Poco::FileOutputStream* ostream;
     Poco::FileIOS* stream;
+
+    // Private, copy-on-write mapping of the file when opened with MODE_MAPPED,
+    // so writes to it never reach the file.
+    // Reads from a mapped stream return slices of this object.
+    BytesRef mapping;
+    size_t mappingOffset;
+
+    // Input is read in large chunks and lines are returned as slices
+    // of the current chunk. A chunk is never reused once it has been
+    // handed out, so slices stay valid after the stream moves on.
+    BytesRef readBuffer;
+    size_t readPosition;
+    size_t readLimit;
+    bool readEOF;
+
+    // Output is coalesced here until the buffer fills, the stream is
+    // flushed explicitly or the stream is closed.
+    std::vector<char> writeBuffer;
 };
 
 }
@@ -65,6 +65,7 @@ namespace ti
         this->SetInt("MODE_READ", FileStream::MODE_READ);
         this->SetInt("MODE_WRITE", FileStream::MODE_WRITE);
         this->SetInt("MODE_APPEND", FileStream::MODE_APPEND);
+        this->SetInt("MODE_MAPPED", FileStream::MODE_MAPPED);
         this->SetInt("SEEK_START", std::ios::beg);
         this->SetInt("SEEK_CURRENT", std::ios::cur);
         this->SetInt("SEEK_END", std::ios::end);
@@ -307,9 +308,9 @@ namespace ti
 
     void FilesystemBinding::ExecuteAsyncCopy(const ValueList& args, ValueRef result)
     {
-        if (args.size()!=3)
+        if (args.size() < 3 || args.size() > 4)
         {
-            throw ValueException::FromString("invalid arguments - this method takes 3 arguments");
+            throw ValueException::FromString("invalid arguments - this method takes 3 or 4 arguments");
         }
         std::vector<std::string> files;
         if (args.at(0)->IsString())
@@ -331,7 +332,8 @@ namespace ti
         ValueRef v = args.at(1);
         std::string destination(FilesystemUtils::FilenameFromValue(v));
         TiMethodRef method = args.at(2)->ToMethod();
-        TiObjectRef copier = new ti::AsyncCopy(this,host,files,destination,method);
+        TiObjectRef options = args.GetObject(3);
+        TiObjectRef copier = new ti::AsyncCopy(this,host,files,destination,method,options);
         result->SetObject(copier);
         asyncOperations.push_back(copier);
         // we need to create a timer thread that can cleanup operations
@@ -14,6 +14,7 @@ using namespace TideUtils;
 #include <sstream>
 #include <functional>
 #include <Poco/Path.h>
+#include <Poco/Timestamp.h>
 using std::vector;
 using std::string;
 
@@ -22,10 +23,30 @@ namespace ti
     MonkeyBinding::MonkeyBinding(Host *host, TiObjectRef global) :
         StaticBoundObject("Monkey"),
         global(global),
-        logger(Logger::Get("Monkey"))
+        logger(Logger::Get("Monkey")),
+        pages(0),
+        injected(0),
+        matchTime(0),
+        injectTime(0),
+        lastMatchTime(0),
+        lastInjectTime(0)
     {
         this->callback = StaticBoundMethod::FromMethod(this, &MonkeyBinding::Callback);
 
+        /**
+         * @tiapi(method=True,name=Monkey.getStats,since=1.4)
+         * @tiapi Return the number of pages userscripts were matched against
+         * @tiapi and scripts injected, and the time in milliseconds spent
+         * @tiapi matching and injecting them, in total and for the last page.
+         * @tiresult(for=Monkey.getStats,type=Object) an object with pages,
+         * @tiresult injected, matchTime, injectTime, lastMatchTime and
+         * @tiresult lastInjectTime properties
+         */
+        this->SetMethod("getStats", &MonkeyBinding::GetStats);
+
+        // Tests the matcher against a URL without loading any userscripts.
+        this->SetMethod("_matches", &MonkeyBinding::_Matches);
+
         std::string resourcesPath = host->GetApplication()->GetResourcesPath();
         std::string userscriptsPath = FileUtils::Join(
             resourcesPath.c_str(), "userscripts", NULL);
@@ -49,6 +70,9 @@ namespace ti
 
             if (!scripts.empty())
             {
+                logger->Debug("Loaded %lu userscripts with %lu patterns",
+                    (unsigned long) scripts.size(),
+                    (unsigned long) matcher.GetPatternCount());
                 GlobalObject::GetInstance()->AddEventListener(Event::PAGE_LOADED, callback);
             }
             
@@ -112,8 +136,16 @@ namespace ti
 
         if (script && inScript)
         {
+            // The source is only wrapped in a Value once, so each page
+            // load does not copy it again.
             scriptSource << "\n})();";
-            script->source = scriptSource.str();
+            script->source = Value::NewString(scriptSource.str());
+
+            size_t index = scripts.size();
+            for (size_t i = 0; i < script->includes.size(); i++)
+                matcher.AddInclude(index, script->includes[i]);
+            for (size_t i = 0; i < script->excludes.size(); i++)
+                matcher.AddExclude(index, script->excludes[i]);
             scripts.push_back(script);
         }
     }
@@ -131,20 +163,66 @@ namespace ti
 
         std::string url = event->GetString("url");
         TiObjectRef windowObject = event->GetObject("scope")->GetObject("window");
-        vector<Script*>::iterator iter = scripts.begin();
-        while (iter != scripts.end())
+
+        Poco::Timestamp matchStart;
+        vector<size_t> matches;
+        matcher.Match(url, matches);
+        double matchElapsed = matchStart.elapsed() / 1000.0;
+
+        Poco::Timestamp injectStart;
+        for (size_t i = 0; i < matches.size(); i++)
         {
-            Script* script = (*iter++);
-            if (script->Matches(url))
-            {
-                EvaluateUserScript(event, url, windowObject, script->source);
-            }
+            EvaluateUserScript(event, url, windowObject, scripts[matches[i]]->source);
         }
+        double injectElapsed = injectStart.elapsed() / 1000.0;
+
+        this->pages++;
+        this->injected += matches.size();
+        this->matchTime += matchElapsed;
+        this->injectTime += injectElapsed;
+        this->lastMatchTime = matchElapsed;
+        this->lastInjectTime = injectElapsed;
+
+        logger->Debug("Matched %lu of %lu userscripts for %s in %.3fms, "
+            "injected in %.3fms", (unsigned long) matches.size(),
+            (unsigned long) scripts.size(), url.c_str(), matchElapsed,
+            injectElapsed);
+    }
+
+    void MonkeyBinding::_Matches(const ValueList &args, ValueRef result)
+    {
+        args.VerifyException("_matches", "s l ?l");
+        std::string url(args.GetString(0));
+
+        UserScriptMatcher matcher;
+        TiListRef includes(args.GetList(1));
+        for (unsigned int i = 0; i < includes->Size(); i++)
+            matcher.AddInclude(0, includes->At(i)->ToString());
+
+        TiListRef excludes(args.GetList(2, new StaticBoundList()));
+        for (unsigned int i = 0; i < excludes->Size(); i++)
+            matcher.AddExclude(0, excludes->At(i)->ToString());
+
+        vector<size_t> matches;
+        matcher.Match(url, matches);
+        result->SetBool(!matches.empty());
+    }
+
+    void MonkeyBinding::GetStats(const ValueList &args, ValueRef result)
+    {
+        TiObjectRef stats(new StaticBoundObject());
+        stats->SetDouble("pages", this->pages);
+        stats->SetDouble("injected", this->injected);
+        stats->SetDouble("matchTime", this->matchTime);
+        stats->SetDouble("injectTime", this->injectTime);
+        stats->SetDouble("lastMatchTime", this->lastMatchTime);
+        stats->SetDouble("lastInjectTime", this->lastInjectTime);
+        result->SetObject(stats);
     }
 
     void MonkeyBinding::EvaluateUserScript(
         TiObjectRef event, std::string& url,
-        TiObjectRef windowObject, std::string& scriptSource)
+        TiObjectRef windowObject, ValueRef scriptSource)
     {
         static Logger *logger = Logger::Get("Monkey");
         // I got a castle in brooklyn, that's where i dwell
@@ -169,7 +247,7 @@ namespace ti
         logger->Info("Loading userscript for %s\n", url.c_str());
         try
         {
-            evalFunction->Call(Value::NewString(scriptSource));
+            evalFunction->Call(scriptSource);
         }
         catch (ValueException &ex)
         {
@@ -185,42 +263,4 @@ namespace ti
                 "(line %i): %s", url.c_str(), line, ss->c_str());
         }
     }
-
-    bool Script::Matches(const char* pattern, const char* target)
-    {
-        // exact match returns immediately
-        if (!strcmp(pattern, target))
-            return true;
-
-        switch (*pattern)
-        {
-            case '\0':
-                return *target == '\0';
-            case '*':
-                return Matches(pattern+1, target) 
-                    || (*target && Matches(pattern, target+1));
-            default:
-                return *pattern == *target &&
-                    Matches(pattern+1, target+1);
-        }
-    }
-
-    bool Script::Matches(vector<string>& patterns, string& url)
-    {
-        vector<string>::iterator iter = patterns.begin();
-        while (iter != patterns.end())
-        {
-            string& pattern = (*iter++);
-            if (Matches(pattern.c_str(), url.c_str()))
-            {
-                return true;
-            }
-        }
-        return false;
-    }
-
-    bool Script::Matches(string& url)
-    {
-        return !Matches(this->excludes, url) && Matches(this->includes, url);
-    }
 }
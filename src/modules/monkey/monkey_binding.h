@@ -11,6 +11,8 @@
 #include <tide/tide.h>
 #include <vector>
 
+#include "userscript_matcher.h"
+
 namespace ti
 {
     struct Script
@@ -18,10 +20,7 @@ namespace ti
         public:
         std::vector<std::string> includes;
         std::vector<std::string> excludes;
-        std::string source;
-        bool Matches(std::string& url);
-        static bool Matches(std::vector<std::string>&, std::string& url);
-        static bool Matches(const char* pattern, const char* target);
+        ValueRef source;
     };
 
     class MonkeyBinding : public tide::StaticBoundObject
@@ -33,13 +32,22 @@ namespace ti
         virtual ~MonkeyBinding();
         void ParseFile(string filePath);
         void Callback(const ValueList &args, ValueRef result);
+        void GetStats(const ValueList &args, ValueRef result);
+        void _Matches(const ValueList &args, ValueRef result);
         void EvaluateUserScript(
-            TiObjectRef, std::string&,TiObjectRef, std::string&);
+            TiObjectRef, std::string&,TiObjectRef, ValueRef);
 
         TiObjectRef global;
         Logger* logger;
         TiMethodRef callback;
         std::vector<Script*> scripts;
+        UserScriptMatcher matcher;
+        double pages;
+        double injected;
+        double matchTime;
+        double injectTime;
+        double lastMatchTime;
+        double lastInjectTime;
     };
 }
 
@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include "userscript_matcher.h"
+#include <tide/glob.h>
+
+#define INCLUDED 1
+#define EXCLUDED 2
+
+namespace ti
+{
+    UserScriptMatcher::Node::~Node()
+    {
+        std::map<char, Node*>::iterator i = this->children.begin();
+        while (i != this->children.end())
+            delete (i++)->second;
+    }
+
+    UserScriptMatcher::UserScriptMatcher() :
+        scriptCount(0),
+        patternCount(0)
+    {
+    }
+
+    UserScriptMatcher::~UserScriptMatcher()
+    {
+    }
+
+    void UserScriptMatcher::AddInclude(size_t script, const std::string& pattern)
+    {
+        this->Add(script, pattern, false);
+    }
+
+    void UserScriptMatcher::AddExclude(size_t script, const std::string& pattern)
+    {
+        this->Add(script, pattern, true);
+    }
+
+    void UserScriptMatcher::Add(size_t script, const std::string& pattern, bool exclude)
+    {
+        size_t wildcard = pattern.find('*');
+        if (wildcard == std::string::npos)
+            wildcard = pattern.size();
+
+        Node* node = &this->root;
+        for (size_t i = 0; i < wildcard; i++)
+        {
+            Node*& child = node->children[pattern[i]];
+            if (!child)
+                child = new Node();
+            node = child;
+        }
+
+        Pattern entry;
+        entry.script = script;
+        entry.exclude = exclude;
+        entry.rest = pattern.substr(wildcard);
+        node->patterns.push_back(entry);
+
+        if (script >= this->scriptCount)
+            this->scriptCount = script + 1;
+        this->patternCount++;
+    }
+
+    void UserScriptMatcher::Match(const std::string& url, std::vector<size_t>& scripts) const
+    {
+        std::vector<char> state(this->scriptCount, 0);
+        const Node* node = &this->root;
+        size_t depth = 0;
+        while (node)
+        {
+            const char* rest = url.c_str() + depth;
+            std::vector<Pattern>::const_iterator i = node->patterns.begin();
+            for (; i != node->patterns.end(); i++)
+            {
+                // Once a script is excluded none of its globs matter, and
+                // once it is included only its excludes still do.
+                char& scriptState = state[i->script];
+                if (scriptState & EXCLUDED || (!i->exclude && scriptState & INCLUDED))
+                    continue;
+
+                if (tide::MatchGlob(i->rest.c_str(), rest))
+                    scriptState |= i->exclude ? EXCLUDED : INCLUDED;
+            }
+
+            if (depth == url.size())
+                break;
+
+            std::map<char, Node*>::const_iterator child = node->children.find(url[depth++]);
+            node = child == node->children.end() ? 0 : child->second;
+        }
+
+        for (size_t i = 0; i < state.size(); i++)
+        {
+            if (state[i] == INCLUDED)
+                scripts.push_back(i);
+        }
+    }
+}
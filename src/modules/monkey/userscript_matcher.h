@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _USERSCRIPT_MATCHER_H_
+#define _USERSCRIPT_MATCHER_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ti
+{
+    /**
+     * Matches a URL against the @include and @exclude globs of every
+     * userscript at once. Each glob is filed in a trie under its literal
+     * prefix, the part before the first '*', so a page load only walks
+     * the URL once and only tests the remainder of the globs whose prefix
+     * it has, which is usually very few of them.
+     */
+    class UserScriptMatcher
+    {
+    public:
+        UserScriptMatcher();
+        ~UserScriptMatcher();
+
+        void AddInclude(size_t script, const std::string& pattern);
+        void AddExclude(size_t script, const std::string& pattern);
+
+        // Find the scripts with an include matching url and no exclude
+        // matching it. Indices are returned in the order they were added.
+        void Match(const std::string& url, std::vector<size_t>& scripts) const;
+
+        size_t GetPatternCount() const { return this->patternCount; }
+
+    private:
+        struct Pattern
+        {
+            size_t script;
+            bool exclude;
+            std::string rest;
+        };
+
+        struct Node
+        {
+            ~Node();
+            std::map<char, Node*> children;
+            std::vector<Pattern> patterns;
+        };
+
+        void Add(size_t script, const std::string& pattern, bool exclude);
+
+        Node root;
+        size_t scriptCount;
+        size_t patternCount;
+    };
+}
+
+#endif
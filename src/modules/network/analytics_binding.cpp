@@ -9,17 +9,33 @@
 #include <tideutils/url_utils.h>
 #include <tideutils/data_utils.h>
 #include <tideutils/platform_utils.h>
+#include <tideutils/file_utils.h>
+#include <tideutils/environment_utils.h>
 
 #include <tide/thread_manager.h>
 #include <Poco/Environment.h>
 #include <Poco/Timezone.h>
 #include <Poco/NumberFormatter.h>
+#include <Poco/FileStream.h>
+#include <Poco/DeflatingStream.h>
+#include <algorithm>
+#include <sstream>
 #include "network_module.h"
 #include "network_binding.h"
 #include "analytics_binding.h"
 #include "common.h"
 
 #define SPEC_VERSION "2"
+#define BATCH_SPEC_VERSION "3"
+#define JOURNAL_NAME "analytics.journal"
+#define JOURNAL_LIMIT 500
+#define BATCH_EVENTS 20
+#define BATCH_BYTES 65536
+#define FLUSH_INTERVAL_SECONDS 30
+#define RETRY_MIN_SECONDS 5
+#define RETRY_MAX_SECONDS 600
+#define REQUEST_TIMEOUT_SECONDS 30
+
 namespace ti
 {
 
@@ -39,14 +55,34 @@ static void AddQueryParameter(std::string& url, const std::string& key,
     url.append(URLUtils::EncodeURIComponent(value));
 }
 
+static size_t DiscardResponse(char* data, size_t size, size_t count, void* userdata)
+{
+    return size * count;
+}
+
 AnalyticsBinding::AnalyticsBinding() :
     EventObject("Network.Analytics"),
     running(true),
+    started(false),
+    batching(false),
+    targetChanged(false),
     curlHandle(0),
-    startCallback(0)
+    oldestEvent(0),
+    nextAttempt(0),
+    retryDelay(0),
+    startCallback(0),
+    received(0),
+    sent(0),
+    batches(0),
+    failures(0)
 {
     SharedApplication app(Host::GetInstance()->GetApplication());
-    this->url = app->GetStreamURL("https") + "/app-track";
+    this->defaultURL = app->GetStreamURL("https") + "/app-track";
+    this->UpdateTarget();
+
+    this->journalPath = FileUtils::Join(app->GetDataPath().c_str(),
+        JOURNAL_NAME, NULL);
+    this->LoadJournal();
 
     AddQueryParameter(baseData, "mid", PlatformUtils::GetMachineId(), true);
     AddQueryParameter(baseData, "guid", app->guid);
@@ -65,7 +101,6 @@ AnalyticsBinding::AnalyticsBinding() :
         Poco::NumberFormatter::format(PlatformUtils::GetProcessorCount()));
     AddQueryParameter(baseData, "un", PlatformUtils::GetUsername());
     AddQueryParameter(baseData, "ip", NetworkBinding::GetFirstIPAddress());
-    AddQueryParameter(baseData, "ver", SPEC_VERSION);
 
     // The 'tz' property is the amount of minutes to add to local time to get
     // UTC time. According to: http://pocoproject.org/docs/Poco.Timezone.html
@@ -75,6 +110,14 @@ AnalyticsBinding::AnalyticsBinding() :
 
     this->SetMethod("_sendEvent", &AnalyticsBinding::_SendEvent);
 
+    /**
+     * @tiapi(method=True,name=Analytics.getStats,since=1.4)
+     * @tiapi Return counters for the events queued and sent by this process.
+     * @tiresult(for=Analytics.getStats,type=Object) an object with received,
+     * @tiresult sent, batches, failures and pending properties
+     */
+    this->SetMethod("getStats", &AnalyticsBinding::_GetStats);
+
     // When curl_easy_perform is called with an HTTPS address on Windows,
     // it seems to block the UI thread until the request initializes. This
     // causes a multi-second lag before the first page display. The most
@@ -94,6 +137,7 @@ void AnalyticsBinding::_StartAnalyticsThread(const ValueList &args, ValueRef res
         return;
 
     this->thread.start(*this);
+    this->started = true;
     GlobalObject::GetInstance()->RemoveEventListener(
         Event::PAGE_LOADED, this->startCallback);
     this->startCallback = 0;
@@ -109,17 +153,58 @@ void AnalyticsBinding::Shutdown()
     if (!this->running)
         return;
 
-    this->running = false;
-    this->thread.join();
+    {
+        Poco::Mutex::ScopedLock lock(this->eventsLock);
+        this->running = false;
+        this->eventsCondition.signal();
+    }
+
+    if (this->started)
+        this->thread.join();
 }
 
 void AnalyticsBinding::_SendEvent(const ValueList &args, ValueRef result)
 {
+    // Each event takes a single line of the journal and of a batch.
     std::string eventString(args.GetString(0));
+    std::string::size_type i;
+    while ((i = eventString.find_first_of("\r\n")) != std::string::npos)
+        eventString.replace(i, 1, eventString[i] == '\n' ? "%0A" : "%0D");
+
+    // Events are kept along with the data of the session they were sent
+    // in, so that any left for a later run are still reported as this one's.
+    std::string payload(this->baseData + "&" + eventString);
+
+    Poco::Mutex::ScopedLock lock(this->eventsLock);
+    this->received++;
+    if (this->events.size() >= JOURNAL_LIMIT)
     {
-        Poco::Mutex::ScopedLock lock(eventsLock);
-        events.push(eventString);
+        GetLogger()->Warn("Too many unsent events, dropping event");
+        return;
     }
+
+    if (this->events.empty())
+        this->oldestEvent.update();
+    this->events.push_back(payload);
+    this->AppendToJournal(payload);
+
+    // The sender only needs to wake up to start timing a new batch,
+    // to send a full one or to start over with a new server.
+    if (this->UpdateTarget() || !this->batching || this->events.size() == 1 ||
+        this->events.size() == BATCH_EVENTS)
+        this->eventsCondition.signal();
+}
+
+void AnalyticsBinding::_GetStats(const ValueList &args, ValueRef result)
+{
+    Poco::Mutex::ScopedLock lock(this->eventsLock);
+    TiObjectRef stats(new StaticBoundObject());
+    stats->SetDouble("received", this->received);
+    stats->SetDouble("sent", this->sent);
+    stats->SetDouble("batches", this->batches);
+    stats->SetDouble("failures", this->failures);
+    stats->SetInt("pending", this->events.size());
+    result->SetObject(stats);
 }
 
 void AnalyticsBinding::run()
@@ -128,57 +213,270 @@ void AnalyticsBinding::run()
 
     this->curlHandle = curl_easy_init();
 
-    SET_CURL_OPTION(this->curlHandle, CURLOPT_URL, url.c_str());
     SET_CURL_OPTION(this->curlHandle, CURLOPT_POST, 1);
-
-    SetCurlProxySettings(this->curlHandle, ProxyConfig::GetProxyForURL(url));
+    SET_CURL_OPTION(this->curlHandle, CURLOPT_TIMEOUT, REQUEST_TIMEOUT_SECONDS);
+    SET_CURL_OPTION(this->curlHandle, CURLOPT_WRITEFUNCTION, &DiscardResponse);
     SetStandardCurlHandleOptions(this->curlHandle);
 
-    while (this->running || !events.empty())
-    {
+    struct curl_slist* batchHeaders = 0;
+    batchHeaders = curl_slist_append(batchHeaders, "Content-Type: text/plain; charset=utf-8");
+    batchHeaders = curl_slist_append(batchHeaders, "Content-Encoding: gzip");
 
-        while (!this->events.empty())
+    std::string url;
+    bool batching = false;
+    bool configure = true;
+    while (true)
+    {
+        std::string body;
+        size_t count = 0;
         {
-            std::string nextEvent;
+            Poco::Mutex::ScopedLock lock(this->eventsLock);
+            long delay;
+            while (this->running && (delay = this->GetFlushDelay()) != 0)
             {
-                Poco::Mutex::ScopedLock lock(eventsLock);
-                nextEvent = events.front();
-                events.pop();
+                if (delay < 0)
+                    this->eventsCondition.wait(this->eventsLock);
+                else
+                    this->eventsCondition.tryWait(this->eventsLock, delay);
             }
-            this->SendEventToAPIServer(nextEvent);
+
+            // At exit, make one last attempt to send everything unless the
+            // server is already failing. Whatever is left stays in the
+            // journal for the next run.
+            if (this->events.empty() || (!this->running && this->retryDelay > 0))
+                break;
+
+            this->UpdateTarget();
+            count = this->GetBatch(body);
+            configure = configure || this->targetChanged;
+            this->targetChanged = false;
+            url = this->url;
+            batching = this->batching;
         }
 
-        if (this->running && this->events.empty())
-            Poco::Thread::sleep(100);
+        if (configure)
+        {
+            SET_CURL_OPTION(this->curlHandle, CURLOPT_URL, url.c_str());
+            SET_CURL_OPTION(this->curlHandle, CURLOPT_HTTPHEADER,
+                batching ? batchHeaders : 0);
+            SetCurlProxySettings(this->curlHandle, ProxyConfig::GetProxyForURL(url));
+            configure = false;
+        }
+
+        BatchResult result = this->SendBatch(body, count, url, batching);
+
+        Poco::Mutex::ScopedLock lock(this->eventsLock);
+        if (result == BATCH_FAILED)
+        {
+            this->failures++;
+            this->retryDelay = this->retryDelay == 0 ?
+                (Poco::Timestamp::TimeDiff) RETRY_MIN_SECONDS * 1000000 :
+                std::min(this->retryDelay * 2,
+                    (Poco::Timestamp::TimeDiff) RETRY_MAX_SECONDS * 1000000);
+            this->nextAttempt.update();
+            this->nextAttempt += this->retryDelay;
+            continue;
+        }
+
+        if (result == BATCH_SENT)
+        {
+            this->sent += count;
+            this->batches++;
+        }
+        this->retryDelay = 0;
+        this->events.erase(this->events.begin(), this->events.begin() + count);
+        this->RewriteJournal();
     }
 
     curl_easy_cleanup(this->curlHandle);
+    curl_slist_free_all(batchHeaders);
     this->curlHandle = 0;
 
     END_TIDE_THREAD;
 }
 
-void AnalyticsBinding::SendEventToAPIServer(std::string& eventData)
+// Pick the server to send to. The stand-in addresses are read every
+// time, so that a running application can be pointed at a local server.
+// Returns true when the server has changed. Called with eventsLock held.
+bool AnalyticsBinding::UpdateTarget()
+{
+    std::string url(this->defaultURL);
+    bool batching = false;
+
+    std::string standInURL(EnvironmentUtils::Get("TIDE_ANALYTICS_URL"));
+    if (!standInURL.empty())
+        url = standInURL;
+
+    // The stream server only takes one form-encoded event per request, so
+    // batches are only sent to a collector which asks for them.
+    std::string batchURL(EnvironmentUtils::Get("TIDE_ANALYTICS_BATCH_URL"));
+    if (!batchURL.empty())
+    {
+        url = batchURL;
+        batching = true;
+    }
+
+    if (url == this->url && batching == this->batching)
+        return false;
+
+    // Failures of one server say nothing about another.
+    this->url = url;
+    this->batching = batching;
+    this->targetChanged = true;
+    this->retryDelay = 0;
+    this->nextAttempt = 0;
+    return true;
+}
+
+// How many milliseconds the sender should wait before sending the next
+// batch, or -1 if it should wait until an event is queued. Called with
+// eventsLock held.
+long AnalyticsBinding::GetFlushDelay()
+{
+    if (this->events.empty())
+        return -1;
+
+    Poco::Timestamp now;
+    if (this->nextAttempt > now)
+        return (long) ((this->nextAttempt - now) / 1000) + 1;
+
+    if (!this->batching || this->events.size() >= BATCH_EVENTS)
+        return 0;
+
+    Poco::Timestamp::TimeDiff interval =
+        (Poco::Timestamp::TimeDiff) FLUSH_INTERVAL_SECONDS * 1000000;
+    Poco::Timestamp::TimeDiff waited = now - this->oldestEvent;
+    if (waited >= interval)
+        return 0;
+    return (long) ((interval - waited) / 1000) + 1;
+}
+
+// Join the oldest events into a batch body, one per line. Without
+// batching the body is just the oldest event. Called with eventsLock held.
+size_t AnalyticsBinding::GetBatch(std::string& body)
 {
-    std::string postData(baseData + "&" + eventData);
+    size_t limit = this->batching ? BATCH_EVENTS : 1;
+    std::string version(this->batching ? BATCH_SPEC_VERSION : SPEC_VERSION);
+    size_t count = 0;
+    while (count < this->events.size() && count < limit)
+    {
+        std::string line(this->events[count] + "&ver=" + version);
+        if (count > 0 && body.size() + line.size() + 1 > BATCH_BYTES)
+            break;
+
+        if (count > 0)
+            body.append("\n");
+        body.append(line);
+        count++;
+    }
+    return count;
+}
+
+AnalyticsBinding::BatchResult AnalyticsBinding::SendBatch(
+    const std::string& body, size_t count, const std::string& url, bool batching)
+{
+    std::string postData(body);
+    if (batching)
+    {
+        std::ostringstream compressed;
+        Poco::DeflatingOutputStream deflater(compressed,
+            Poco::DeflatingStreamBuf::STREAM_GZIP);
+        deflater.write(body.data(), body.size());
+        deflater.close();
+        postData = compressed.str();
+    }
+
     SET_CURL_OPTION(this->curlHandle, CURLOPT_POSTFIELDSIZE, postData.length());
     SET_CURL_OPTION(this->curlHandle, CURLOPT_POSTFIELDS, postData.c_str());
 
     CURLcode result = curl_easy_perform(this->curlHandle);
-    if (result == CURLE_OPERATION_TIMEDOUT)
+    if (result != CURLE_OK)
     {
-        GetLogger()->Error("Failed for URL (%s): %s", this->url.c_str(),
+        GetLogger()->Error("Failed for URL (%s): %s", url.c_str(),
             curl_easy_strerror(result));
+        return BATCH_FAILED;
     }
-    else if (result == CURLE_ABORTED_BY_CALLBACK)
+
+    long status = 0;
+    curl_easy_getinfo(this->curlHandle, CURLINFO_RESPONSE_CODE, &status);
+    if (status >= 200 && status < 300)
     {
-        GetLogger()->Error("Failed for URL (%s): %s", this->url.c_str(),
-            curl_easy_strerror(result));
+        GetLogger()->Debug("Sent %lu events in %lu bytes", (unsigned long) count,
+            (unsigned long) postData.length());
+        return BATCH_SENT;
     }
-    else if (result != CURLE_OK)
+
+    // Retrying a batch the server refuses will never succeed, so drop it.
+    if (status >= 400 && status < 500 && status != 408 && status != 429)
     {
-        GetLogger()->Error("Failed for URL (%s): %s", this->url.c_str(),
-            curl_easy_strerror(result));
+        GetLogger()->Error("Server at %s rejected %lu events (HTTP %ld)",
+            url.c_str(), (unsigned long) count, status);
+        return BATCH_REJECTED;
+    }
+
+    GetLogger()->Error("Failed for URL (%s): HTTP %ld", url.c_str(), status);
+    return BATCH_FAILED;
+}
+
+void AnalyticsBinding::LoadJournal()
+{
+    if (!FileUtils::IsFile(this->journalPath))
+        return;
+
+    try
+    {
+        Poco::FileInputStream stream(this->journalPath);
+        std::string line;
+        while (std::getline(stream, line) && this->events.size() < JOURNAL_LIMIT)
+        {
+            if (!line.empty())
+                this->events.push_back(line);
+        }
+    }
+    catch (Poco::Exception& e)
+    {
+        GetLogger()->Error("Could not read %s: %s", this->journalPath.c_str(),
+            e.displayText().c_str());
+    }
+
+    // oldestEvent is zero, so these are sent as soon as the sender starts.
+    if (!this->events.empty())
+    {
+        GetLogger()->Debug("Found %lu events left unsent by the last run",
+            (unsigned long) this->events.size());
+    }
+}
+
+// Called with eventsLock held.
+void AnalyticsBinding::AppendToJournal(const std::string& eventData)
+{
+    try
+    {
+        Poco::FileOutputStream stream(this->journalPath,
+            std::ios::out | std::ios::app);
+        stream << eventData << "\n";
+    }
+    catch (Poco::Exception& e)
+    {
+        GetLogger()->Error("Could not write %s: %s", this->journalPath.c_str(),
+            e.displayText().c_str());
+    }
+}
+
+// Called with eventsLock held.
+void AnalyticsBinding::RewriteJournal()
+{
+    try
+    {
+        Poco::FileOutputStream stream(this->journalPath,
+            std::ios::out | std::ios::trunc);
+        for (size_t i = 0; i < this->events.size(); i++)
+            stream << this->events[i] << "\n";
+    }
+    catch (Poco::Exception& e)
+    {
+        GetLogger()->Error("Could not write %s: %s", this->journalPath.c_str(),
+            e.displayText().c_str());
     }
 }
 }
@@ -14,11 +14,28 @@
 #include <Poco/Runnable.h>
 #include <Poco/Mutex.h>
 #include <Poco/Condition.h>
+#include <Poco/Timestamp.h>
 #include <curl/curl.h>
-#include <queue>
+#include <deque>
 
 namespace ti
 {
+    /**
+     * Sends Analytics events to the application's stream server. Events
+     * are written to a journal in the application data directory as soon
+     * as they are queued and are only removed from it once the server has
+     * accepted them, so events that could not be sent before exit are
+     * sent on the next run. Failed sends are retried with an increasing
+     * delay, and the sender thread sleeps on a condition between sends
+     * rather than polling the queue.
+     *
+     * Each event is normally sent as its own form POST to /app-track.
+     * When TIDE_ANALYTICS_BATCH_URL names a collector which accepts them,
+     * events are instead sent there in batches, each a gzipped POST body
+     * with one event per line, when enough have been queued or the oldest
+     * has waited long enough. TIDE_ANALYTICS_URL replaces the /app-track
+     * address, so tests can use a local stand-in server.
+     */
     class AnalyticsBinding : public EventObject, public Poco::Runnable
     {
     public:
@@ -28,17 +45,45 @@ namespace ti
 
     private:
         bool running;
+        bool started;
+        bool batching;
+        bool targetChanged;
+        std::string defaultURL;
         std::string url;
         std::string baseData;
+        std::string journalPath;
         CURL* curlHandle;
         Poco::Thread thread;
-        std::queue<std::string> events;
+        std::deque<std::string> events;
+        Poco::Timestamp oldestEvent;
+        Poco::Timestamp nextAttempt;
+        Poco::Timestamp::TimeDiff retryDelay;
         Poco::Mutex eventsLock;
+        Poco::Condition eventsCondition;
         TiMethodRef startCallback;
+        double received;
+        double sent;
+        double batches;
+        double failures;
+
+        enum BatchResult
+        {
+            BATCH_SENT,
+            BATCH_REJECTED,
+            BATCH_FAILED
+        };
 
         void run();
-        void SendEventToAPIServer(std::string& eventData);
+        bool UpdateTarget();
+        long GetFlushDelay();
+        size_t GetBatch(std::string& body);
+        BatchResult SendBatch(const std::string& body, size_t count,
+            const std::string& url, bool batching);
+        void LoadJournal();
+        void AppendToJournal(const std::string& eventData);
+        void RewriteJournal();
         void _SendEvent(const ValueList& args, ValueRef result);
+        void _GetStats(const ValueList& args, ValueRef result);
         void _StartAnalyticsThread(const ValueList &args, ValueRef result);
     };
 }
@@ -17,6 +17,11 @@ using namespace TideUtils;
 
 #include "network_module.h"
 #include "common.h"
+#include "dns_resolver.h"
+
+#include <Poco/NumberFormatter.h>
+#include <Poco/URI.h>
+#include <Poco/Net/IPAddress.h>
 
 static Logger* GetLogger()
 {
@@ -56,6 +61,49 @@ void SetCurlProxySettings(CURL* curlHandle, SharedProxy proxy)
     }
 }
 
+struct curl_slist* SetCurlResolvedHost(CURL* curlHandle, const std::string& url)
+{
+    // Hand cURL the address of the URL's host from the shared resolver
+    // cache, instead of letting each new handle resolve it again. Only
+    // used for direct connections, as a proxy resolves the host itself.
+    // The returned list must outlive the handle.
+#if LIBCURL_VERSION_NUM >= 0x071503
+    try
+    {
+        Poco::URI uri(url);
+        if (uri.getScheme() == "file" || uri.getHost().empty())
+            return 0;
+
+        Poco::Net::IPAddress address;
+        if (Poco::Net::IPAddress::tryParse(uri.getHost(), address))
+            return 0;
+
+        Poco::Net::HostEntry entry(
+            ti::DNSResolver::GetInstance().ResolveName(uri.getHost()));
+        address = ti::DNSResolver::GetPreferredAddress(entry);
+        if (address.family() != Poco::Net::IPAddress::IPv4)
+            return 0;
+
+        std::string resolve(uri.getHost());
+        resolve.append(":");
+        resolve.append(Poco::NumberFormatter::format(uri.getPort()));
+        resolve.append(":");
+        resolve.append(address.toString());
+
+        struct curl_slist* list = curl_slist_append(0, resolve.c_str());
+        SET_CURL_OPTION(curlHandle, CURLOPT_RESOLVE, list);
+        return list;
+    }
+    catch (Poco::Exception&)
+    {
+        // Let cURL resolve the host and report the failure itself.
+        return 0;
+    }
+#else
+    return 0;
+#endif
+}
+
 void SetStandardCurlHandleOptions(CURL* handle)
 {
     // non negative number means don't verify peer cert - we might want to 
@@ -23,6 +23,7 @@
 
 void SetCurlProxySettings(CURL* curlHandle, SharedProxy proxy);
 void SetStandardCurlHandleOptions(CURL* handle);
+struct curl_slist* SetCurlResolvedHost(CURL* curlHandle, const std::string& url);
 BytesRef ObjectToBytes(TiObjectRef dataObject);
 
 #endif
@@ -0,0 +1,373 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include "dns_resolver.h"
+#include "host_binding.h"
+
+#include <tide/thread_manager.h>
+
+#include <Poco/Notification.h>
+#include <Poco/String.h>
+#include <Poco/Net/DNS.h>
+#include <Poco/Net/NetException.h>
+
+// The system resolver does not expose record TTLs, so every answer is
+// cached for a fixed time. Failures are cached for less, so that a host
+// which comes back is noticed soon.
+#define DNS_POSITIVE_TTL_SECONDS 60
+#define DNS_NEGATIVE_TTL_SECONDS 10
+#define DNS_CACHE_CAPACITY 256
+#define DNS_RESOLVER_THREADS 4
+
+using Poco::Net::DNS;
+using Poco::Net::HostEntry;
+using Poco::Net::IPAddress;
+using Poco::Net::HostNotFoundException;
+using Poco::Net::NoAddressFoundException;
+
+namespace ti
+{
+    DNSResolver* DNSResolver::instance = 0;
+    Poco::FastMutex DNSResolver::instanceMutex;
+
+    class ResolverNotification : public Poco::Notification
+    {
+    public:
+        // A notification without a job tells a resolver thread to exit.
+        ResolverNotification(AutoPtr<AsyncJob> job=0) : job(job) {}
+        AutoPtr<AsyncJob> job;
+    };
+
+    /*static*/
+    DNSResolver& DNSResolver::GetInstance()
+    {
+        Poco::FastMutex::ScopedLock lock(instanceMutex);
+        if (!instance)
+            instance = new DNSResolver();
+        return *instance;
+    }
+
+    /*static*/
+    void DNSResolver::Shutdown()
+    {
+        DNSResolver* resolver;
+        {
+            Poco::FastMutex::ScopedLock lock(instanceMutex);
+            resolver = instance;
+        }
+        if (!resolver)
+            return;
+
+        // Drop any lookups that have not started and wait for the ones
+        // that have. Each thread exits when it takes a stop notification.
+        // instanceMutex isn't held meanwhile, since a running job may
+        // still call GetInstance.
+        std::vector<Poco::Thread*> threads;
+        {
+            Poco::FastMutex::ScopedLock threadsLock(resolver->mutex);
+            threads.swap(resolver->threads);
+        }
+
+        resolver->queue.clear();
+        for (size_t i = 0; i < threads.size(); i++)
+            resolver->queue.enqueueNotification(new ResolverNotification());
+        for (size_t i = 0; i < threads.size(); i++)
+        {
+            threads[i]->join();
+            delete threads[i];
+        }
+
+        {
+            Poco::FastMutex::ScopedLock lock(instanceMutex);
+            instance = 0;
+        }
+        delete resolver;
+    }
+
+    DNSResolver::DNSResolver() :
+        lookups(0),
+        hits(0),
+        failures(0),
+        resolveTime(0)
+    {
+    }
+
+    DNSResolver::~DNSResolver()
+    {
+    }
+
+    HostEntry DNSResolver::ResolveName(const std::string& name)
+    {
+        std::string key("name:");
+        key.append(Poco::toLower(name));
+
+        HostEntry host;
+        bool found;
+        if (this->Find(key, host, found))
+        {
+            if (!found)
+                throw HostNotFoundException(name);
+            return host;
+        }
+
+        Poco::Timestamp start;
+        try
+        {
+            host = DNS::hostByName(name);
+        }
+        catch (HostNotFoundException&)
+        {
+            this->Store(key, host, false);
+            throw;
+        }
+        catch (NoAddressFoundException&)
+        {
+            this->Store(key, host, false);
+            throw;
+        }
+
+        this->Store(key, host, true);
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        this->resolveTime += start.elapsed();
+        return host;
+    }
+
+    HostEntry DNSResolver::ResolveAddress(const IPAddress& address)
+    {
+        std::string key("address:");
+        key.append(address.toString());
+
+        HostEntry host;
+        bool found;
+        if (this->Find(key, host, found))
+        {
+            if (!found)
+                throw HostNotFoundException(address.toString());
+            return host;
+        }
+
+        Poco::Timestamp start;
+        try
+        {
+            host = DNS::hostByAddress(address);
+        }
+        catch (HostNotFoundException&)
+        {
+            this->Store(key, host, false);
+            throw;
+        }
+        catch (NoAddressFoundException&)
+        {
+            this->Store(key, host, false);
+            throw;
+        }
+
+        this->Store(key, host, true);
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        this->resolveTime += start.elapsed();
+        return host;
+    }
+
+    bool DNSResolver::GetCachedName(const std::string& name, HostEntry& host)
+    {
+        std::string key("name:");
+        key.append(Poco::toLower(name));
+
+        // Callers go on to ResolveName when this fails, which counts the
+        // lookup, so only a hit is counted here.
+        bool found;
+        if (!this->Find(key, host, found, false) || !found)
+            return false;
+
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        this->lookups++;
+        this->hits++;
+        return true;
+    }
+
+    /*static*/
+    IPAddress DNSResolver::GetPreferredAddress(const HostEntry& host)
+    {
+        // Prefer IPv4, as most of the hosts an application talks to
+        // are still only reachable that way.
+        const HostEntry::AddressList& addresses = host.addresses();
+        if (addresses.empty())
+            throw NoAddressFoundException(host.name());
+
+        for (size_t i = 0; i < addresses.size(); i++)
+        {
+            if (addresses[i].family() == IPAddress::IPv4)
+                return addresses[i];
+        }
+        return addresses[0];
+    }
+
+    void DNSResolver::Enqueue(AutoPtr<AsyncJob> job)
+    {
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            if (this->threads.empty())
+            {
+                for (int i = 0; i < DNS_RESOLVER_THREADS; i++)
+                {
+                    Poco::Thread* thread = new Poco::Thread();
+                    thread->setName("DNSResolver");
+                    thread->start(*this);
+                    this->threads.push_back(thread);
+                }
+            }
+        }
+
+        this->queue.enqueueNotification(new ResolverNotification(job));
+    }
+
+    void DNSResolver::run()
+    {
+        START_TIDE_THREAD;
+        while (true)
+        {
+            Poco::AutoPtr<Poco::Notification> n(this->queue.waitDequeueNotification());
+            ResolverNotification* notification =
+                dynamic_cast<ResolverNotification*>(n.get());
+            if (!notification || notification->job.isNull())
+                break;
+
+            // A job which throws must not take the thread with it, or
+            // everything queued behind it would wait forever.
+            try
+            {
+                notification->job->Run();
+            }
+            catch (std::exception& e)
+            {
+                Logger::Get("Network.DNSResolver")->Error(
+                    "Lookup failed: %s", e.what());
+            }
+            catch (...)
+            {
+                Logger::Get("Network.DNSResolver")->Error("Lookup failed");
+            }
+        }
+        END_TIDE_THREAD;
+    }
+
+    void DNSResolver::Clear()
+    {
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        this->entries.clear();
+        this->order.clear();
+    }
+
+    TiObjectRef DNSResolver::GetStats()
+    {
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        TiObjectRef stats(new StaticBoundObject());
+        stats->SetDouble("lookups", this->lookups);
+        stats->SetDouble("cacheHits", this->hits);
+        stats->SetDouble("failures", this->failures);
+        stats->SetDouble("totalResolutionTime", this->resolveTime / 1000.0);
+        stats->SetInt("size", this->entries.size());
+        stats->SetInt("capacity", DNS_CACHE_CAPACITY);
+        return stats;
+    }
+
+    bool DNSResolver::Find(const std::string& key, HostEntry& host, bool& found,
+        bool count)
+    {
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        if (count)
+            this->lookups++;
+
+        EntryMap::iterator i = this->entries.find(key);
+        if (i == this->entries.end())
+            return false;
+
+        if (i->second.expires < Poco::Timestamp())
+        {
+            this->Remove(i);
+            return false;
+        }
+
+        this->order.splice(this->order.begin(), this->order, i->second.position);
+        if (count)
+            this->hits++;
+        host = i->second.host;
+        found = i->second.found;
+        return true;
+    }
+
+    void DNSResolver::Store(const std::string& key, const HostEntry& host, bool found)
+    {
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        if (!found)
+            this->failures++;
+
+        EntryMap::iterator i = this->entries.find(key);
+        if (i != this->entries.end())
+            this->Remove(i);
+
+        while (this->entries.size() >= DNS_CACHE_CAPACITY)
+            this->Remove(this->entries.find(this->order.back()));
+
+        Poco::Timestamp expires;
+        expires += (Poco::Timestamp::TimeDiff) (found ?
+            DNS_POSITIVE_TTL_SECONDS : DNS_NEGATIVE_TTL_SECONDS) * 1000000;
+
+        this->order.push_front(key);
+        Entry& entry = this->entries[key];
+        entry.host = host;
+        entry.found = found;
+        entry.expires = expires;
+        entry.position = this->order.begin();
+    }
+
+    void DNSResolver::Remove(EntryMap::iterator i)
+    {
+        this->order.erase(i->second.position);
+        this->entries.erase(i);
+    }
+
+    HostLookupJob::HostLookupJob(DNSResolver& resolver, const std::string& name,
+        bool byAddress, TiMethodRef callback) :
+        AsyncJob(),
+        resolver(resolver),
+        name(name),
+        byAddress(byAddress),
+        callback(callback)
+    {
+    }
+
+    ValueRef HostLookupJob::Execute()
+    {
+        AutoPtr<HostBinding> host;
+        try
+        {
+            if (this->byAddress)
+                host = new HostBinding(IPAddress(this->name), this->resolver);
+            else
+                host = new HostBinding(this->name, this->resolver);
+        }
+        catch (Poco::Exception& e)
+        {
+            // For instance an address which doesn't parse.
+            ValueException error(ValueException::FromString(e.displayText()));
+            this->Error(error);
+            return Value::Undefined;
+        }
+
+        if (this->cancelled)
+            return Value::Undefined;
+
+        // An unresolvable host is still passed to the callback, so that
+        // it can check isInvalid() as with the synchronous lookups.
+        ValueRef result(Value::NewObject(host));
+        if (!this->callback.isNull())
+            RunOnMainThread(this->callback, ValueList(result), false);
+        return result;
+    }
+}
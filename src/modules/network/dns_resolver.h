@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _TINET_DNS_RESOLVER_H_
+#define _TINET_DNS_RESOLVER_H_
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Poco/Mutex.h>
+#include <Poco/NotificationQueue.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
+#include <Poco/Timestamp.h>
+#include <Poco/Net/HostEntry.h>
+#include <Poco/Net/IPAddress.h>
+
+#include <tide/tide.h>
+
+namespace ti
+{
+    /**
+     * Resolves host names for the HTTP client, TCP sockets and IRC, and
+     * for the Network.getHostBy* functions. Answers are kept in a bounded
+     * cache shared by all of them, so that reconnecting to the same host
+     * does not go back to the system resolver each time. The system
+     * resolver does not report record TTLs, so successful lookups are
+     * kept for a fixed time and failed ones for a shorter one.
+     *
+     * Lookups that must not block the caller are queued as jobs and run
+     * on a small pool of worker threads, started on first use.
+     */
+    class DNSResolver : public Poco::Runnable
+    {
+    public:
+        static DNSResolver& GetInstance();
+        static void Shutdown();
+
+        // Resolve a host name or an address, blocking the calling thread
+        // on a cache miss. These throw the same exceptions as Poco's DNS.
+        Poco::Net::HostEntry ResolveName(const std::string& name);
+        Poco::Net::HostEntry ResolveAddress(const Poco::Net::IPAddress& address);
+
+        // Look a host name up in the cache only. Returns false when the
+        // name has no fresh, successful entry.
+        bool GetCachedName(const std::string& name, Poco::Net::HostEntry& host);
+
+        // Choose the address to connect to from a resolved host.
+        static Poco::Net::IPAddress GetPreferredAddress(const Poco::Net::HostEntry& host);
+
+        // Run a job on one of the resolver threads.
+        void Enqueue(AutoPtr<AsyncJob> job);
+
+        void Clear();
+        TiObjectRef GetStats();
+
+        virtual void run();
+
+    private:
+        DNSResolver();
+        ~DNSResolver();
+
+        struct Entry
+        {
+            Poco::Net::HostEntry host;
+            bool found;
+            Poco::Timestamp expires;
+            std::list<std::string>::iterator position;
+        };
+        typedef std::map<std::string, Entry> EntryMap;
+
+        bool Find(const std::string& key, Poco::Net::HostEntry& host, bool& found,
+            bool count=true);
+        void Store(const std::string& key, const Poco::Net::HostEntry& host, bool found);
+        void Remove(EntryMap::iterator i);
+
+        EntryMap entries;
+        std::list<std::string> order;
+        Poco::FastMutex mutex;
+        double lookups;
+        double hits;
+        double failures;
+        double resolveTime;
+
+        Poco::NotificationQueue queue;
+        std::vector<Poco::Thread*> threads;
+
+        static DNSResolver* instance;
+        static Poco::FastMutex instanceMutex;
+
+        DISALLOW_EVIL_CONSTRUCTORS(DNSResolver);
+    };
+
+    /**
+     * A Network.getHostByName or Network.getHostByAddress lookup run on
+     * the resolver threads. The callback, if any, is passed the resulting
+     * Network.Host on the main thread.
+     */
+    class HostLookupJob : public AsyncJob
+    {
+    public:
+        HostLookupJob(DNSResolver& resolver, const std::string& name, bool byAddress,
+            TiMethodRef callback);
+
+    protected:
+        virtual ValueRef Execute();
+
+    private:
+        DNSResolver& resolver;
+        std::string name;
+        bool byAddress;
+        TiMethodRef callback;
+    };
+}
+
+#endif
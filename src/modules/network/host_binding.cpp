@@ -7,17 +7,18 @@
  **/
 
 #include "host_binding.h"
+#include "dns_resolver.h"
 
 namespace ti
 {
-    HostBinding::HostBinding(IPAddress addr) :
+    HostBinding::HostBinding(IPAddress addr, DNSResolver& resolver) :
         StaticBoundObject("Network.Host"),
         name(addr.toString())
     {
         this->Init();
         try
         {
-            this->host = DNS::hostByAddress(addr);
+            this->host = resolver.ResolveAddress(addr);
         }
         catch (HostNotFoundException&)
         {
@@ -29,13 +30,20 @@ namespace ti
             this->invalid = true;
             //TODO: improve this exception so we can properly raise
         }
+        catch (Poco::Exception&)
+        {
+            // Temporary failures, like having no network, aren't cached.
+            this->invalid = true;
+        }
     }
-    HostBinding::HostBinding(std::string name) : StaticBoundObject("Host"), name(name)
+    HostBinding::HostBinding(std::string name, DNSResolver& resolver) :
+        StaticBoundObject("Host"),
+        name(name)
     {
         this->Init();
         try
         {
-            this->host = DNS::hostByName(name.c_str());
+            this->host = resolver.ResolveName(name);
         }
         catch (HostNotFoundException&)
         {
@@ -47,6 +55,11 @@ namespace ti
             this->invalid = true;
             //TODO: improve this exception so we can properly raise
         }
+        catch (Poco::Exception&)
+        {
+            // Temporary failures, like having no network, aren't cached.
+            this->invalid = true;
+        }
     }
     HostBinding::~HostBinding()
     {
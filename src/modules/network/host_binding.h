@@ -25,11 +25,13 @@ using Poco::Net::NoAddressFoundException;
 
 namespace ti
 {
+    class DNSResolver;
+
     class HostBinding : public StaticBoundObject
     {
     public:
-        HostBinding(IPAddress);
-        HostBinding(std::string);
+        HostBinding(IPAddress, DNSResolver& resolver);
+        HostBinding(std::string, DNSResolver& resolver);
         virtual ~HostBinding();
     protected:
         void Init();
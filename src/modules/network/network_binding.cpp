@@ -17,6 +17,7 @@
 #include "interface_binding.h"
 #include "ipaddress_binding.h"
 #include "host_binding.h"
+#include "dns_resolver.h"
 #include "protocols/irc/irc_client_binding.h"
 #include "protocols/http/http_client_binding.h"
 #include "protocols/http/http_server_binding.h"
@@ -100,13 +101,19 @@ namespace ti
         /**
          * @tiapi(method=True,name=Network.getHostByName,since=0.2) Returns a Host object using a hostname
          * @tiarg(for=Network.getHostByName,name=name,type=String) the hostname
-         * @tiresult(for=Network.getHostByName,type=Network.Host) a Host object referencing the hostname
+         * @tiarg(for=Network.getHostByName,name=callback,type=Function,optional=True,since=1.4) if given,
+         * resolve the hostname in the background and pass the Host object to this function
+         * @tiresult(for=Network.getHostByName,type=Network.Host|AsyncJob) a Host object referencing the
+         * hostname, or the lookup job when a callback is given
          */
         this->SetMethod("getHostByName",&NetworkBinding::_GetHostByName);
         /**
          * @tiapi(method=True,name=Network.getHostByAddress,since=0.2) Returns a Host object using an address
          * @tiarg(for=Network.getHostByAddress,name=address,type=String) the address
-         * @tiresult(for=Network.getHostByAddress,type=Network.Host) a Host object referencing the address
+         * @tiarg(for=Network.getHostByAddress,name=callback,type=Function,optional=True,since=1.4) if given,
+         * resolve the address in the background and pass the Host object to this function
+         * @tiresult(for=Network.getHostByAddress,type=Network.Host|AsyncJob) a Host object referencing the
+         * address, or the lookup job when a callback is given
          */
         this->SetMethod("getHostByAddress",&NetworkBinding::_GetHostByAddress);
         /**
@@ -152,6 +159,30 @@ namespace ti
          */
         this->SetMethod("getHTTPSProxy", &NetworkBinding::_GetHTTPSProxy);
 
+        /**
+         * @tiapi(method=True,name=Network.getProxyStats,since=1.4)
+         * @tiapi Return statistics about proxy autodetection. Decisions are cached per
+         * @tiapi scheme, host and port, and the cache is cleared when a proxy override changes.
+         * @tiresult[Object] lookups, cacheHits and resolutions counts, and the total and
+         * maximum time spent resolving proxies in milliseconds.
+         */
+        this->SetMethod("getProxyStats", &NetworkBinding::_GetProxyStats);
+
+        /**
+         * @tiapi(method=True,name=Network.getDNSStats,since=1.4)
+         * @tiapi Return statistics about the host name cache shared by Network.Host lookups,
+         * @tiapi TCP sockets, IRC clients and HTTP clients.
+         * @tiresult[Object] lookups, cacheHits and failures counts, the total time spent
+         * resolving in milliseconds, and the size and capacity of the cache.
+         */
+        this->SetMethod("getDNSStats", &NetworkBinding::_GetDNSStats);
+
+        /**
+         * @tiapi(method=True,name=Network.clearDNSCache,since=1.4)
+         * @tiapi Forget all cached host name lookups.
+         */
+        this->SetMethod("clearDNSCache", &NetworkBinding::_ClearDNSCache);
+
         /**
          * @tiapi(method=True,name=Network.getInterfaces,since=0.9)
          * Get a list of interfaces active on this machine.
@@ -182,7 +213,7 @@ namespace ti
 
     AutoPtr<HostBinding> NetworkBinding::GetHostBinding(std::string hostname)
     {
-        AutoPtr<HostBinding> binding(new HostBinding(hostname));
+        AutoPtr<HostBinding> binding(new HostBinding(hostname, DNSResolver::GetInstance()));
         if (binding->IsInvalid())
             throw ValueException::FromString("Could not resolve address");
 
@@ -191,6 +222,33 @@ namespace ti
 
     void NetworkBinding::_GetHostByAddress(const ValueList& args, ValueRef result)
     {
+        args.VerifyException("getHostByAddress", "s|o ?m");
+        if (args.size() > 1 && args.at(1)->IsMethod())
+        {
+            std::string address;
+            if (args.at(0)->IsObject())
+            {
+                TiMethodRef toStringMethod = args.GetObject(0)->GetMethod("toString");
+                if (toStringMethod.isNull())
+                    throw ValueException::FromString("Unknown object passed");
+                address = toStringMethod->Call()->ToString();
+            }
+            else
+            {
+                address = args.GetString(0);
+            }
+
+            IPAddress parsed;
+            if (!IPAddress::tryParse(address, parsed))
+                throw ValueException::FromFormat("Invalid address: %s", address.c_str());
+
+            DNSResolver& resolver(DNSResolver::GetInstance());
+            AutoPtr<AsyncJob> job(new HostLookupJob(resolver, address, true, args.GetMethod(1)));
+            resolver.Enqueue(job);
+            result->SetObject(job);
+            return;
+        }
+
         if (args.at(0)->IsObject())
         {
             TiObjectRef obj = args.at(0)->ToObject();
@@ -201,7 +259,7 @@ namespace ti
                 // object, which we can just retrieve the ipaddress
                 // instance and resolving using it
                 IPAddress addr(b->GetAddress()->toString());
-                AutoPtr<HostBinding> binding = new HostBinding(addr);
+                AutoPtr<HostBinding> binding = new HostBinding(addr, DNSResolver::GetInstance());
                 if (binding->IsInvalid())
                 {
                     throw ValueException::FromString("Could not resolve address");
@@ -228,6 +286,17 @@ namespace ti
 
     void NetworkBinding::_GetHostByName(const ValueList& args, ValueRef result)
     {
+        args.VerifyException("getHostByName", "s ?m");
+        if (args.size() > 1 && args.at(1)->IsMethod())
+        {
+            DNSResolver& resolver(DNSResolver::GetInstance());
+            AutoPtr<AsyncJob> job(new HostLookupJob(resolver, args.GetString(0), false,
+                args.GetMethod(1)));
+            resolver.Enqueue(job);
+            result->SetObject(job);
+            return;
+        }
+
         result->SetObject(GetHostBinding(args.GetString(0)));
     }
 
@@ -379,6 +448,28 @@ namespace ti
             result->SetString(proxy->ToString().c_str());
     }
 
+    void NetworkBinding::_GetProxyStats(const ValueList& args, ValueRef result)
+    {
+        ProxyResolutionStats stats(ProxyConfig::GetResolutionStats());
+        TiObjectRef o(new StaticBoundObject());
+        o->SetDouble("lookups", stats.lookups);
+        o->SetDouble("cacheHits", stats.cacheHits);
+        o->SetDouble("resolutions", stats.resolutions);
+        o->SetDouble("totalResolutionTime", stats.totalResolutionTime / 1000.0);
+        o->SetDouble("maxResolutionTime", stats.maxResolutionTime / 1000.0);
+        result->SetObject(o);
+    }
+
+    void NetworkBinding::_GetDNSStats(const ValueList& args, ValueRef result)
+    {
+        result->SetObject(DNSResolver::GetInstance().GetStats());
+    }
+
+    void NetworkBinding::_ClearDNSCache(const ValueList& args, ValueRef result)
+    {
+        DNSResolver::GetInstance().Clear();
+    }
+
     Host* NetworkBinding::GetHost()
     {
         return this->host;
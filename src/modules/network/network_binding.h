@@ -52,6 +52,9 @@ namespace ti
         void _SetHTTPSProxy(const ValueList& args, ValueRef result);
         void _GetHTTPProxy(const ValueList& args, ValueRef result);
         void _GetHTTPSProxy(const ValueList& args, ValueRef result);
+        void _GetProxyStats(const ValueList& args, ValueRef result);
+        void _GetDNSStats(const ValueList& args, ValueRef result);
+        void _ClearDNSCache(const ValueList& args, ValueRef result);
     };
 }
 
@@ -12,6 +12,8 @@
 using namespace TideUtils;
 
 #include "network_module.h"
+#include "protocols/tcp/tcp_socket_reactor.h"
+#include "dns_resolver.h"
 #include <Poco/Mutex.h>
 
 using namespace tide;
@@ -73,6 +75,8 @@ namespace ti
     void NetworkModule::Stop()
     {
         analyticsBinding->Shutdown();
+        DNSResolver::Shutdown();
+        TCPSocketReactor::Shutdown();
     }
 
     /*static*/
@@ -842,6 +842,7 @@ namespace ti
     void HTTPClientBinding::ExecuteRequest()
     {
         struct curl_slist* curlHeaders = 0;
+        struct curl_slist* curlResolve = 0;
         char curlErrorBuffer[CURL_ERROR_SIZE];
 
         try
@@ -874,7 +875,10 @@ namespace ti
                 this->GetString("userAgent").c_str());
 
             curlHeaders = SetRequestHeaders(curlHandle);
-            SetCurlProxySettings(curlHandle, ProxyConfig::GetProxyForURL(url));
+            SharedProxy proxy(ProxyConfig::GetProxyForURL(url));
+            SetCurlProxySettings(curlHandle, proxy);
+            if (proxy.isNull())
+                curlResolve = SetCurlResolvedHost(curlHandle, url);
 
             if (this->timeout > 0)
             {
@@ -900,6 +904,8 @@ namespace ti
                 this->SetObject("responseData", Bytes::Concat(this->responseData));
 
             CleanupCurl(curlHeaders);
+            if (curlResolve)
+                curl_slist_free_all(curlResolve);
 
             this->ChangeState(4); // Done
         }
@@ -909,6 +915,8 @@ namespace ti
             this->url.c_str(), e.ToString().c_str());
 
             this->CleanupCurl(curlHeaders);
+            if (curlResolve)
+                curl_slist_free_all(curlResolve);
             if (!async)
                 throw e;
         }
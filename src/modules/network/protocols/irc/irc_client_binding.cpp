@@ -9,6 +9,7 @@
 #include <tide/tide.h>
 #include <tide/thread_manager.h>
 #include "irc_client_binding.h"
+#include "../../dns_resolver.h"
 #include <cstring>
 
 #ifdef OS_OSX
@@ -167,8 +168,22 @@ namespace ti
         std::string pass = args.at(5)->ToString();
         this->callback = args.at(6)->ToMethod();
 
+        // Resolve through the shared cache. The IRC connection itself
+        // only speaks IPv4, so hand it a dotted address.
+        std::string server;
+        try
+        {
+            Poco::Net::HostEntry entry(DNSResolver::GetInstance().ResolveName(hostname));
+            server = DNSResolver::GetPreferredAddress(entry).toString();
+        }
+        catch (Poco::Exception& e)
+        {
+            throw ValueException::FromFormat("Could not resolve %s: %s",
+                hostname.c_str(), e.displayText().c_str());
+        }
+
         //char* server, int port, char* nick, char* user, char* name, char* pass
-        this->irc.start((char*)hostname.c_str(),
+        this->irc.start((char*)server.c_str(),
                         port,
                         (char*)nick.c_str(),
                         (char*)user.c_str(),
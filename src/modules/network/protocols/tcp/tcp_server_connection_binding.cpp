@@ -15,15 +15,21 @@ namespace ti
         return tide::Logger::Get("Network.TCPServerSocketConnection");
     }
     
-    TCPServerConnectionBinding::TCPServerConnectionBinding(Poco::Net::StreamSocket& s, Poco::Net::SocketReactor & r) :
+    TCPServerConnectionBinding::TCPServerConnectionBinding(Poco::Net::StreamSocket& s, Poco::AutoPtr<TCPServerReactorPool> pool_) :
         StaticBoundObject("Network.TCPServerSocketConnection"),
+        pool(pool_),
         socket(s), 
-        reactor(r),
+        reactor(pool_->NextReactor()),
         closed(false),
         onRead(0),
         onWrite(0),
         onReadComplete(0),
         currentSendDataOffset(0),
+        sendDataLength(0),
+        readBufferUsed(0),
+        readBufferSize(pool_->GetReadBufferSize()),
+        bytesRead(0),
+        bytesWritten(0),
         readStarted(false),
         writeReadyHandlerInstalled(false)
     {
@@ -51,6 +57,14 @@ namespace ti
          */
         this->SetMethod("isClosed",&TCPServerConnectionBinding::IsClosed);
 
+        /**
+         * @tiapi(method=True,name=Network.TCPServerSocketConnection.getStats,since=1.4)
+         * @tiapi Get the traffic counters of this connection.
+         * @tiresult[Object] bytesRead and bytesWritten since the connection was accepted,
+         * @tiresult queuedWrites and queuedBytes waiting to be sent
+         */
+        this->SetMethod("getStats",&TCPServerConnectionBinding::GetStats);
+
         /**
          * @tiapi(method=True,name=Network.TCPServerSocketConnection.onRead,since=1.2)
          * @tiapi Set a callback that will be fired when data is received on the Socket.
@@ -107,14 +121,30 @@ namespace ti
         
         try
         {
+            // Start a new buffer when the current one is nearly full.
+            // Bytes handed out earlier still refer to the old one.
+            size_t freeSpace = this->readBufferSize - this->readBufferUsed;
+            if (this->readBuffer.isNull() || freeSpace < MIN_READ_SPACE)
+            {
+                this->readBuffer = new Bytes(this->readBufferSize);
+                this->readBufferUsed = 0;
+                freeSpace = this->readBufferSize;
+            }
+
             // Always read bytes, so that the tubes get cleared.
-            char data[BUFFER_SIZE + 1];
-            int size = socket.receiveBytes(&data, BUFFER_SIZE);
+            char* data = this->readBuffer->Pointer() + this->readBufferUsed;
+            int size = socket.receiveBytes(data, (int) freeSpace);
 
             // A read is only complete if we've already read some bytes from the socket.
             bool readComplete = this->readStarted && (size <= 0);
             this->readStarted = (size > 0);
 
+            if (size > 0)
+            {
+                Poco::Mutex::ScopedLock lock(sendDataMutex);
+                this->bytesRead += size;
+            }
+
             if (readComplete && !this->onReadComplete.isNull())
             {
                 ValueList args;
@@ -122,9 +152,9 @@ namespace ti
             }
             else if (size > 0 && !this->onRead.isNull())
             {
-                data[size] = '\0';
+                BytesRef bytes(new Bytes(this->readBuffer, this->readBufferUsed, size));
+                this->readBufferUsed += size;
 
-                BytesRef bytes(new Bytes(data, size));
                 ValueList args(Value::NewObject(bytes));
                 RunOnMainThread(this->onRead, args, false);
             }
@@ -189,6 +219,11 @@ namespace ti
         size_t length = buffer->Length() - currentSendDataOffset;
         size_t count = this->socket.sendBytes(data, length);
         currentSendDataOffset += count;
+        {
+            Poco::Mutex::ScopedLock lock(sendDataMutex);
+            bytesWritten += count;
+            sendDataLength -= count;
+        }
 
         if (currentSendDataOffset == (size_t) buffer->Length())
         {
@@ -264,6 +299,7 @@ namespace ti
         {
             Poco::Mutex::ScopedLock lock(sendDataMutex);
             sendData.push(data);
+            sendDataLength += data->Length();
 
             // Only install the ReadyForWrite handler when there is actually data
             // to write, because otherwise the CPU usage will spike to 100%
@@ -301,4 +337,15 @@ namespace ti
     {
         return result->SetBool(this->closed);
     }
+
+    void TCPServerConnectionBinding::GetStats(const ValueList& args, ValueRef result)
+    {
+        TiObjectRef stats(new StaticBoundObject());
+        Poco::Mutex::ScopedLock lock(sendDataMutex);
+        stats->SetDouble("bytesRead", (double) this->bytesRead);
+        stats->SetDouble("bytesWritten", (double) this->bytesWritten);
+        stats->SetInt("queuedWrites", (int) this->sendData.size());
+        stats->SetDouble("queuedBytes", (double) this->sendDataLength);
+        result->SetObject(stats);
+    }
 }
@@ -21,17 +21,20 @@
 
 namespace ti
 {
+    class TCPServerReactorPool;
+
     class TCPServerConnectionBinding : public StaticBoundObject
     {
     public:
-        TCPServerConnectionBinding(Poco::Net::StreamSocket& s, Poco::Net::SocketReactor & reactor_);
+        TCPServerConnectionBinding(Poco::Net::StreamSocket& s, Poco::AutoPtr<TCPServerReactorPool> pool_);
         virtual ~TCPServerConnectionBinding();
 
     private:
         enum
         {
-            BUFFER_SIZE = 1024
+            MIN_READ_SPACE = 128
         };
+        Poco::AutoPtr<TCPServerReactorPool> pool;
         Poco::Net::StreamSocket socket;
         Poco::Net::SocketReactor& reactor;
         bool closed;
@@ -42,6 +45,16 @@ namespace ti
         std::queue<BytesRef> sendData;
         Poco::Mutex sendDataMutex;
         size_t currentSendDataOffset;
+        size_t sendDataLength;
+
+        // Reads are slices of this buffer, which is replaced
+        // once it no longer has room for a useful read.
+        BytesRef readBuffer;
+        size_t readBufferUsed;
+        size_t readBufferSize;
+
+        Poco::UInt64 bytesRead;
+        Poco::UInt64 bytesWritten;
         bool readStarted;
         bool writeReadyHandlerInstalled;
 
@@ -53,6 +66,7 @@ namespace ti
         void Write(const ValueList& args, ValueRef result);
         void Close(const ValueList& args, ValueRef result);
         void IsClosed(const ValueList& args, ValueRef result);
+        void GetStats(const ValueList& args, ValueRef result);
         void SetOnRead(const ValueList& args, ValueRef result);
         void SetOnWrite(const ValueList& args, ValueRef result);
         void SetOnError(const ValueList& args, ValueRef result);
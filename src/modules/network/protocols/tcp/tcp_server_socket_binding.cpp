@@ -10,15 +10,60 @@
 #include "tcp_server_connection_binding.h"
 
 #include <Poco/NObserver.h>
+#include <Poco/Environment.h>
 #include <Poco/Net/SocketNotification.h>
 
+#define DEFAULT_READ_BUFFER_SIZE 64*1024
+#define MIN_READ_BUFFER_SIZE 1024
+#define MAX_READ_BUFFER_SIZE 16*1024*1024
+#define MAX_REACTORS 64
+
 namespace ti
 {
-    
+
+    //////////////////////////////////////////////////////////////////////////////////////////
+
+    TCPServerReactorPool::TCPServerReactorPool(size_t reactorCount, size_t readBufferSize_) :
+        nextReactor(0),
+        readBufferSize(readBufferSize_)
+    {
+        for (size_t i = 0; i < reactorCount; i++)
+        {
+            Poco::Net::SocketReactor* reactor = new Poco::Net::SocketReactor();
+            Poco::Thread* thread = new Poco::Thread();
+            thread->setName("TCPServerReactor");
+            thread->start(*reactor);
+            reactors.push_back(reactor);
+            threads.push_back(thread);
+        }
+    }
+
+    TCPServerReactorPool::~TCPServerReactorPool()
+    {
+        for (size_t i = 0; i < reactors.size(); i++)
+            reactors[i]->stop();
+
+        for (size_t i = 0; i < reactors.size(); i++)
+        {
+            threads[i]->join();
+            delete threads[i];
+            delete reactors[i];
+        }
+    }
+
+    Poco::Net::SocketReactor& TCPServerReactorPool::NextReactor()
+    {
+        Poco::FastMutex::ScopedLock lock(mutex);
+        Poco::Net::SocketReactor* reactor = reactors[nextReactor];
+        nextReactor = (nextReactor + 1) % reactors.size();
+        return *reactor;
+    }
+
     //////////////////////////////////////////////////////////////////////////////////////////
 
-    TCPServerSocketConnector::TCPServerSocketConnector(TiMethodRef callback_, Poco::Net::ServerSocket& socket_, Poco::Net::SocketReactor & reactor_) :
-        callback(callback_),socket(socket_),reactor(reactor_)
+    TCPServerSocketConnector::TCPServerSocketConnector(TiMethodRef callback_, Poco::Net::ServerSocket& socket_, Poco::Net::SocketReactor & reactor_,
+        Poco::AutoPtr<TCPServerReactorPool> pool_) :
+        callback(callback_),socket(socket_),reactor(reactor_),pool(pool_)
     {
         reactor.addEventHandler(socket, Poco::Observer<TCPServerSocketConnector, Poco::Net::ReadableNotification>(*this, &TCPServerSocketConnector::onAccept));
     }
@@ -32,7 +77,7 @@ namespace ti
 
         n->release();
         Poco::Net::StreamSocket sock = socket.acceptConnection();
-        AutoPtr<TCPServerConnectionBinding> conn = new TCPServerConnectionBinding(sock,reactor);
+        AutoPtr<TCPServerConnectionBinding> conn = new TCPServerConnectionBinding(sock,pool);
 
         ValueList args = ValueList();
         args.push_back(Value::NewObject(conn));
@@ -62,6 +107,9 @@ namespace ti
          * @tiapi(method=True,name=Network.TCPServerSocket.listen,since=1.2)
          * @tiapi start listening for incoming connections
          * @tiarg[int, port] port to bind server socket
+         * @tiarg[Object, options, optional=True] reactors: number of threads serving
+         * @tiarg connections (default: one per core, at most 64), readBufferSize:
+         * @tiarg size of the buffer reads are sliced from (1 KB to 16 MB)
          */
         this->SetMethod("listen", &TCPServerSocketBinding::Listen);
 
@@ -83,22 +131,28 @@ namespace ti
 
         listenThread.join();
         delete listenAdapter;
+
+        // Connections which are still open keep the pool running.
+        this->pool = 0;
     }
     
     void TCPServerSocketBinding::ListenThread()
     {
-        this->acceptor = new TCPServerSocketConnector(this->onCreate,*this->socket,this->reactor);
+        this->acceptor = new TCPServerSocketConnector(this->onCreate,*this->socket,this->reactor,this->pool);
         this->listening = true;
 
         while(this->listening)
         {
             this->reactor.run();
         }
+
+        delete this->acceptor;
+        this->acceptor = 0;
     }
     
     void TCPServerSocketBinding::Listen(const ValueList& args, ValueRef result)
     {
-        args.VerifyException("listen", "n");
+        args.VerifyException("listen", "n ?o");
 
         if (this->listening || listenThread.isRunning())
         {
@@ -107,8 +161,32 @@ namespace ti
         
         //TODO: add support for bind ipaddress
         
+        int reactorCount = (int) Poco::Environment::processorCount();
+        int readBufferSize = DEFAULT_READ_BUFFER_SIZE;
+        if (args.size() > 1 && args.at(1)->IsObject())
+        {
+            TiObjectRef options(args.GetObject(1));
+            reactorCount = options->GetInt("reactors", reactorCount);
+            readBufferSize = options->GetInt("readBufferSize", readBufferSize);
+            if (reactorCount <= 0)
+                throw ValueException::FromString("reactors must be greater than zero");
+            if (readBufferSize <= 0)
+                throw ValueException::FromString("readBufferSize must be greater than zero");
+        }
+
+        if (reactorCount < 1)
+            reactorCount = 1;
+        if (reactorCount > MAX_REACTORS)
+            reactorCount = MAX_REACTORS;
+        if (readBufferSize < MIN_READ_BUFFER_SIZE)
+            readBufferSize = MIN_READ_BUFFER_SIZE;
+        if (readBufferSize > MAX_READ_BUFFER_SIZE)
+            readBufferSize = MAX_READ_BUFFER_SIZE;
+
         int port = args.at(0)->ToInt();
         this->socket = new Poco::Net::ServerSocket(port);
+        this->pool = new TCPServerReactorPool((size_t) reactorCount,
+            (size_t) readBufferSize);
 
         listenThread.start(*listenAdapter);
         result->SetBool(true);
@@ -121,6 +199,9 @@ namespace ti
             this->listening = false;
             this->reactor.stop();
             this->socket->close();
+
+            // Stop accepting, but leave open connections running.
+            this->pool = 0;
             result->SetBool(true);
         }
         else
@@ -17,6 +17,8 @@
 #include <Poco/Net/SocketNotification.h>
 #include <Poco/NObserver.h>
 #include <Poco/RunnableAdapter.h>
+#include <Poco/RefCountedObject.h>
+#include <vector>
 #include "tcp_server_connection_binding.h"
 
 /**
@@ -30,16 +32,43 @@
  */
 namespace ti
 {
+    /**
+     * The reactors which serve the connections of one server, each on
+     * its own thread. Connections are spread over them round-robin. The
+     * pool is shared by the server and its connections, and it stops
+     * once the last of them is gone.
+     */
+    class TCPServerReactorPool : public Poco::RefCountedObject
+    {
+    public:
+        TCPServerReactorPool(size_t reactorCount, size_t readBufferSize);
+
+        Poco::Net::SocketReactor& NextReactor();
+        size_t GetReadBufferSize() { return readBufferSize; }
+
+    protected:
+        virtual ~TCPServerReactorPool();
+
+    private:
+        std::vector<Poco::Net::SocketReactor*> reactors;
+        std::vector<Poco::Thread*> threads;
+        size_t nextReactor;
+        size_t readBufferSize;
+        Poco::FastMutex mutex;
+    };
+
     class TCPServerSocketConnector
     {
     public:
-        TCPServerSocketConnector(TiMethodRef callback,Poco::Net::ServerSocket& socket,Poco::Net::SocketReactor& reactor);
+        TCPServerSocketConnector(TiMethodRef callback,Poco::Net::ServerSocket& socket,Poco::Net::SocketReactor& reactor,
+            Poco::AutoPtr<TCPServerReactorPool> pool);
         virtual ~TCPServerSocketConnector();
         void onAccept(Poco::Net::ReadableNotification* pNotification);
     private:
         TiMethodRef callback;
         Poco::Net::ServerSocket& socket;
         Poco::Net::SocketReactor& reactor;
+        Poco::AutoPtr<TCPServerReactorPool> pool;
     };
 
     class TCPServerSocketBinding : public StaticBoundObject
@@ -55,6 +84,7 @@ namespace ti
         TiMethodRef onCreate;
         Poco::Net::ServerSocket* socket;
         Poco::Net::SocketReactor reactor;
+        Poco::AutoPtr<TCPServerReactorPool> pool;
         TCPServerSocketConnector* acceptor;
         Poco::Thread listenThread;
         Poco::RunnableAdapter<TCPServerSocketBinding>* listenAdapter;
@@ -7,32 +7,97 @@
  **/
 
 #include "tcp_socket.h"
+#include "tcp_socket_reactor.h"
+#include "../../dns_resolver.h"
 
-#include <Poco/ThreadPool.h>
-#include <Poco/Timespan.h>
+#include <algorithm>
+
+#include <Poco/Error.h>
+#include <Poco/NObserver.h>
+#include <Poco/Net/NetException.h>
+
+#if defined(OS_WIN32)
+#include <winsock2.h>
+#else
+#include <errno.h>
+#include <sys/uio.h>
+#endif
 
 #define READ_BUFFER_SIZE 40*1024
 #define READ_BUFFER_MIN_SIZE 128
+#define HIGH_WATER_MARK 64*1024
+#define LOW_WATER_MARK 16*1024
+
+// The most buffers handed to the kernel in one vectored write.
+#define MAX_WRITE_BUFFERS 64
+
+using Poco::NObserver;
+using Poco::Net::ReadableNotification;
+using Poco::Net::WritableNotification;
+using Poco::Net::ErrorNotification;
+using Poco::Net::HostEntry;
+using Poco::Net::IPAddress;
+using Poco::Net::SocketAddress;
+using Poco::Net::StreamSocket;
 
 namespace ti
 {
+    class TCPResolveJob : public AsyncJob
+    {
+    public:
+        TCPResolveJob(AutoPtr<TCPSocket> socket, DNSResolver& resolver) :
+            socket(socket),
+            resolver(resolver)
+        {
+        }
+
+    protected:
+        virtual ValueRef Execute()
+        {
+            this->socket->ResolveAndConnect(this->resolver);
+            return Value::Undefined;
+        }
+
+    private:
+        AutoPtr<TCPSocket> socket;
+        DNSResolver& resolver;
+    };
+
     TCPSocket::TCPSocket(std::string& host, int port) :
         EventObject("Network.TCPSocket"),
-        address(host, port),
-        socket(address.family()),
+        host(host),
+        port(port),
         state(CLOSED),
-        reader(*this, &TCPSocket::ReadThread),
-        writer(*this, &TCPSocket::WriteThread)
+        writeOffset(0),
+        bufferedAmount(0),
+        highWaterMark(HIGH_WATER_MARK),
+        lowWaterMark(LOW_WATER_MARK),
+        needDrain(false),
+        readBufferUsed(0),
+        readBufferSize(READ_BUFFER_SIZE),
+        receiveBufferSize(0),
+        keepAlive(false),
+        paused(false),
+        readHandlerInstalled(false),
+        writeHandlerInstalled(false),
+        timeout(0)
     {
         SetMethod("connect", &TCPSocket::_Connect);
         SetMethod("setTimeout", &TCPSocket::_SetTimeout);
         SetMethod("close", &TCPSocket::_Close);
         SetMethod("isClosed", &TCPSocket::_IsClosed);
         SetMethod("write", &TCPSocket::_Write);
+        SetMethod("pause", &TCPSocket::_Pause);
+        SetMethod("resume", &TCPSocket::_Resume);
+        SetMethod("isPaused", &TCPSocket::_IsPaused);
+        SetMethod("setReceiveBufferSize", &TCPSocket::_SetReceiveBufferSize);
+        SetMethod("setWriteWatermarks", &TCPSocket::_SetWriteWatermarks);
+        SetMethod("getBufferedAmount", &TCPSocket::_GetBufferedAmount);
         SetMethod("onRead", &TCPSocket::_OnRead);
         SetMethod("onReadComplete", &TCPSocket::_OnReadComplete);
         SetMethod("onError", &TCPSocket::_OnError);
         SetMethod("onTimeout", &TCPSocket::_OnTimeout);
+        SetMethod("onDrain", &TCPSocket::_OnDrain);
     }
 
     TCPSocket::~TCPSocket()
@@ -41,62 +106,245 @@ namespace ti
 
     void TCPSocket::Connect()
     {
-        Poco::FastMutex::ScopedLock lock(this->mutex);
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+
+            if (this->state != CLOSED)
+                throw ValueException::FromString("socket is already connected");
+
+            TCPSocketReactor* reactor = TCPSocketReactor::GetInstance();
+            if (!reactor)
+                throw ValueException::FromString("the network module has been shut down");
+
+            this->state = CONNECTING;
+            this->self = TiObjectRef(this, true);
+            this->lastActivity.update();
+            if (this->timeout > 0)
+                reactor->AddTimeout(this);
+        }
+
+        // Only wait for the resolver when the answer isn't at hand.
+        DNSResolver& resolver(DNSResolver::GetInstance());
+        IPAddress address;
+        HostEntry entry;
+        try
+        {
+            if (IPAddress::tryParse(this->host, address))
+            {
+                this->ConnectTo(SocketAddress(address, this->port));
+                return;
+            }
+            if (resolver.GetCachedName(this->host, entry))
+            {
+                this->ConnectTo(SocketAddress(
+                    DNSResolver::GetPreferredAddress(entry), this->port));
+                return;
+            }
+        }
+        catch (Poco::Exception& e)
+        {
+            HandleError(e);
+            return;
+        }
+
+        resolver.Enqueue(new TCPResolveJob(AutoPtr<TCPSocket>(this, true), resolver));
+    }
+
+    void TCPSocket::ResolveAndConnect(DNSResolver& resolver)
+    {
+        // No events are fired from here. Dispatching one waits for the
+        // main thread, which may itself be waiting for the resolver to
+        // shut down, so the outcome is handed to the main thread instead.
+        ValueList args(Value::NewObject(TiObjectRef(this, true)));
+        try
+        {
+            HostEntry entry(resolver.ResolveName(this->host));
+            args.push_back(Value::NewString(
+                DNSResolver::GetPreferredAddress(entry).toString()));
+        }
+        catch (Poco::Exception& e)
+        {
+            args.push_back(Value::Null);
+            args.push_back(Value::NewString(e.what()));
+        }
+
+        RunOnMainThread(new FunctionPtrMethod(&TCPSocket::ConnectResolved), args, false);
+    }
+
+    /*static*/
+    ValueRef TCPSocket::ConnectResolved(const ValueList& args)
+    {
+        AutoPtr<TCPSocket> socket(args.GetObject(0).cast<TCPSocket>());
+        if (args.at(1)->IsString())
+        {
+            socket->ConnectTo(SocketAddress(
+                IPAddress(args.GetString(1)), socket->port));
+        }
+        else
+        {
+            socket->HandleError(args.GetString(2));
+        }
+        return Value::Undefined;
+    }
+
+    void TCPSocket::ConnectTo(const SocketAddress& address)
+    {
+        try
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
 
-        if (this->state != CLOSED)
-            throw ValueException::FromString("socket is already connected");
+            // The socket may have been closed while its host was resolved.
+            if (this->state != CONNECTING)
+                return;
 
-        // Start up the reading thread.
-        // This thread will establish the connection
-        // and then begin reading data from the socket.
-        this->state = CONNECTING;
-        this->readThread.start(reader);
+            this->socket = StreamSocket(address.family());
+            if (this->receiveBufferSize > 0)
+                this->socket.setReceiveBufferSize((int) this->receiveBufferSize);
+            if (this->keepAlive)
+                this->socket.setKeepAlive(true);
+
+            // Begin a non-blocking connect. The reactor reports the socket
+            // as writable once the connection is established, or as in
+            // error if it failed.
+            this->socket.connectNB(address);
+
+            TCPSocketReactor* reactor = TCPSocketReactor::GetInstance();
+            if (!reactor)
+                throw Poco::IOException("the network module has been shut down");
+            reactor->addEventHandler(this->socket,
+                NObserver<TCPSocket, ErrorNotification>(*this, &TCPSocket::OnError));
+            this->InstallWriteHandler(true);
+        }
+        catch (Poco::Exception& e)
+        {
+            HandleError(e);
+        }
     }
 
     bool TCPSocket::Close()
     {
+        // The reactor may hold the last reference to this socket.
+        TiObjectRef save(this, true);
+
         {
             Poco::FastMutex::ScopedLock lock(this->mutex);
 
             if (this->state == CLOSED)
                 return false;
 
+            TCPSocketReactor* reactor = TCPSocketReactor::GetInstance();
+            if (!this->self.isNull() && reactor)
+            {
+                this->InstallReadHandler(false);
+                this->InstallWriteHandler(false);
+                reactor->removeEventHandler(this->socket,
+                    NObserver<TCPSocket, ErrorNotification>(*this, &TCPSocket::OnError));
+                reactor->RemoveTimeout(this);
+            }
+
             this->socket.close();
             this->state = CLOSED;
 
             // Delete any remaining buffers in write queue.
-            this->writeQueue = std::queue<BytesRef>();
+            this->writeQueue.clear();
+            this->writeOffset = 0;
+            this->bufferedAmount = 0;
+            this->needDrain = false;
+            this->self = 0;
         }
 
         FireEvent("close");
         return true;
     }
 
-    void TCPSocket::Write(BytesRef data)
+    bool TCPSocket::Write(BytesRef data)
     {
-        Poco::FastMutex::ScopedLock lock(this->mutex);
-        if (this->state != DUPLEX && this->state != WRITEONLY)
-            throw ValueException::FromString("Socket is not writable");
+        try
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            if (this->state != DUPLEX && this->state != WRITEONLY)
+                throw ValueException::FromString("Socket is not writable");
+
+            if (data->Length() > 0)
+            {
+                this->writeQueue.push_back(data);
+                this->bufferedAmount += data->Length();
 
-        if (this->writeQueue.empty())
+                // Nothing else is waiting to be sent, so try to send this
+                // right away and only involve the reactor if it won't fit.
+                if (!this->writeHandlerInstalled && !this->Flush())
+                    this->InstallWriteHandler(true);
+            }
+
+            if (this->bufferedAmount < this->highWaterMark)
+                return true;
+
+            this->needDrain = true;
+            return false;
+        }
+        catch (Poco::Exception& e)
         {
-            Poco::ThreadPool::defaultPool().start(this->writer);
+            HandleError(e);
+            return false;
         }
+    }
 
-        this->writeQueue.push(data);
+    void TCPSocket::Pause()
+    {
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        this->paused = true;
+        this->InstallReadHandler(false);
+    }
+
+    void TCPSocket::Resume()
+    {
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        this->paused = false;
+        if (this->state == DUPLEX || this->state == READONLY)
+            this->InstallReadHandler(true);
     }
 
     void TCPSocket::SetKeepAlive(bool enable)
     {
-        this->socket.setKeepAlive(enable);
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        this->keepAlive = enable;
+        if (this->socket.impl()->sockfd() != POCO_INVALID_SOCKET)
+            this->socket.setKeepAlive(enable);
     }
 
     void TCPSocket::SetTimeout(long milliseconds)
     {
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        this->timeout = milliseconds;
+        this->lastActivity.update();
+
+        TCPSocketReactor* reactor = TCPSocketReactor::GetInstance();
+        if (this->self.isNull() || !reactor)
+            return;
+
+        if (milliseconds > 0)
+            reactor->AddTimeout(this);
+        else
+            reactor->RemoveTimeout(this);
+    }
+
+    void TCPSocket::SetReceiveBufferSize(size_t size)
+    {
+        if (size < READ_BUFFER_MIN_SIZE)
+            size = READ_BUFFER_MIN_SIZE;
+
         try
         {
-            Poco::Timespan t(0, milliseconds * 1000);
-            this->socket.setReceiveTimeout(t);
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            this->readBufferSize = size;
+            this->readBuffer = 0;
+            this->readBufferUsed = 0;
+            this->receiveBufferSize = size;
+
+            // Before the host is resolved there is no socket yet, and
+            // the size is applied once there is.
+            if (this->socket.impl()->sockfd() != POCO_INVALID_SOCKET)
+                this->socket.setReceiveBufferSize((int) size);
         }
         catch (Poco::Exception& e)
         {
@@ -104,18 +352,80 @@ namespace ti
         }
     }
 
-    void TCPSocket::ReadThread()
+    void TCPSocket::SetWriteWatermarks(size_t high, size_t low)
+    {
+        if (low > high)
+            throw ValueException::FromString(
+                "Low water mark must not be above the high water mark");
+
+        bool drained = false;
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            this->highWaterMark = high;
+            this->lowWaterMark = low;
+            if (this->needDrain && this->bufferedAmount <= low)
+            {
+                this->needDrain = false;
+                drained = true;
+            }
+        }
+
+        if (drained)
+            FireEvent("drain");
+    }
+
+    void TCPSocket::CheckTimeout(const Poco::Timestamp& now)
     {
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            if (this->timeout <= 0 || this->state == CLOSED)
+                return;
+            if (now - this->lastActivity < (Poco::Timestamp::TimeDiff) this->timeout * 1000)
+                return;
+
+            this->lastActivity = now;
+        }
+
+        FireEvent("timeout");
+    }
+
+    void TCPSocket::OnReadable(const Poco::AutoPtr<ReadableNotification>& n)
+    {
+        BytesRef data;
+        bool ended = false;
+
         try
         {
-            this->socket.connect(this->address);
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            if (!this->readHandlerInstalled)
+                return;
 
+            // Re-allocate a new read buffer if the current
+            // one has become too small. Data events hold slices
+            // of the old buffer, so it can't be reused.
+            size_t freeSpace = this->readBufferSize - this->readBufferUsed;
+            if (this->readBuffer.isNull() || freeSpace < READ_BUFFER_MIN_SIZE)
             {
-                Poco::FastMutex::ScopedLock lock(this->mutex);
-                this->state = DUPLEX;
+                this->readBuffer = new Bytes(this->readBufferSize);
+                this->readBufferUsed = 0;
+                freeSpace = this->readBufferSize;
             }
 
-            FireEvent("connect");
+            char* bufferPtr = this->readBuffer->Pointer() + this->readBufferUsed;
+            int bytesRecv = this->socket.receiveBytes(bufferPtr, (int) freeSpace);
+            if (bytesRecv > 0)
+            {
+                data = new Bytes(this->readBuffer, this->readBufferUsed, bytesRecv);
+                this->readBufferUsed += bytesRecv;
+                this->lastActivity.update();
+            }
+            else if (bytesRecv == 0)
+            {
+                // Remote host sent FIN, we are now write only.
+                this->state = WRITEONLY;
+                this->InstallReadHandler(false);
+                ended = true;
+            }
         }
         catch (Poco::Exception& e)
         {
@@ -123,94 +433,197 @@ namespace ti
             return;
         }
 
-        BytesRef buffer = new Bytes(READ_BUFFER_SIZE);
-        size_t usedSpace = 0;
+        if (!data.isNull())
+            FireEvent("data", ValueList(Value::NewObject(data)));
+        else if (ended)
+            FireEvent("end");
+    }
+
+    void TCPSocket::OnWritable(const Poco::AutoPtr<WritableNotification>& n)
+    {
+        bool connected = false;
+        bool drained = false;
 
-        while (true)
+        try
         {
-            // Re-allocate a new read buffer if the current
-            // one has become too small.
-            int freeSpace = READ_BUFFER_SIZE - usedSpace;
-            if (freeSpace < READ_BUFFER_MIN_SIZE)
-            {
-                buffer = new Bytes(READ_BUFFER_SIZE);
-                usedSpace = 0;
-                freeSpace = READ_BUFFER_SIZE;
-            }
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            if (!this->writeHandlerInstalled)
+                return;
 
-            // Attempt to read data from socket into buffer.
-            try
+            if (this->state == CONNECTING)
             {
-                char* bufferPtr = buffer->Pointer() + usedSpace;
-                int bytesRecv = this->socket.receiveBytes(bufferPtr, freeSpace);
-                if (bytesRecv > 0)
-                {
-                    BytesRef data = new Bytes(buffer, usedSpace, bytesRecv);
-                    usedSpace += bytesRecv;
-                    this->FireEvent("data", ValueList(Value::NewObject(data)));
-                }
-                else
-                {
-                    // Remote host sent FIN, we are now write only.
-                    {
-                        Poco::FastMutex::ScopedLock lock(this->mutex);
-                        this->state = WRITEONLY;
-                    }
-
-                    FireEvent("end");
-                    return;
-                }
+                this->FinishConnect();
+                connected = true;
             }
-            catch (Poco::TimeoutException& e)
+            else if (this->Flush())
             {
-                this->FireEvent("timeout");
+                this->InstallWriteHandler(false);
             }
-            catch (Poco::Exception& e)
+
+            if (this->needDrain && this->bufferedAmount <= this->lowWaterMark)
             {
-                HandleError(e);
-                return;
+                this->needDrain = false;
+                drained = true;
             }
         }
+        catch (Poco::Exception& e)
+        {
+            HandleError(e);
+            return;
+        }
+
+        if (connected)
+            FireEvent("connect");
+        if (drained)
+            FireEvent("drain");
+    }
+
+    void TCPSocket::OnError(const Poco::AutoPtr<ErrorNotification>& n)
+    {
+        try
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            if (this->state == CLOSED || this->state == CLOSING)
+                return;
+
+            int error = this->socket.impl()->socketError();
+            throw Poco::Net::NetException(Poco::Error::getMessage(error), error);
+        }
+        catch (Poco::Exception& e)
+        {
+            HandleError(e);
+        }
     }
 
-    void TCPSocket::WriteThread()
+    bool TCPSocket::FinishConnect()
     {
-        this->mutex.lock();
+        int error = this->socket.impl()->socketError();
+        if (error != 0)
+            throw Poco::Net::NetException(Poco::Error::getMessage(error), error);
+
+        this->state = DUPLEX;
+        this->lastActivity.update();
+        this->InstallWriteHandler(false);
+        if (!this->paused)
+            this->InstallReadHandler(true);
+        return true;
+    }
+
+    bool TCPSocket::Flush()
+    {
+        // Send as much of the write queue as the socket will take without
+        // blocking. Small writes queued while the socket was busy go out
+        // together in one system call. Returns true once the queue is empty.
         while (!this->writeQueue.empty())
         {
-            BytesRef data = this->writeQueue.front();
-            char* buffer = data->Pointer();
-            size_t remaining = data->Length();
+            size_t count = std::min(this->writeQueue.size(), (size_t) MAX_WRITE_BUFFERS);
+            size_t offset = this->writeOffset;
+            long sent;
 
-            // Release lock while sending data to avoid blocking write().
-            this->mutex.unlock();
-            while (true)
+#if defined(OS_WIN32)
+            WSABUF buffers[MAX_WRITE_BUFFERS];
+            for (size_t i = 0; i < count; i++)
             {
-                try
-                {
-                    size_t sent = this->socket.sendBytes(buffer, remaining);
-                    if (sent == remaining) break;
+                BytesRef data(this->writeQueue[i]);
+                buffers[i].buf = data->Pointer() + offset;
+                buffers[i].len = (ULONG) (data->Length() - offset);
+                offset = 0;
+            }
 
-                    buffer += sent;
-                    remaining -= sent;
-                }
-                catch (Poco::Exception& e)
+            DWORD bytesSent = 0;
+            if (WSASend(this->socket.impl()->sockfd(), buffers, (DWORD) count,
+                &bytesSent, 0, 0, 0) == SOCKET_ERROR)
+            {
+                int error = WSAGetLastError();
+                if (error == WSAEWOULDBLOCK)
+                    return false;
+                throw Poco::Net::NetException(Poco::Error::getMessage(error), error);
+            }
+            sent = (long) bytesSent;
+#else
+            struct iovec buffers[MAX_WRITE_BUFFERS];
+            for (size_t i = 0; i < count; i++)
+            {
+                BytesRef data(this->writeQueue[i]);
+                buffers[i].iov_base = data->Pointer() + offset;
+                buffers[i].iov_len = data->Length() - offset;
+                offset = 0;
+            }
+
+            sent = (long) writev(this->socket.impl()->sockfd(), buffers, (int) count);
+            if (sent < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    return false;
+                throw Poco::Net::NetException(Poco::Error::getMessage(errno), errno);
+            }
+#endif
+
+            this->bufferedAmount -= sent;
+            this->lastActivity.update();
+
+            // Drop every buffer that was written completely and
+            // remember how far into the next one we got.
+            while (sent > 0)
+            {
+                size_t remaining = this->writeQueue.front()->Length() - this->writeOffset;
+                if ((size_t) sent < remaining)
                 {
-                    HandleError(e);
-                    return;
+                    this->writeOffset += sent;
+                    break;
                 }
-            }
 
-            this->mutex.lock();
-            this->writeQueue.pop();
+                sent -= (long) remaining;
+                this->writeQueue.pop_front();
+                this->writeOffset = 0;
+            }
         }
 
-        // Notify listeners we have fully drained the queue.
-        this->mutex.unlock();
-        FireEvent("drain");
+        return true;
+    }
+
+    void TCPSocket::InstallReadHandler(bool install)
+    {
+        if (install == this->readHandlerInstalled)
+            return;
+
+        TCPSocketReactor* reactor = TCPSocketReactor::GetInstance();
+        if (!reactor)
+            return;
+
+        NObserver<TCPSocket, ReadableNotification> observer(*this, &TCPSocket::OnReadable);
+        if (install)
+            reactor->addEventHandler(this->socket, observer);
+        else
+            reactor->removeEventHandler(this->socket, observer);
+        this->readHandlerInstalled = install;
+    }
+
+    void TCPSocket::InstallWriteHandler(bool install)
+    {
+        if (install == this->writeHandlerInstalled)
+            return;
+
+        TCPSocketReactor* reactor = TCPSocketReactor::GetInstance();
+        if (!reactor)
+            return;
+
+        NObserver<TCPSocket, WritableNotification> observer(*this, &TCPSocket::OnWritable);
+        if (install)
+            reactor->addEventHandler(this->socket, observer);
+        else
+            reactor->removeEventHandler(this->socket, observer);
+        this->writeHandlerInstalled = install;
     }
 
     void TCPSocket::HandleError(Poco::Exception& e)
+    {
+        this->HandleError(std::string(e.what()));
+    }
+
+    void TCPSocket::HandleError(const std::string& message)
     {
         {
             Poco::FastMutex::ScopedLock lock(this->mutex);
@@ -219,7 +632,7 @@ namespace ti
             this->state = CLOSING;
         }
 
-        FireErrorEvent(e);
+        FireEvent("error", ValueList(Value::NewString(message)));
         Close();
     }
 
@@ -264,7 +677,50 @@ namespace ti
             }
         }
 
-        Write(data);
+        result->SetBool(Write(data));
+    }
+
+    void TCPSocket::_Pause(const ValueList& args, ValueRef result)
+    {
+        Pause();
+    }
+
+    void TCPSocket::_Resume(const ValueList& args, ValueRef result)
+    {
+        Resume();
+    }
+
+    void TCPSocket::_IsPaused(const ValueList& args, ValueRef result)
+    {
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        result->SetBool(this->paused);
+    }
+
+    void TCPSocket::_SetReceiveBufferSize(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("setReceiveBufferSize", "n");
+        double size = args.GetNumber(0);
+        if (size <= 0)
+            throw ValueException::FromString("Buffer size must be positive");
+        SetReceiveBufferSize((size_t) size);
+    }
+
+    void TCPSocket::_SetWriteWatermarks(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("setWriteWatermarks", "n ?n");
+        double high = args.GetNumber(0);
+        if (high <= 0)
+            throw ValueException::FromString("High water mark must be positive");
+        double low = args.GetNumber(1, high / 4);
+        if (low < 0)
+            throw ValueException::FromString("Low water mark must not be negative");
+        SetWriteWatermarks((size_t) high, (size_t) low);
+    }
+
+    void TCPSocket::_GetBufferedAmount(const ValueList& args, ValueRef result)
+    {
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        result->SetDouble((double) this->bufferedAmount);
     }
 
     void TCPSocket::_OnRead(const ValueList& args, ValueRef result)
@@ -290,4 +746,10 @@ namespace ti
         args.VerifyException("onTimeout", "m");
         AddEventListener("timeout", args.GetMethod(0));
     }
+
+    void TCPSocket::_OnDrain(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("onDrain", "m");
+        AddEventListener("drain", args.GetMethod(0));
+    }
 }
@@ -9,17 +9,32 @@
 #ifndef _TINET_TCP_SOCKET_H_
 #define _TINET_TCP_SOCKET_H_
 
-#include <queue>
+#include <deque>
 #include <string>
 
+#include <Poco/Net/SocketAddress.h>
 #include <Poco/Net/StreamSocket.h>
-#include <Poco/Thread.h>
+#include <Poco/Net/SocketNotification.h>
 #include <Poco/Mutex.h>
+#include <Poco/Timestamp.h>
 
 #include <tide/tide.h>
 
 namespace ti
 {
+    /**
+     * A client TCP connection. All sockets are driven by the shared
+     * TCPSocketReactor instead of a thread of their own. Writes are
+     * sent immediately when the socket can take them, and otherwise
+     * queued and sent together with a single vectored write once it
+     * becomes writable again.
+     *
+     * Host names are looked up through the shared DNSResolver. When the
+     * answer is not already cached, the lookup runs on a resolver thread
+     * and the connection is started once the main thread has the answer.
+     */
+    class DNSResolver;
+
     class TCPSocket : public EventObject
     {
     public:
@@ -28,32 +43,83 @@ namespace ti
 
         void Connect();
         bool Close();
-        void Write(BytesRef data);
+
+        // Queue data for sending. Returns false once more than the
+        // high water mark is buffered, in which case a drain event
+        // follows when the buffer falls to the low water mark.
+        bool Write(BytesRef data);
+
+        void Pause();
+        void Resume();
         void SetKeepAlive(bool enable);
         void SetTimeout(long milliseconds);
+        void SetReceiveBufferSize(size_t size);
+        void SetWriteWatermarks(size_t high, size_t low);
 
-        void ReadThread();
-        void WriteThread();
+        // Called by the reactor to fire timeout events.
+        void CheckTimeout(const Poco::Timestamp& now);
+
+        // Called on a resolver thread to look up the host. Connecting,
+        // or reporting the failure, happens on the main thread.
+        void ResolveAndConnect(DNSResolver& resolver);
 
     private:
+        void ConnectTo(const Poco::Net::SocketAddress& address);
+        static ValueRef ConnectResolved(const ValueList& args);
+        void OnReadable(const Poco::AutoPtr<Poco::Net::ReadableNotification>& n);
+        void OnWritable(const Poco::AutoPtr<Poco::Net::WritableNotification>& n);
+        void OnError(const Poco::AutoPtr<Poco::Net::ErrorNotification>& n);
+
+        bool FinishConnect();
+        bool Flush();
+        void InstallReadHandler(bool install);
+        void InstallWriteHandler(bool install);
         void HandleError(Poco::Exception& e);
+        void HandleError(const std::string& message);
 
         void _Connect(const ValueList& args, ValueRef result);
         void _SetTimeout(const ValueList& args, ValueRef result);
         void _Close(const ValueList& args, ValueRef result);
         void _IsClosed(const ValueList& args, ValueRef result);
         void _Write(const ValueList& args, ValueRef result);
+        void _Pause(const ValueList& args, ValueRef result);
+        void _Resume(const ValueList& args, ValueRef result);
+        void _IsPaused(const ValueList& args, ValueRef result);
+        void _SetReceiveBufferSize(const ValueList& args, ValueRef result);
+        void _SetWriteWatermarks(const ValueList& args, ValueRef result);
+        void _GetBufferedAmount(const ValueList& args, ValueRef result);
         void _OnRead(const ValueList& args, ValueRef result);
         void _OnReadComplete(const ValueList& args, ValueRef result);
         void _OnError(const ValueList& args, ValueRef result);
         void _OnTimeout(const ValueList& args, ValueRef result);
+        void _OnDrain(const ValueList& args, ValueRef result);
 
-        Poco::Net::SocketAddress address;
+        std::string host;
+        int port;
         Poco::Net::StreamSocket socket;
         enum { CONNECTING, READONLY, WRITEONLY, DUPLEX, CLOSING, CLOSED } state;
-        Poco::Thread readThread;
-        Poco::RunnableAdapter<TCPSocket> reader, writer;
-        std::queue<BytesRef> writeQueue;
+
+        // Keeps this socket alive while it is registered with the reactor.
+        TiObjectRef self;
+
+        std::deque<BytesRef> writeQueue;
+        size_t writeOffset;
+        size_t bufferedAmount;
+        size_t highWaterMark;
+        size_t lowWaterMark;
+        bool needDrain;
+
+        BytesRef readBuffer;
+        size_t readBufferUsed;
+        size_t readBufferSize;
+        size_t receiveBufferSize;
+
+        bool keepAlive;
+        bool paused;
+        bool readHandlerInstalled;
+        bool writeHandlerInstalled;
+        long timeout;
+        Poco::Timestamp lastActivity;
         Poco::FastMutex mutex;
     };
 }
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include "tcp_socket_reactor.h"
+#include "tcp_socket.h"
+
+#include <vector>
+
+#include <Poco/Timespan.h>
+
+// How long the reactor waits for socket events before checking
+// timeouts and picking up newly registered sockets.
+#define REACTOR_TIMEOUT_MS 50
+
+namespace ti
+{
+    TCPSocketReactor* TCPSocketReactor::instance = 0;
+    bool TCPSocketReactor::shutDown = false;
+    Poco::FastMutex TCPSocketReactor::instanceMutex;
+
+    /*static*/
+    TCPSocketReactor* TCPSocketReactor::GetInstance()
+    {
+        Poco::FastMutex::ScopedLock lock(instanceMutex);
+        if (!instance && !shutDown)
+        {
+            instance = new TCPSocketReactor();
+            instance->thread.setName("TCPSocketReactor");
+            instance->thread.start(*instance);
+        }
+        return instance;
+    }
+
+    /*static*/
+    void TCPSocketReactor::Shutdown()
+    {
+        Poco::FastMutex::ScopedLock lock(instanceMutex);
+        shutDown = true;
+        if (!instance)
+            return;
+
+        instance->stop();
+        instance->thread.join();
+        delete instance;
+        instance = 0;
+    }
+
+    TCPSocketReactor::TCPSocketReactor() :
+        Poco::Net::SocketReactor(Poco::Timespan(0, REACTOR_TIMEOUT_MS * 1000))
+    {
+    }
+
+    void TCPSocketReactor::AddTimeout(TCPSocket* socket)
+    {
+        Poco::FastMutex::ScopedLock lock(this->timeoutMutex);
+        this->timeouts.insert(socket);
+    }
+
+    void TCPSocketReactor::RemoveTimeout(TCPSocket* socket)
+    {
+        Poco::FastMutex::ScopedLock lock(this->timeoutMutex);
+        this->timeouts.erase(socket);
+    }
+
+    void TCPSocketReactor::onTimeout()
+    {
+        Poco::Net::SocketReactor::onTimeout();
+        this->CheckTimeouts();
+    }
+
+    void TCPSocketReactor::onBusy()
+    {
+        Poco::Net::SocketReactor::onBusy();
+        this->CheckTimeouts();
+    }
+
+    void TCPSocketReactor::onIdle()
+    {
+        Poco::Net::SocketReactor::onIdle();
+        this->CheckTimeouts();
+    }
+
+    void TCPSocketReactor::CheckTimeouts()
+    {
+        Poco::Timestamp now;
+        if (now - this->lastCheck < REACTOR_TIMEOUT_MS * 1000)
+            return;
+        this->lastCheck = now;
+
+        // Hold a reference to each socket, so that one closed by a
+        // timeout handler stays alive until the check is done.
+        std::vector<AutoPtr<TCPSocket> > sockets;
+        {
+            Poco::FastMutex::ScopedLock lock(this->timeoutMutex);
+            std::set<TCPSocket*>::iterator i = this->timeouts.begin();
+            while (i != this->timeouts.end())
+                sockets.push_back(AutoPtr<TCPSocket>(*i++, true));
+        }
+
+        for (size_t i = 0; i < sockets.size(); i++)
+            sockets[i]->CheckTimeout(now);
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _TINET_TCP_SOCKET_REACTOR_H_
+#define _TINET_TCP_SOCKET_REACTOR_H_
+
+#include <set>
+
+#include <Poco/Net/SocketReactor.h>
+#include <Poco/Thread.h>
+#include <Poco/Mutex.h>
+#include <Poco/Timestamp.h>
+
+namespace ti
+{
+    class TCPSocket;
+
+    /**
+     * The reactor shared by all Network.TCPSockets. It runs on a single
+     * thread, which is started on first use. Poco only reports timeouts
+     * when every socket is idle, so this reactor also checks the read
+     * timeouts of each socket after every pass through its loop.
+     */
+    class TCPSocketReactor : public Poco::Net::SocketReactor
+    {
+    public:
+        // Returns null once the reactor has been shut down, so that
+        // sockets closed during exit do not start it again.
+        static TCPSocketReactor* GetInstance();
+        static void Shutdown();
+
+        void AddTimeout(TCPSocket* socket);
+        void RemoveTimeout(TCPSocket* socket);
+
+    protected:
+        virtual void onTimeout();
+        virtual void onBusy();
+        virtual void onIdle();
+
+    private:
+        TCPSocketReactor();
+        void CheckTimeouts();
+
+        Poco::Thread thread;
+        Poco::FastMutex timeoutMutex;
+        std::set<TCPSocket*> timeouts;
+        Poco::Timestamp lastCheck;
+
+        static TCPSocketReactor* instance;
+        static bool shutDown;
+        static Poco::FastMutex instanceMutex;
+    };
+}
+
+#endif
@@ -33,9 +33,12 @@ namespace ti
         delete writeThreadAdapter;
     }
 
-    void NativePipe::StopMonitors()
+    void NativePipe::StopMonitors(bool wait)
     {
         closed = true;
+        if (!wait)
+            return;
+
         try
         {
             if (readThread.isRunning())
@@ -50,6 +53,11 @@ namespace ti
         }
     }
 
+    bool NativePipe::IsMonitoring()
+    {
+        return readThread.isRunning() || writeThread.isRunning();
+    }
+
     void NativePipe::Close()
     {
         if (!isReader)
@@ -23,7 +23,9 @@ namespace ti
         ~NativePipe();
         void StartMonitor();
         void StartMonitor(TiMethodRef readCallback);
-        virtual void StopMonitors();
+        // Tell the monitor threads to finish, and optionally wait for them.
+        virtual void StopMonitors(bool wait=true);
+        bool IsMonitoring();
         virtual int Write(BytesRef bytes);
         void PollForWriteIteration();
         virtual void Close();
@@ -52,7 +52,9 @@ namespace ti
          * @tiapi Attach an IO object to this pipe. An IO object is an object that
          * @tiapi implements a public "write(Bytes)". In Ti, this include
          * @tiapi FileStreams, and Pipes. You may also use your own custom IO implementation
-         * @tiapi here.
+         * @tiapi here. When the output of a process is attached to the input of
+         * @tiapi another process which is already running, the data is passed from
+         * @tiapi one process to the other by the operating system instead.
          */
         SetMethod("attach", &Pipe::_Attach);
         
@@ -109,6 +111,18 @@ namespace ti
         return attachedObjects.size() > 0;
     }
 
+    std::vector<TiObjectRef> Pipe::GetAttachedObjects()
+    {
+        Poco::Mutex::ScopedLock lock(attachedMutex);
+        return attachedObjects;
+    }
+
+    void Pipe::SetNativeLink(TiObjectRef object)
+    {
+        Poco::Mutex::ScopedLock lock(attachedMutex);
+        nativeLink = object;
+    }
+
     int Pipe::FindFirstLineFeed(char *data, int length, int *charsToErase)
     {
         int newline = -1;
@@ -207,7 +221,8 @@ namespace ti
             Poco::Mutex::ScopedLock lock(attachedMutex);
             for (size_t i = 0; i < attachedObjects.size(); i++)
             {
-                this->CallWrite(attachedObjects.at(i), bytes);
+                if (attachedObjects.at(i).get() != nativeLink.get())
+                    this->CallWrite(attachedObjects.at(i), bytes);
             }
         }
 
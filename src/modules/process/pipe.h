@@ -32,6 +32,12 @@ namespace ti
         void Attach(TiObjectRef object);
         void Detach(TiObjectRef object);
         bool IsAttached();
+        std::vector<TiObjectRef> GetAttachedObjects();
+
+        // Mark an attached object as receiving this pipe's data directly
+        // from the kernel, so that Write no longer copies data to it.
+        // It is still closed along with this pipe.
+        void SetNativeLink(TiObjectRef object);
         AutoPipe Clone();
         std::vector<BytesRef> readData;
         static void FireEventAsynchronously(AutoPtr<Event> event);
@@ -47,6 +53,7 @@ namespace ti
         void _Flush(const ValueList& args, ValueRef result);
         Poco::Mutex attachedMutex;
         std::vector<TiObjectRef> attachedObjects;
+        TiObjectRef nativeLink;
         Logger *logger;
     };
 }
@@ -0,0 +1,286 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include "posix_child_reaper.h"
+#include "posix_process.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(OS_LINUX)
+# include <sys/epoll.h>
+# include <sys/syscall.h>
+#endif
+
+// How often children without a pidfd are polled, and how often a
+// reaped child is checked for its pipe monitors having finished.
+#define REAPER_POLL_INTERVAL_MS 50
+
+#define MAX_EPOLL_EVENTS 64
+
+namespace ti
+{
+    PosixChildReaper* PosixChildReaper::instance = 0;
+    Poco::FastMutex PosixChildReaper::instanceMutex;
+
+    // Exit events are run on the main thread by a plain function rather
+    // than a method of the reaper, since a batch may still be queued when
+    // Shutdown deletes the reaper.
+    static ValueRef DeliverExits(const ValueList& args)
+    {
+        for (size_t i = 0; i < args.size(); i++)
+        {
+            AutoPtr<PosixProcess> process(args.at(i)->ToMethod().cast<PosixProcess>());
+            if (!process.isNull())
+                process->ExitCallback(ValueList(), Value::Undefined);
+        }
+        return Value::Undefined;
+    }
+
+    /*static*/
+    PosixChildReaper& PosixChildReaper::GetInstance()
+    {
+        Poco::FastMutex::ScopedLock lock(instanceMutex);
+        if (!instance)
+        {
+            instance = new PosixChildReaper();
+            instance->thread.setName("PosixChildReaper");
+            instance->thread.start(*instance);
+        }
+        return *instance;
+    }
+
+    /*static*/
+    void PosixChildReaper::Shutdown()
+    {
+        Poco::FastMutex::ScopedLock lock(instanceMutex);
+        if (!instance)
+            return;
+
+        instance->running = false;
+        instance->Wake();
+        instance->thread.join();
+        delete instance;
+        instance = 0;
+    }
+
+    PosixChildReaper::PosixChildReaper() :
+        polledChildren(0),
+        epollHandle(-1),
+        running(true),
+        deliverExits(new FunctionPtrMethod(&DeliverExits))
+    {
+        if (pipe(this->wakeHandles) != 0)
+        {
+            throw ValueException::FromFormat(
+                "Error creating pipe: %s (%d)", strerror(errno), errno);
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            fcntl(this->wakeHandles[i], F_SETFD, FD_CLOEXEC);
+            fcntl(this->wakeHandles[i], F_SETFL, O_NONBLOCK);
+        }
+
+#if defined(OS_LINUX)
+        this->epollHandle = epoll_create(MAX_EPOLL_EVENTS);
+        if (this->epollHandle >= 0)
+        {
+            fcntl(this->epollHandle, F_SETFD, FD_CLOEXEC);
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.u64 = 0;
+            epoll_ctl(this->epollHandle, EPOLL_CTL_ADD, this->wakeHandles[0], &event);
+        }
+#endif
+    }
+
+    PosixChildReaper::~PosixChildReaper()
+    {
+        std::map<pid_t, Child>::iterator i = this->children.begin();
+        while (i != this->children.end())
+        {
+            if (i->second.pidfd >= 0)
+                close(i->second.pidfd);
+            i++;
+        }
+
+        if (this->epollHandle >= 0)
+            close(this->epollHandle);
+        close(this->wakeHandles[0]);
+        close(this->wakeHandles[1]);
+    }
+
+    void PosixChildReaper::Add(AutoPtr<PosixProcess> process)
+    {
+        Child child;
+        child.process = process;
+        child.pidfd = -1;
+
+#if defined(OS_LINUX) && defined(__NR_pidfd_open)
+        if (this->epollHandle >= 0)
+        {
+            child.pidfd = syscall(__NR_pidfd_open, process->GetPID(), 0);
+            if (child.pidfd >= 0)
+            {
+                fcntl(child.pidfd, F_SETFD, FD_CLOEXEC);
+                struct epoll_event event;
+                event.events = EPOLLIN;
+                event.data.u64 = process->GetPID();
+                if (epoll_ctl(this->epollHandle, EPOLL_CTL_ADD, child.pidfd, &event) != 0)
+                {
+                    close(child.pidfd);
+                    child.pidfd = -1;
+                }
+            }
+        }
+#endif
+
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            this->children[process->GetPID()] = child;
+            if (child.pidfd < 0)
+                this->polledChildren++;
+        }
+        this->Wake();
+    }
+
+    void PosixChildReaper::Wake()
+    {
+        char byte = 0;
+        while (write(this->wakeHandles[1], &byte, 1) < 0 && errno == EINTR);
+    }
+
+    void PosixChildReaper::WaitForChildren(std::vector<pid_t>& ready, bool pending)
+    {
+        bool polling;
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            polling = this->polledChildren > 0;
+        }
+        int timeout = (polling || pending) ? REAPER_POLL_INTERVAL_MS : -1;
+
+#if defined(OS_LINUX)
+        if (this->epollHandle >= 0)
+        {
+            struct epoll_event events[MAX_EPOLL_EVENTS];
+            int count = epoll_wait(this->epollHandle, events, MAX_EPOLL_EVENTS, timeout);
+
+            // Each pidfd is registered with its pid, and the wake
+            // pipe with zero.
+            for (int e = 0; e < count; e++)
+            {
+                if (events[e].data.u64 != 0)
+                    ready.push_back((pid_t) events[e].data.u64);
+            }
+        }
+        else
+#endif
+        {
+            struct pollfd wake;
+            wake.fd = this->wakeHandles[0];
+            wake.events = POLLIN;
+            poll(&wake, 1, timeout);
+        }
+
+        char buffer[64];
+        while (read(this->wakeHandles[0], buffer, sizeof(buffer)) > 0);
+
+        if (polling)
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            std::map<pid_t, Child>::iterator i = this->children.begin();
+            while (i != this->children.end())
+            {
+                if (i->second.pidfd < 0)
+                    ready.push_back(i->first);
+                i++;
+            }
+        }
+    }
+
+    void PosixChildReaper::Reap(pid_t pid, std::vector<AutoPtr<PosixProcess> >& pending)
+    {
+        int status;
+        struct rusage usage;
+        int rc;
+        do
+        {
+            rc = wait4(pid, &status, WNOHANG, &usage);
+        } while (rc < 0 && errno == EINTR);
+
+        // Still running, or stopped rather than exited.
+        if (rc == 0)
+            return;
+
+        Child child;
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            std::map<pid_t, Child>::iterator i = this->children.find(pid);
+            if (i == this->children.end())
+                return;
+            child = i->second;
+            this->children.erase(i);
+            if (child.pidfd < 0)
+                this->polledChildren--;
+        }
+
+        if (child.pidfd >= 0)
+            close(child.pidfd);
+
+        if (rc == pid)
+        {
+            child.process->SetExitStatus(WEXITSTATUS(status),
+                PosixProcess::GetResourceUsage(usage));
+        }
+        else
+        {
+            Logger::Get("Process.PosixChildReaper")->Error(
+                "Cannot wait for process %d: %s", pid, strerror(errno));
+            child.process->SetExitStatus(-1, 0);
+        }
+
+        child.process->StopMonitors(false);
+        pending.push_back(child.process);
+    }
+
+    void PosixChildReaper::run()
+    {
+        std::vector<AutoPtr<PosixProcess> > pending;
+        while (this->running)
+        {
+            std::vector<pid_t> ready;
+            this->WaitForChildren(ready, !pending.empty());
+            for (size_t i = 0; i < ready.size(); i++)
+                this->Reap(ready[i], pending);
+
+            // Children whose output has been read are delivered in a
+            // single call to the main thread.
+            ValueList exited;
+            std::vector<AutoPtr<PosixProcess> >::iterator i = pending.begin();
+            while (i != pending.end())
+            {
+                if ((*i)->IsMonitoring())
+                {
+                    i++;
+                    continue;
+                }
+
+                (*i)->StopMonitors(true);
+                exited.push_back(Value::NewMethod(*i));
+                i = pending.erase(i);
+            }
+
+            if (exited.size() > 0)
+                RunOnMainThread(this->deliverExits, exited, false);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _POSIX_CHILD_REAPER_H_
+#define _POSIX_CHILD_REAPER_H_
+
+#include <map>
+#include <vector>
+#include <sys/types.h>
+
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
+
+#include <tide/tide.h>
+
+namespace ti
+{
+    class PosixProcess;
+
+    /**
+     * Waits for every asynchronously launched child on a single thread,
+     * instead of one blocking waitpid thread per process. On Linux each
+     * child is watched through a pidfd in an epoll set; elsewhere, or
+     * when the kernel has no pidfds, children are polled with WNOHANG.
+     *
+     * A reaped child's exit event is held back until its pipe monitors
+     * have finished, so that all of its output is read first. Exit
+     * events that become ready together are sent to the main thread in
+     * one batch.
+     */
+    class PosixChildReaper : public Poco::Runnable
+    {
+    public:
+        static PosixChildReaper& GetInstance();
+        static void Shutdown();
+
+        void Add(AutoPtr<PosixProcess> process);
+        virtual void run();
+
+    private:
+        PosixChildReaper();
+        ~PosixChildReaper();
+
+        struct Child
+        {
+            AutoPtr<PosixProcess> process;
+            int pidfd;
+        };
+
+        void Wake();
+        void WaitForChildren(std::vector<pid_t>& ready, bool pending);
+        void Reap(pid_t pid, std::vector<AutoPtr<PosixProcess> >& pending);
+
+        std::map<pid_t, Child> children;
+        size_t polledChildren;
+        int wakeHandles[2];
+        int epollHandle;
+        bool running;
+        TiMethodRef deliverExits;
+        Poco::Thread thread;
+        Poco::FastMutex mutex;
+
+        static PosixChildReaper* instance;
+        static Poco::FastMutex instanceMutex;
+
+        DISALLOW_EVIL_CONSTRUCTORS(PosixChildReaper);
+    };
+}
+
+#endif
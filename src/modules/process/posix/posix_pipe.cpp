@@ -8,12 +8,19 @@
 
 #include "posix_pipe.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
 namespace ti
 {
     PosixPipe::PosixPipe(bool isReader) :
         NativePipe(isReader),
         readHandle(-1),
-        writeHandle(-1)
+        writeHandle(-1),
+        teeHandle(-1),
+        teeSignalsBlocked(false)
     {
     }
 
@@ -42,8 +49,65 @@ namespace ti
         NativePipe::Close();
     }
 
+    bool PosixPipe::SetTeeHandle(int handle)
+    {
+#if defined(OS_LINUX)
+        if (teeHandle != -1)
+            close(teeHandle);
+        teeHandle = dup(handle);
+        if (teeHandle != -1)
+            fcntl(teeHandle, F_SETFD, FD_CLOEXEC);
+        return teeHandle != -1;
+#else
+        return false;
+#endif
+    }
+
+    int PosixPipe::Tee(int size)
+    {
+#if defined(OS_LINUX)
+        // A reader that has gone away should end the link, not the
+        // application, so SIGPIPE is blocked on this monitor thread.
+        if (!teeSignalsBlocked)
+        {
+            sigset_t signals;
+            sigemptyset(&signals);
+            sigaddset(&signals, SIGPIPE);
+            pthread_sigmask(SIG_BLOCK, &signals, 0);
+            teeSignalsBlocked = true;
+        }
+
+        ssize_t n;
+        do
+        {
+            n = tee(readHandle, teeHandle, size, 0);
+        }
+        while (n < 0 && errno == EINTR);
+
+        if (n >= 0)
+            return n;
+
+        if (errno != EPIPE)
+        {
+            logger->Warn("Could not duplicate pipe data: %s", strerror(errno));
+        }
+        close(teeHandle);
+        teeHandle = -1;
+#endif
+        return size;
+    }
+
     int PosixPipe::RawRead(char *buffer, int size)
     {
+        // Wait for data with tee, so that exactly what was passed on
+        // to the linked pipe is read here.
+        if (teeHandle != -1)
+        {
+            size = this->Tee(size);
+            if (size == 0)
+                return 0;
+        }
+
         int n;
         do
         {
@@ -81,6 +145,12 @@ namespace ti
 
     void PosixPipe::CloseNativeRead()
     {
+        if (teeHandle != -1)
+        {
+            close(teeHandle);
+            teeHandle = -1;
+        }
+
         if (readHandle != -1)
         {
             close(this->readHandle);
@@ -25,9 +25,24 @@ namespace ti
         inline int GetReadHandle() { return readHandle; }
         inline int GetWriteHandle() { return writeHandle; }
 
+        // Whether this is the stdin pipe of a running process: the child
+        // has the read end and only the write end is left here.
+        inline bool IsConnected()
+        {
+            return !isReader && !closed && readHandle == -1 && writeHandle != -1;
+        }
+
+        // Duplicate everything read from this pipe into another pipe
+        // with tee(2) before it is read. Returns false when the
+        // platform cannot do this.
+        bool SetTeeHandle(int handle);
+
     protected:
         int readHandle;
         int writeHandle;
+        int teeHandle;
+        bool teeSignalsBlocked;
+        int Tee(int size);
         virtual int RawRead(char *buffer, int size);
         virtual int RawWrite(const char *buffer, int size);
     };
@@ -8,6 +8,8 @@
 
 
 #include "posix_process.h"
+#include "posix_process_launcher.h"
+#include "posix_child_reaper.h"
 #include <errno.h>
 #include <signal.h>
 #include <sys/time.h>
@@ -41,6 +43,9 @@ namespace ti
 
     void PosixProcess::RecreateNativePipes()
     {
+        // Only the current native stdin may be attached, or processes
+        // piping into this one will not link to it.
+        stdinPipe->Detach(this->GetNativeStdin());
         this->nativeIn = new PosixPipe(false);
         this->nativeOut = new PosixPipe(true);
         this->nativeErr = new PosixPipe(true);
@@ -75,52 +80,72 @@ namespace ti
         nativeOut->CreateHandles();
         nativeErr->CreateHandles();
 
-        int pid = fork();
-        if (pid < 0)
+        // Everything the child needs is prepared here, so that it
+        // only has to set up its streams and exec.
+        PosixProcessLauncher launcher(args, environment);
+        int outHandle = this->LinkOutput(stdoutPipe, nativeOut);
+        int errHandle = this->LinkOutput(stderrPipe, nativeErr);
+        pid_t pid;
+        try
         {
-            throw ValueException::FromFormat("Cannot fork process for %s", 
-                args->At(0)->ToString());
+            pid = launcher.Launch(nativeIn->GetReadHandle(), outHandle, errHandle);
         }
-        else if (pid == 0)
+        catch (ValueException&)
         {
-            // outPipe and errPipe may be the same, so we dup first and close later
-            dup2(nativeIn->GetReadHandle(), STDIN_FILENO);
-            dup2(nativeOut->GetWriteHandle(), STDOUT_FILENO);
-            dup2(nativeErr->GetWriteHandle(), STDERR_FILENO);
             nativeIn->CloseNative();
             nativeOut->CloseNative();
             nativeErr->CloseNative();
+            throw;
+        }
 
-            // close all open file descriptors other than stdin, stdout, stderr
-            for (int i = 3; i < getdtablesize(); ++i)
-                close(i);
+        SetPID(pid);
+        nativeIn->CloseNativeRead();
+        nativeOut->CloseNativeWrite();
+        nativeErr->CloseNativeWrite();
+    }
 
-            size_t i = 0;
-            char** argv = new char*[args->Size() + 1];
-            //argv[i++] = const_cast<char*>(command.c_str());
-            for (;i < args->Size(); i++)
-            {
-                argv[i] = const_cast<char*>(args->At(i)->ToString());
-            }
-            argv[i] = NULL;
+    int PosixProcess::LinkOutput(AutoPipe output, AutoPtr<PosixPipe> nativeOutput)
+    {
+        // If this output is attached to the stdin pipe of a running
+        // process, the child can write straight into that process' native
+        // stdin. When something else also wants the data, it is read as
+        // usual and duplicated into the other process with tee. A process
+        // which isn't running yet gets the data through the attached pipe,
+        // as does any synchronous launch, which must not wait on a reader.
+        output->SetNativeLink(0);
+        if (synchronous)
+            return nativeOutput->GetWriteHandle();
+
+        std::vector<TiObjectRef> attached(output->GetAttachedObjects());
+        for (size_t i = 0; i < attached.size(); i++)
+        {
+            AutoPipe target(attached[i].cast<Pipe>());
+            if (target.isNull())
+                continue;
 
-            SharedStringList envNames = environment->GetPropertyNames();
-            for (i = 0; i < envNames->size(); i++)
+            std::vector<TiObjectRef> targetAttached(target->GetAttachedObjects());
+            if (targetAttached.size() != 1)
+                continue;
+
+            AutoPtr<PosixPipe> nativeInput(targetAttached[0].cast<PosixPipe>());
+            if (nativeInput.isNull() || !nativeInput->IsConnected()
+                || nativeInput.get() == nativeIn.get())
+                continue;
+
+            bool observed = !onRead.isNull() || attached.size() > 1
+                || output->HasEventListeners(Event::READ.c_str());
+            if (!observed)
             {
-                const char* key = envNames->at(i)->c_str();
-                std::string value(environment->Get(key)->ToString());
-                setenv(key, value.c_str(), 1);
+                output->SetNativeLink(target);
+                return nativeInput->GetWriteHandle();
             }
 
-            const char *command = args->At(0)->ToString();
-            execvp(command, argv);
-            _exit(72);
+            if (nativeOutput->SetTeeHandle(nativeInput->GetWriteHandle()))
+                output->SetNativeLink(target);
+            break;
         }
 
-        SetPID(pid);
-        nativeIn->CloseNativeRead();
-        nativeOut->CloseNativeWrite();
-        nativeErr->CloseNativeWrite();
+        return nativeOutput->GetWriteHandle();
     }
 
     void PosixProcess::MonitorAsync()
@@ -158,13 +183,37 @@ namespace ti
         return output;
     }
 
+    void PosixProcess::StartExitMonitor()
+    {
+        PosixChildReaper::GetInstance().Add(AutoPtr<PosixProcess>(this, true));
+    }
+
+    /*static*/
+    TiObjectRef PosixProcess::GetResourceUsage(const struct rusage& usage)
+    {
+        TiObjectRef result(new StaticBoundObject());
+        result->SetDouble("userTime", usage.ru_utime.tv_sec * 1000.0
+            + usage.ru_utime.tv_usec / 1000.0);
+        result->SetDouble("systemTime", usage.ru_stime.tv_sec * 1000.0
+            + usage.ru_stime.tv_usec / 1000.0);
+
+        // OS X reports the peak resident set size in bytes, Linux in kilobytes.
+#if defined(OS_OSX)
+        result->SetDouble("maxRSS", (double) usage.ru_maxrss);
+#else
+        result->SetDouble("maxRSS", usage.ru_maxrss * 1024.0);
+#endif
+        return result;
+    }
+
     int PosixProcess::Wait()
     {
         int status;
+        struct rusage usage;
         int rc;
         do
         {
-            rc = waitpid(GetPID(), &status, 0);
+            rc = wait4(GetPID(), &status, 0, &usage);
         } while (rc < 0 && errno == EINTR);
 
         if (rc != GetPID())
@@ -172,6 +221,8 @@ namespace ti
             throw ValueException::FromFormat("Cannot wait for process: %d", GetPID());
         }
 
+        this->resourceUsage = GetResourceUsage(usage);
+
         int exitCode = WEXITSTATUS(status);
         return exitCode;
     }
@@ -10,6 +10,7 @@
 #define _POSIX_PROCESS_H_
 
 #include <sstream>
+#include <sys/resource.h>
 #include <Poco/Thread.h>
 #include "posix_pipe.h"
 #include "../process.h"
@@ -26,11 +27,13 @@ namespace ti
         virtual void Kill();
         virtual void SendSignal(int signal);
         static AutoPtr<PosixProcess> GetCurrentProcess();
+        static TiObjectRef GetResourceUsage(const struct rusage& usage);
 
         virtual void ForkAndExec();
         virtual void MonitorAsync();
         virtual BytesRef MonitorSync();
         virtual int Wait();
+        virtual void StartExitMonitor();
         virtual void RecreateNativePipes();
         virtual void SetArguments(TiListRef args);
         void ReadCallback(const ValueList& args, ValueRef result);
@@ -50,6 +53,7 @@ namespace ti
         Poco::Mutex processOutputMutex;
         std::vector<BytesRef> processOutput;
         void StartProcess();
+        int LinkOutput(AutoPipe output, AutoPtr<PosixPipe> nativeOutput);
     };
 }
 
@@ -0,0 +1,220 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#include "posix_process_launcher.h"
+#include <tideutils/environment_utils.h>
+
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(OS_LINUX)
+# include <sys/syscall.h>
+#endif
+
+// glibc 2.34 can close descriptors as a posix_spawn file action, and
+// OS X can mark every inherited descriptor close-on-exec. Elsewhere
+// the launcher falls back to vfork.
+#if defined(OS_OSX)
+# define USE_POSIX_SPAWN 1
+#elif defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+# define USE_POSIX_SPAWN 1
+# define USE_SPAWN_CLOSEFROM 1
+#endif
+
+// The exit code of a child that could not exec, as before.
+#define EXEC_FAILED_EXIT_CODE 72
+
+// execvp searches these directories when PATH is unset.
+#define DEFAULT_PATH "/bin:/usr/bin"
+
+namespace ti
+{
+    PosixProcessLauncher::PosixProcessLauncher(
+        TiListRef args, TiObjectRef environment)
+    {
+        for (size_t i = 0; i < args->Size(); i++)
+            this->arguments.push_back(args->At(i)->ToString());
+
+        // The environment object only overrides variables, the way
+        // setenv did in the child, so the rest are inherited.
+        std::map<std::string, std::string> variables(EnvironmentUtils::GetEnvironment());
+        SharedStringList envNames(environment->GetPropertyNames());
+        for (size_t i = 0; i < envNames->size(); i++)
+        {
+            const std::string& name = *envNames->at(i);
+            variables[name] = environment->Get(name.c_str())->ToString();
+        }
+
+        std::string path(DEFAULT_PATH);
+        std::map<std::string, std::string>::iterator i = variables.begin();
+        for (; i != variables.end(); i++)
+        {
+            if (i->first == "PATH")
+                path = i->second;
+            this->environment.push_back(i->first + "=" + i->second);
+        }
+
+        // Pointers into the string vectors are only taken once the
+        // vectors are complete, so they cannot be invalidated.
+        for (size_t i = 0; i < this->arguments.size(); i++)
+            this->argv.push_back(const_cast<char*>(this->arguments[i].c_str()));
+        this->argv.push_back(0);
+        for (size_t i = 0; i < this->environment.size(); i++)
+            this->envp.push_back(const_cast<char*>(this->environment[i].c_str()));
+        this->envp.push_back(0);
+
+        if (!this->arguments.empty())
+            this->executable = FindExecutable(this->arguments[0], path);
+    }
+
+    /*static*/
+    std::string PosixProcessLauncher::FindExecutable(
+        const std::string& command, const std::string& path)
+    {
+        if (command.empty() || command.find('/') != std::string::npos)
+            return command;
+
+        size_t start = 0;
+        while (start <= path.size())
+        {
+            size_t end = path.find(':', start);
+            if (end == std::string::npos)
+                end = path.size();
+
+            // An empty PATH entry means the current directory.
+            std::string dir(path.substr(start, end - start));
+            std::string candidate(dir.empty() ? command : dir + "/" + command);
+
+            struct stat info;
+            if (stat(candidate.c_str(), &info) == 0 && S_ISREG(info.st_mode)
+                && access(candidate.c_str(), X_OK) == 0)
+            {
+                return candidate;
+            }
+            start = end + 1;
+        }
+
+        // Let the launch itself fail with ENOENT.
+        return command;
+    }
+
+#if !defined(USE_POSIX_SPAWN)
+    // Runs in the vfork child, so it must not allocate or touch
+    // anything shared with the parent.
+    static void CloseDescriptorsFrom(int lowest)
+    {
+#if defined(__NR_close_range)
+        if (syscall(__NR_close_range, lowest, ~0U, 0) == 0)
+            return;
+#endif
+        int highest = 1024;
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+            highest = (int) limit.rlim_cur;
+        for (int fd = lowest; fd < highest; fd++)
+            close(fd);
+    }
+#endif
+
+    pid_t PosixProcessLauncher::Launch(
+        int stdinHandle, int stdoutHandle, int stderrHandle)
+    {
+        if (this->arguments.empty())
+            throw ValueException::FromString("Cannot launch a process without a command");
+
+        const char* command = this->arguments[0].c_str();
+        pid_t pid = -1;
+
+#if defined(USE_POSIX_SPAWN)
+        posix_spawn_file_actions_t actions;
+        posix_spawnattr_t attributes;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawnattr_init(&attributes);
+
+        // stdout and stderr may be the same pipe, so all of the
+        // descriptors are duplicated before any are closed.
+        posix_spawn_file_actions_adddup2(&actions, stdinHandle, STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, stdoutHandle, STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, stderrHandle, STDERR_FILENO);
+#if defined(USE_SPAWN_CLOSEFROM)
+        posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
+#else
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_CLOEXEC_DEFAULT);
+#endif
+
+        int error = posix_spawn(&pid, this->executable.c_str(), &actions,
+            &attributes, &this->argv[0], &this->envp[0]);
+
+        posix_spawnattr_destroy(&attributes);
+        posix_spawn_file_actions_destroy(&actions);
+
+        if (error != 0)
+        {
+            throw ValueException::FromFormat("Cannot launch %s: %s",
+                command, strerror(error));
+        }
+#else
+        const char* executable = this->executable.c_str();
+        char** argv = &this->argv[0];
+        char** envp = &this->envp[0];
+
+        // The vfork child shares our memory until it execs, so it
+        // reports a failed exec by writing the error here. Signals
+        // stay blocked so no handler runs on the shared stack.
+        volatile int execError = 0;
+        sigset_t allSignals, oldSignals;
+        sigfillset(&allSignals);
+        pthread_sigmask(SIG_SETMASK, &allSignals, &oldSignals);
+
+        pid = vfork();
+        if (pid == 0)
+        {
+            if (dup2(stdinHandle, STDIN_FILENO) < 0
+                || dup2(stdoutHandle, STDOUT_FILENO) < 0
+                || dup2(stderrHandle, STDERR_FILENO) < 0)
+            {
+                execError = errno;
+                _exit(EXEC_FAILED_EXIT_CODE);
+            }
+
+            CloseDescriptorsFrom(STDERR_FILENO + 1);
+            sigprocmask(SIG_SETMASK, &oldSignals, 0);
+            execve(executable, argv, envp);
+            execError = errno;
+            _exit(EXEC_FAILED_EXIT_CODE);
+        }
+
+        int forkError = errno;
+        pthread_sigmask(SIG_SETMASK, &oldSignals, 0);
+
+        if (pid < 0)
+        {
+            throw ValueException::FromFormat("Cannot fork process for %s: %s",
+                command, strerror(forkError));
+        }
+
+        if (execError != 0)
+        {
+            // Reap the child now, since no one else knows about it.
+            int error = execError;
+            while (waitpid(pid, 0, 0) < 0 && errno == EINTR);
+            throw ValueException::FromFormat("Cannot launch %s: %s",
+                command, strerror(error));
+        }
+#endif
+
+        return pid;
+    }
+}
@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2012 - 2014 TideSDK contributors
+ * http://www.tidesdk.org
+ * Includes modified sources under the Apache 2 License
+ * Copyright (c) 2008 - 2012 Appcelerator Inc
+ * Refer to LICENSE for details of distribution and use.
+ **/
+
+#ifndef _POSIX_PROCESS_LAUNCHER_H_
+#define _POSIX_PROCESS_LAUNCHER_H_
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include <tide/tide.h>
+
+namespace ti
+{
+    /**
+     * Starts a child process without doing any work between fork and
+     * exec. The argument and environment arrays are built and the
+     * executable is resolved against the PATH in the parent, so that
+     * the child only has to set up its standard streams, close the
+     * remaining descriptors and exec. Where the platform allows it the
+     * launch is a single posix_spawn call, otherwise it uses vfork.
+     */
+    class PosixProcessLauncher
+    {
+    public:
+        PosixProcessLauncher(TiListRef args, TiObjectRef environment);
+
+        // Start the process with the given descriptors as its stdin,
+        // stdout and stderr. Every other descriptor is closed in the
+        // child. Throws a ValueException when the process could not
+        // be started, including when the executable does not exist.
+        pid_t Launch(int stdinHandle, int stdoutHandle, int stderrHandle);
+
+        inline const std::string& GetExecutable() { return executable; }
+
+    private:
+        static std::string FindExecutable(
+            const std::string& command, const std::string& path);
+
+        std::string executable;
+        std::vector<std::string> arguments;
+        std::vector<std::string> environment;
+        std::vector<char*> argv;
+        std::vector<char*> envp;
+
+        DISALLOW_EVIL_CONSTRUCTORS(PosixProcessLauncher);
+    };
+}
+
+#endif
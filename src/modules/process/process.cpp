@@ -40,11 +40,13 @@ namespace ti
         environment(GetCurrentEnvironment()),
         pid(-1),
         exitCode(Value::Null),
+        resourceUsage(0),
         onRead(0),
         onExit(0),
         exitMonitorAdapter(new RunnableAdapter<Process>(
             *this, &Process::ExitMonitorAsync)),
-        running(false)
+        running(false),
+        synchronous(false)
     {
         /**
          * @tiapi(method=True,name=Process.Process.getPID,since=0.5)
@@ -57,6 +59,16 @@ namespace ti
          * @tiresult[Number] The exit code of this process. If the process is still running, this will return -1
          */
         SetMethod("getExitCode", &Process::_GetExitCode);
+
+        /**
+         * @tiapi(method=True,name=Process.Process.getResourceUsage,since=1.4)
+         * @tiapi Get the resources used by this process once it has exited.
+         * @tiapi This is not available on Windows.
+         * @tiresult[Object|null] An object with userTime and systemTime (the CPU time
+         * @tiresult used, in milliseconds) and maxRSS (the peak resident set size, in bytes),
+         * @tiresult or null if the process is still running.
+         */
+        SetMethod("getResourceUsage", &Process::_GetResourceUsage);
         
         /**
          * @tiapi(method=True,name=Process.Process.getArguments,since=0.5)
@@ -181,6 +193,26 @@ namespace ti
         }
     }
 
+    void Process::SetExitStatus(int exitCode, TiObjectRef resourceUsage)
+    {
+        this->exitCode = Value::NewInt(exitCode);
+        this->resourceUsage = resourceUsage;
+    }
+
+    void Process::StopMonitors(bool wait)
+    {
+        this->GetNativeStdin()->StopMonitors(wait);
+        this->GetNativeStdout()->StopMonitors(wait);
+        this->GetNativeStderr()->StopMonitors(wait);
+    }
+
+    bool Process::IsMonitoring()
+    {
+        return this->GetNativeStdin()->IsMonitoring()
+            || this->GetNativeStdout()->IsMonitoring()
+            || this->GetNativeStderr()->IsMonitoring();
+    }
+
     void Process::SetOnRead(TiMethodRef newOnRead)
     {
         if (running)
@@ -250,6 +282,8 @@ namespace ti
     {
         this->running = true;
         this->exitCode = Value::Null;
+        this->resourceUsage = 0;
+        this->synchronous = false;
 
         this->AttachPipes(true);
         ForkAndExec();
@@ -257,6 +291,11 @@ namespace ti
 
         this->exitCallback = StaticBoundMethod::FromMethod<Process>(
             this, &Process::ExitCallback);
+        this->StartExitMonitor();
+    }
+
+    void Process::StartExitMonitor()
+    {
         this->exitMonitorThread.start(*exitMonitorAdapter);
     }
 
@@ -264,6 +303,8 @@ namespace ti
     {
         this->running = true;
         this->exitCode = Value::Null;
+        this->resourceUsage = 0;
+        this->synchronous = true;
 
         this->AttachPipes(false);
         ForkAndExec();
@@ -286,10 +327,7 @@ namespace ti
     void Process::ExitMonitorSync()
     {
         this->exitCode = Value::NewInt(this->Wait());
-
-        this->GetNativeStdin()->StopMonitors();
-        this->GetNativeStdout()->StopMonitors();
-        this->GetNativeStderr()->StopMonitors();
+        this->StopMonitors(true);
         if (!exitCallback.isNull())
             RunOnMainThread(exitCallback, ValueList());
     }
@@ -305,9 +343,7 @@ namespace ti
         // next launch. Don't do this for synchronous process
         // launch becauase we are already on the main thread and that
         // will cause a deadlock.
-        this->GetNativeStdin()->StopMonitors();
-        this->GetNativeStdout()->StopMonitors();
-        this->GetNativeStderr()->StopMonitors();
+        this->StopMonitors(true);
 
         if (!exitCallback.isNull())
             RunOnMainThread(exitCallback, ValueList());
@@ -332,6 +368,14 @@ namespace ti
         result->SetValue(exitCode);
     }
     
+    void Process::_GetResourceUsage(const ValueList& args, ValueRef result)
+    {
+        if (this->resourceUsage.isNull())
+            result->SetNull();
+        else
+            result->SetObject(this->resourceUsage);
+    }
+
     void Process::_GetArguments(const ValueList& args, ValueRef result)
     {
         result->SetList(this->args);
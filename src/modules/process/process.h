@@ -33,6 +33,9 @@ namespace ti
         void SetOnRead(TiMethodRef method);
         void SetOnExit(TiMethodRef onExit);
         void Exited(bool async);
+        void SetExitStatus(int exitCode, TiObjectRef resourceUsage);
+        void StopMonitors(bool wait);
+        bool IsMonitoring();
         void ExitCallback(const ValueList& args, ValueRef result);
         virtual ValueRef Call(const ValueList& args);
         static TiObjectRef GetCurrentEnvironment();
@@ -68,9 +71,14 @@ namespace ti
         virtual AutoPtr<NativePipe> GetNativeStderr() = 0;
         void AttachPipes(bool async);
 
+        // Start waiting for an asynchronously launched process to exit.
+        // By default this starts a thread that blocks in Wait().
+        virtual void StartExitMonitor();
+
     protected:
         void _GetPID(const ValueList& args, ValueRef result);
         void _GetExitCode(const ValueList& args, ValueRef result);
+        void _GetResourceUsage(const ValueList& args, ValueRef result);
         void _GetArguments(const ValueList& args, ValueRef result);
         void _GetEnvironment(const ValueList& args, ValueRef result);
         void _SetEnvironment(const ValueList& args, ValueRef result);
@@ -95,12 +103,14 @@ namespace ti
         TiListRef args;
         int pid;
         ValueRef exitCode;
+        TiObjectRef resourceUsage;
         TiMethodRef onRead;
         TiMethodRef onExit;
         Poco::RunnableAdapter<Process>* exitMonitorAdapter;
         Poco::Thread exitMonitorThread;
         TiMethodRef exitCallback;
         bool running;
+        bool synchronous;
     };
 }
 
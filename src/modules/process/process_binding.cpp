@@ -199,6 +199,7 @@ namespace ti
             if (argList.isNull())
                 throw ValueException::FromString(
                     "Ti.Process option 'args' must be an array");
+            argList = argList->SnapshotList();
 
             environment = options->GetObject("env", 0);
 
@@ -217,7 +218,7 @@ namespace ti
         }
         else if (args.at(0)->IsList())
         {
-            argList = args.at(0)->ToList();
+            argList = args.at(0)->ToList()->SnapshotList();
             
             if (args.size() > 1)
                 environment = args.GetObject(1);
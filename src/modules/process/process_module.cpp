@@ -9,6 +9,9 @@
 #include <tide/tide.h>
 #include "process_module.h"
 #include "process_binding.h"
+#if !defined(OS_WIN32)
+#include "posix/posix_child_reaper.h"
+#endif
 
 using namespace tide;
 using namespace ti;
@@ -35,6 +38,9 @@ namespace ti
 
     void ProcessModule::Stop()
     {
+#if !defined(OS_WIN32)
+        PosixChildReaper::Shutdown();
+#endif
     }
     
 }
@@ -13,10 +13,14 @@
 
 #include <boost/system/error_code.hpp>
 
+#include <algorithm>
 #include <string>
 #include <deque>
+#include <vector>
 
-#define BUFFER_SIZE 1024   // choose a reasonable size to send back to JS
+#define READ_BUFFER_SIZE 64*1024
+#define READ_BUFFER_MIN_SIZE 1024  // start a new buffer below this much free space
+#define MAX_WRITE_BUFFERS 64       // most queued writes gathered into one send
 
 namespace ti
 {
@@ -33,8 +37,19 @@ namespace ti
 		T *socket;
 
     boost::asio::detail::mutex write_mutex;
-		std::deque<std::string> write_buffer;
-		char read_data_buffer[BUFFER_SIZE + 1];
+		std::deque<BytesRef> write_buffer;
+		size_t write_in_flight;
+
+		// Reads land in a shared buffer and are passed to JS as slices
+		// of it, so nothing is copied. A new buffer is started when the
+		// current one fills up, leaving the old one to the slices. The
+		// buffer is only replaced on the thread which reads into it;
+		// setReadBufferSize only records the size for the next buffer.
+		BytesRef read_buffer;
+		size_t read_buffer_used;
+		size_t read_buffer_size;
+		boost::asio::detail::mutex read_mutex;
+		size_t requested_read_buffer_size;
 		bool non_blocking;
 		enum SOCK_STATE_en { SOCK_CLOSED,
 			SOCK_CONNECTING,
@@ -43,7 +58,7 @@ namespace ti
 			SOCK_CLOSING
 		} sock_state;
 
-		void on_read(char * data, int size);
+		void on_read(BytesRef data);
 		void on_error(const std::string& error_text);
 		void on_close();
 
@@ -86,18 +101,23 @@ namespace ti
 		}
 		void Write(const ValueList& args, ValueRef result);
 		void Read(const ValueList& args, ValueRef result);
+		void SetReadBufferSize(const ValueList& args, ValueRef result);
 		void Close(const ValueList& args, ValueRef result);
 		void IsClosed(const ValueList& args, ValueRef result);
 
 		void registerHandleWrite();
 		void handleWrite(const boost::system::error_code& error, std::size_t bytes_transferred);
-		void writeAsync(const std::string &data);
+		void writeAsync(BytesRef data);
 
-		bool writeSync(const std::string &data);
-		bool write(const std::string &data);
-		std::string read();
+		bool writeSync(BytesRef data);
+		bool write(BytesRef data);
+		BytesRef read();
 
-		void handleRead(const boost::system::error_code& error, std::size_t bytes_transferred);
+		char* prepareReadBuffer(size_t& space);
+		BytesRef consumeReadBuffer(BytesRef buffer, size_t size);
+
+		void handleRead(BytesRef buffer, const boost::system::error_code& error,
+			std::size_t bytes_transferred);
 	};
 
 
@@ -106,6 +126,10 @@ namespace ti
 		: StaticBoundObject(name.c_str()),
 	ti_host(host),
 	socket(NULL),
+	write_in_flight(0),
+	read_buffer_used(0),
+	read_buffer_size(READ_BUFFER_SIZE),
+	requested_read_buffer_size(READ_BUFFER_SIZE),
 	non_blocking(false),
 	sock_state(SOCK_CLOSED)
 	{
@@ -115,6 +139,7 @@ namespace ti
 
 		this->SetMethod("read",&Socket::Read);
 		this->SetMethod("write",&Socket::Write);
+		this->SetMethod("setReadBufferSize",&Socket::SetReadBufferSize);
 
 		this->SetMethod("isClosed",&Socket::IsClosed);
 		this->SetMethod("close",&Socket::Close);
@@ -132,16 +157,16 @@ namespace ti
 
 
 	template <class T>
-	void Socket<T>::on_read(char * data, int size)
+	void Socket<T>::on_read(BytesRef data)
 	{
 		if(!this->onRead.isNull()) 
 		{
-			BytesRef bytes(new Bytes(data, size));
-			ValueList args (Value::NewObject(bytes));
+			ValueList args (Value::NewObject(data));
 			RunOnMainThread(this->onRead, args, false);
 			return;
 		}
-		GetLogger()->Warn("Socket::onRead: not read subscriber registered:  " + string(data));
+		GetLogger()->Warn("Socket::onRead: no read subscriber registered, dropping %lu bytes",
+			(unsigned long) data->Length());
 	}
 
 	template <class T>
@@ -169,7 +194,16 @@ namespace ti
 	{
 		try
 		{
-			std::string data = args.at(0)->ToString();
+			// Bytes are queued as they are; anything else is sent
+			// as its string value.
+			BytesRef data;
+			if (args.at(0)->IsObject())
+				data = args.at(0)->ToObject().cast<Bytes>();
+			if (data.isNull())
+			{
+				std::string str(args.at(0)->ToString());
+				data = new Bytes(str);
+			}
 			result->SetBool(this->write(data));
 		}
 		catch(SocketException &e)
@@ -183,9 +217,7 @@ namespace ti
 	{
 		try
 		{
-			std::string data = this->read();
-			BytesRef bytes(new Bytes(data.c_str(), data.size()));
-			result->SetValue(Value::NewObject(bytes));
+			result->SetValue(Value::NewObject(this->read()));
 		}
 		catch(SocketException &e)
 		{
@@ -193,6 +225,21 @@ namespace ti
 		}
 	}
 
+	template <class T>
+	void Socket<T>::SetReadBufferSize(const ValueList& args, ValueRef result)
+	{
+		args.VerifyException("setReadBufferSize", "n");
+		double size = args.GetNumber(0);
+		if (size < READ_BUFFER_MIN_SIZE)
+			throw ValueException::FromFormat(
+				"Read buffer size must be at least %d bytes", READ_BUFFER_MIN_SIZE);
+
+		// A read may be in flight into the current buffer, so this only
+		// takes effect when the next buffer is started.
+		boost::asio::detail::mutex::scoped_lock lock(read_mutex);
+		this->requested_read_buffer_size = (size_t) size;
+	}
+
 	template <class T>
 	void Socket<T>::Close(const ValueList& args, ValueRef result)
 	{
@@ -210,8 +257,19 @@ namespace ti
 	template <class T>
 	void Socket<T>::registerHandleWrite()
 	{
-    boost::asio::async_write(*socket,
-			boost::asio::buffer(write_buffer.front().c_str(), write_buffer.front().size()),
+		// Gather everything queued while the last write was in
+		// flight into a single scatter-gather send.
+		std::vector<boost::asio::const_buffer> buffers;
+		size_t count = std::min(write_buffer.size(), (size_t) MAX_WRITE_BUFFERS);
+		buffers.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			buffers.push_back(boost::asio::buffer(
+				write_buffer[i]->Pointer(), write_buffer[i]->Length()));
+		}
+		write_in_flight = count;
+
+    boost::asio::async_write(*socket, buffers,
 			boost::bind(&Socket::handleWrite, this,
 			boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
 
@@ -231,7 +289,8 @@ namespace ti
 			return;
 		}
     boost::asio::detail::mutex::scoped_lock lock(write_mutex);
-		write_buffer.pop_front();
+		write_buffer.erase(write_buffer.begin(), write_buffer.begin() + write_in_flight);
+		write_in_flight = 0;
 		if (!write_buffer.empty())
 		{
 			this->registerHandleWrite();
@@ -239,10 +298,10 @@ namespace ti
 	}
 
 	template <class T>
-	void Socket<T>::writeAsync(const std::string &data)
+	void Socket<T>::writeAsync(BytesRef data)
 	{
     boost::asio::detail::mutex::scoped_lock lock(write_mutex);
-		bool write_in_progress = !write_buffer.empty();
+		bool write_in_progress = write_in_flight > 0;
 		write_buffer.push_back(data);
 		if (!write_in_progress)
 		{
@@ -251,11 +310,11 @@ namespace ti
 	}
 
 	template <class T>
-	bool Socket<T>::writeSync(const std::string &data)
+	bool Socket<T>::writeSync(BytesRef data)
 	{
 		try
 		{
-      boost::asio::write(*socket, boost::asio::buffer(data.c_str(), data.size()));
+      boost::asio::write(*socket, boost::asio::buffer(data->Pointer(), data->Length()));
 		}
 		catch(boost::system::system_error & e)
 		{
@@ -267,7 +326,7 @@ namespace ti
 	}
 
 	template <class T>
-	bool Socket<T>::write(const std::string &data)
+	bool Socket<T>::write(BytesRef data)
 	{
 		if (this->sock_state != SOCK_CONNECTED)
 		{
@@ -282,7 +341,8 @@ namespace ti
 	}
 
 	template <class T>
-	void Socket<T>::handleRead(const boost::system::error_code& error, std::size_t bytes_transferred)
+	void Socket<T>::handleRead(BytesRef buffer, const boost::system::error_code& error,
+		std::size_t bytes_transferred)
 	{
 		if (error)
 		{
@@ -294,23 +354,57 @@ namespace ti
 			this->on_error(error.message());
 			return;
 		}
-		this->on_read(read_data_buffer, bytes_transferred);
+		this->on_read(this->consumeReadBuffer(buffer, bytes_transferred));
 		this->registerHandleRead();
 	}
 
+	template <class T>
+	char* Socket<T>::prepareReadBuffer(size_t& space)
+	{
+		size_t requested;
+		{
+			boost::asio::detail::mutex::scoped_lock lock(read_mutex);
+			requested = this->requested_read_buffer_size;
+		}
+
+		space = this->read_buffer_size - this->read_buffer_used;
+		if (this->read_buffer.isNull() || space < READ_BUFFER_MIN_SIZE ||
+			requested != this->read_buffer_size)
+		{
+			this->read_buffer_size = requested;
+			this->read_buffer = new Bytes(this->read_buffer_size);
+			this->read_buffer_used = 0;
+			space = this->read_buffer_size;
+		}
+		return this->read_buffer->Pointer() + this->read_buffer_used;
+	}
+
+	template <class T>
+	BytesRef Socket<T>::consumeReadBuffer(BytesRef buffer, size_t size)
+	{
+		BytesRef data(new Bytes(buffer, this->read_buffer_used, size));
+		this->read_buffer_used += size;
+		return data;
+	}
+
 
 	template <class T>
 	void Socket<T>::registerHandleRead()
 	{
+		size_t space;
+		char* buffer = this->prepareReadBuffer(space);
+
+		// The handler holds a reference to the buffer being read into,
+		// so it outlives the read whatever happens to read_buffer.
     boost::asio::async_read(*socket,
-			boost::asio::buffer(read_data_buffer, BUFFER_SIZE),
+			boost::asio::buffer(buffer, space),
 			boost::asio::transfer_at_least(1),
-			boost::bind(&Socket::handleRead, this,
+			boost::bind(&Socket::handleRead, this, this->read_buffer,
 			boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
 	}
 
 	template <class T>
-	std::string Socket<T>::read()
+	BytesRef Socket<T>::read()
 	{
 		if (this->sock_state != SOCK_CONNECTED)
 		{
@@ -318,9 +412,11 @@ namespace ti
 		}
 		// TODO: implement sync read
 		size_t size = 0;
+		size_t space;
+		char* buffer = this->prepareReadBuffer(space);
 		try
 		{
-			size = boost::asio::read(*socket, boost::asio::buffer(read_data_buffer, BUFFER_SIZE),
+			size = boost::asio::read(*socket, boost::asio::buffer(buffer, space),
 				boost::asio::transfer_at_least(1));
 		}
 		catch(boost::system::system_error & e)
@@ -329,11 +425,7 @@ namespace ti
 			this->on_error(e.what());
 			throw TCPSocketReadException();
 		}
-		if (size > 0)
-		{
-			return std::string(read_data_buffer, size);
-		}
-		return std::string("");
+		return this->consumeReadBuffer(this->read_buffer, size);
 	}
 
 }
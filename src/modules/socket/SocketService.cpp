@@ -8,25 +8,62 @@
 
 namespace ti
 {
-	std::auto_ptr<boost::asio::io_service> SocketService::io_service(new boost::asio::io_service());
+	std::vector<boost::asio::io_service*> SocketService::io_services;
+	std::vector<boost::asio::io_service::work*> SocketService::io_idleworks;
+	std::vector<boost::thread*> SocketService::io_threads;
+	size_t SocketService::next_io_service = 0;
+	boost::asio::detail::mutex SocketService::pool_mutex;
 
-	std::auto_ptr<boost::asio::io_service::work> SocketService::io_idlework(
-		new boost::asio::io_service::work(*io_service));
+	void SocketService::initialize(size_t threads)
+	{
+		boost::asio::detail::mutex::scoped_lock lock(pool_mutex);
+		if (!io_services.empty())
+			return;
 
-	std::auto_ptr<boost::thread> SocketService::io_thread(NULL);
+		if (threads == 0)
+			threads = boost::thread::hardware_concurrency();
+		if (threads == 0)
+			threads = 1;
 
-	void SocketService::initialize()
-	{
-		io_thread.reset(new boost::thread(
-			boost::bind(&boost::asio::io_service::run, SocketService::io_service.get())));
+		for (size_t i = 0; i < threads; i++)
+		{
+			boost::asio::io_service* io_service = new boost::asio::io_service(1);
+			io_services.push_back(io_service);
+			io_idleworks.push_back(new boost::asio::io_service::work(*io_service));
+			io_threads.push_back(new boost::thread(
+				boost::bind(&boost::asio::io_service::run, io_service)));
+		}
 	}
-	
+
 	void SocketService::uninitialize()
 	{
-		io_service->stop();
-		io_thread->join();
-		io_idlework.reset();
-		io_thread.reset();
-		io_service.reset();
+		boost::asio::detail::mutex::scoped_lock lock(pool_mutex);
+		for (size_t i = 0; i < io_services.size(); i++)
+		{
+			io_services[i]->stop();
+		}
+
+		for (size_t i = 0; i < io_services.size(); i++)
+		{
+			io_threads[i]->join();
+			delete io_threads[i];
+			delete io_idleworks[i];
+			delete io_services[i];
+		}
+
+		io_threads.clear();
+		io_idleworks.clear();
+		io_services.clear();
+	}
+
+	boost::asio::io_service* SocketService::getIOService()
+	{
+		boost::asio::detail::mutex::scoped_lock lock(pool_mutex);
+		if (io_services.empty())
+			return NULL;
+
+		boost::asio::io_service* io_service = io_services[next_io_service];
+		next_io_service = (next_io_service + 1) % io_services.size();
+		return io_service;
 	}
 }
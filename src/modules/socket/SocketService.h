@@ -18,6 +18,7 @@
 
 #include <string>
 #include <deque>
+#include <vector>
 
 #include <boost/asio.hpp>
 #include <boost/asio/detail/mutex.hpp>
@@ -29,20 +30,31 @@ using boost::asio::ip::tcp;
 
 namespace ti
 {
+	/**
+	 * A pool of io_services, one per core, each run by its own thread.
+	 * A socket takes its io_service from getIOService() when it is
+	 * created and keeps it for its lifetime, so its completion handlers
+	 * run on one thread while other connections use other cores. Reads
+	 * and writes are still started from the main thread, so state shared
+	 * between the two must be locked.
+	 */
 	class SocketService
 	{
 	public:
-		static void initialize();
+		// Start the pool. With no thread count, one io_service is
+		// started for every core.
+		static void initialize(size_t threads = 0);
 		static void uninitialize();
-		static boost::asio::io_service* getIOService()
-		{
-			return io_service.get();
-		}
+
+		// Return the next io_service in the pool, round-robin.
+		static boost::asio::io_service* getIOService();
 
 	private:
-		static std::auto_ptr<boost::asio::io_service> io_service;
-		static std::auto_ptr<boost::asio::io_service::work> io_idlework;
-		static std::auto_ptr<boost::thread> io_thread;
+		static std::vector<boost::asio::io_service*> io_services;
+		static std::vector<boost::asio::io_service::work*> io_idleworks;
+		static std::vector<boost::thread*> io_threads;
+		static size_t next_io_service;
+		static boost::asio::detail::mutex pool_mutex;
 	};
 }
 #endif
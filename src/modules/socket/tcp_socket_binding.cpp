@@ -13,9 +13,10 @@ namespace ti
 		onConnect(0),
 		hostname(hostname),
 		port(port),
-		resolver(*SocketService::getIOService())
+		io_service(*SocketService::getIOService()),
+		resolver(io_service)
 	{
-		this->socket = new tcp::socket(*SocketService::getIOService());
+		this->socket = new tcp::socket(io_service);
 		this->SetMethod("connect",&TCPSocketBinding::Connect);
 		this->SetMethod("connectNB",&TCPSocketBinding::ConnectNB);
 
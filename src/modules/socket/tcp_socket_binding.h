@@ -39,6 +39,8 @@ namespace ti
 		const std::string hostname;
 		const std::string port;
 
+		// Every handler for this connection runs on this pool thread.
+		boost::asio::io_service& io_service;
 		tcp::resolver resolver;
 
 		bool connect(long timeout = 10);
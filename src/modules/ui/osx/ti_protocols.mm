@@ -161,7 +161,6 @@ static NSString* GetRegisteredMimeTypeFromExtension(NSString* ext)
 
     // This is a canonical request, so try to load the file it represents.
     std::string urlString([[url absoluteString] UTF8String]);
-    std::string path(URLUtils::URLToPath(urlString));
     NSError* error = nil;
     NSData* data = nil;
     NSString* mimeType = nil;
@@ -176,14 +175,29 @@ static NSString* GetRegisteredMimeTypeFromExtension(NSString* ext)
     }
     else
     {
-        NSString* nsPath = [NSString stringWithUTF8String:path.c_str()];
-        data = [NSData dataWithContentsOfFile:nsPath options:0 error:&error];
-        mimeType = [TideSDKProtocols mimeTypeFromExtension:
-            [nsPath pathExtension]];
+        // Serve packed resources straight from the mapped archive, and
+        // fall back to loose files.
+        const char* resource;
+        size_t resourceLength;
+        if (URLUtils::AppURLToResource(urlString, resource, resourceLength))
+        {
+            data = [NSData dataWithBytesNoCopy:(void*) resource
+                length:resourceLength freeWhenDone:NO];
+            mimeType = [TideSDKProtocols mimeTypeFromExtension:
+                [[url path] pathExtension]];
+        }
+        else
+        {
+            std::string path(URLUtils::URLToPath(urlString));
+            NSString* nsPath = [NSString stringWithUTF8String:path.c_str()];
+            data = [NSData dataWithContentsOfFile:nsPath options:0 error:&error];
+            mimeType = [TideSDKProtocols mimeTypeFromExtension:
+                [nsPath pathExtension]];
+
+            if (data == nil)
+                logger->Error("Error finding %s", [nsPath UTF8String]);
+        }
         cachePolicy = NSURLCacheStorageAllowed;
-
-        if (data == nil)
-            logger->Error("Error finding %s", [nsPath UTF8String]);
     }
 
     if (data == nil) // File doesn't exist
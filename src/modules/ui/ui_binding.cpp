@@ -44,6 +44,15 @@ namespace ti
         this->SetMethod("getMainWindow", &UIBinding::_GetMainWindow);
         this->SetMethod("createWindow", &UIBinding::_CreateWindow);
 
+        /**
+         * @tiapi(method=True,name=UI.getWrapperCacheStats,since=1.4)
+         * @tiapi Return counters for the cache of script wrappers made for
+         * @tiapi native objects, which each window and frame has its own of.
+         * @tiresult(for=UI.getWrapperCacheStats,type=Object) an object with
+         * @tiresult hits, allocations, size and contexts properties
+         */
+        this->SetMethod("getWrapperCacheStats", &UIBinding::_GetWrapperCacheStats);
+
         // Initialize notifications
         this->SetBool("nativeNotifications", Notification::InitializeImpl());
 
@@ -144,6 +153,19 @@ namespace ti
         result->SetList(list);
     }
 
+    void UIBinding::_GetWrapperCacheStats(const ValueList& args, ValueRef result)
+    {
+        size_t hits, allocations, size, contexts;
+        JSUtil::GetWrapperCacheStats(hits, allocations, size, contexts);
+
+        TiObjectRef stats(new StaticBoundObject());
+        stats->SetDouble("hits", hits);
+        stats->SetDouble("allocations", allocations);
+        stats->SetInt("size", size);
+        stats->SetInt("contexts", contexts);
+        result->SetObject(stats);
+    }
+
     void UIBinding::_GetMainWindow(const ValueList& args, ValueRef result)
     {
         result->SetObject(this->mainWindow);
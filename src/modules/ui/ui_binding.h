@@ -31,6 +31,7 @@ namespace ti
         void ClearTray();
         void UnregisterTrayItem(TrayItem*);
         void _GetOpenWindows(const ValueList& args, ValueRef result);
+        void _GetWrapperCacheStats(const ValueList& args, ValueRef result);
         void _GetMainWindow(const ValueList& args, ValueRef result);
         void _CreateWindow(const ValueList& args, ValueRef result);
         void _CreateNotification(const ValueList& args, ValueRef result);
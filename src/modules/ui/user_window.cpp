@@ -14,6 +14,15 @@ using namespace TideUtils;
 #include "ui_module.h"
 #include <tide/javascript/javascript_module_instance.h>
 
+#include <Poco/Timestamp.h>
+#include <algorithm>
+
+// Collect garbage after a page initializes only when this many pages
+// have initialized, or this long has passed, since the last collection.
+// Frames that load together then share one collection.
+#define GC_PAGE_INTERVAL 8
+#define GC_TIME_INTERVAL_MS 5000
+
 namespace ti
 {
 UserWindow::UserWindow(AutoPtr<WindowConfig> config, AutoUserWindow parent) :
@@ -188,6 +197,7 @@ void UserWindow::Closed()
 {
     this->config->SetVisible(false);
     this->FireEvent(Event::CLOSED);
+    this->UnregisterJSContexts();
 
     // Close all children and cleanup
     std::vector<AutoUserWindow>::iterator iter = this->children.begin();
@@ -1522,6 +1532,15 @@ static bool IsMainFrame(JSGlobalContextRef ctx, JSObjectRef global)
 
 void UserWindow::InsertAPI(TiObjectRef frameGlobal)
 {
+    // The API objects only depend on this window, so build them once and
+    // give the same ones to every frame and page that loads in it. Their
+    // properties are looked up on demand when a page first uses them.
+    if (!this->apiObject.isNull())
+    {
+        frameGlobal->SetObject(GLOBAL_NAMESPACE, this->apiObject);
+        return;
+    }
+
     // Produce a delegating object to represent the top-level Ti object.
     // When a property isn't found in this object it will look for it globally.
     TiObjectRef windowTiObject(new AccessorObject());
@@ -1546,20 +1565,53 @@ void UserWindow::InsertAPI(TiObjectRef frameGlobal)
     windowTiObject->Set("UI", Value::NewObject(delegateUIAPI));
 
     // Place the Ti object into the window's global object
-    TiObjectRef delegateGlobalObject = new DelegatingObject(
-        host->GetGlobalObject(), windowTiObject);
-    frameGlobal->SetObject(GLOBAL_NAMESPACE, delegateGlobalObject);
+    this->apiObject = new DelegatingObject(host->GetGlobalObject(), windowTiObject);
+    frameGlobal->SetObject(GLOBAL_NAMESPACE, this->apiObject);
 }
 
+// Page initialization and collection both happen on the main thread.
+static bool garbageCollectionPending = false;
+static int pagesSinceGarbageCollection = 0;
+static Poco::Timestamp lastGarbageCollection;
+
 static ValueRef DeferredGarbageCollection(const ValueList& args)
 {
     JavaScriptModuleInstance::GarbageCollect();
+    garbageCollectionPending = false;
+    pagesSinceGarbageCollection = 0;
+    lastGarbageCollection.update();
     return Value::Undefined;
 }
 
+static void ScheduleGarbageCollection()
+{
+    pagesSinceGarbageCollection++;
+    if (garbageCollectionPending)
+        return;
+
+    if (pagesSinceGarbageCollection < GC_PAGE_INTERVAL &&
+        !lastGarbageCollection.isElapsed((Poco::Timestamp::TimeDiff) GC_TIME_INTERVAL_MS * 1000))
+        return;
+
+    garbageCollectionPending = true;
+    RunOnMainThread(new FunctionPtrMethod(&DeferredGarbageCollection),
+        ArgList(), false);
+}
+
 void UserWindow::RegisterJSContext(JSGlobalContextRef context)
 {
     JSObjectRef globalObject = JSContextGetGlobalObject(context);
+    bool mainFrame = IsMainFrame(context, globalObject);
+
+    // A new page in the main frame replaces all the frames of the old
+    // one, so the contexts of those can be let go of.
+    if (mainFrame)
+        this->UnregisterJSContexts(context);
+    if (std::find(jsContexts.begin(), jsContexts.end(), context) == jsContexts.end())
+    {
+        JSGlobalContextRetain(context);
+        this->jsContexts.push_back(context);
+    }
     JSUtil::RegisterGlobalContext(globalObject, context);
 
     // Get the global object as a KKJSObject
@@ -1568,7 +1620,7 @@ void UserWindow::RegisterJSContext(JSGlobalContextRef context)
     // We only want to set this UserWindow's DOM window property if the
     // particular frame that just loaded was the main frame. Each frame
     // that loads on a page will follow this same code path.
-    if (IsMainFrame(context, globalObject))
+    if (mainFrame)
         this->domWindow = frameGlobal->GetObject("window", 0);
 
     // Only certain pages should get the Ti object. This is to prevent
@@ -1588,10 +1640,28 @@ void UserWindow::RegisterJSContext(JSGlobalContextRef context)
     this->FireEvent(event);
 
     // The page location has changed, but JavaScriptCore may have references
-    // to old DOMs still in memory waiting on garbage collection. Force a GC
-    // here so that memory usage stays reasonable.
-    RunOnMainThread(new FunctionPtrMethod(&DeferredGarbageCollection),
-        ArgList(), false);
+    // to old DOMs still in memory waiting on garbage collection. Collect
+    // every so often so that memory usage stays reasonable.
+    ScheduleGarbageCollection();
+}
+
+void UserWindow::UnregisterJSContexts(JSGlobalContextRef keep)
+{
+    // Unregistering drops the wrappers cached for a context, which would
+    // otherwise keep their native objects alive for as long as we run.
+    std::vector<JSGlobalContextRef> contexts;
+    contexts.swap(this->jsContexts);
+    for (size_t i = 0; i < contexts.size(); i++)
+    {
+        if (contexts[i] == keep)
+        {
+            this->jsContexts.push_back(keep);
+            continue;
+        }
+
+        JSUtil::UnregisterGlobalContext(contexts[i]);
+        JSGlobalContextRelease(contexts[i]);
+    }
 }
 
 void UserWindow::LoadUIJavaScript(JSGlobalContextRef context)
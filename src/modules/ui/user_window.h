@@ -40,6 +40,7 @@ namespace ti
             virtual ~UserWindow();
             void UpdateWindowForURL(std::string url);
             void RegisterJSContext(JSGlobalContextRef);
+            void UnregisterJSContexts(JSGlobalContextRef keep=0);
             void InsertAPI(TiObjectRef frameGlobal);
             void PageLoaded(TiObjectRef scope, std::string &url, JSGlobalContextRef context);
             inline TiObjectRef GetDOMWindow() { return this->domWindow; }
@@ -231,6 +232,8 @@ namespace ti
             Logger* logger;
             AutoUIBinding binding;
             TiObjectRef domWindow;
+            std::vector<JSGlobalContextRef> jsContexts;
+            TiObjectRef apiObject;
             Host* host;
             AutoPtr<WindowConfig> config;
             AutoUserWindow parent;
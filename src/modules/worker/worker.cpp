@@ -144,7 +144,19 @@ namespace ti
 
     void Worker::_PostMessage(const ValueList& args, ValueRef result)
     {
-        workerContext->SendMessageToWorker(args.GetValue(0));
+        workerContext->SendMessageToWorker(SnapshotMessage(args.GetValue(0)));
+    }
+
+    ValueRef SnapshotMessage(ValueRef message)
+    {
+        // Copy script arrays and objects when they are posted, so that
+        // the receiving thread never reads them through the sender's
+        // context.
+        if (message->IsList())
+            return Value::NewList(message->ToList()->SnapshotList());
+        else if (message->IsObject())
+            return Value::NewObject(message->ToObject()->Snapshot());
+        return message;
     }
 
     void Worker::Set(const char* name, ValueRef value)
@@ -20,6 +20,8 @@ namespace ti
 {
     class WorkerContext;
 
+    ValueRef SnapshotMessage(ValueRef message);
+
     class Worker : public EventObject
     {
     public:
@@ -138,7 +138,7 @@ namespace ti
 
     void WorkerContext::_PostMessage(const ValueList &args, ValueRef result)
     {
-        worker->SendMessageToMainThread(args.GetValue(0));
+        worker->SendMessageToMainThread(SnapshotMessage(args.GetValue(0)));
     }
 
     void WorkerContext::_Sleep(const ValueList &args, ValueRef result)
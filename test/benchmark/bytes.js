@@ -0,0 +1,51 @@
+// Timing benchmarks for Bytes. These are not specs: run this file on its
+// own and compare the logged rates between builds.
+function rate(megabytes, start) {
+    var seconds = Math.max(new Date().getTime() - start, 1) / 1000;
+    return seconds + "s (" + Math.round(megabytes / seconds) + " MB/s)";
+}
+
+(function bytesThroughput() {
+    var line = "Only two things are infinite, the universe and human stupidity.";
+    var text = "";
+    while (text.length < 4 * 1024 * 1024)
+        text += line + "\n";
+    var bytes = Ti.API.createBytes(text);
+    var megabytes = bytes.length / (1024 * 1024);
+
+    var start = new Date().getTime();
+    var lines = bytes.split("\n");
+    Ti.API.info("split into " + lines.length + " lines: " + rate(megabytes, start));
+
+    start = new Date().getTime();
+    lines = bytes.splitBytes("\n");
+    Ti.API.info("splitBytes into " + lines.length + " lines: " + rate(megabytes, start));
+
+    // The needle is only at the very end, so each search scans everything.
+    var needle = "the end of the universe";
+    var haystack = Ti.API.createBytes(text + needle);
+    start = new Date().getTime();
+    for (var i = 0; i < 10; i++) {
+        if (haystack.indexOf(needle) != text.length)
+            throw new Error("indexOf did not find the needle");
+    }
+    Ti.API.info("indexOf x10: " + rate(10 * megabytes, start));
+
+    // This needle is nowhere, so each backward search scans everything.
+    start = new Date().getTime();
+    for (var i = 0; i < 10; i++) {
+        if (haystack.lastIndexOf("the start of the universe") != -1)
+            throw new Error("lastIndexOf found a needle that is not there");
+    }
+    Ti.API.info("lastIndexOf x10: " + rate(10 * megabytes, start));
+
+    start = new Date().getTime();
+    bytes.toUpperCase();
+    bytes.toLowerCase();
+    Ti.API.info("toUpperCase and toLowerCase: " + rate(2 * megabytes, start));
+
+    start = new Date().getTime();
+    for (var offset = 0; offset + 1024 <= bytes.length; offset += 1024)
+        bytes.slice(offset, 1024);
+    Ti.API.info("slice into 1 KB pieces: " + rate(megabytes, start));
+})();
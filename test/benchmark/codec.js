@@ -0,0 +1,75 @@
+// Timing benchmarks for Ti.Codec. These are not specs: run this file
+// on its own and compare the logged rates between builds.
+//
+// The string functions (encodeBase64, decodeBase64, encodeHexBinary and
+// decodeHexBinary) exist in every build, so running this file on a build
+// from before the Bytes codecs and on a current one compares the old and
+// new implementations directly. The page's own btoa and atob are timed
+// over the same data in each run as a fixed point of reference, so rates
+// from different machines can be compared as ratios.
+var testString = "Only two things are infinite, the universe and human stupidity, and I'm not sure about the former. -- Albert Einstein";
+
+function megabytesPerSecond(megabytes, start) {
+    return Math.round(megabytes / (Math.max(new Date().getTime() - start, 1) / 1000));
+}
+
+function compare(name, megabytes, encode, decode, reference) {
+    var start = new Date().getTime();
+    var encoded = encode();
+    var encodeRate = megabytesPerSecond(megabytes, start);
+
+    start = new Date().getTime();
+    decode(encoded);
+    var decodeRate = megabytesPerSecond(megabytes, start);
+
+    var message = name + ": encode " + encodeRate + " MB/s, decode " + decodeRate + " MB/s";
+    if (reference) {
+        message += " (" + (encodeRate / reference.encode).toFixed(1) + "x and " +
+            (decodeRate / reference.decode).toFixed(1) + "x btoa/atob)";
+    }
+    Ti.API.info(message);
+    return {encode: encodeRate, decode: decodeRate};
+}
+
+(function encodingThroughput() {
+    var chunk = testString;
+    while (chunk.length < 1024 * 1024)
+        chunk += chunk;
+    var megabytes = chunk.length / (1024 * 1024);
+
+    var reference = null;
+    if (typeof btoa == "function" && typeof atob == "function") {
+        reference = compare("btoa and atob", megabytes,
+            function () { return btoa(chunk); },
+            function (encoded) { return atob(encoded); });
+    }
+
+    // Present in every build.
+    compare("encodeBase64 and decodeBase64 strings", megabytes,
+        function () { return Ti.Codec.encodeBase64(chunk); },
+        function (encoded) { return Ti.Codec.decodeBase64(encoded); },
+        reference);
+    compare("encodeHexBinary and decodeHexBinary strings", megabytes,
+        function () { return Ti.Codec.encodeHexBinary(chunk); },
+        function (encoded) { return Ti.Codec.decodeHexBinary(encoded); },
+        reference);
+
+    // Builds before the Bytes codecs stop here.
+    if (typeof Ti.Codec.encode != "function")
+        return;
+
+    var data = Ti.API.createBytes(chunk);
+    var names = ["BASE64", "BASE64URL", "HEX"];
+    for (var i = 0; i < names.length; i++) {
+        var type = Ti.Codec[names[i]];
+        compare(names[i] + " Bytes", megabytes,
+            function () { return Ti.Codec.encode(type, data); },
+            function (encoded) {
+                var decoded = Ti.Codec.decode(type, encoded);
+                if (decoded.length != data.length)
+                    throw new Error(names[i] + " decoded " + decoded.length + " of " + data.length + " bytes");
+                return decoded;
+            },
+            reference);
+    }
+})();
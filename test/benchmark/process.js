@@ -0,0 +1,19 @@
+// Timing benchmarks for Ti.Process. These are not specs: run this file
+// on its own and compare the logged rates between builds.
+var isWindows = Ti.Platform.getName().indexOf("Windows") != -1,
+    trueCommand = isWindows ? ["C:\\Windows\\System32\\cmd.exe", "/c", "exit", "0"] : ["true"],
+    spawnCount = 200;
+
+(function spawnRate() {
+    var start = new Date().getTime();
+    for (var i = 0; i < spawnCount; i++) {
+        var process = Ti.Process.createProcess(trueCommand);
+        process();
+        if (process.getExitCode() != 0)
+            throw new Error("Process " + i + " exited with " + process.getExitCode());
+    }
+
+    var seconds = Math.max(new Date().getTime() - start, 1) / 1000;
+    Ti.API.info("Spawned " + spawnCount + " processes in " + seconds +
+        "s (" + Math.round(spawnCount / seconds) + " per second)");
+})();
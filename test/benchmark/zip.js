@@ -0,0 +1,53 @@
+// Timing benchmarks for zip archives. These are not specs: run this file
+// on its own and compare the logged rates between builds.
+var fileCount = 200,
+    fileSize = 256 * 1024;
+
+function writeFile(file, contents) {
+    var stream = file.open(Ti.Filesystem.MODE_WRITE);
+    stream.write(contents);
+    stream.close();
+}
+
+function rate(megabytes, start) {
+    var seconds = Math.max(new Date().getTime() - start, 1) / 1000;
+    return seconds + "s (" + Math.round(megabytes / seconds) + " MB/s)";
+}
+
+(function zipThroughput() {
+    var source = Ti.Filesystem.createTempDirectory(),
+        output = Ti.Filesystem.createTempDirectory(),
+        zipFile = Ti.Filesystem.createTempDirectory().resolve("benchmark.zip");
+
+    // Text compresses like typical application resources do.
+    var chunk = "Only two things are infinite, the universe and human stupidity. ";
+    var contents = "";
+    while (contents.length < fileSize)
+        contents += chunk + contents.length + "\n";
+    for (var i = 0; i < fileCount; i++) {
+        var directory = source.resolve("dir" + (i % 10));
+        if (!directory.exists())
+            directory.createDirectory();
+        writeFile(directory.resolve("file" + i + ".txt"), contents);
+    }
+    var megabytes = fileCount * contents.length / (1024 * 1024);
+
+    var start = new Date().getTime();
+    Ti.Codec.createZip(source, zipFile, function () {
+        Ti.API.info("createZip of " + fileCount + " files: " + rate(megabytes, start));
+
+        start = new Date().getTime();
+        Ti.Codec.extractZip(zipFile, output.resolve("codec"), function () {
+            Ti.API.info("extractZip of " + fileCount + " files: " + rate(megabytes, start));
+
+            start = new Date().getTime();
+            if (!zipFile.unzip(output.resolve("file")))
+                throw new Error("Could not unzip " + zipFile);
+            Ti.API.info("File.unzip of " + fileCount + " files: " + rate(megabytes, start));
+
+            source.deleteDirectory(true);
+            output.deleteDirectory(true);
+            zipFile.parent().deleteDirectory(true);
+        });
+    });
+})();
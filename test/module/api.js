@@ -0,0 +1,103 @@
+describe("Bytes", function () {
+    function strings(list) {
+        var result = [];
+        for (var i = 0; i < list.length; i++)
+            result.push(list[i].toString());
+        return result;
+    }
+
+    function lengths(list) {
+        var result = [];
+        for (var i = 0; i < list.length; i++)
+            result.push(list[i].length);
+        return result;
+    }
+
+    describe("split", function () {
+        it("keeps empty pieces like String.split", function () {
+            var bytes = Ti.API.createBytes("abc,def,,");
+            expect(strings(bytes.split(","))).toEqual(["abc", "def", "", ""]);
+            expect(strings(bytes.split(",", 2))).toEqual(["abc", "def"]);
+            expect(strings(bytes.split(",", 0))).toEqual([]);
+        });
+
+        it("skips the whole of a separator longer than one byte", function () {
+            var bytes = Ti.API.createBytes("a--b----c");
+            expect(strings(bytes.split("--"))).toEqual(["a", "b", "", "c"]);
+        });
+
+        it("splits every byte on an empty separator", function () {
+            expect(strings(Ti.API.createBytes("abc").split(""))).toEqual(["a", "b", "c"]);
+        });
+
+        it("returns the whole buffer without a separator or when empty", function () {
+            expect(strings(Ti.API.createBytes("a,b").split())).toEqual(["a,b"]);
+            expect(strings(Ti.API.createBytes("").split(","))).toEqual([""]);
+        });
+
+        it("reads past NUL bytes", function () {
+            var bytes = Ti.Codec.decode(Ti.Codec.HEX, "6100622c63");
+            expect(lengths(bytes.splitBytes(","))).toEqual([3, 1]);
+        });
+
+        it("returns slices from splitBytes", function () {
+            var bytes = Ti.API.createBytes("one two");
+            var pieces = bytes.splitBytes(" ");
+            expect(strings(pieces)).toEqual(["one", "two"]);
+            bytes.write("T", 4);
+            expect(pieces[1].toString()).toEqual("Two");
+        });
+    });
+
+    describe("indexOf", function () {
+        var bytes = Ti.API.createBytes("hello world hello");
+
+        it("finds needles at the start, middle and end", function () {
+            expect(bytes.indexOf("hello")).toEqual(0);
+            expect(bytes.indexOf("world")).toEqual(6);
+            expect(bytes.indexOf("hello", 1)).toEqual(12);
+            expect(bytes.indexOf("o", 17)).toEqual(-1);
+        });
+
+        it("checks the whole needle, not just its first and last bytes", function () {
+            expect(bytes.indexOf("hxllo")).toEqual(-1);
+            expect(bytes.indexOf("hello world hello!")).toEqual(-1);
+        });
+
+        it("clamps the start like String.indexOf", function () {
+            expect(bytes.indexOf("hello", -5)).toEqual(0);
+            expect(bytes.indexOf("hello", 100)).toEqual(-1);
+            expect(bytes.indexOf("")).toEqual(0);
+            expect(bytes.indexOf("", 5)).toEqual(5);
+        });
+
+        it("searches buffers longer than a vector register", function () {
+            var text = "";
+            for (var i = 0; i < 100; i++)
+                text += "ab";
+            var long = Ti.API.createBytes(text + "abc" + text);
+            expect(long.indexOf("abc")).toEqual(200);
+            expect(long.indexOf("abc", 201)).toEqual(-1);
+            expect(long.lastIndexOf("ab")).toEqual(401);
+        });
+
+        it("reads past NUL bytes", function () {
+            var binary = Ti.Codec.decode(Ti.Codec.HEX, "6100622c63");
+            expect(binary.indexOf(",")).toEqual(3);
+        });
+    });
+
+    describe("slice", function () {
+        var bytes = Ti.API.createBytes("hello world");
+
+        it("returns the given range", function () {
+            expect(bytes.slice(6, 5).toString()).toEqual("world");
+            expect(bytes.slice(0, 5).toString()).toEqual("hello");
+        });
+
+        it("is empty when given a length of zero", function () {
+            expect(bytes.slice(3, 0).length).toEqual(0);
+            expect(bytes.slice(3, 0).toString()).toEqual("");
+        });
+    });
+});
@@ -18,6 +18,36 @@ describe("appURLToPath", function () {
     });
 });
 
+describe("getURLCacheStats", function () {
+    it("counts repeated conversions as cache hits", function () {
+        Ti.App.appURLToPath("app://index.html");
+        var before = Ti.App.getURLCacheStats();
+        Ti.App.appURLToPath("app://index.html");
+        var after = Ti.App.getURLCacheStats();
+        expect(after.hits).toBeGreaterThan(before.hits);
+        expect(after.size).toBeGreaterThan(0);
+    });
+});
+
+describe("native wrappers", function () {
+    it("are reused for the same native value", function () {
+        expect(Ti.App.getURLCacheStats).toBe(Ti.App.getURLCacheStats);
+        expect(Ti.App).toBe(Ti.App);
+    });
+
+    it("stay usable after being evicted from the cache", function () {
+        var first = Ti.App.createProperties({name: "first"});
+        var others = [];
+        for (var i = 0; i < 1000; i++) {
+            others.push(Ti.App.createProperties());
+        }
+        others = null;
+
+        expect(first.getString("name")).toEqual("first");
+        expect(Ti.App.getURLCacheStats).toBe(Ti.App.getURLCacheStats);
+    });
+});
+
 // TODO: implement a test for the exit() function.
 xdescribe("exit", function () {});
 
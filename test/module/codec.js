@@ -16,12 +16,51 @@ describe("checksum", function () {
     });
 });
 
+describe("createChecksum", function () {
+    it("computes a CRC32C checksum over several updates", function () {
+        var checksum = Ti.Codec.createChecksum(Ti.Codec.CRC32C);
+        checksum.update(testString.substring(0, 10));
+        checksum.update(testString.substring(10));
+        expect(checksum.digest()).toEqual("90d2c5b6");
+    });
+
+    it("uses CRC32 by default", function () {
+        expect(Ti.Codec.createChecksum().update(testString).digest()).toEqual("b2b0664c");
+    });
+});
+
+describe("createDigest", function () {
+    it("computes a SHA256 digest over several updates", function () {
+        var digest = Ti.Codec.createDigest(Ti.Codec.SHA256);
+        digest.update(testString.substring(0, 50));
+        digest.update(Ti.API.createBytes(testString.substring(50)));
+        expect(digest.digest()).toEqual("28682dff9046ebd581a1d0bc42f89d28bddbfd476695f12f1e71236a18fc66ad");
+    });
+
+    it("resets after computing a digest", function () {
+        var digest = Ti.Codec.createDigest(Ti.Codec.SHA512);
+        digest.update("something else").digest();
+        expect(digest.update(testString).digest()).toEqual(Ti.Codec.digestToHex(Ti.Codec.SHA512, testString));
+    });
+
+    it("computes an HMAC when given a key", function () {
+        var digest = Ti.Codec.createDigest(Ti.Codec.SHA256, "secret");
+        expect(digest.update(testString).digest()).toEqual("6f8da2fddce0ba8e9a5dfdff545edb8a06b172da81c0cd79b94289872e56820b");
+        expect(Ti.Codec.digestHMACToHex(Ti.Codec.SHA256, testString, "secret")).toEqual("6f8da2fddce0ba8e9a5dfdff545edb8a06b172da81c0cd79b94289872e56820b");
+    });
+
+    it("pads MD2 HMAC keys to the block size Poco has always used", function () {
+        var expected = "b894ac638bc69ef8ecdb97f4ca8d1ece";
+        expect(Ti.Codec.digestHMACToHex(Ti.Codec.MD2, testString, "secret")).toEqual(expected);
+        expect(Ti.Codec.createDigest(Ti.Codec.MD2, "secret").update(testString).digest()).toEqual(expected);
+    });
+});
+
 xdescribe("createZip", function () {
     // TODO
 });
 
 describe("decodeBase64", function () {
-    // FIXME: appears our impl is putting newlines in the hash causing these tests to fail.
     it("returns the original string that was base 64 encoded", function () {
         expect(Ti.Codec.decodeBase64(base64Encoded)).toEqual(testString);
     });
@@ -44,3 +83,69 @@ describe("encodeHexBinary", function () {
         expect(Ti.Codec.encodeHexBinary(testString)).toEqual(hexEncoded);
     });
 });
+
+describe("encode", function () {
+    var binary = Ti.Codec.decode(Ti.Codec.HEX, "00fb00ff");
+
+    it("returns Bytes in each encoding", function () {
+        expect(Ti.Codec.encode(Ti.Codec.BASE64, testString).toString()).toEqual(base64Encoded);
+        expect(Ti.Codec.encode(Ti.Codec.HEX, testString).toString()).toEqual(hexEncoded);
+    });
+
+    it("uses the URL safe alphabet without padding for BASE64URL", function () {
+        expect(Ti.Codec.encode(Ti.Codec.BASE64URL, "??>").toString()).toEqual("Pz8-");
+        expect(Ti.Codec.encode(Ti.Codec.BASE64URL, "??").toString()).toEqual("Pz8");
+        expect(Ti.Codec.encode(Ti.Codec.BASE64, "??").toString()).toEqual("Pz8=");
+    });
+
+    it("round trips binary data through decode", function () {
+        var types = [Ti.Codec.BASE64, Ti.Codec.BASE64URL, Ti.Codec.HEX];
+        for (var i = 0; i < types.length; i++) {
+            var decoded = Ti.Codec.decode(types[i], Ti.Codec.encode(types[i], binary));
+            expect(decoded.length).toEqual(4);
+            expect(decoded.byteAt(0)).toEqual(0);
+            expect(decoded.byteAt(1)).toEqual(251);
+        }
+    });
+
+    it("ignores whitespace when decoding and rejects invalid data", function () {
+        var wrapped = base64Encoded.substring(0, 76) + "\r\n" + base64Encoded.substring(76);
+        expect(Ti.Codec.decode(Ti.Codec.BASE64, wrapped).toString()).toEqual(testString);
+        expect(function () { Ti.Codec.decode(Ti.Codec.BASE64, "a!==") }).toThrow();
+        expect(function () { Ti.Codec.decode(Ti.Codec.HEX, "abc") }).toThrow();
+    });
+});
+
+describe("createEncoder", function () {
+    it("encodes data given in pieces", function () {
+        var encoder = Ti.Codec.createEncoder(Ti.Codec.BASE64);
+        var encoded = "";
+        for (var i = 0; i < testString.length; i += 7)
+            encoded += encoder.update(testString.substring(i, i + 7)).toString();
+        encoded += encoder.finish().toString();
+        expect(encoded).toEqual(base64Encoded);
+    });
+});
+
+describe("encode and decode", function () {
+    it("round-trip a large buffer in every encoding", function () {
+        var chunk = testString;
+        while (chunk.length < 64 * 1024)
+            chunk += chunk;
+        var data = Ti.API.createBytes(chunk);
+
+        var names = ["BASE64", "BASE64URL", "HEX"];
+        for (var i = 0; i < names.length; i++) {
+            var type = Ti.Codec[names[i]];
+            var decoded = Ti.Codec.decode(type, Ti.Codec.encode(type, data));
+            expect(decoded.length).toEqual(data.length);
+            expect(decoded.toString()).toEqual(chunk);
+        }
+    });
+});
+
+describe("digestToHex", function () {
+    it("supports SHA512", function () {
+        expect(Ti.Codec.digestToHex(Ti.Codec.SHA512, testString)).toEqual("de0e8252fba4a7f1856fbbfeb7a53004cf229457f9d16241392cfa47d89d6c67e6c1c1aff3fa480cbdfe5b7e2f0b99d16a24ec266016226080dfeb7a699fe5b1");
+    });
+});
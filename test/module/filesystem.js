@@ -0,0 +1,197 @@
+describe("FileStream.MODE_MAPPED", function () {
+    var file;
+
+    beforeEach(function () {
+        file = Ti.Filesystem.createTempFile();
+        var stream = file.open(Ti.Filesystem.MODE_WRITE);
+        stream.write("mapped contents");
+        stream.close();
+    });
+
+    afterEach(function () {
+        file.deleteFile();
+    });
+
+    it("returns writable data without changing the file", function () {
+        var stream = file.open(Ti.Filesystem.MODE_MAPPED);
+        var contents = stream.readAll();
+        contents.write("M", 0);
+        stream.close();
+        expect(contents.toString()).toEqual("Mapped contents");
+
+        stream = file.open(Ti.Filesystem.MODE_READ);
+        expect(stream.readAll().toString()).toEqual("mapped contents");
+        stream.close();
+    });
+});
+
+describe("asyncCopy", function () {
+    var source, destination;
+
+    function writeFile(file, contents) {
+        var stream = file.open(Ti.Filesystem.MODE_WRITE);
+        stream.write(contents);
+        stream.close();
+    }
+
+    function readFile(file) {
+        var stream = file.open(Ti.Filesystem.MODE_READ);
+        var contents = stream.readAll().toString();
+        stream.close();
+        return contents;
+    }
+
+    beforeEach(function () {
+        source = Ti.Filesystem.createTempDirectory();
+        destination = Ti.Filesystem.createTempDirectory();
+        writeFile(source.resolve("a.txt"), "first file");
+        writeFile(source.resolve("b.txt"), "second file");
+        source.resolve("nested").createDirectory();
+        writeFile(source.resolve("nested").resolve("c.txt"), "third file");
+    });
+
+    afterEach(function () {
+        source.deleteDirectory(true);
+        destination.deleteDirectory(true);
+    });
+
+    it("copies a directory and reports its progress", function () {
+        var done = 0, last = null, copier;
+        runs(function () {
+            copier = Ti.Filesystem.asyncCopy([source], destination, function () {
+                done++;
+            }, {progress: function (stats) {
+                last = stats;
+            }, progressInterval: 10});
+        });
+        waitsFor(function () {
+            return done == 1 && last && last.progress == 1;
+        }, "the copy to finish", 5000);
+        runs(function () {
+            expect(last.filesCopied).toEqual(3);
+            expect(last.totalFiles).toEqual(3);
+            expect(readFile(destination.resolve("a.txt"))).toEqual("first file");
+            expect(readFile(destination.resolve("nested").resolve("c.txt"))).toEqual("third file");
+        });
+    });
+
+    it("counts the bytes copied in its stats", function () {
+        var done = 0, copier;
+        runs(function () {
+            copier = Ti.Filesystem.asyncCopy([source], destination, function () {
+                done++;
+            });
+        });
+        waitsFor(function () {
+            return done == 1 && !copier.running;
+        }, "the copy to finish", 5000);
+        runs(function () {
+            var stats = copier.getStats();
+            var size = "first file".length + "second file".length + "third file".length;
+            expect(stats.totalBytes).toEqual(size);
+            expect(stats.bytesCopied).toEqual(size);
+            expect(stats.filesCopied).toEqual(3);
+            expect(stats.elapsed).not.toBeLessThan(0);
+        });
+    });
+
+    it("keeps running after a cancel until its workers stop", function () {
+        var done = 0, copier;
+        runs(function () {
+            copier = Ti.Filesystem.asyncCopy([source], destination, function () {
+                done++;
+            });
+            copier.cancel();
+        });
+        waitsFor(function () {
+            return !copier.running;
+        }, "the copy to stop", 5000);
+        runs(function () {
+            var stats = copier.getStats();
+            expect(copier.cancel()).toBe(false);
+            expect(stats.bytesCopied).not.toBeGreaterThan(stats.totalBytes);
+            if (stats.filesCopied < stats.totalFiles)
+                expect(done).toEqual(0);
+        });
+    });
+});
+
+describe("File.walk", function () {
+    var isWindows = Ti.Platform.getName().indexOf("Windows") != -1,
+        root;
+
+    function touch(file) {
+        var stream = file.open(Ti.Filesystem.MODE_WRITE);
+        stream.write(file.name());
+        stream.close();
+    }
+
+    // Paths relative to the root, with forward slashes, in sorted order.
+    function walk(options) {
+        var prefix = root.nativePath(),
+            entries = root.walk(options).readAll(),
+            paths = [];
+        for (var i = 0; i < entries.length; i++) {
+            var path = entries[i].path.substring(prefix.length + 1);
+            paths.push(path.replace(/\\/g, "/"));
+        }
+        return paths.sort();
+    }
+
+    beforeEach(function () {
+        root = Ti.Filesystem.createTempDirectory();
+        touch(root.resolve("a.txt"));
+        touch(root.resolve("b.log"));
+        touch(root.resolve(".hidden.txt"));
+        root.resolve("nested").createDirectory();
+        touch(root.resolve("nested").resolve("c.txt"));
+        root.resolve("nested").resolve("deeper").createDirectory();
+        touch(root.resolve("nested").resolve("deeper").resolve("d.txt"));
+    });
+
+    afterEach(function () {
+        root.deleteDirectory(true);
+    });
+
+    it("walks into every directory", function () {
+        expect(walk()).toEqual([".hidden.txt", "a.txt", "b.log", "nested",
+            "nested/c.txt", "nested/deeper", "nested/deeper/d.txt"]);
+    });
+
+    it("stops at maxDepth and can skip hidden entries", function () {
+        expect(walk({maxDepth: 0, hidden: false})).toEqual(["a.txt", "b.log", "nested"]);
+        expect(walk({maxDepth: 1, directories: false})).toEqual(
+            [".hidden.txt", "a.txt", "b.log", "nested/c.txt"]);
+    });
+
+    it("filters names with a glob", function () {
+        expect(walk({pattern: "*.txt", hidden: false})).toEqual(
+            ["a.txt", "nested/c.txt", "nested/deeper/d.txt"]);
+        expect(walk({pattern: "?.log"})).toEqual(["b.log"]);
+        expect(walk({pattern: "deep*", files: false})).toEqual(["nested/deeper"]);
+    });
+
+    it("reports symbolic links without following them", function () {
+        if (isWindows)
+            return;
+        expect(root.resolve("nested").createShortcut(root.resolve("link"))).toBeTruthy();
+
+        var entries = root.walk({pattern: "link"}).readAll();
+        expect(entries.length).toEqual(1);
+        expect(entries[0].type).toEqual("symlink");
+
+        var paths = walk();
+        for (var i = 0; i < paths.length; i++)
+            expect(paths[i].indexOf("link/")).toEqual(-1);
+    });
+
+    it("can be stopped before it finishes", function () {
+        var walker = root.walk({batchSize: 2});
+        expect(walker.next().length).toEqual(2);
+        expect(walker.next(1).length).toEqual(1);
+        expect(walker.hasNext()).toBeTruthy();
+        walker.close();
+        expect(walker.hasNext()).toBeFalsy();
+        expect(walker.next()).toBeNull();
+    });
+});
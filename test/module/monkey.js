@@ -0,0 +1,61 @@
+describe("Monkey._matches", function () {
+    // The reference matcher: a userscript glob as a regular expression,
+    // in which only '*' is special.
+    function globToRegExp(glob) {
+        var parts = glob.split("*");
+        for (var i = 0; i < parts.length; i++)
+            parts[i] = parts[i].replace(/[\\^$.|?+()\[\]{}\/]/g, "\\$&");
+        return new RegExp("^" + parts.join("[\\s\\S]*") + "$");
+    }
+
+    function repeat(s, count) {
+        var result = "";
+        for (var i = 0; i < count; i++)
+            result += s;
+        return result;
+    }
+
+    var patterns = [
+        "", "*", "**", "***",
+        "http://example.com/", "http://example.com/*",
+        "http://*.example.com/*", "*://example.com/*",
+        "http://example.com/*.js", "*example*", "*.com",
+        "http://example.com/?q=*", "http://example.com/a*b*c",
+        "*a*a*a*b", "a*", "*a", "a**b", "*?*"
+    ];
+    var urls = [
+        "", "a", "ab", "aab", "b",
+        "http://example.com/", "http://example.com/index.html",
+        "http://www.example.com/path", "https://example.com/x.js",
+        "http://example.com/?q=tide", "http://example.com/abc",
+        "http://example.com/axbxc", "http://example.com/acb",
+        "http://example.org/", "?", repeat("a", 16), repeat("a", 16) + "b"
+    ];
+
+    it("agrees with a regular expression for each glob", function () {
+        for (var i = 0; i < patterns.length; i++) {
+            var expected = globToRegExp(patterns[i]);
+            for (var j = 0; j < urls.length; j++) {
+                var matched = Ti.Monkey._matches(urls[j], [patterns[i]]);
+                expect("'" + patterns[i] + "' ~ '" + urls[j] + "': " + matched).toEqual(
+                    "'" + patterns[i] + "' ~ '" + urls[j] + "': " + expected.test(urls[j]));
+            }
+        }
+    });
+
+    it("lets an exclude override every include", function () {
+        expect(Ti.Monkey._matches("http://example.com/a",
+            ["http://example.com/*", "*"], ["*/a"])).toBeFalsy();
+        expect(Ti.Monkey._matches("http://example.com/b",
+            ["http://example.com/*", "*"], ["*/a"])).toBeTruthy();
+    });
+
+    it("does not backtrack on many wildcards", function () {
+        var pattern = repeat("*a", 30) + "*b";
+        var url = repeat("a", 5000);
+        var start = new Date().getTime();
+        expect(Ti.Monkey._matches(url, [pattern])).toBeFalsy();
+        expect(Ti.Monkey._matches(url + "b", [pattern])).toBeTruthy();
+        expect(new Date().getTime() - start).toBeLessThan(1000);
+    });
+});
@@ -0,0 +1,94 @@
+describe("getHostByName", function () {
+    it("resolves localhost", function () {
+        var host = Ti.Network.getHostByName("localhost");
+        expect(host.isInvalid()).toBeFalsy();
+        expect(host.getAddresses().length).toBeGreaterThan(0);
+    });
+
+    it("answers repeated lookups from the cache", function () {
+        Ti.Network.clearDNSCache();
+        Ti.Network.getHostByName("localhost");
+        var before = Ti.Network.getDNSStats();
+        Ti.Network.getHostByName("localhost");
+        var after = Ti.Network.getDNSStats();
+        expect(after.cacheHits).toEqual(before.cacheHits + 1);
+        expect(after.size).toBeGreaterThan(0);
+    });
+
+    it("returns a job when given a callback", function () {
+        var job = Ti.Network.getHostByName("localhost", function (host) {});
+        expect(job.isComplete).toBeDefined();
+    });
+});
+
+describe("clearDNSCache", function () {
+    it("empties the cache", function () {
+        Ti.Network.getHostByName("localhost");
+        Ti.Network.clearDNSCache();
+        expect(Ti.Network.getDNSStats().size).toEqual(0);
+    });
+});
+
+describe("Analytics", function () {
+    var server, environment;
+
+    beforeEach(function () {
+        environment = Ti.API.getEnvironment();
+        server = Ti.Network.createHTTPServer();
+    });
+
+    afterEach(function () {
+        environment.TIDE_ANALYTICS_BATCH_URL = "";
+        server.close();
+    });
+
+    it("batches events and replays a failed batch", function () {
+        var requests = [], before;
+
+        runs(function () {
+            // Fail the first batch so that the sender has to send it again.
+            server.bind(18052, function (request, response) {
+                var body = request.read(65536);
+                requests.push({
+                    encoding: request.getHeader("Content-Encoding"),
+                    body: body ? Ti.Codec.encodeBase64(body) : ""
+                });
+                if (requests.length == 1)
+                    response.setStatusAndReason("503", "Service Unavailable");
+                else
+                    response.setStatus("200");
+                response.setContentLength(0);
+            });
+
+            environment.TIDE_ANALYTICS_BATCH_URL = "http://127.0.0.1:18052/";
+            before = Ti.Analytics.getStats();
+            for (var i = 0; i < 20; i++)
+                Ti.Analytics._sendEvent("type=spec&event=" + i);
+        });
+        waitsFor(function () {
+            return requests.length >= 2 &&
+                Ti.Analytics.getStats().sent >= before.sent + 20;
+        }, "the batch to be sent again", 15000);
+        runs(function () {
+            var after = Ti.Analytics.getStats();
+            expect(requests[0].encoding).toEqual("gzip");
+            expect(requests[0].body.length).toBeGreaterThan(0);
+            expect(requests[1].body).toEqual(requests[0].body);
+            expect(after.batches).toBeGreaterThan(before.batches);
+            expect(after.failures).toBeGreaterThan(before.failures);
+            expect(after.pending).toEqual(0);
+        });
+    });
+});
+
+describe("TCPServerSocket.listen", function () {
+    it("rejects reactor counts and buffer sizes below one", function () {
+        var server = Ti.Network.createTCPServerSocket(function (connection) {});
+        expect(function () {
+            server.listen(18053, {reactors: -1});
+        }).toThrow();
+        expect(function () {
+            server.listen(18053, {readBufferSize: 0});
+        }).toThrow();
+    });
+});
@@ -0,0 +1,143 @@
+var isWindows = Ti.Platform.getName().indexOf("Windows") != -1,
+    trueCommand = isWindows ? ["C:\\Windows\\System32\\cmd.exe", "/c", "exit", "0"] : ["true"];
+
+describe("createProcess", function () {
+    it("finds a command on the PATH", function () {
+        var process = Ti.Process.createProcess(trueCommand);
+        process();
+        expect(process.getExitCode()).toEqual(0);
+    });
+
+    it("captures the output of a process", function () {
+        var command = isWindows ? ["C:\\Windows\\System32\\cmd.exe", "/c", "echo tide"] : ["echo", "tide"];
+        var output = Ti.Process.createProcess(command)();
+        expect(output.toString().replace(/\s+$/, "")).toEqual("tide");
+    });
+
+    it("passes its environment to the process", function () {
+        if (isWindows)
+            return;
+        var process = Ti.Process.createProcess(["sh", "-c", "echo $TIDE_SPAWN_TEST"]);
+        process.setEnvironment("TIDE_SPAWN_TEST", "launched");
+        expect(process().toString().replace(/\s+$/, "")).toEqual("launched");
+    });
+
+    it("keeps the rest of the environment when given one", function () {
+        if (isWindows)
+            return;
+        var process = Ti.Process.createProcess({
+            args: ["sh", "-c", "echo $TIDE_SPAWN_TEST:$HOME"],
+            env: {TIDE_SPAWN_TEST: "launched"}
+        });
+        var home = Ti.Process.createProcess(trueCommand).getEnvironment("HOME");
+        var expected = "launched:" + home;
+        expect(process().toString().replace(/\s+$/, "")).toEqual(expected);
+    });
+
+    it("reports resource usage once the process exits", function () {
+        var process = Ti.Process.createProcess(trueCommand);
+        expect(process.getResourceUsage()).toBeNull();
+        process();
+        if (isWindows)
+            return;
+        var usage = process.getResourceUsage();
+        expect(usage.userTime).not.toBeLessThan(0);
+        expect(usage.systemTime).not.toBeLessThan(0);
+        expect(usage.maxRSS).toBeGreaterThan(0);
+    });
+
+    it("fires the exit event of a launched process", function () {
+        var process = Ti.Process.createProcess(trueCommand),
+            exits = 0;
+        process.setOnExit(function () {
+            exits++;
+        });
+
+        runs(function () {
+            process.launch();
+        });
+        waitsFor(function () {
+            return exits > 0;
+        }, "the exit event", 5000);
+        runs(function () {
+            expect(exits).toEqual(1);
+            expect(process.getExitCode()).toEqual(0);
+            expect(process.isRunning()).toBe(false);
+        });
+    });
+
+    it("runs synchronously with its output attached to another process", function () {
+        if (isWindows)
+            return;
+        var producer = Ti.Process.createProcess(["echo", "tide"]),
+            consumer = Ti.Process.createProcess(["cat"]);
+        producer.getStdout().attach(consumer.getStdin());
+
+        var output = producer();
+        expect(output.toString().replace(/\s+$/, "")).toEqual("tide");
+        expect(producer.getExitCode()).toEqual(0);
+        expect(consumer.isRunning()).toBe(false);
+    });
+
+    function launchLinked(observeProducer) {
+        var result = {consumed: "", produced: "", exited: false};
+        result.consumer = Ti.Process.createProcess(["cat"]);
+        result.consumer.setOnRead(function (event) {
+            result.consumed += event.data.toString();
+        });
+        result.consumer.launch();
+
+        result.producer = Ti.Process.createProcess(["echo", "tide"]);
+        if (observeProducer) {
+            result.producer.setOnRead(function (event) {
+                result.produced += event.data.toString();
+            });
+        }
+        result.producer.setOnExit(function () {
+            result.exited = true;
+        });
+        result.producer.getStdout().attach(result.consumer.getStdin());
+        result.producer.launch();
+        return result;
+    }
+
+    it("links its output straight into a running process", function () {
+        if (isWindows)
+            return;
+        var linked;
+        runs(function () {
+            linked = launchLinked(false);
+        });
+        waitsFor(function () {
+            return linked.exited && linked.consumed.indexOf("tide") != -1;
+        }, "the consumer to receive the output", 5000);
+        runs(function () {
+            expect(linked.consumed.replace(/\s+$/, "")).toEqual("tide");
+            linked.consumer.terminate();
+        });
+    });
+
+    it("still fires its own onRead when linked to a running process", function () {
+        if (isWindows)
+            return;
+        var linked;
+        runs(function () {
+            linked = launchLinked(true);
+        });
+        waitsFor(function () {
+            return linked.exited && linked.consumed.indexOf("tide") != -1 &&
+                linked.produced.indexOf("tide") != -1;
+        }, "both processes to see the output", 5000);
+        runs(function () {
+            expect(linked.consumed.replace(/\s+$/, "")).toEqual("tide");
+            expect(linked.produced.replace(/\s+$/, "")).toEqual("tide");
+            linked.consumer.terminate();
+        });
+    });
+
+    it("throws when the command does not exist", function () {
+        expect(function () {
+            Ti.Process.createProcess(["tide-no-such-command"])();
+        }).toThrow();
+    });
+});
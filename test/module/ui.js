@@ -0,0 +1,55 @@
+describe("UI.getWrapperCacheStats", function () {
+    var directory, page;
+
+    beforeEach(function () {
+        // Pages loaded from files get the Ti object, so the page makes
+        // wrappers of its own when it touches it.
+        directory = Ti.Filesystem.createTempDirectory();
+        page = directory.resolve("wrappers.html");
+        var stream = page.open(Ti.Filesystem.MODE_WRITE);
+        stream.write("<html><body><script>" +
+            "for (var i = 0; i < 10; i++) Ti.App.createProperties();" +
+            "</script></body></html>");
+        stream.close();
+    });
+
+    afterEach(function () {
+        directory.deleteDirectory(true);
+    });
+
+    it("lets go of the wrappers of closed windows", function () {
+        var before, opened, loaded = 0, closed = 0, windows = [];
+
+        runs(function () {
+            before = Ti.UI.getWrapperCacheStats();
+            for (var i = 0; i < 3; i++) {
+                var w = Ti.UI.createWindow("file://" + page.nativePath());
+                w.addEventListener(Ti.PAGE_LOADED, function () {
+                    loaded++;
+                });
+                w.addEventListener(Ti.CLOSED, function () {
+                    closed++;
+                });
+                w.open();
+                windows.push(w);
+            }
+        });
+        waitsFor(function () {
+            return loaded == 3;
+        }, "the windows to load", 10000);
+        runs(function () {
+            opened = Ti.UI.getWrapperCacheStats();
+            expect(opened.contexts).toBeGreaterThan(before.contexts);
+            for (var i = 0; i < windows.length; i++)
+                windows[i].close();
+        });
+        waitsFor(function () {
+            return closed == 3;
+        }, "the windows to close", 10000);
+        runs(function () {
+            var after = Ti.UI.getWrapperCacheStats();
+            expect(after.contexts).toEqual(before.contexts);
+            expect(after.size).toBeLessThan(opened.size);
+        });
+    });
+});